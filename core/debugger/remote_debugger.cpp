@@ -270,6 +270,39 @@ struct RemoteDebugger::ScriptsProfiler {
 	}
 };
 
+struct RemoteDebugger::ScriptsSampler {
+	void toggle(bool p_enable, const Array &p_opts) {
+		if (p_enable) {
+			uint64_t interval_usec = 1000;
+			if (p_opts.size() == 1 && p_opts[0].get_type() == Variant::INT) {
+				interval_usec = MAX(1, int64_t(p_opts[0]));
+			}
+			for (int i = 0; i < ScriptServer::get_language_count(); i++) {
+				ScriptServer::get_language(i)->profiling_sampler_start(interval_usec);
+			}
+		} else {
+			// Send collapsed stacks as pairs of "frame;frame;..." strings and sample counts.
+			Array stacks;
+			for (int i = 0; i < ScriptServer::get_language_count(); i++) {
+				ScriptLanguage *lang = ScriptServer::get_language(i);
+				lang->profiling_sampler_stop();
+
+				List<ScriptLanguage::ProfilingSample> samples;
+				lang->profiling_sampler_get_data(&samples);
+				for (const List<ScriptLanguage::ProfilingSample>::Element *E = samples.front(); E; E = E->next()) {
+					stacks.push_back(E->get().stack);
+					stacks.push_back(E->get().count);
+				}
+			}
+			EngineDebugger::get_singleton()->send_message("scripts_sampler:stacks", stacks);
+		}
+	}
+
+	void add(const Array &p_data) {}
+
+	void tick(float p_frame_time, float p_idle_time, float p_physics_time, float p_physics_frame_time) {}
+};
+
 struct RemoteDebugger::ServersProfiler {
 	bool skip_profile_frame = false;
 	typedef DebuggerMarshalls::ServerInfo ServerInfo;
@@ -937,6 +970,10 @@ RemoteDebugger::RemoteDebugger(Ref<RemoteDebuggerPeer> p_peer) {
 	visual_profiler = memnew(VisualProfiler);
 	_bind_profiler("visual", visual_profiler);
 
+	// Scripts Sampler (collapsed call stacks for flame graphs)
+	scripts_sampler = memnew(ScriptsSampler);
+	_bind_profiler("scripts_sampler", scripts_sampler);
+
 	// Performance Profiler
 	Object *perf = Engine::get_singleton()->get_singleton_object("Performance");
 	if (perf) {
@@ -974,12 +1011,14 @@ RemoteDebugger::~RemoteDebugger() {
 	EngineDebugger::get_singleton()->unregister_profiler("servers");
 	EngineDebugger::get_singleton()->unregister_profiler("network");
 	EngineDebugger::get_singleton()->unregister_profiler("visual");
+	EngineDebugger::get_singleton()->unregister_profiler("scripts_sampler");
 	if (EngineDebugger::has_profiler("performance")) {
 		EngineDebugger::get_singleton()->unregister_profiler("performance");
 	}
 	memdelete(servers_profiler);
 	memdelete(network_profiler);
 	memdelete(visual_profiler);
+	memdelete(scripts_sampler);
 	if (performance_profiler) {
 		memdelete(performance_profiler);
 	}
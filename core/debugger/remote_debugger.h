@@ -54,11 +54,13 @@ private:
 	struct ScriptsProfiler;
 	struct VisualProfiler;
 	struct PerformanceProfiler;
+	struct ScriptsSampler;
 
 	NetworkProfiler *network_profiler = nullptr;
 	ServersProfiler *servers_profiler = nullptr;
 	VisualProfiler *visual_profiler = nullptr;
 	PerformanceProfiler *performance_profiler = nullptr;
+	ScriptsSampler *scripts_sampler = nullptr;
 
 	Ref<RemoteDebuggerPeer> peer;
 
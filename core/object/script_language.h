@@ -394,6 +394,15 @@ public:
 	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr, int p_info_max) = 0;
 	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr, int p_info_max) = 0;
 
+	struct ProfilingSample {
+		String stack; // Collapsed stack, outermost frame first, frames separated by ';'.
+		uint64_t count;
+	};
+
+	virtual void profiling_sampler_start(uint64_t p_interval_usec) {} //optional, not used by all languages
+	virtual void profiling_sampler_stop() {} //optional, not used by all languages
+	virtual void profiling_sampler_get_data(List<ProfilingSample> *r_samples) {} //optional, not used by all languages
+
 	virtual void *alloc_instance_binding_data(Object *p_object) { return nullptr; } //optional, not used by all languages
 	virtual void free_instance_binding_data(void *p_data) {} //optional, not used by all languages
 	virtual void refcount_incremented_instance_binding(Object *p_object) {} //optional, not used by all languages
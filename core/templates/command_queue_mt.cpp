@@ -70,35 +70,95 @@ CommandQueueMT::SyncSemaphore *CommandQueueMT::_alloc_sync_sem() {
 	return &sync_sems[idx];
 }
 
-bool CommandQueueMT::dealloc_one() {
-tryagain:
-	if (dealloc_ptr == (write_ptr_and_epoch >> 1)) {
-		// The queue is empty
-		return false;
+void CommandQueueMT::_wait_for_sync(SyncSemaphore *p_sync_sem) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	p_sync_sem->sem.wait();
+	sync_wait_usec.add(OS::get_singleton()->get_ticks_usec() - begin);
+	p_sync_sem->in_use = false;
+}
+
+void CommandQueueMT::_wait_for_commands() {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	sync->wait();
+	flush_wait_usec.add(OS::get_singleton()->get_ticks_usec() - begin);
+}
+
+void CommandQueueMT::wait_and_flush() {
+	ERR_FAIL_COND(!sync);
+	_wait_for_commands();
+#ifndef NO_THREADS
+	// Take the posts of the commands about to be flushed, so they don't cause wakeups later.
+	// A command pushed after this still posts, and will wake the reader if it was missed.
+	while (sync->try_wait()) {
 	}
+#endif
+	flush_all();
+}
 
-	uint32_t size = *(uint32_t *)&command_mem[dealloc_ptr];
+void CommandQueueMT::_next_write_page(uint32_t p_command_size) {
+	uint32_t needed = COMMAND_HEADER_SIZE + p_command_size + COMMAND_HEADER_SIZE;
 
-	if (size == 0) {
-		// End of command buffer wrap down
-		dealloc_ptr = 0;
-		goto tryagain;
+	Page *page = nullptr;
+	if (needed <= page_size) {
+		MutexLock lock(page_mutex);
+		if (free_pages.size()) {
+			page = free_pages[free_pages.size() - 1];
+			free_pages.resize(free_pages.size() - 1);
+		}
+	}
+
+	if (!page) {
+		// Commands bigger than a page get a page of their own.
+		page = memnew(Page);
+		page->size = MAX(page_size, needed);
+		page->mem = (uint8_t *)memalloc(page->size);
+		page_count.increment();
 	}
+	page->next = nullptr;
+
+	write_page->next = page;
+	*(uint32_t *)&write_page->mem[write_offset] = 0;
+	write_size += COMMAND_HEADER_SIZE;
+
+	write_page = page;
+	write_offset = 0;
+}
 
-	if (size & 1) {
-		// Still used, nothing can be deallocated
-		return false;
+void CommandQueueMT::_release_retired_pages() {
+	MutexLock lock(page_mutex);
+	for (uint32_t i = 0; i < retired_pages.size(); i++) {
+		Page *page = retired_pages[i];
+		if (page->size == page_size && free_pages.size() < MAX_FREE_PAGES) {
+			free_pages.push_back(page);
+		} else {
+			memfree(page->mem);
+			memdelete(page);
+			page_count.decrement();
+		}
 	}
+	retired_pages.clear();
+}
 
-	dealloc_ptr += (size >> 1) + 8;
-	return true;
+CommandQueueMT::Stats CommandQueueMT::get_stats() const {
+	Stats stats;
+	stats.commands_flushed = commands_flushed.get();
+	stats.sync_wait_usec = sync_wait_usec.get();
+	stats.flush_wait_usec = flush_wait_usec.get();
+	stats.page_count = page_count.get();
+	return stats;
 }
 
 CommandQueueMT::CommandQueueMT(bool p_sync) {
-	command_mem_size = GLOBAL_DEF_RST("memory/limits/command_queue/multithreading_queue_size_kb", DEFAULT_COMMAND_MEM_SIZE_KB);
+	page_size = GLOBAL_DEF_RST("memory/limits/command_queue/multithreading_queue_size_kb", DEFAULT_COMMAND_MEM_SIZE_KB);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/command_queue/multithreading_queue_size_kb", PropertyInfo(Variant::INT, "memory/limits/command_queue/multithreading_queue_size_kb", PROPERTY_HINT_RANGE, "1,4096,1,or_greater"));
-	command_mem_size *= 1024;
-	command_mem = (uint8_t *)memalloc(command_mem_size);
+	page_size *= 1024;
+
+	write_page = memnew(Page);
+	write_page->size = page_size;
+	write_page->mem = (uint8_t *)memalloc(page_size);
+	read_page = write_page;
+	page_count.increment();
+
 	if (p_sync) {
 		sync = memnew(Semaphore);
 	}
@@ -108,5 +168,16 @@ CommandQueueMT::~CommandQueueMT() {
 	if (sync) {
 		memdelete(sync);
 	}
-	memfree(command_mem);
+
+	for (uint32_t i = 0; i < retired_pages.size(); i++) {
+		free_pages.push_back(retired_pages[i]);
+	}
+	while (read_page) {
+		free_pages.push_back(read_page);
+		read_page = read_page->next;
+	}
+	for (uint32_t i = 0; i < free_pages.size(); i++) {
+		memfree(free_pages[i]->mem);
+		memdelete(free_pages[i]);
+	}
 }
@@ -34,6 +34,8 @@
 #include "core/os/memory.h"
 #include "core/os/mutex.h"
 #include "core/os/semaphore.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/simple_type.h"
 #include "core/typedefs.h"
 
@@ -252,7 +254,7 @@
 		cmd->instance = p_instance;                                          \
 		cmd->method = p_method;                                              \
 		SEMIC_SEP_LIST(CMD_ASSIGN_PARAM, N);                                 \
-		unlock();                                                            \
+		commit_and_unlock();                                                 \
 		if (sync)                                                            \
 			sync->post();                                                    \
 	}
@@ -269,11 +271,10 @@
 		SEMIC_SEP_LIST(CMD_ASSIGN_PARAM, N);                                                   \
 		cmd->ret = r_ret;                                                                      \
 		cmd->sync_sem = ss;                                                                    \
-		unlock();                                                                              \
+		commit_and_unlock();                                                                   \
 		if (sync)                                                                              \
 			sync->post();                                                                      \
-		ss->sem.wait();                                                                        \
-		ss->in_use = false;                                                                    \
+		_wait_for_sync(ss);                                                                    \
 	}
 
 #define CMD_SYNC_TYPE(N) CommandSync##N<T, M COMMA(N) COMMA_SEP_LIST(TYPE_ARG, N)>
@@ -287,11 +288,10 @@
 		cmd->method = p_method;                                                       \
 		SEMIC_SEP_LIST(CMD_ASSIGN_PARAM, N);                                          \
 		cmd->sync_sem = ss;                                                           \
-		unlock();                                                                     \
+		commit_and_unlock();                                                          \
 		if (sync)                                                                     \
 			sync->post();                                                             \
-		ss->sem.wait();                                                               \
-		ss->in_use = false;                                                           \
+		_wait_for_sync(ss);                                                           \
 	}
 
 #define MAX_CMD_PARAMS 15
@@ -331,153 +331,135 @@ class CommandQueueMT {
 
 	enum {
 		DEFAULT_COMMAND_MEM_SIZE_KB = 256,
-		SYNC_SEMAPHORES = 8
+		SYNC_SEMAPHORES = 8,
+		COMMAND_HEADER_SIZE = 8,
+		MAX_FREE_PAGES = 4,
 	};
 
-	uint8_t *command_mem = nullptr;
-	uint32_t read_ptr_and_epoch = 0;
-	uint32_t write_ptr_and_epoch = 0;
-	uint32_t dealloc_ptr = 0;
-	uint32_t command_mem_size = 0;
-	SyncSemaphore sync_sems[SYNC_SEMAPHORES];
+	// Commands are written back to back into pages, each one after a header holding its size.
+	// The writer never waits for the reader: when a page is full, it continues on a free (or new)
+	// page and leaves a zero header behind, telling the reader to follow Page::next.
+	// The reader only needs committed_size to know how far it can read, so it runs commands
+	// without taking the writers' mutex.
+	struct Page {
+		uint8_t *mem = nullptr;
+		uint32_t size = 0;
+		Page *next = nullptr;
+	};
+
+	uint32_t page_size = 0;
+
+	// Writer side, protected by mutex.
 	Mutex mutex;
+	Page *write_page = nullptr;
+	uint32_t write_offset = 0;
+	uint64_t write_size = 0;
+
+	// Bytes (commands and page ends) handed over to the reader.
+	SafeNumeric<uint64_t> committed_size;
+
+	// Reader side, protected by flush_mutex. Pages passed while a command is running (flushing
+	// can be reentrant) are only recycled once the outermost command is done.
+	Mutex flush_mutex;
+	Page *read_page = nullptr;
+	uint32_t read_offset = 0;
+	uint64_t read_size = 0;
+	uint32_t flush_depth = 0;
+	LocalVector<Page *> retired_pages;
+
+	Mutex page_mutex;
+	LocalVector<Page *> free_pages;
+	SafeNumeric<uint32_t> page_count;
+
+	SyncSemaphore sync_sems[SYNC_SEMAPHORES];
 	Semaphore *sync = nullptr;
 
+	SafeNumeric<uint64_t> commands_flushed;
+	SafeNumeric<uint64_t> sync_wait_usec;
+	SafeNumeric<uint64_t> flush_wait_usec;
+
 	template <class T>
 	T *allocate() {
-		// alloc size is size+T+safeguard
-		uint32_t alloc_size = ((sizeof(T) + 8 - 1) & ~(8 - 1)) + 8;
-
-		// Assert that the buffer is big enough to hold at least two messages.
-		ERR_FAIL_COND_V(alloc_size * 2 + sizeof(uint32_t) > command_mem_size, nullptr);
-
-	tryagain:
-		uint32_t write_ptr = write_ptr_and_epoch >> 1;
-
-		if (write_ptr < dealloc_ptr) {
-			// behind dealloc_ptr, check that there is room
-			if ((dealloc_ptr - write_ptr) <= alloc_size) {
-				// There is no more room, try to deallocate something
-				if (dealloc_one()) {
-					goto tryagain;
-				}
-				return nullptr;
-			}
-		} else {
-			// ahead of dealloc_ptr, check that there is room
-
-			if ((command_mem_size - write_ptr) < alloc_size + sizeof(uint32_t)) {
-				// no room at the end, wrap down;
-
-				if (dealloc_ptr == 0) { // don't want write_ptr to become dealloc_ptr
-
-					// There is no more room, try to deallocate something
-					if (dealloc_one()) {
-						goto tryagain;
-					}
-					return nullptr;
-				}
-
-				// if this happens, it's a bug
-				ERR_FAIL_COND_V((command_mem_size - write_ptr) < 8, nullptr);
-				// zero means, wrap to beginning
-
-				uint32_t *p = (uint32_t *)&command_mem[write_ptr];
-				*p = 1;
-				write_ptr_and_epoch = 0 | (1 & ~write_ptr_and_epoch); // Invert epoch.
-				// See if we can get the thread to run and clear up some more space while we wait.
-				// This is required if alloc_size * 2 + 4 > COMMAND_MEM_SIZE
-				if (sync) {
-					sync->post();
-				}
-				goto tryagain;
-			}
-		}
-		// Allocate the size and the 'in use' bit.
-		// First bit used to mark if command is still in use (1)
-		// or if it has been destroyed and can be deallocated (0).
 		uint32_t size = (sizeof(T) + 8 - 1) & ~(8 - 1);
-		uint32_t *p = (uint32_t *)&command_mem[write_ptr];
-		*p = (size << 1) | 1;
-		write_ptr += 8;
-		// allocate the command
-		T *cmd = memnew_placement(&command_mem[write_ptr], T);
-		write_ptr += size;
-		write_ptr_and_epoch = (write_ptr << 1) | (write_ptr_and_epoch & 1);
+		// Always leave room for the header that ends the page.
+		if (write_offset + COMMAND_HEADER_SIZE + size + COMMAND_HEADER_SIZE > write_page->size) {
+			_next_write_page(size);
+		}
+
+		*(uint32_t *)&write_page->mem[write_offset] = size;
+		T *cmd = memnew_placement(&write_page->mem[write_offset + COMMAND_HEADER_SIZE], T);
+		write_offset += COMMAND_HEADER_SIZE + size;
+		write_size += COMMAND_HEADER_SIZE + size;
 		return cmd;
 	}
 
 	template <class T>
 	T *allocate_and_lock() {
 		lock();
-		T *ret;
-
-		while ((ret = allocate<T>()) == nullptr) {
-			unlock();
-			// sleep a little until fetch happened and some room is made
-			wait_for_flush();
-			lock();
-		}
-
-		return ret;
+		return allocate<T>();
 	}
 
-	bool flush_one(bool p_lock = true) {
-		if (p_lock) {
-			lock();
-		}
-	tryagain:
+	_FORCE_INLINE_ void commit_and_unlock() {
+		committed_size.set(write_size);
+		unlock();
+	}
 
-		// tried to read an empty queue
-		if (read_ptr_and_epoch == write_ptr_and_epoch) {
-			if (p_lock) {
-				unlock();
+	// Must be called with flush_mutex locked.
+	bool _flush_one() {
+		while (read_size != committed_size.get()) {
+			uint32_t size = *(uint32_t *)&read_page->mem[read_offset];
+
+			if (size == 0) {
+				// End of the page, continue on the next one.
+				retired_pages.push_back(read_page);
+				read_page = read_page->next;
+				read_offset = 0;
+				read_size += COMMAND_HEADER_SIZE;
+				continue;
 			}
-			return false;
-		}
-
-		uint32_t read_ptr = read_ptr_and_epoch >> 1;
-		uint32_t size_ptr = read_ptr;
-		uint32_t size = *(uint32_t *)&command_mem[read_ptr] >> 1;
-
-		if (size == 0) {
-			*(uint32_t *)&command_mem[read_ptr] = 0; // clear in-use bit.
-			//end of ringbuffer, wrap
-			read_ptr_and_epoch = 0 | (1 & ~read_ptr_and_epoch); // Invert epoch.
-			goto tryagain;
-		}
 
-		read_ptr += 8;
+			CommandBase *cmd = reinterpret_cast<CommandBase *>(&read_page->mem[read_offset + COMMAND_HEADER_SIZE]);
+			read_offset += COMMAND_HEADER_SIZE + size;
+			read_size += COMMAND_HEADER_SIZE + size;
 
-		CommandBase *cmd = reinterpret_cast<CommandBase *>(&command_mem[read_ptr]);
+			flush_depth++;
+			cmd->call();
+			cmd->post();
+			cmd->~CommandBase();
+			flush_depth--;
 
-		read_ptr += size;
+			if (flush_depth == 0 && retired_pages.size()) {
+				_release_retired_pages();
+			}
+			return true;
+		}
 
-		read_ptr_and_epoch = (read_ptr << 1) | (read_ptr_and_epoch & 1);
+		return false;
+	}
 
+	bool flush_one(bool p_lock = true) {
 		if (p_lock) {
-			unlock();
+			flush_mutex.lock();
 		}
-		cmd->call();
+		bool flushed = _flush_one();
 		if (p_lock) {
-			lock();
+			flush_mutex.unlock();
 		}
 
-		cmd->post();
-		cmd->~CommandBase();
-		*(uint32_t *)&command_mem[size_ptr] &= ~1;
-
-		if (p_lock) {
-			unlock();
+		if (flushed) {
+			commands_flushed.increment();
 		}
-		return true;
+		return flushed;
 	}
 
 	void lock();
 	void unlock();
 	void wait_for_flush();
 	SyncSemaphore *_alloc_sync_sem();
-	bool dealloc_one();
+	void _wait_for_sync(SyncSemaphore *p_sync_sem);
+	void _wait_for_commands();
+	void _next_write_page(uint32_t p_command_size);
+	void _release_retired_pages();
 
 public:
 	/* NORMAL PUSH COMMANDS */
@@ -494,23 +476,42 @@ public:
 
 	void wait_and_flush_one() {
 		ERR_FAIL_COND(!sync);
-		sync->wait();
+		_wait_for_commands();
 		flush_one();
 	}
 
+	// Waits until something is pushed, then runs everything that was pushed so far.
+	void wait_and_flush();
+
 	_FORCE_INLINE_ void flush_if_pending() {
-		if (unlikely(read_ptr_and_epoch != write_ptr_and_epoch)) {
+		if (unlikely(read_size != committed_size.get())) {
 			flush_all();
 		}
 	}
 	void flush_all() {
-		//ERR_FAIL_COND(sync);
-		lock();
-		while (flush_one(false)) {
+		flush_mutex.lock();
+		uint64_t count = 0;
+		while (_flush_one()) {
+			count++;
+		}
+		flush_mutex.unlock();
+
+		if (count) {
+			commands_flushed.add(count);
 		}
-		unlock();
 	}
 
+	struct Stats {
+		uint64_t commands_flushed = 0;
+		// Time writers spent blocked in push_and_ret() and push_and_sync().
+		uint64_t sync_wait_usec = 0;
+		// Time the reader spent waiting for commands to be pushed.
+		uint64_t flush_wait_usec = 0;
+		uint32_t page_count = 0;
+	};
+
+	Stats get_stats() const;
+
 	CommandQueueMT(bool p_sync);
 	~CommandQueueMT();
 };
@@ -35,7 +35,9 @@
 #include "hash_map.h"
 #include "list.h"
 
-template <class TKey, class TData>
+// BeforeEvict, if set, is called for every entry that is replaced, erased or evicted,
+// but not for entries dropped by clear().
+template <class TKey, class TData, void (*BeforeEvict)(TKey &, TData &) = nullptr>
 class LRUCache {
 private:
 	struct Pair {
@@ -55,26 +57,49 @@ private:
 	HashMap<TKey, Element> _map;
 	size_t capacity;
 
+	_FORCE_INLINE_ void _before_evict(Element p_element) {
+		if constexpr (BeforeEvict != nullptr) {
+			BeforeEvict(p_element->get().key, p_element->get().data);
+		}
+	}
+
+	void _evict_to_capacity() {
+		while (_map.size() > capacity) {
+			Element d = _list.back();
+			_before_evict(d);
+			_map.erase(d->get().key);
+			_list.pop_back();
+		}
+	}
+
 public:
 	const TData *insert(const TKey &p_key, const TData &p_value) {
 		Element *e = _map.getptr(p_key);
 		Element n = _list.push_front(Pair(p_key, p_value));
 
 		if (e) {
+			_before_evict(*e);
 			_list.erase(*e);
 			_map.erase(p_key);
 		}
 		_map[p_key] = _list.front();
 
-		while (_map.size() > capacity) {
-			Element d = _list.back();
-			_map.erase(d->get().key);
-			_list.pop_back();
-		}
+		_evict_to_capacity();
 
 		return &n->get().data;
 	}
 
+	bool erase(const TKey &p_key) {
+		Element *e = _map.getptr(p_key);
+		if (!e) {
+			return false;
+		}
+		_before_evict(*e);
+		_list.erase(*e);
+		_map.erase(p_key);
+		return true;
+	}
+
 	void clear() {
 		_map.clear();
 		_list.clear();
@@ -102,15 +127,12 @@ public:
 	}
 
 	_FORCE_INLINE_ size_t get_capacity() const { return capacity; }
+	_FORCE_INLINE_ size_t get_size() const { return _map.size(); }
 
 	void set_capacity(size_t p_capacity) {
 		if (capacity > 0) {
 			capacity = p_capacity;
-			while (_map.size() > capacity) {
-				Element d = _list.back();
-				_map.erase(d->get().key);
-				_list.pop_back();
-			}
+			_evict_to_capacity();
 		}
 	}
 
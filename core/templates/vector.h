@@ -130,6 +130,10 @@ public:
 		_cowdata._ref(p_from._cowdata);
 		return *this;
 	}
+	inline Vector &operator=(Vector &&p_from) {
+		_cowdata = std::move(p_from._cowdata);
+		return *this;
+	}
 
 	Vector<uint8_t> to_byte_array() const {
 		Vector<uint8_t> ret;
@@ -189,6 +193,8 @@ public:
 
 	_FORCE_INLINE_ Vector() {}
 	_FORCE_INLINE_ Vector(const Vector &p_from) { _cowdata._ref(p_from._cowdata); }
+	_FORCE_INLINE_ Vector(Vector &&p_from) :
+			_cowdata(std::move(p_from._cowdata)) {}
 
 	_FORCE_INLINE_ ~Vector() {}
 };
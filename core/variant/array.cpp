@@ -46,7 +46,23 @@ public:
 	ContainerTypeValidate typed;
 };
 
+// Moved-from arrays all point to this empty private, so moves never allocate. It isn't reference
+// counted, each array gets its own private before it's written to or copied.
+static ArrayPrivate *_get_moved_from_private() {
+	static ArrayPrivate moved_from;
+	return &moved_from;
+}
+
+void Array::_ensure_private() const {
+	if (unlikely(_p == _get_moved_from_private())) {
+		_p = memnew(ArrayPrivate);
+		_p->refcount.init();
+	}
+}
+
 void Array::_ref(const Array &p_from) const {
+	// Copies must share the data, so the source can't stay on the moved-from private.
+	p_from._ensure_private();
 	ArrayPrivate *_fp = p_from._p;
 
 	ERR_FAIL_COND(!_fp); // should NOT happen.
@@ -65,7 +81,8 @@ void Array::_ref(const Array &p_from) const {
 }
 
 void Array::_unref() const {
-	if (!_p) {
+	if (!_p || _p == _get_moved_from_private()) {
+		_p = nullptr;
 		return;
 	}
 
@@ -92,6 +109,7 @@ bool Array::is_empty() const {
 }
 
 void Array::clear() {
+	_ensure_private();
 	_p->array.clear();
 }
 
@@ -140,6 +158,7 @@ uint32_t Array::hash() const {
 }
 
 bool Array::_assign(const Array &p_array) {
+	_ensure_private();
 	if (_p->typed.type != Variant::OBJECT && _p->typed.type == p_array._p->typed.type) {
 		//same type or untyped, just reference, should be fine
 		_ref(p_array);
@@ -189,21 +208,34 @@ void Array::operator=(const Array &p_array) {
 	_ref(p_array);
 }
 
+void Array::operator=(Array &&p_array) {
+	// Detach the data first, as the other array may be owned by this one.
+	ArrayPrivate *new_p = p_array._p;
+	p_array._p = _get_moved_from_private();
+
+	_unref();
+	_p = new_p;
+}
+
 void Array::push_back(const Variant &p_value) {
+	_ensure_private();
 	ERR_FAIL_COND(!_p->typed.validate(p_value, "push_back"));
 	_p->array.push_back(p_value);
 }
 
 void Array::append_array(const Array &p_array) {
+	_ensure_private();
 	ERR_FAIL_COND(!_p->typed.validate(p_array, "append_array"));
 	_p->array.append_array(p_array._p->array);
 }
 
 Error Array::resize(int p_new_size) {
+	_ensure_private();
 	return _p->array.resize(p_new_size);
 }
 
 void Array::insert(int p_pos, const Variant &p_value) {
+	_ensure_private();
 	ERR_FAIL_COND(!_p->typed.validate(p_value, "insert"));
 	_p->array.insert(p_pos, p_value);
 }
@@ -529,6 +561,7 @@ void Array::reverse() {
 }
 
 void Array::push_front(const Variant &p_value) {
+	_ensure_private();
 	ERR_FAIL_COND(!_p->typed.validate(p_value, "push_front"));
 	_p->array.insert(0, p_value);
 }
@@ -612,6 +645,7 @@ bool Array::typed_assign(const Array &p_other) {
 }
 
 void Array::set_typed(uint32_t p_type, const StringName &p_class_name, const Variant &p_script) {
+	_ensure_private();
 	ERR_FAIL_COND_MSG(_p->array.size() > 0, "Type can only be set when array is empty.");
 	ERR_FAIL_COND_MSG(_p->refcount.get() > 1, "Type can only be set when array has no more than one user.");
 	ERR_FAIL_COND_MSG(_p->typed.type != Variant::NIL, "Type can only be set once.");
@@ -646,6 +680,12 @@ Array::Array(const Array &p_from) {
 	_ref(p_from);
 }
 
+Array::Array(Array &&p_from) {
+	// The moved-from array is left empty, but usable.
+	_p = p_from._p;
+	p_from._p = _get_moved_from_private();
+}
+
 Array::Array() {
 	_p = memnew(ArrayPrivate);
 	_p->refcount.init();
@@ -43,6 +43,7 @@ class Array {
 	mutable ArrayPrivate *_p;
 	void _ref(const Array &p_from) const;
 	void _unref() const;
+	void _ensure_private() const;
 
 	inline int _clamp_slice_index(int p_index) const;
 
@@ -66,6 +67,7 @@ public:
 
 	uint32_t hash() const;
 	void operator=(const Array &p_array);
+	void operator=(Array &&p_array);
 
 	void push_back(const Variant &p_value);
 	_FORCE_INLINE_ void append(const Variant &p_value) { push_back(p_value); } //for python compatibility
@@ -122,6 +124,7 @@ public:
 	StringName get_typed_class_name() const;
 	Variant get_typed_script() const;
 	Array(const Array &p_from);
+	Array(Array &&p_from);
 	Array();
 	~Array();
 };
@@ -39,6 +39,20 @@ struct DictionaryPrivate {
 	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> variant_map;
 };
 
+// Moved-from dictionaries all point to this empty private, so moves never allocate. It isn't reference
+// counted, each dictionary gets its own private before it's written to or copied.
+static DictionaryPrivate *_get_moved_from_private() {
+	static DictionaryPrivate moved_from;
+	return &moved_from;
+}
+
+void Dictionary::_ensure_private() const {
+	if (unlikely(_p == _get_moved_from_private())) {
+		_p = memnew(DictionaryPrivate);
+		_p->refcount.init();
+	}
+}
+
 void Dictionary::get_key_list(List<Variant> *p_keys) const {
 	if (_p->variant_map.is_empty()) {
 		return;
@@ -74,6 +88,7 @@ Variant Dictionary::get_value_at_index(int p_index) const {
 }
 
 Variant &Dictionary::operator[](const Variant &p_key) {
+	_ensure_private();
 	return _p->variant_map[p_key];
 }
 
@@ -151,6 +166,9 @@ bool Dictionary::operator!=(const Dictionary &p_dictionary) const {
 }
 
 void Dictionary::_ref(const Dictionary &p_from) const {
+	// Copies must share the data, so the source can't stay on the moved-from private.
+	p_from._ensure_private();
+
 	//make a copy first (thread safe)
 	if (!p_from._p->refcount.ref()) {
 		return; // couldn't copy
@@ -168,11 +186,16 @@ void Dictionary::_ref(const Dictionary &p_from) const {
 }
 
 void Dictionary::clear() {
+	_ensure_private();
 	_p->variant_map.clear();
 }
 
 void Dictionary::_unref() const {
 	ERR_FAIL_COND(!_p);
+	if (_p == _get_moved_from_private()) {
+		_p = nullptr;
+		return;
+	}
 	if (_p->refcount.unref()) {
 		memdelete(_p);
 	}
@@ -254,6 +277,15 @@ void Dictionary::operator=(const Dictionary &p_dictionary) {
 	_ref(p_dictionary);
 }
 
+void Dictionary::operator=(Dictionary &&p_dictionary) {
+	// Detach the data first, as the other dictionary may be owned by this one.
+	DictionaryPrivate *new_p = p_dictionary._p;
+	p_dictionary._p = _get_moved_from_private();
+
+	_unref();
+	_p = new_p;
+}
+
 const void *Dictionary::id() const {
 	return _p->variant_map.id();
 }
@@ -263,6 +295,12 @@ Dictionary::Dictionary(const Dictionary &p_from) {
 	_ref(p_from);
 }
 
+Dictionary::Dictionary(Dictionary &&p_from) {
+	// The moved-from dictionary is left empty, but usable.
+	_p = p_from._p;
+	p_from._p = _get_moved_from_private();
+}
+
 Dictionary::Dictionary() {
 	_p = memnew(DictionaryPrivate);
 	_p->refcount.init();
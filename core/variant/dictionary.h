@@ -44,6 +44,7 @@ class Dictionary {
 
 	void _ref(const Dictionary &p_from) const;
 	void _unref() const;
+	void _ensure_private() const;
 
 public:
 	void get_key_list(List<Variant> *p_keys) const;
@@ -73,6 +74,7 @@ public:
 
 	uint32_t hash() const;
 	void operator=(const Dictionary &p_dictionary);
+	void operator=(Dictionary &&p_dictionary);
 
 	const Variant *next(const Variant *p_key = nullptr) const;
 
@@ -84,6 +86,7 @@ public:
 	const void *id() const;
 
 	Dictionary(const Dictionary &p_from);
+	Dictionary(Dictionary &&p_from);
 	Dictionary();
 	~Dictionary();
 };
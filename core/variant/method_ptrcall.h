@@ -46,7 +46,7 @@ struct PtrToArg {};
 			return *reinterpret_cast<const m_type *>(p_ptr);           \
 		}                                                              \
 		_FORCE_INLINE_ static void encode(m_type p_val, void *p_ptr) { \
-			*((m_type *)p_ptr) = p_val;                                \
+			*((m_type *)p_ptr) = std::move(p_val);                     \
 		}                                                              \
 	};                                                                 \
 	template <>                                                        \
@@ -55,7 +55,7 @@ struct PtrToArg {};
 			return *reinterpret_cast<const m_type *>(p_ptr);           \
 		}                                                              \
 		_FORCE_INLINE_ static void encode(m_type p_val, void *p_ptr) { \
-			*((m_type *)p_ptr) = p_val;                                \
+			*((m_type *)p_ptr) = std::move(p_val);                     \
 		}                                                              \
 	}
 
@@ -36,10 +36,41 @@
 #include "core/io/resource.h"
 #include "core/math/math_funcs.h"
 #include "core/string/print_string.h"
+#include "core/templates/paged_allocator.h"
 #include "core/variant/variant_parser.h"
 #include "scene/gui/control.h"
 #include "scene/main/node.h"
 
+#ifdef VARIANT_POOLS_ENABLED
+// The pools are created on first use and never freed, as static Variants holding
+// pooled values may be constructed before, or destroyed after, any static pool.
+PagedAllocator<Variant::Pools::BucketSmall, true> &Variant::Pools::get_bucket_small() {
+	static PagedAllocator<BucketSmall, true> *bucket = memnew((PagedAllocator<BucketSmall, true>));
+	return *bucket;
+}
+
+PagedAllocator<Variant::Pools::BucketLarge, true> &Variant::Pools::get_bucket_large() {
+	static PagedAllocator<BucketLarge, true> *bucket = memnew((PagedAllocator<BucketLarge, true>));
+	return *bucket;
+}
+
+void *Variant::Pools::alloc_small() {
+	return get_bucket_small().alloc();
+}
+
+void *Variant::Pools::alloc_large() {
+	return get_bucket_large().alloc();
+}
+
+void Variant::Pools::free_small(void *p_mem) {
+	get_bucket_small().free((BucketSmall *)p_mem);
+}
+
+void Variant::Pools::free_large(void *p_mem) {
+	get_bucket_large().free((BucketLarge *)p_mem);
+}
+#endif
+
 String Variant::get_type_name(Variant::Type p_type) {
 	switch (p_type) {
 		case NIL: {
@@ -1077,7 +1108,7 @@ void Variant::reference(const Variant &p_variant) {
 			memnew_placement(_data._mem, Rect2i(*reinterpret_cast<const Rect2i *>(p_variant._data._mem)));
 		} break;
 		case TRANSFORM2D: {
-			_data._transform2d = memnew(Transform2D(*p_variant._data._transform2d));
+			_data._transform2d = _alloc_math(*p_variant._data._transform2d);
 		} break;
 		case VECTOR3: {
 			memnew_placement(_data._mem, Vector3(*reinterpret_cast<const Vector3 *>(p_variant._data._mem)));
@@ -1090,18 +1121,18 @@ void Variant::reference(const Variant &p_variant) {
 		} break;
 
 		case AABB: {
-			_data._aabb = memnew(::AABB(*p_variant._data._aabb));
+			_data._aabb = _alloc_math(*p_variant._data._aabb);
 		} break;
 		case QUAT: {
 			memnew_placement(_data._mem, Quat(*reinterpret_cast<const Quat *>(p_variant._data._mem)));
 
 		} break;
 		case BASIS: {
-			_data._basis = memnew(Basis(*p_variant._data._basis));
+			_data._basis = _alloc_math(*p_variant._data._basis);
 
 		} break;
 		case TRANSFORM: {
-			_data._transform = memnew(Transform(*p_variant._data._transform));
+			_data._transform = _alloc_math(*p_variant._data._transform);
 		} break;
 
 		// misc types
@@ -1281,16 +1312,16 @@ void Variant::_clear_internal() {
 		RECT2
 		*/
 		case TRANSFORM2D: {
-			memdelete(_data._transform2d);
+			_free_math(_data._transform2d);
 		} break;
 		case AABB: {
-			memdelete(_data._aabb);
+			_free_math(_data._aabb);
 		} break;
 		case BASIS: {
-			memdelete(_data._basis);
+			_free_math(_data._basis);
 		} break;
 		case TRANSFORM: {
-			memdelete(_data._transform);
+			_free_math(_data._transform);
 		} break;
 
 			// misc types
@@ -2487,12 +2518,12 @@ Variant::Variant(const Plane &p_plane) {
 
 Variant::Variant(const ::AABB &p_aabb) {
 	type = AABB;
-	_data._aabb = memnew(::AABB(p_aabb));
+	_data._aabb = _alloc_math(p_aabb);
 }
 
 Variant::Variant(const Basis &p_matrix) {
 	type = BASIS;
-	_data._basis = memnew(Basis(p_matrix));
+	_data._basis = _alloc_math(p_matrix);
 }
 
 Variant::Variant(const Quat &p_quat) {
@@ -2502,12 +2533,12 @@ Variant::Variant(const Quat &p_quat) {
 
 Variant::Variant(const Transform &p_transform) {
 	type = TRANSFORM;
-	_data._transform = memnew(Transform(p_transform));
+	_data._transform = _alloc_math(p_transform);
 }
 
 Variant::Variant(const Transform2D &p_transform) {
 	type = TRANSFORM2D;
-	_data._transform2d = memnew(Transform2D(p_transform));
+	_data._transform2d = _alloc_math(p_transform);
 }
 
 Variant::Variant(const Color &p_color) {
@@ -2681,6 +2712,21 @@ Variant::Variant(const Vector<StringName> &p_array) {
 	*this = v;
 }
 
+void Variant::operator=(Variant &&p_variant) {
+	if (unlikely(this == &p_variant)) {
+		return;
+	}
+
+	// Detach the data first, as the other variant may be owned by this one.
+	Type new_type = p_variant.type;
+	decltype(_data) new_data = p_variant._data;
+	p_variant.type = NIL;
+
+	clear();
+	type = new_type;
+	_data = new_data;
+}
+
 void Variant::operator=(const Variant &p_variant) {
 	if (unlikely(this == &p_variant)) {
 		return;
@@ -57,6 +57,9 @@ class Control; // helper
 struct PropertyInfo;
 struct MethodInfo;
 
+template <class T, bool thread_safe>
+class PagedAllocator;
+
 typedef Vector<uint8_t> PackedByteArray;
 typedef Vector<int32_t> PackedInt32Array;
 typedef Vector<int64_t> PackedInt64Array;
@@ -190,6 +193,66 @@ private:
 	};
 
 	/* end of array helpers */
+
+	/* storage for math types too big to fit in _data */
+#ifdef VARIANT_POOLS_ENABLED
+	struct Pools {
+		union BucketSmall {
+			BucketSmall() {}
+			~BucketSmall() {}
+			Transform2D _transform2d;
+			::AABB _aabb;
+		};
+		union BucketLarge {
+			BucketLarge() {}
+			~BucketLarge() {}
+			Basis _basis;
+			Transform _transform;
+		};
+
+		static PagedAllocator<BucketSmall, true> &get_bucket_small();
+		static PagedAllocator<BucketLarge, true> &get_bucket_large();
+
+		// Out of line, so the allocator is only needed in variant.cpp.
+		static void *alloc_small();
+		static void *alloc_large();
+		static void free_small(void *p_mem);
+		static void free_large(void *p_mem);
+	};
+
+	template <class T>
+	static _FORCE_INLINE_ T *_alloc_math(const T &p_value) {
+		void *mem;
+		if (sizeof(T) <= sizeof(Pools::BucketSmall)) {
+			mem = Pools::alloc_small();
+		} else {
+			mem = Pools::alloc_large();
+		}
+		return memnew_placement(mem, T(p_value));
+	}
+
+	template <class T>
+	static _FORCE_INLINE_ void _free_math(T *p_value) {
+		p_value->~T();
+		if (sizeof(T) <= sizeof(Pools::BucketSmall)) {
+			Pools::free_small(p_value);
+		} else {
+			Pools::free_large(p_value);
+		}
+	}
+#else
+	template <class T>
+	static _FORCE_INLINE_ T *_alloc_math(const T &p_value) {
+		return memnew(T(p_value));
+	}
+
+	template <class T>
+	static _FORCE_INLINE_ void _free_math(T *p_value) {
+		memdelete(p_value);
+	}
+#endif
+	/* end of math type storage */
+
 	_ALWAYS_INLINE_ ObjData &_get_obj();
 	_ALWAYS_INLINE_ const ObjData &_get_obj() const;
 
@@ -659,11 +722,18 @@ public:
 	static void construct_from_string(const String &p_string, Variant &r_value, ObjectConstruct p_obj_construct = nullptr, void *p_construct_ud = nullptr);
 
 	void operator=(const Variant &p_variant); // only this is enough for all the other types
+	void operator=(Variant &&p_variant);
 
 	static void register_types();
 	static void unregister_types();
 
 	Variant(const Variant &p_variant);
+	_FORCE_INLINE_ Variant(Variant &&p_variant) {
+		// All variant types can be relocated, so steal the data and leave the other one empty.
+		type = p_variant.type;
+		_data = p_variant._data;
+		p_variant.type = NIL;
+	}
 	_FORCE_INLINE_ Variant() {}
 	_FORCE_INLINE_ ~Variant() {
 		clear();
@@ -35,6 +35,7 @@
 #include "core/debugger/engine_debugger.h"
 #include "core/io/compression.h"
 #include "core/io/marshalls.h"
+#include "core/math/simd.h"
 #include "core/object/class_db.h"
 #include "core/os/os.h"
 #include "core/templates/local_vector.h"
@@ -545,6 +546,25 @@ static _FORCE_INLINE_ void vc_ptrcall(void (*method)(T *, P...), void *p_base, c
 		}                                                                                                                                                         \
 	};
 
+// Component type and count of the elements of packed arrays with bulk math operations.
+template <class T>
+struct PackedBulk {
+	typedef float Scalar;
+	enum { COMPONENTS = 1 };
+};
+
+template <>
+struct PackedBulk<Vector2> {
+	typedef real_t Scalar;
+	enum { COMPONENTS = 2 };
+};
+
+template <>
+struct PackedBulk<Vector3> {
+	typedef real_t Scalar;
+	enum { COMPONENTS = 3 };
+};
+
 struct _VariantCall {
 	static String func_PackedByteArray_get_string_from_ascii(PackedByteArray *p_instance) {
 		String s;
@@ -834,6 +854,305 @@ struct _VariantCall {
 		return len;
 	}
 
+	// Bulk operations on float and vector packed arrays. They work directly on the
+	// array storage, which is only copied if it is shared with another array.
+	// Vectors are worked on as a flat array of components, so the same kernels serve
+	// all three array types, four floats at a time when real_t is float.
+
+	enum BulkReduce {
+		BULK_SUM,
+		BULK_MIN,
+		BULK_MAX,
+	};
+
+	template <class F>
+	static _FORCE_INLINE_ F _bulk_reduce_op(F p_a, F p_b, BulkReduce p_op) {
+		switch (p_op) {
+			case BULK_SUM:
+				return p_a + p_b;
+			case BULK_MIN:
+				return MIN(p_a, p_b);
+			default:
+				return MAX(p_a, p_b);
+		}
+	}
+
+	template <class F>
+	static void _bulk_add_scalar(F *p_dst, int p_count, F p_scalar) {
+		for (int i = 0; i < p_count; i++) {
+			p_dst[i] += p_scalar;
+		}
+	}
+
+	template <class F>
+	static void _bulk_multiply_scalar(F *p_dst, int p_count, F p_scalar) {
+		for (int i = 0; i < p_count; i++) {
+			p_dst[i] *= p_scalar;
+		}
+	}
+
+	template <class F>
+	static void _bulk_add(F *p_dst, const F *p_src, int p_count) {
+		for (int i = 0; i < p_count; i++) {
+			p_dst[i] += p_src[i];
+		}
+	}
+
+	template <class F>
+	static void _bulk_multiply(F *p_dst, const F *p_src, int p_count) {
+		for (int i = 0; i < p_count; i++) {
+			p_dst[i] *= p_src[i];
+		}
+	}
+
+	template <class F>
+	static void _bulk_lerp(F *p_dst, const F *p_to, int p_count, F p_weight) {
+		for (int i = 0; i < p_count; i++) {
+			p_dst[i] += (p_to[i] - p_dst[i]) * p_weight;
+		}
+	}
+
+	// Reduces p_count vectors of C components from p_from into r_result, which holds the starting value.
+	template <int C, class F>
+	static void _bulk_reduce(const F *p_src, int p_from, int p_count, BulkReduce p_op, F *r_result) {
+		for (int i = p_from; i < p_count; i++) {
+			for (int j = 0; j < C; j++) {
+				r_result[j] = _bulk_reduce_op(r_result[j], p_src[i * C + j], p_op);
+			}
+		}
+	}
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+#if defined(SIMD_SSE2)
+	typedef __m128 BulkVec;
+	static _FORCE_INLINE_ BulkVec _bulk_load(const float *p_src) { return _mm_loadu_ps(p_src); }
+	static _FORCE_INLINE_ void _bulk_store(float *p_dst, BulkVec p_v) { _mm_storeu_ps(p_dst, p_v); }
+	static _FORCE_INLINE_ BulkVec _bulk_splat(float p_value) { return _mm_set1_ps(p_value); }
+	static _FORCE_INLINE_ BulkVec _bulk_vadd(BulkVec p_a, BulkVec p_b) { return _mm_add_ps(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vsub(BulkVec p_a, BulkVec p_b) { return _mm_sub_ps(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vmul(BulkVec p_a, BulkVec p_b) { return _mm_mul_ps(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vmin(BulkVec p_a, BulkVec p_b) { return _mm_min_ps(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vmax(BulkVec p_a, BulkVec p_b) { return _mm_max_ps(p_a, p_b); }
+#else
+	typedef float32x4_t BulkVec;
+	static _FORCE_INLINE_ BulkVec _bulk_load(const float *p_src) { return vld1q_f32(p_src); }
+	static _FORCE_INLINE_ void _bulk_store(float *p_dst, BulkVec p_v) { vst1q_f32(p_dst, p_v); }
+	static _FORCE_INLINE_ BulkVec _bulk_splat(float p_value) { return vdupq_n_f32(p_value); }
+	static _FORCE_INLINE_ BulkVec _bulk_vadd(BulkVec p_a, BulkVec p_b) { return vaddq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vsub(BulkVec p_a, BulkVec p_b) { return vsubq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vmul(BulkVec p_a, BulkVec p_b) { return vmulq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vmin(BulkVec p_a, BulkVec p_b) { return vminq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ BulkVec _bulk_vmax(BulkVec p_a, BulkVec p_b) { return vmaxq_f32(p_a, p_b); }
+#endif
+
+	static void _bulk_add_scalar(float *p_dst, int p_count, float p_scalar) {
+		const BulkVec scalar = _bulk_splat(p_scalar);
+		int i = 0;
+		for (; i + 4 <= p_count; i += 4) {
+			_bulk_store(p_dst + i, _bulk_vadd(_bulk_load(p_dst + i), scalar));
+		}
+		for (; i < p_count; i++) {
+			p_dst[i] += p_scalar;
+		}
+	}
+
+	static void _bulk_multiply_scalar(float *p_dst, int p_count, float p_scalar) {
+		const BulkVec scalar = _bulk_splat(p_scalar);
+		int i = 0;
+		for (; i + 4 <= p_count; i += 4) {
+			_bulk_store(p_dst + i, _bulk_vmul(_bulk_load(p_dst + i), scalar));
+		}
+		for (; i < p_count; i++) {
+			p_dst[i] *= p_scalar;
+		}
+	}
+
+	static void _bulk_add(float *p_dst, const float *p_src, int p_count) {
+		int i = 0;
+		for (; i + 4 <= p_count; i += 4) {
+			_bulk_store(p_dst + i, _bulk_vadd(_bulk_load(p_dst + i), _bulk_load(p_src + i)));
+		}
+		for (; i < p_count; i++) {
+			p_dst[i] += p_src[i];
+		}
+	}
+
+	static void _bulk_multiply(float *p_dst, const float *p_src, int p_count) {
+		int i = 0;
+		for (; i + 4 <= p_count; i += 4) {
+			_bulk_store(p_dst + i, _bulk_vmul(_bulk_load(p_dst + i), _bulk_load(p_src + i)));
+		}
+		for (; i < p_count; i++) {
+			p_dst[i] *= p_src[i];
+		}
+	}
+
+	static void _bulk_lerp(float *p_dst, const float *p_to, int p_count, float p_weight) {
+		const BulkVec weight = _bulk_splat(p_weight);
+		int i = 0;
+		for (; i + 4 <= p_count; i += 4) {
+			BulkVec from = _bulk_load(p_dst + i);
+			_bulk_store(p_dst + i, _bulk_vadd(from, _bulk_vmul(_bulk_vsub(_bulk_load(p_to + i), from), weight)));
+		}
+		for (; i < p_count; i++) {
+			p_dst[i] += (p_to[i] - p_dst[i]) * p_weight;
+		}
+	}
+
+	// Four vectors of C components fill C registers, so lane j of register k always holds
+	// component (4 * k + j) % C and each register can be reduced on its own.
+	template <int C>
+	static void _bulk_reduce(const float *p_src, int p_from, int p_count, BulkReduce p_op, float *r_result) {
+		int blocks = (p_count - p_from) / 4;
+		if (blocks > 0) {
+			BulkVec acc[C];
+			for (int k = 0; k < C; k++) {
+				acc[k] = p_op == BULK_SUM ? _bulk_splat(0) : _bulk_load(p_src + p_from * C + k * 4);
+			}
+			for (int b = 0; b < blocks; b++) {
+				const float *src = p_src + (p_from + b * 4) * C;
+				for (int k = 0; k < C; k++) {
+					BulkVec v = _bulk_load(src + k * 4);
+					acc[k] = p_op == BULK_SUM ? _bulk_vadd(acc[k], v) : (p_op == BULK_MIN ? _bulk_vmin(acc[k], v) : _bulk_vmax(acc[k], v));
+				}
+			}
+
+			float lanes[4 * C];
+			for (int k = 0; k < C; k++) {
+				_bulk_store(lanes + k * 4, acc[k]);
+			}
+			for (int j = 0; j < 4 * C; j++) {
+				r_result[j % C] = _bulk_reduce_op(r_result[j % C], lanes[j], p_op);
+			}
+		}
+
+		for (int i = p_from + blocks * 4; i < p_count; i++) {
+			for (int j = 0; j < C; j++) {
+				r_result[j] = _bulk_reduce_op(r_result[j], p_src[i * C + j], p_op);
+			}
+		}
+	}
+#endif
+
+	template <class T>
+	static _FORCE_INLINE_ typename PackedBulk<T>::Scalar *_bulk_ptrw(Vector<T> *p_instance) {
+		return reinterpret_cast<typename PackedBulk<T>::Scalar *>(p_instance->ptrw());
+	}
+
+	template <class T>
+	static _FORCE_INLINE_ const typename PackedBulk<T>::Scalar *_bulk_ptr(const Vector<T> &p_array) {
+		return reinterpret_cast<const typename PackedBulk<T>::Scalar *>(p_array.ptr());
+	}
+
+	template <class T>
+	static T _bulk_reduce_array(Vector<T> *p_instance, BulkReduce p_op) {
+		typedef typename PackedBulk<T>::Scalar Scalar;
+		const int components = PackedBulk<T>::COMPONENTS;
+		const Scalar *src = _bulk_ptr(*p_instance);
+
+		// Sums start from zero, minimum and maximum from the first element.
+		T ret = p_op == BULK_SUM ? T() : p_instance->get(0);
+		_bulk_reduce<components>(src, p_op == BULK_SUM ? 0 : 1, p_instance->size(), p_op, reinterpret_cast<Scalar *>(&ret));
+		return ret;
+	}
+
+	static void func_PackedFloat32Array_add_scalar(PackedFloat32Array *p_instance, float p_scalar) {
+		_bulk_add_scalar(p_instance->ptrw(), p_instance->size(), p_scalar);
+	}
+
+	template <class T>
+	static void func_Packed_multiply_scalar(Vector<T> *p_instance, float p_scalar) {
+		typedef typename PackedBulk<T>::Scalar Scalar;
+		int count = p_instance->size() * PackedBulk<T>::COMPONENTS;
+		_bulk_multiply_scalar(_bulk_ptrw(p_instance), count, Scalar(p_scalar));
+	}
+
+	template <class T>
+	static void func_Packed_add_array(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_MSG(p_array.size() != p_instance->size(), "Both arrays must have the same size.");
+		int count = p_instance->size() * PackedBulk<T>::COMPONENTS;
+		_bulk_add(_bulk_ptrw(p_instance), _bulk_ptr(p_array), count);
+	}
+
+	template <class T>
+	static void func_Packed_multiply_array(Vector<T> *p_instance, const Vector<T> &p_array) {
+		ERR_FAIL_COND_MSG(p_array.size() != p_instance->size(), "Both arrays must have the same size.");
+		int count = p_instance->size() * PackedBulk<T>::COMPONENTS;
+		_bulk_multiply(_bulk_ptrw(p_instance), _bulk_ptr(p_array), count);
+	}
+
+	template <class T>
+	static void func_Packed_lerp_array(Vector<T> *p_instance, const Vector<T> &p_to, float p_weight) {
+		typedef typename PackedBulk<T>::Scalar Scalar;
+		ERR_FAIL_COND_MSG(p_to.size() != p_instance->size(), "Both arrays must have the same size.");
+		int count = p_instance->size() * PackedBulk<T>::COMPONENTS;
+		_bulk_lerp(_bulk_ptrw(p_instance), _bulk_ptr(p_to), count, Scalar(p_weight));
+	}
+
+	template <class T>
+	static T func_Packed_sum(Vector<T> *p_instance) {
+		return _bulk_reduce_array(p_instance, BULK_SUM);
+	}
+
+	template <class T>
+	static T func_Packed_min(Vector<T> *p_instance) {
+		ERR_FAIL_COND_V_MSG(p_instance->size() == 0, T(), "Can't get the minimum of an empty array.");
+		return _bulk_reduce_array(p_instance, BULK_MIN);
+	}
+
+	template <class T>
+	static T func_Packed_max(Vector<T> *p_instance) {
+		ERR_FAIL_COND_V_MSG(p_instance->size() == 0, T(), "Can't get the maximum of an empty array.");
+		return _bulk_reduce_array(p_instance, BULK_MAX);
+	}
+
+	static void func_PackedVector2Array_transform(PackedVector2Array *p_instance, const Transform2D &p_transform) {
+		int size = p_instance->size();
+		Vector2 *w = p_instance->ptrw();
+		int i = 0;
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+		// Two points per register: (x0, y0, x1, y1).
+		const __m128 axis_x = _mm_setr_ps(p_transform.elements[0].x, p_transform.elements[0].y, p_transform.elements[0].x, p_transform.elements[0].y);
+		const __m128 axis_y = _mm_setr_ps(p_transform.elements[1].x, p_transform.elements[1].y, p_transform.elements[1].x, p_transform.elements[1].y);
+		const __m128 origin = _mm_setr_ps(p_transform.elements[2].x, p_transform.elements[2].y, p_transform.elements[2].x, p_transform.elements[2].y);
+		float *points = &w[0].x;
+		for (; i + 2 <= size; i += 2) {
+			__m128 p = _mm_loadu_ps(points + i * 2);
+			__m128 x = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+			__m128 y = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+			_mm_storeu_ps(points + i * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, axis_x), _mm_mul_ps(y, axis_y)), origin));
+		}
+#elif defined(SIMD_NEON) && !defined(REAL_T_IS_DOUBLE)
+		const float axis_x_v[4] = { p_transform.elements[0].x, p_transform.elements[0].y, p_transform.elements[0].x, p_transform.elements[0].y };
+		const float axis_y_v[4] = { p_transform.elements[1].x, p_transform.elements[1].y, p_transform.elements[1].x, p_transform.elements[1].y };
+		const float origin_v[4] = { p_transform.elements[2].x, p_transform.elements[2].y, p_transform.elements[2].x, p_transform.elements[2].y };
+		const float32x4_t axis_x = vld1q_f32(axis_x_v);
+		const float32x4_t axis_y = vld1q_f32(axis_y_v);
+		const float32x4_t origin = vld1q_f32(origin_v);
+		float *points = &w[0].x;
+		for (; i + 2 <= size; i += 2) {
+			// Deinterleaving gives (x0, x1) and (y0, y1), zipping them with themselves spreads each to both lanes of its point.
+			float32x2x2_t p = vld2_f32(points + i * 2);
+			float32x4_t x = vcombine_f32(vzip_f32(p.val[0], p.val[0]).val[0], vzip_f32(p.val[0], p.val[0]).val[1]);
+			float32x4_t y = vcombine_f32(vzip_f32(p.val[1], p.val[1]).val[0], vzip_f32(p.val[1], p.val[1]).val[1]);
+			vst1q_f32(points + i * 2, vaddq_f32(vaddq_f32(vmulq_f32(x, axis_x), vmulq_f32(y, axis_y)), origin));
+		}
+#endif
+		for (; i < size; i++) {
+			w[i] = p_transform.xform(w[i]);
+		}
+	}
+
+	static void func_PackedVector3Array_transform(PackedVector3Array *p_instance, const Transform &p_transform) {
+		// Points are 12 bytes, so a four-wide store would overwrite the next point before it is read.
+		// Transforming in place keeps this scalar.
+		int size = p_instance->size();
+		Vector3 *w = p_instance->ptrw();
+		for (int i = 0; i < size; i++) {
+			w[i] = p_transform.xform(w[i]);
+		}
+	}
+
 	static void func_Callable_call(Variant *v, const Variant **p_args, int p_argcount, Variant &r_ret, Callable::CallError &r_error) {
 		Callable *callable = VariantGetInternalPtr<Callable>::get_ptr(v);
 		callable->call(p_args, p_argcount, r_ret, r_error);
@@ -1862,6 +2181,15 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedFloat32Array, sort, sarray(), varray());
 	bind_method(PackedFloat32Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedFloat32Array, add_scalar, _VariantCall::func_PackedFloat32Array_add_scalar, sarray("scalar"), varray());
+	bind_functionnc(PackedFloat32Array, multiply_scalar, _VariantCall::func_Packed_multiply_scalar<float>, sarray("scalar"), varray());
+	bind_functionnc(PackedFloat32Array, add_array, _VariantCall::func_Packed_add_array<float>, sarray("array"), varray());
+	bind_functionnc(PackedFloat32Array, multiply_array, _VariantCall::func_Packed_multiply_array<float>, sarray("array"), varray());
+	bind_functionnc(PackedFloat32Array, lerp_array, _VariantCall::func_Packed_lerp_array<float>, sarray("to", "weight"), varray());
+	bind_function(PackedFloat32Array, sum, _VariantCall::func_Packed_sum<float>, sarray(), varray());
+	bind_function(PackedFloat32Array, min, _VariantCall::func_Packed_min<float>, sarray(), varray());
+	bind_function(PackedFloat32Array, max, _VariantCall::func_Packed_max<float>, sarray(), varray());
+
 	/* Float64 Array */
 
 	bind_method(PackedFloat64Array, size, sarray(), varray());
@@ -1919,6 +2247,15 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedVector2Array, sort, sarray(), varray());
 	bind_method(PackedVector2Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedVector2Array, multiply_scalar, _VariantCall::func_Packed_multiply_scalar<Vector2>, sarray("scalar"), varray());
+	bind_functionnc(PackedVector2Array, add_array, _VariantCall::func_Packed_add_array<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, multiply_array, _VariantCall::func_Packed_multiply_array<Vector2>, sarray("array"), varray());
+	bind_functionnc(PackedVector2Array, lerp_array, _VariantCall::func_Packed_lerp_array<Vector2>, sarray("to", "weight"), varray());
+	bind_function(PackedVector2Array, sum, _VariantCall::func_Packed_sum<Vector2>, sarray(), varray());
+	bind_function(PackedVector2Array, min, _VariantCall::func_Packed_min<Vector2>, sarray(), varray());
+	bind_function(PackedVector2Array, max, _VariantCall::func_Packed_max<Vector2>, sarray(), varray());
+	bind_functionnc(PackedVector2Array, transform, _VariantCall::func_PackedVector2Array_transform, sarray("transform"), varray());
+
 	/* Vector3 Array */
 
 	bind_method(PackedVector3Array, size, sarray(), varray());
@@ -1938,6 +2275,15 @@ static void _register_variant_builtin_methods() {
 	bind_method(PackedVector3Array, sort, sarray(), varray());
 	bind_method(PackedVector3Array, duplicate, sarray(), varray());
 
+	bind_functionnc(PackedVector3Array, multiply_scalar, _VariantCall::func_Packed_multiply_scalar<Vector3>, sarray("scalar"), varray());
+	bind_functionnc(PackedVector3Array, add_array, _VariantCall::func_Packed_add_array<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, multiply_array, _VariantCall::func_Packed_multiply_array<Vector3>, sarray("array"), varray());
+	bind_functionnc(PackedVector3Array, lerp_array, _VariantCall::func_Packed_lerp_array<Vector3>, sarray("to", "weight"), varray());
+	bind_function(PackedVector3Array, sum, _VariantCall::func_Packed_sum<Vector3>, sarray(), varray());
+	bind_function(PackedVector3Array, min, _VariantCall::func_Packed_min<Vector3>, sarray(), varray());
+	bind_function(PackedVector3Array, max, _VariantCall::func_Packed_max<Vector3>, sarray(), varray());
+	bind_functionnc(PackedVector3Array, transform, _VariantCall::func_PackedVector3Array_transform, sarray("transform"), varray());
+
 	/* Color Array */
 
 	bind_method(PackedColorArray, size, sarray(), varray());
@@ -205,19 +205,19 @@ public:
 	}
 
 	_FORCE_INLINE_ static void init_transform2d(Variant *v) {
-		v->_data._transform2d = memnew(Transform2D);
+		v->_data._transform2d = Variant::_alloc_math(Transform2D());
 		v->type = Variant::TRANSFORM2D;
 	}
 	_FORCE_INLINE_ static void init_aabb(Variant *v) {
-		v->_data._aabb = memnew(AABB);
+		v->_data._aabb = Variant::_alloc_math(AABB());
 		v->type = Variant::AABB;
 	}
 	_FORCE_INLINE_ static void init_basis(Variant *v) {
-		v->_data._basis = memnew(Basis);
+		v->_data._basis = Variant::_alloc_math(Basis());
 		v->type = Variant::BASIS;
 	}
 	_FORCE_INLINE_ static void init_transform(Variant *v) {
-		v->_data._transform = memnew(Transform);
+		v->_data._transform = Variant::_alloc_math(Transform());
 		v->type = Variant::TRANSFORM;
 	}
 	_FORCE_INLINE_ static void init_string_name(Variant *v) {
@@ -34,6 +34,7 @@
 
 #include "core/config/project_settings.h"
 #include "core/os/os.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 #include <errno.h>
 
@@ -195,9 +196,7 @@ void AudioDriverALSA::thread_func(void *p_udata) {
 		} else {
 			ad->audio_server_process(ad->period_size, ad->samples_in.ptrw());
 
-			for (uint64_t i = 0; i < ad->period_size * ad->channels; i++) {
-				ad->samples_out.write[i] = ad->samples_in[i] >> 16;
-			}
+			AudioMixKernels::int32_to_int16(ad->samples_out.ptrw(), ad->samples_in.ptr(), ad->period_size * ad->channels);
 		}
 
 		int todo = ad->period_size;
@@ -34,6 +34,7 @@
 
 #include "core/config/project_settings.h"
 #include "core/os/os.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 #define kOutputBus 0
 #define kInputBus 1
@@ -189,9 +190,7 @@ OSStatus AudioDriverCoreAudio::output_callback(void *inRefCon,
 			unsigned int frames = MIN(frames_left, ad->buffer_frames);
 			ad->audio_server_process(frames, ad->samples_in.ptrw());
 
-			for (unsigned int j = 0; j < frames * ad->channels; j++) {
-				out[j] = ad->samples_in[j] >> 16;
-			}
+			AudioMixKernels::int32_to_int16(out, ad->samples_in.ptr(), frames * ad->channels);
 
 			frames_left -= frames;
 			out += frames * ad->channels;
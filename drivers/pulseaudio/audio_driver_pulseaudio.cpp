@@ -34,6 +34,7 @@
 
 #include "core/config/project_settings.h"
 #include "core/os/os.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 void AudioDriverPulseAudio::pa_state_cb(pa_context *c, void *userdata) {
 	AudioDriverPulseAudio *ad = (AudioDriverPulseAudio *)userdata;
@@ -381,9 +382,7 @@ void AudioDriverPulseAudio::thread_func(void *p_udata) {
 				ad->audio_server_process(ad->buffer_frames, ad->samples_in.ptrw());
 
 				if (ad->channels == ad->pa_map.channels) {
-					for (unsigned int i = 0; i < ad->pa_buffer_size; i++) {
-						ad->samples_out.write[i] = ad->samples_in[i] >> 16;
-					}
+					AudioMixKernels::int32_to_int16(ad->samples_out.ptrw(), ad->samples_in.ptr(), ad->pa_buffer_size);
 				} else {
 					// Uneven amount of channels
 					unsigned int in_idx = 0;
@@ -180,6 +180,10 @@ bool ResourceImporterScene::get_option_visibility(const String &p_option, const
 		return false;
 	}
 
+	if (p_option == "meshes/hlod_distance" && float(p_options["meshes/hlod_cluster_size"]) <= 0) {
+		return false;
+	}
+
 	return true;
 }
 
@@ -723,6 +727,7 @@ Node *ResourceImporterScene::_post_fix_node(Node *p_node, Node *p_root, Map<Ref<
 		float anim_optimizer_linerr = node_settings["optimizer/max_linear_error"];
 		float anim_optimizer_angerr = node_settings["optimizer/max_angular_error"];
 		float anim_optimizer_maxang = node_settings["optimizer/max_angle"];
+		bool use_compression = node_settings["compression/enabled"];
 
 		if (use_optimizer) {
 			_optimize_animations(ap, anim_optimizer_linerr, anim_optimizer_angerr, anim_optimizer_maxang);
@@ -752,8 +757,12 @@ Node *ResourceImporterScene::_post_fix_node(Node *p_node, Node *p_root, Map<Ref<
 		}
 
 		if (animation_clips.size()) {
-			_create_clips(ap, animation_clips, true);
+			_create_clips(ap, animation_clips, true, use_compression);
 		} else {
+			if (use_compression) {
+				_compress_animations(ap);
+			}
+
 			List<StringName> anims;
 			ap->get_animation_list(&anims);
 			for (List<StringName>::Element *E = anims.front(); E; E = E->next()) {
@@ -821,7 +830,7 @@ Ref<Animation> ResourceImporterScene::_save_animation_to_file(Ref<Animation> ani
 	return anim;
 }
 
-void ResourceImporterScene::_create_clips(AnimationPlayer *anim, const Array &p_clips, bool p_bake_all) {
+void ResourceImporterScene::_create_clips(AnimationPlayer *anim, const Array &p_clips, bool p_bake_all, bool p_compress) {
 	if (!anim->has_animation("default")) {
 		return;
 	}
@@ -922,6 +931,9 @@ void ResourceImporterScene::_create_clips(AnimationPlayer *anim, const Array &p_
 
 		new_anim->set_loop(loop);
 		new_anim->set_length(to - from);
+		if (p_compress) {
+			new_anim->compress();
+		}
 		anim->add_animation(name, new_anim);
 
 		Ref<Animation> saved_anim = _save_animation_to_file(new_anim, save_to_file, save_to_path, keep_current);
@@ -942,6 +954,15 @@ void ResourceImporterScene::_optimize_animations(AnimationPlayer *anim, float p_
 	}
 }
 
+void ResourceImporterScene::_compress_animations(AnimationPlayer *anim) {
+	List<StringName> anim_names;
+	anim->get_animation_list(&anim_names);
+	for (List<StringName>::Element *E = anim_names.front(); E; E = E->next()) {
+		Ref<Animation> a = anim->get_animation(E->get());
+		a->compress();
+	}
+}
+
 void ResourceImporterScene::get_internal_import_options(InternalImportCategory p_category, List<ImportOption> *r_options) const {
 	switch (p_category) {
 		case INTERNAL_IMPORT_CATEGORY_NODE: {
@@ -976,6 +997,7 @@ void ResourceImporterScene::get_internal_import_options(InternalImportCategory p
 			r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "optimizer/max_linear_error"), 0.05));
 			r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "optimizer/max_angular_error"), 0.01));
 			r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "optimizer/max_angle"), 22));
+			r_options->push_back(ImportOption(PropertyInfo(Variant::BOOL, "compression/enabled"), false));
 			r_options->push_back(ImportOption(PropertyInfo(Variant::INT, "slices/amount", PROPERTY_HINT_RANGE, "0,256,1", PROPERTY_USAGE_DEFAULT | PROPERTY_USAGE_UPDATE_ALL_IF_MODIFIED), 0));
 
 			for (int i = 0; i < 256; i++) {
@@ -1059,6 +1081,8 @@ void ResourceImporterScene::get_import_options(List<ImportOption> *r_options, in
 	r_options->push_back(ImportOption(PropertyInfo(Variant::BOOL, "meshes/create_shadow_meshes"), true));
 	r_options->push_back(ImportOption(PropertyInfo(Variant::INT, "meshes/light_baking", PROPERTY_HINT_ENUM, "Disabled,Dynamic,Static,Static Lightmaps", PROPERTY_USAGE_DEFAULT | PROPERTY_USAGE_UPDATE_ALL_IF_MODIFIED), 2));
 	r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "meshes/lightmap_texel_size", PROPERTY_HINT_RANGE, "0.001,100,0.001"), 0.1));
+	r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "meshes/hlod_cluster_size", PROPERTY_HINT_RANGE, "0,1000,0.01,or_greater", PROPERTY_USAGE_DEFAULT | PROPERTY_USAGE_UPDATE_ALL_IF_MODIFIED), 0.0));
+	r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "meshes/hlod_distance", PROPERTY_HINT_RANGE, "0.01,10000,0.01,or_greater"), 100.0));
 	r_options->push_back(ImportOption(PropertyInfo(Variant::BOOL, "skins/use_named_skins"), true));
 	r_options->push_back(ImportOption(PropertyInfo(Variant::BOOL, "animation/import"), true));
 	r_options->push_back(ImportOption(PropertyInfo(Variant::FLOAT, "animation/fps", PROPERTY_HINT_RANGE, "1,120,1"), 15));
@@ -1290,6 +1314,101 @@ void ResourceImporterScene::_generate_meshes(Node *p_node, const Dictionary &p_m
 	}
 }
 
+void ResourceImporterScene::_generate_hlod(Node *p_scene, float p_cluster_size, float p_distance) {
+	struct Source {
+		MeshInstance3D *node = nullptr;
+		Transform xform; // Relative to the scene root, where the proxies are added.
+	};
+
+	// Static meshes are grouped by the cell of a regular grid their center falls in.
+	Map<Vector3i, Vector<Source>> clusters;
+
+	List<Node *> nodes;
+	nodes.push_back(p_scene);
+	while (nodes.size()) {
+		Node *node = nodes.front()->get();
+		nodes.pop_front();
+		for (int i = 0; i < node->get_child_count(); i++) {
+			nodes.push_back(node->get_child(i));
+		}
+
+		MeshInstance3D *mesh_node = Object::cast_to<MeshInstance3D>(node);
+		if (!mesh_node || mesh_node->get_mesh().is_null() || mesh_node->get_skin().is_valid() || !mesh_node->get_lod_proxy().is_empty()) {
+			continue;
+		}
+
+		Ref<Mesh> mesh = mesh_node->get_mesh();
+		bool mergeable = mesh->get_blend_shape_count() == 0;
+		for (int i = 0; i < mesh->get_surface_count(); i++) {
+			if (mesh->surface_get_primitive_type(i) != Mesh::PRIMITIVE_TRIANGLES) {
+				mergeable = false;
+			}
+		}
+		if (!mergeable) {
+			continue;
+		}
+
+		Source source;
+		source.node = mesh_node;
+		Node3D *n = mesh_node;
+		while (n && n != p_scene) {
+			source.xform = n->get_transform() * source.xform;
+			n = n->get_parent_spatial();
+		}
+
+		AABB aabb = source.xform.xform(mesh->get_aabb());
+		Vector3i cell = ((aabb.position + aabb.size * 0.5) / p_cluster_size).floor();
+		clusters[cell].push_back(source);
+	}
+
+	int proxy_count = 0;
+	for (Map<Vector3i, Vector<Source>>::Element *E = clusters.front(); E; E = E->next()) {
+		const Vector<Source> &sources = E->get();
+		if (sources.size() < 2) {
+			continue; // Replacing a single mesh saves nothing its own LODs don't.
+		}
+
+		// Surfaces are merged by material, so the proxy costs one draw call per material.
+		Vector<Ref<Material>> materials;
+		Vector<Ref<SurfaceTool>> surface_tools;
+		for (int i = 0; i < sources.size(); i++) {
+			Ref<Mesh> mesh = sources[i].node->get_mesh();
+			for (int j = 0; j < mesh->get_surface_count(); j++) {
+				Ref<Material> material = sources[i].node->get_active_material(j);
+				int idx = materials.find(material);
+				if (idx == -1) {
+					idx = materials.size();
+					materials.push_back(material);
+					Ref<SurfaceTool> st;
+					st.instance();
+					surface_tools.push_back(st);
+				}
+				surface_tools.write[idx]->append_from(mesh, j, sources[i].xform);
+			}
+		}
+
+		Ref<EditorSceneImporterMesh> proxy_mesh;
+		proxy_mesh.instance();
+		for (int i = 0; i < materials.size(); i++) {
+			proxy_mesh->add_surface(Mesh::PRIMITIVE_TRIANGLES, surface_tools.write[i]->commit_to_arrays(), Array(), Dictionary(), materials[i]);
+		}
+		// The proxy is only seen from far away, so it always gets simplified LODs.
+		proxy_mesh->generate_lods();
+
+		MeshInstance3D *proxy = memnew(MeshInstance3D);
+		proxy->set_name("HLOD" + itos(proxy_count++));
+		proxy->set_mesh(proxy_mesh->get_mesh());
+		proxy->set_gi_mode(sources[0].node->get_gi_mode());
+		proxy->set_lod_min_distance(p_distance);
+		p_scene->add_child(proxy, true);
+		proxy->set_owner(p_scene);
+
+		for (int i = 0; i < sources.size(); i++) {
+			sources[i].node->set_lod_proxy(sources[i].node->get_path_to(proxy));
+		}
+	}
+}
+
 void ResourceImporterScene::_add_shapes(Node *p_node, const List<Ref<Shape3D>> &p_shapes) {
 	for (const List<Ref<Shape3D>>::Element *E = p_shapes.front(); E; E = E->next()) {
 		CollisionShape3D *cshape = memnew(CollisionShape3D);
@@ -1469,6 +1588,11 @@ Error ResourceImporterScene::import(const String &p_source_file, const String &p
 	}
 	_generate_meshes(scene, mesh_data, gen_lods, create_shadow_meshes, LightBakeMode(light_bake_mode), lightmap_texel_size, src_lightmap_cache, mesh_lightmap_caches);
 
+	float hlod_cluster_size = p_options["meshes/hlod_cluster_size"];
+	if (hlod_cluster_size > 0) {
+		_generate_hlod(scene, hlod_cluster_size, p_options["meshes/hlod_distance"]);
+	}
+
 	if (mesh_lightmap_caches.size()) {
 		FileAccessRef f = FileAccess::open(p_source_file + ".unwrap_cache", FileAccess::WRITE);
 		if (f) {
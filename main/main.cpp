@@ -58,10 +58,14 @@
 #include "modules/modules_enabled.gen.h"
 #include "modules/register_module_types.h"
 #include "platform/register_platform_apis.h"
+#include "scene/main/canvas_item.h"
 #include "scene/main/scene_tree.h"
 #include "scene/main/window.h"
 #include "scene/register_scene_types.h"
+#include "scene/resources/material.h"
 #include "scene/resources/packed_scene.h"
+#include "scene/resources/particles_material.h"
+#include "scene/resources/shader.h"
 #include "servers/audio_server.h"
 #include "servers/camera_server.h"
 #include "servers/display_server.h"
@@ -195,6 +199,112 @@ static String get_full_version_string() {
 	return String(VERSION_FULL_BUILD) + hash;
 }
 
+// Collects p_value and every resource stored in it, so built-in shaders and materials
+// of scenes and other resources are found too.
+static void collect_stored_resources(const Variant &p_value, Set<RES> &r_resources) {
+	switch (p_value.get_type()) {
+		case Variant::OBJECT: {
+			RES res = p_value;
+			if (res.is_null() || r_resources.has(res)) {
+				return;
+			}
+			r_resources.insert(res);
+
+			List<PropertyInfo> plist;
+			res->get_property_list(&plist);
+			for (List<PropertyInfo>::Element *E = plist.front(); E; E = E->next()) {
+				const PropertyInfo &pi = E->get();
+				if ((pi.usage & PROPERTY_USAGE_STORAGE) && (pi.type == Variant::OBJECT || pi.type == Variant::ARRAY || pi.type == Variant::DICTIONARY)) {
+					collect_stored_resources(res->get(pi.name), r_resources);
+				}
+			}
+		} break;
+		case Variant::ARRAY: {
+			Array array = p_value;
+			for (int i = 0; i < array.size(); i++) {
+				collect_stored_resources(array[i], r_resources);
+			}
+		} break;
+		case Variant::DICTIONARY: {
+			Dictionary dict = p_value;
+			List<Variant> keys;
+			dict.get_key_list(&keys);
+			for (List<Variant>::Element *E = keys.front(); E; E = E->next()) {
+				collect_stored_resources(E->get(), r_resources);
+				collect_stored_resources(dict[E->get()], r_resources);
+			}
+		} break;
+		default:
+			break;
+	}
+}
+
+// Loads every resource in p_dir and its subdirectories that may own a shader, and makes
+// the renderer compile the shaders of all shaders and materials found, which stores them
+// in the shader cache. Returns how many shaders and materials were found.
+static int prepopulate_shader_cache(const String &p_dir) {
+	DirAccessRef da = DirAccess::open(p_dir);
+	ERR_FAIL_COND_V(!da, 0);
+
+	// Leaf resources that can't own a shader, not worth loading.
+	static const char *skip_types[] = { "Texture", "AudioStream", "Script", "Translation", "Font", nullptr };
+
+	int count = 0;
+	da->list_dir_begin();
+	for (String file = da->get_next(); file != ""; file = da->get_next()) {
+		if (file.begins_with(".")) {
+			continue; // Also skips the project's metadata and import folders.
+		}
+
+		String path = p_dir.plus_file(file);
+		if (da->current_is_dir()) {
+			count += prepopulate_shader_cache(path);
+			continue;
+		}
+
+		String type = ResourceLoader::get_resource_type(path);
+		if (type == "") {
+			continue;
+		}
+		bool skip = false;
+		for (int i = 0; skip_types[i]; i++) {
+			skip = skip || ClassDB::is_parent_class(type, skip_types[i]);
+		}
+		if (skip) {
+			continue;
+		}
+
+		RES res = ResourceLoader::load(path);
+		if (res.is_null()) {
+			continue;
+		}
+
+		Set<RES> resources;
+		collect_stored_resources(res, resources);
+
+		// Built-in materials generate their shaders when flushed, which usually happens on idle.
+		BaseMaterial3D::flush_changes();
+		ParticlesMaterial::flush_changes();
+		CanvasItemMaterial::flush_changes();
+
+		for (Set<RES>::Element *E = resources.front(); E; E = E->next()) {
+			Ref<Shader> shader = E->get();
+			if (shader.is_valid()) {
+				shader->get_rid(); // Visual shaders generate their code on demand.
+				count++;
+				continue;
+			}
+			Ref<Material> material = E->get();
+			if (material.is_valid() && material->get_shader_rid().is_valid()) {
+				count++;
+			}
+		}
+	}
+	da->list_dir_end();
+
+	return count;
+}
+
 // FIXME: Could maybe be moved to PhysicsServer3DManager and PhysicsServer2DManager directly
 // to have less code in main.cpp.
 void initialize_physics() {
@@ -360,6 +470,7 @@ void Main::print_help(const char *p_binary) {
 	OS::get_singleton()->print("Standalone tools:\n");
 	OS::get_singleton()->print("  -s, --script <script>                        Run a script.\n");
 	OS::get_singleton()->print("  --check-only                                 Only parse for errors and quit (use with --script).\n");
+	OS::get_singleton()->print("  --prepopulate-shader-cache                   Compile the engine's and the project's shaders into the shader cache, then quit.\n");
 #ifdef TOOLS_ENABLED
 	OS::get_singleton()->print("  --export <preset> <path>                     Export the project using the given preset and matching release template. The preset name should match one defined in export_presets.cfg.\n");
 	OS::get_singleton()->print("                                               <path> should be absolute or relative to the project directory, and include the filename for the binary (e.g. 'builds/game.exe'). The target directory should exist.\n");
@@ -1837,6 +1948,7 @@ bool Main::start() {
 	String game_path;
 	String script;
 	bool check_only = false;
+	bool shader_cache_only = false;
 
 #ifdef TOOLS_ENABLED
 	bool doc_base = true;
@@ -1854,6 +1966,8 @@ bool Main::start() {
 		// Designed to override and pass arguments to the unit test handler.
 		if (args[i] == "--check-only") {
 			check_only = true;
+		} else if (args[i] == "--prepopulate-shader-cache") {
+			shader_cache_only = true;
 #ifdef TOOLS_ENABLED
 		} else if (args[i] == "--no-docbase") {
 			doc_base = false;
@@ -1995,6 +2109,15 @@ bool Main::start() {
 
 #endif
 
+	if (shader_cache_only) {
+		// The engine's shaders were compiled, and cached, when the renderer was set up.
+		ERR_FAIL_COND_V_MSG(!GLOBAL_GET("rendering/shader_compiler/shader_cache/enabled"), false, "The shader cache is disabled in the project settings.");
+		int count = prepopulate_shader_cache("res://");
+		RenderingServer::get_singleton()->sync();
+		print_line(vformat("Shader cache prepopulated with the engine's shaders and %d project shaders and materials.", count));
+		return false;
+	}
+
 	if (script == "" && game_path == "" && String(GLOBAL_GET("application/run/main_scene")) != "") {
 		game_path = GLOBAL_GET("application/run/main_scene");
 	}
@@ -1790,6 +1790,7 @@ Error GDScriptLanguage::execute_file(const String &p_path) {
 }
 
 void GDScriptLanguage::finish() {
+	profiling_sampler_stop();
 }
 
 void GDScriptLanguage::profiling_start() {
@@ -1870,6 +1871,135 @@ int GDScriptLanguage::profiling_get_frame_data(ProfilingInfo *p_info_arr, int p_
 	return current;
 }
 
+int GDScriptLanguage::_get_function_state_stack_class(uint32_t p_size) {
+	if (p_size > 1u << (FUNCTION_STATE_STACK_MIN_SHIFT + FUNCTION_STATE_STACK_SIZE_CLASSES - 1)) {
+		return -1;
+	}
+	return get_shift_from_power_of_2(next_power_of_2(MAX(p_size, 1u << FUNCTION_STATE_STACK_MIN_SHIFT))) - FUNCTION_STATE_STACK_MIN_SHIFT;
+}
+
+void GDScriptLanguage::_acquire_function_state_stack(Vector<uint8_t> &r_stack, uint32_t p_size) {
+	int size_class = _get_function_state_stack_class(p_size);
+	if (size_class < 0) {
+		r_stack.resize(p_size);
+		return;
+	}
+
+	FunctionStateStackPool &pool = function_state_stack_pools[size_class];
+	pool.lock.lock();
+	if (pool.count) {
+		r_stack = std::move(pool.stacks[--pool.count]);
+		pool.lock.unlock();
+		return;
+	}
+	pool.lock.unlock();
+
+	r_stack.resize(1 << (FUNCTION_STATE_STACK_MIN_SHIFT + size_class));
+}
+
+void GDScriptLanguage::_release_function_state_stack(Vector<uint8_t> &p_stack) {
+	int size_class = _get_function_state_stack_class(p_stack.size());
+	// Only stacks that came from a pool have the exact size of their class.
+	if (size_class >= 0 && p_stack.size() == 1 << (FUNCTION_STATE_STACK_MIN_SHIFT + size_class)) {
+		FunctionStateStackPool &pool = function_state_stack_pools[size_class];
+		pool.lock.lock();
+		if (pool.count < MAX_POOLED_FUNCTION_STATE_STACKS) {
+			pool.stacks[pool.count++] = std::move(p_stack);
+		}
+		pool.lock.unlock();
+	}
+
+	// Freed outside the lock when the pool is full.
+	p_stack.clear();
+}
+
+#ifdef DEBUG_ENABLED
+void GDScriptLanguage::_sampler_thread_func(void *p_userdata) {
+	GDScriptLanguage *lang = (GDScriptLanguage *)p_userdata;
+	while (!lang->sampler_exit.is_set()) {
+		OS::get_singleton()->delay_usec(lang->sampler_interval_usec);
+		lang->_sampler_take_sample();
+	}
+}
+
+void GDScriptLanguage::_sampler_take_sample() {
+	// Holding the lock keeps functions from being freed while their signature is read.
+	// Frames below the published depth belong to functions that are still running.
+	MutexLock lock(this->lock);
+
+	// The main thread may push or pop frames meanwhile, so a sample can mix two
+	// consecutive stacks; that is fine for statistics.
+	int depth = sampler_depth.get();
+	if (depth <= 0) {
+		return;
+	}
+
+	String stack;
+	for (int i = 0; i < depth; i++) {
+		GDScriptFunction *function = sampler_frames[i].function.get();
+		if (!function) {
+			continue;
+		}
+		if (!stack.is_empty()) {
+			stack += ";";
+		}
+		stack += String(function->profile.signature) + ":" + itos(sampler_frames[i].line.get());
+	}
+
+	if (stack.is_empty()) {
+		return;
+	}
+
+	Map<String, uint64_t>::Element *E = sampler_stacks.find(stack);
+	if (E) {
+		E->get()++;
+	} else {
+		sampler_stacks.insert(stack, 1);
+	}
+}
+#endif
+
+void GDScriptLanguage::profiling_sampler_start(uint64_t p_interval_usec) {
+#ifdef DEBUG_ENABLED
+	if (sampler_thread.is_started()) {
+		return;
+	}
+
+	{
+		MutexLock lock(this->lock);
+		sampler_stacks.clear();
+	}
+
+	sampler_interval_usec = MAX(p_interval_usec, (uint64_t)1);
+	sampler_exit.clear();
+	sampler_thread.start(_sampler_thread_func, this);
+#endif
+}
+
+void GDScriptLanguage::profiling_sampler_stop() {
+#ifdef DEBUG_ENABLED
+	if (!sampler_thread.is_started()) {
+		return;
+	}
+
+	sampler_exit.set();
+	sampler_thread.wait_to_finish();
+#endif
+}
+
+void GDScriptLanguage::profiling_sampler_get_data(List<ProfilingSample> *r_samples) {
+#ifdef DEBUG_ENABLED
+	MutexLock lock(this->lock);
+
+	for (const Map<String, uint64_t>::Element *E = sampler_stacks.front(); E; E = E->next()) {
+		ProfilingSample sample;
+		sample.stack = E->key();
+		sample.count = E->get();
+		r_samples->push_back(sample);
+	}
+#endif
+}
+
 struct GDScriptDepSort {
 	//must support sorting so inheritance works properly (parent must be reloaded first)
 	bool operator()(const Ref<GDScript> &A, const Ref<GDScript> &B) const {
@@ -2280,6 +2410,9 @@ GDScriptLanguage::GDScriptLanguage() {
 	}
 
 #ifdef DEBUG_ENABLED
+	sampler_max_depth = dmcs;
+	sampler_frames = memnew_arr(SamplerFrame, sampler_max_depth);
+
 	GLOBAL_DEF("debug/gdscript/warnings/enable", true);
 	GLOBAL_DEF("debug/gdscript/warnings/treat_warnings_as_errors", false);
 	GLOBAL_DEF("debug/gdscript/warnings/exclude_addons", true);
@@ -2293,9 +2426,14 @@ GDScriptLanguage::GDScriptLanguage() {
 }
 
 GDScriptLanguage::~GDScriptLanguage() {
+	profiling_sampler_stop();
+
 	if (_call_stack) {
 		memdelete_arr(_call_stack);
 	}
+#ifdef DEBUG_ENABLED
+	memdelete_arr(sampler_frames);
+#endif
 
 	// Clear dependencies between scripts, to ensure cyclic references are broken (to avoid leaks at exit).
 	SelfList<GDScript> *s = script_list.first();
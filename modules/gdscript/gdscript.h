@@ -37,6 +37,9 @@
 #include "core/io/resource_loader.h"
 #include "core/io/resource_saver.h"
 #include "core/object/script_language.h"
+#include "core/os/thread.h"
+#include "core/os/spin_lock.h"
+#include "core/templates/safe_refcount.h"
 #include "gdscript_function.h"
 
 class GDScriptNativeClass : public Reference {
@@ -363,9 +366,52 @@ class GDScriptLanguage : public ScriptLanguage {
 	friend class GDScriptFunction;
 
 	SelfList<GDScriptFunction>::List function_list;
+
+	// Stacks of finished GDScriptFunctionStates, recycled for the next await. Sizes are rounded up
+	// to a power of two, and each size class holds a bounded number of stacks behind its own lock,
+	// so awaiting never waits on the language lock.
+	enum {
+		FUNCTION_STATE_STACK_MIN_SHIFT = 6, // 64 bytes.
+		FUNCTION_STATE_STACK_SIZE_CLASSES = 10, // Up to 32 KiB, larger stacks aren't pooled.
+		MAX_POOLED_FUNCTION_STATE_STACKS = 64, // Per size class.
+	};
+	struct FunctionStateStackPool {
+		SpinLock lock;
+		uint32_t count = 0;
+		Vector<uint8_t> stacks[MAX_POOLED_FUNCTION_STATE_STACKS];
+	};
+	FunctionStateStackPool function_state_stack_pools[FUNCTION_STATE_STACK_SIZE_CLASSES];
+
+	static int _get_function_state_stack_class(uint32_t p_size);
+	void _acquire_function_state_stack(Vector<uint8_t> &r_stack, uint32_t p_size);
+	void _release_function_state_stack(Vector<uint8_t> &p_stack);
+
 	bool profiling;
 	uint64_t script_frame_time;
 
+#ifdef DEBUG_ENABLED
+	// Sampling profiler. A separate thread periodically snapshots the debug
+	// call stack, so it only sees script frames while the debugger is active.
+	// The main thread publishes each frame's function and current line with
+	// atomics, as the sampler can't read _call_stack or the VM's locals.
+	struct SamplerFrame {
+		SafeNumeric<GDScriptFunction *> function;
+		SafeNumeric<int> line;
+	};
+
+	SamplerFrame *sampler_frames = nullptr;
+	int sampler_max_depth = 0;
+	SafeNumeric<int> sampler_depth;
+
+	Thread sampler_thread;
+	SafeFlag sampler_exit;
+	uint64_t sampler_interval_usec = 1000;
+	Map<String, uint64_t> sampler_stacks;
+
+	static void _sampler_thread_func(void *p_userdata);
+	void _sampler_take_sample();
+#endif
+
 	Map<String, ObjectID> orphan_subclasses;
 
 public:
@@ -396,6 +442,10 @@ public:
 		_call_stack[_debug_call_stack_pos].ip = p_ip;
 		_call_stack[_debug_call_stack_pos].line = p_line;
 		_debug_call_stack_pos++;
+
+#ifdef DEBUG_ENABLED
+		sampler_push_frame(p_function, *p_line);
+#endif
 	}
 
 	_FORCE_INLINE_ void exit_function() {
@@ -414,8 +464,43 @@ public:
 		}
 
 		_debug_call_stack_pos--;
+
+#ifdef DEBUG_ENABLED
+		sampler_pop_frame();
+#endif
 	}
 
+#ifdef DEBUG_ENABLED
+	// Only to be called from the main thread.
+	_FORCE_INLINE_ void sampler_push_frame(GDScriptFunction *p_function, int p_line) {
+		int depth = sampler_depth.get();
+		if (depth >= sampler_max_depth) {
+			return;
+		}
+		sampler_frames[depth].function.set(p_function);
+		sampler_frames[depth].line.set(p_line);
+		sampler_depth.set(depth + 1);
+	}
+
+	_FORCE_INLINE_ void sampler_pop_frame() {
+		int depth = sampler_depth.get();
+		if (depth > 0) {
+			sampler_depth.set(depth - 1);
+		}
+	}
+
+	_FORCE_INLINE_ void sampler_set_line(int p_line) {
+		if (Thread::get_main_id() != Thread::get_caller_id()) {
+			return;
+		}
+
+		int depth = sampler_depth.get();
+		if (depth > 0) {
+			sampler_frames[depth - 1].line.set(p_line);
+		}
+	}
+#endif
+
 	virtual Vector<StackInfo> debug_get_current_stack_info() {
 		if (Thread::get_main_id() != Thread::get_caller_id()) {
 			return Vector<StackInfo>();
@@ -513,6 +598,10 @@ public:
 	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr, int p_info_max);
 	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr, int p_info_max);
 
+	virtual void profiling_sampler_start(uint64_t p_interval_usec);
+	virtual void profiling_sampler_stop();
+	virtual void profiling_sampler_get_data(List<ProfilingSample> *r_samples);
+
 	/* LOADER FUNCTIONS */
 
 	virtual void get_recognized_extensions(List<String> *p_extensions) const;
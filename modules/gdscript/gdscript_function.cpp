@@ -308,4 +308,6 @@ GDScriptFunctionState::~GDScriptFunctionState() {
 		scripts_list.remove_from_list();
 		instances_list.remove_from_list();
 	}
+
+	GDScriptLanguage::singleton->_release_function_state_stack(state.stack);
 }
@@ -629,7 +629,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					}
 					OPCODE_BREAK;
 				}
-				*dst = ret;
+				*dst = std::move(ret);
 #endif
 				ip += 5;
 			}
@@ -855,7 +855,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					err_text = "Invalid get index " + v + " (on base: '" + _get_var_type(src) + "').";
 					OPCODE_BREAK;
 				}
-				*dst = ret;
+				*dst = std::move(ret);
 #endif
 				ip += 4;
 			}
@@ -891,7 +891,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					err_text = "Invalid get index " + v + " (on base: '" + _get_var_type(src) + "').";
 					OPCODE_BREAK;
 				}
-				*dst = ret;
+				*dst = std::move(ret);
 #endif
 				ip += 5;
 			}
@@ -997,7 +997,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					}
 					OPCODE_BREAK;
 				}
-				*dst = ret;
+				*dst = std::move(ret);
 #endif
 				ip += 4;
 			}
@@ -2093,10 +2093,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					Ref<GDScriptFunctionState> gdfs = memnew(GDScriptFunctionState);
 					gdfs->function = this;
 
-					gdfs->state.stack.resize(alloca_size);
-					//copy variant stack
-					for (int i = 0; i < _stack_size; i++) {
-						memnew_placement(&gdfs->state.stack.write[sizeof(Variant) * i], Variant(stack[i]));
+					GDScriptLanguage::get_singleton()->_acquire_function_state_stack(gdfs->state.stack, alloca_size);
+					// Move the variant stack into the state. Variants are relocatable, so they are
+					// transferred bitwise and the old slots are left as nil for the cleanup on exit.
+					if (_stack_size) {
+						memcpy((void *)gdfs->state.stack.ptrw(), (const void *)stack, sizeof(Variant) * _stack_size);
+						for (int i = 0; i < _stack_size; i++) {
+							memnew_placement(&stack[i], Variant);
+						}
 					}
 					gdfs->state.stack_size = _stack_size;
 					gdfs->state.alloca_size = alloca_size;
@@ -3216,6 +3220,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				ip += 2;
 
 				if (EngineDebugger::is_active()) {
+#ifdef DEBUG_ENABLED
+					GDScriptLanguage::get_singleton()->sampler_set_line(line);
+#endif
+
 					// line
 					bool do_break = false;
 
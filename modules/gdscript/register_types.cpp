@@ -178,8 +178,13 @@ void test_bytecode() {
 	GDScriptTests::test(GDScriptTests::TestType::TEST_BYTECODE);
 }
 
+void test_await_benchmark() {
+	GDScriptTests::test_await_benchmark();
+}
+
 REGISTER_TEST_COMMAND("gdscript-tokenizer", &test_tokenizer);
 REGISTER_TEST_COMMAND("gdscript-parser", &test_parser);
 REGISTER_TEST_COMMAND("gdscript-compiler", &test_compiler);
 REGISTER_TEST_COMMAND("gdscript-bytecode", &test_bytecode);
+REGISTER_TEST_COMMAND("gdscript-await-benchmark", &test_await_benchmark);
 #endif
@@ -248,4 +248,55 @@ void test(TestType p_type) {
 
 	finish_language();
 }
+
+static const char *await_benchmark_source =
+		"extends Reference\n"
+		"signal tick\n"
+		"func worker(p_resumes):\n"
+		"\tvar a = 0\n"
+		"\tfor i in p_resumes:\n"
+		"\t\tawait tick\n"
+		"\t\ta += i\n"
+		"\treturn a\n";
+
+void test_await_benchmark() {
+	const int coroutines = 10000;
+	const int resumes = 100;
+
+	init_language(OS::get_singleton()->get_executable_path().get_base_dir());
+
+	Ref<GDScript> script;
+	script.instance();
+	script->set_source_code(await_benchmark_source);
+	Error err = script->reload();
+	if (err != OK) {
+		print_line("Error compiling the await benchmark script.");
+		finish_language();
+		return;
+	}
+
+	Ref<Reference> obj;
+	obj.instance();
+	obj->set_script(script);
+
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < coroutines; i++) {
+		obj->call("worker", resumes);
+	}
+	uint64_t suspend_time = OS::get_singleton()->get_ticks_usec() - start;
+
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < resumes; i++) {
+		obj->emit_signal("tick");
+	}
+	uint64_t resume_time = OS::get_singleton()->get_ticks_usec() - start;
+
+	print_line(vformat("Started %d coroutines in %d usec.", coroutines, suspend_time));
+	print_line(vformat("Resumed %d coroutines %d times in %d usec (%.1f ns per resume/suspend).", coroutines, resumes, resume_time, resume_time * 1000.0 / (double(coroutines) * resumes)));
+
+	obj->set_script(Variant());
+	obj.unref();
+	script.unref();
+	finish_language();
+}
 } // namespace GDScriptTests
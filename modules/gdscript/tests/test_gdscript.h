@@ -44,6 +44,7 @@ enum TestType {
 };
 
 void test(TestType p_type);
+void test_await_benchmark();
 
 } // namespace GDScriptTests
 
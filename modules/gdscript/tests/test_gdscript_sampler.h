@@ -0,0 +1,105 @@
+/*************************************************************************/
+/*  test_gdscript_sampler.h                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_GDSCRIPT_SAMPLER_H
+#define TEST_GDSCRIPT_SAMPLER_H
+
+#include "../gdscript.h"
+#include "core/os/os.h"
+#include "tests/test_macros.h"
+
+namespace GDScriptTests {
+
+#ifdef DEBUG_ENABLED
+
+static List<ScriptLanguage::ProfilingSample> sample_published_stack() {
+	GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+	language->profiling_sampler_start(100);
+	OS::get_singleton()->delay_usec(50000);
+	language->profiling_sampler_stop();
+
+	List<ScriptLanguage::ProfilingSample> samples;
+	language->profiling_sampler_get_data(&samples);
+	return samples;
+}
+
+TEST_CASE("[Modules][GDScript] Sampling profiler exports collapsed stacks") {
+	Ref<GDScript> gdscript = memnew(GDScript);
+	gdscript->set_source_code(R"(
+extends Reference
+
+func outer():
+	inner()
+
+func inner():
+	pass
+)");
+	ERR_PRINT_OFF;
+	const Error error = gdscript->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should parse successfully.");
+
+	const Map<StringName, GDScriptFunction *> &functions = gdscript->get_member_functions();
+	REQUIRE(functions.has("outer"));
+	REQUIRE(functions.has("inner"));
+
+	// Publish frames the way the VM does when entering functions and running lines.
+	GDScriptLanguage *language = GDScriptLanguage::get_singleton();
+	language->sampler_push_frame(functions.find("outer")->get(), 4);
+	language->sampler_push_frame(functions.find("inner")->get(), 7);
+	language->sampler_set_line(8);
+
+	List<ScriptLanguage::ProfilingSample> samples = sample_published_stack();
+	REQUIRE_MESSAGE(samples.size() == 1, "Every sample should collapse to the same stack.");
+	String stack = samples.front()->get().stack;
+	CHECK(samples.front()->get().count > 0);
+	CHECK_MESSAGE(stack.get_slice_count(";") == 2, "Frames should be separated by ';'.");
+	CHECK_MESSAGE(stack.get_slice(";", 0).ends_with("outer:4"), "The outermost frame should come first, with its call line.");
+	CHECK_MESSAGE(stack.get_slice(";", 1).ends_with("inner:8"), "The innermost frame should report its current line.");
+
+	language->sampler_pop_frame();
+
+	samples = sample_published_stack();
+	REQUIRE(samples.size() == 1);
+	stack = samples.front()->get().stack;
+	CHECK_MESSAGE(stack.get_slice_count(";") == 1, "Popped frames should not be sampled.");
+	CHECK(stack.ends_with("outer:4"));
+
+	language->sampler_pop_frame();
+
+	samples = sample_published_stack();
+	CHECK_MESSAGE(samples.is_empty(), "Nothing should be sampled outside of script code.");
+}
+
+#endif // DEBUG_ENABLED
+
+} // namespace GDScriptTests
+
+#endif // TEST_GDSCRIPT_SAMPLER_H
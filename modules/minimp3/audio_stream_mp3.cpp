@@ -37,81 +37,46 @@
 
 #include "core/os/file_access.h"
 
-void AudioStreamPlaybackMP3::_mix_internal(AudioFrame *p_buffer, int p_frames) {
-	ERR_FAIL_COND(!active);
+int AudioStreamPlaybackMP3::_decode(AudioFrame *p_buffer, int p_frames) {
+	int mixed = 0;
 
-	int todo = p_frames;
-
-	while (todo && active) {
+	while (mixed < p_frames) {
 		mp3dec_frame_info_t frame_info;
 		mp3d_sample_t *buf_frame = nullptr;
 
 		int samples_mixed = mp3dec_ex_read_frame(mp3d, &buf_frame, &frame_info, mp3_stream->channels);
-
-		if (samples_mixed) {
-			p_buffer[p_frames - todo] = AudioFrame(buf_frame[0], buf_frame[samples_mixed - 1]);
-			--todo;
-			++frames_mixed;
-		}
-
-		else {
+		if (!samples_mixed) {
 			//EOF
-			if (mp3_stream->loop) {
-				seek(mp3_stream->loop_offset);
-				loops++;
-			} else {
-				//fill remainder with silence
-				for (int i = p_frames - todo; i < p_frames; i++) {
-					p_buffer[i] = AudioFrame(0, 0);
-				}
-				active = false;
-				todo = 0;
-			}
+			break;
 		}
+		p_buffer[mixed++] = AudioFrame(buf_frame[0], buf_frame[samples_mixed - 1]);
 	}
-}
-
-float AudioStreamPlaybackMP3::get_stream_sampling_rate() {
-	return mp3_stream->sample_rate;
-}
 
-void AudioStreamPlaybackMP3::start(float p_from_pos) {
-	active = true;
-	seek(p_from_pos);
-	loops = 0;
-	_begin_resample();
+	return mixed;
 }
 
-void AudioStreamPlaybackMP3::stop() {
-	active = false;
+void AudioStreamPlaybackMP3::_decoder_seek(uint32_t p_frame) {
+	mp3dec_ex_seek(mp3d, uint64_t(p_frame) * mp3_stream->channels);
 }
 
-bool AudioStreamPlaybackMP3::is_playing() const {
-	return active;
+float AudioStreamPlaybackMP3::_get_length() const {
+	return mp3_stream->length;
 }
 
-int AudioStreamPlaybackMP3::get_loop_count() const {
-	return loops;
+float AudioStreamPlaybackMP3::_get_sample_rate() const {
+	return mp3_stream->sample_rate;
 }
 
-float AudioStreamPlaybackMP3::get_playback_position() const {
-	return float(frames_mixed) / mp3_stream->sample_rate;
+bool AudioStreamPlaybackMP3::_has_loop() const {
+	return mp3_stream->loop;
 }
 
-void AudioStreamPlaybackMP3::seek(float p_time) {
-	if (!active) {
-		return;
-	}
-
-	if (p_time >= mp3_stream->get_length()) {
-		p_time = 0;
-	}
-
-	frames_mixed = uint32_t(mp3_stream->sample_rate * p_time);
-	mp3dec_ex_seek(mp3d, frames_mixed * mp3_stream->channels);
+float AudioStreamPlaybackMP3::_get_loop_offset() const {
+	return mp3_stream->loop_offset;
 }
 
 AudioStreamPlaybackMP3::~AudioStreamPlaybackMP3() {
+	_stop_prefetch();
 	if (mp3d) {
 		mp3dec_ex_close(mp3d);
 		memfree(mp3d);
@@ -132,13 +97,10 @@ Ref<AudioStreamPlayback> AudioStreamMP3::instance_playback() {
 
 	int errorcode = mp3dec_ex_open_buf(mp3s->mp3d, (const uint8_t *)data, data_len, MP3D_SEEK_TO_SAMPLE);
 
-	mp3s->frames_mixed = 0;
-	mp3s->active = false;
-	mp3s->loops = 0;
-
 	if (errorcode) {
 		ERR_FAIL_COND_V(errorcode, Ref<AudioStreamPlaybackMP3>());
 	}
+	mp3s->_setup_source(get_instance_id());
 
 	return mp3s;
 }
@@ -170,6 +132,7 @@ void AudioStreamMP3::set_data(const Vector<uint8_t> &p_data) {
 	mp3dec_ex_close(&mp3d);
 
 	clear_data();
+	AudioDecodedCache::erase(get_instance_id());
 
 	data = memalloc(src_data_len);
 	memcpy(data, src_datar, src_data_len);
@@ -229,5 +192,6 @@ AudioStreamMP3::AudioStreamMP3() {
 }
 
 AudioStreamMP3::~AudioStreamMP3() {
+	AudioDecodedCache::erase(get_instance_id());
 	clear_data();
 }
@@ -33,37 +33,31 @@
 
 #include "core/io/resource_loader.h"
 #include "servers/audio/audio_stream.h"
+#include "servers/audio/audio_stream_decoded.h"
 
 #include "minimp3_ex.h"
 
 class AudioStreamMP3;
 
-class AudioStreamPlaybackMP3 : public AudioStreamPlaybackResampled {
-	GDCLASS(AudioStreamPlaybackMP3, AudioStreamPlaybackResampled);
+class AudioStreamPlaybackMP3 : public AudioStreamPlaybackDecoded {
+	GDCLASS(AudioStreamPlaybackMP3, AudioStreamPlaybackDecoded);
 
 	mp3dec_ex_t *mp3d = nullptr;
-	uint32_t frames_mixed = 0;
-	bool active = false;
-	int loops = 0;
 
 	friend class AudioStreamMP3;
 
 	Ref<AudioStreamMP3> mp3_stream;
 
 protected:
-	virtual void _mix_internal(AudioFrame *p_buffer, int p_frames) override;
-	virtual float get_stream_sampling_rate() override;
+	virtual int _decode(AudioFrame *p_buffer, int p_frames) override;
+	virtual void _decoder_seek(uint32_t p_frame) override;
 
-public:
-	virtual void start(float p_from_pos = 0.0) override;
-	virtual void stop() override;
-	virtual bool is_playing() const override;
-
-	virtual int get_loop_count() const override; //times it looped
-
-	virtual float get_playback_position() const override;
-	virtual void seek(float p_time) override;
+	virtual float _get_length() const override;
+	virtual float _get_sample_rate() const override;
+	virtual bool _has_loop() const override;
+	virtual float _get_loop_offset() const override;
 
+public:
 	AudioStreamPlaybackMP3() {}
 	~AudioStreamPlaybackMP3();
 };
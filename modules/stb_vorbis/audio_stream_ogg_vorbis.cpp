@@ -32,89 +32,39 @@
 
 #include "core/os/file_access.h"
 
-void AudioStreamPlaybackOGGVorbis::_mix_internal(AudioFrame *p_buffer, int p_frames) {
-	ERR_FAIL_COND(!active);
-
-	int todo = p_frames;
-
-	int start_buffer = 0;
-
-	while (todo && active) {
-		float *buffer = (float *)p_buffer;
-		if (start_buffer > 0) {
-			buffer = (buffer + start_buffer * 2);
-		}
-		int mixed = stb_vorbis_get_samples_float_interleaved(ogg_stream, 2, buffer, todo * 2);
-		if (vorbis_stream->channels == 1 && mixed > 0) {
-			//mix mono to stereo
-			for (int i = start_buffer; i < start_buffer + mixed; i++) {
-				p_buffer[i].r = p_buffer[i].l;
-			}
-		}
-		todo -= mixed;
-		frames_mixed += mixed;
-
-		if (todo) {
-			//end of file!
-			bool is_not_empty = mixed > 0 || stb_vorbis_stream_length_in_samples(ogg_stream) > 0;
-			if (vorbis_stream->loop && is_not_empty) {
-				//loop
-				seek(vorbis_stream->loop_offset);
-				loops++;
-				// we still have buffer to fill, start from this element in the next iteration.
-				start_buffer = p_frames - todo;
-			} else {
-				for (int i = p_frames - todo; i < p_frames; i++) {
-					p_buffer[i] = AudioFrame(0, 0);
-				}
-				active = false;
-				todo = 0;
-			}
+int AudioStreamPlaybackOGGVorbis::_decode(AudioFrame *p_buffer, int p_frames) {
+	int mixed = stb_vorbis_get_samples_float_interleaved(ogg_stream, 2, (float *)p_buffer, p_frames * 2);
+	if (vorbis_stream->channels == 1) {
+		//mix mono to stereo
+		for (int i = 0; i < mixed; i++) {
+			p_buffer[i].r = p_buffer[i].l;
 		}
 	}
+	return mixed;
 }
 
-float AudioStreamPlaybackOGGVorbis::get_stream_sampling_rate() {
-	return vorbis_stream->sample_rate;
-}
-
-void AudioStreamPlaybackOGGVorbis::start(float p_from_pos) {
-	active = true;
-	seek(p_from_pos);
-	loops = 0;
-	_begin_resample();
+void AudioStreamPlaybackOGGVorbis::_decoder_seek(uint32_t p_frame) {
+	stb_vorbis_seek(ogg_stream, p_frame);
 }
 
-void AudioStreamPlaybackOGGVorbis::stop() {
-	active = false;
+float AudioStreamPlaybackOGGVorbis::_get_length() const {
+	return vorbis_stream->length;
 }
 
-bool AudioStreamPlaybackOGGVorbis::is_playing() const {
-	return active;
-}
-
-int AudioStreamPlaybackOGGVorbis::get_loop_count() const {
-	return loops;
+float AudioStreamPlaybackOGGVorbis::_get_sample_rate() const {
+	return vorbis_stream->sample_rate;
 }
 
-float AudioStreamPlaybackOGGVorbis::get_playback_position() const {
-	return float(frames_mixed) / vorbis_stream->sample_rate;
+bool AudioStreamPlaybackOGGVorbis::_has_loop() const {
+	return vorbis_stream->loop;
 }
 
-void AudioStreamPlaybackOGGVorbis::seek(float p_time) {
-	if (!active) {
-		return;
-	}
-
-	if (p_time >= vorbis_stream->get_length()) {
-		p_time = 0;
-	}
-	frames_mixed = uint32_t(vorbis_stream->sample_rate * p_time);
-
-	stb_vorbis_seek(ogg_stream, frames_mixed);
+float AudioStreamPlaybackOGGVorbis::_get_loop_offset() const {
+	return vorbis_stream->loop_offset;
 }
 
 AudioStreamPlaybackOGGVorbis::~AudioStreamPlaybackOGGVorbis() {
+	_stop_prefetch();
 	if (ogg_alloc.alloc_buffer) {
 		stb_vorbis_close(ogg_stream);
 		memfree(ogg_alloc.alloc_buffer);
@@ -133,9 +83,6 @@ Ref<AudioStreamPlayback> AudioStreamOGGVorbis::instance_playback() {
 	ovs->vorbis_stream = Ref<AudioStreamOGGVorbis>(this);
 	ovs->ogg_alloc.alloc_buffer = (char *)memalloc(decode_mem_size);
 	ovs->ogg_alloc.alloc_buffer_length_in_bytes = decode_mem_size;
-	ovs->frames_mixed = 0;
-	ovs->active = false;
-	ovs->loops = 0;
 	int error;
 	ovs->ogg_stream = stb_vorbis_open_memory((const unsigned char *)data, data_len, &error, &ovs->ogg_alloc);
 	if (!ovs->ogg_stream) {
@@ -143,6 +90,7 @@ Ref<AudioStreamPlayback> AudioStreamOGGVorbis::instance_playback() {
 		ovs->ogg_alloc.alloc_buffer = nullptr;
 		ERR_FAIL_COND_V(!ovs->ogg_stream, Ref<AudioStreamPlaybackOGGVorbis>());
 	}
+	ovs->_setup_source(get_instance_id());
 
 	return ovs;
 }
@@ -202,6 +150,7 @@ void AudioStreamOGGVorbis::set_data(const Vector<uint8_t> &p_data) {
 
 			// free any existing data
 			clear_data();
+			AudioDecodedCache::erase(get_instance_id());
 
 			data = memalloc(src_data_len);
 			memcpy(data, src_datar, src_data_len);
@@ -266,5 +215,6 @@ void AudioStreamOGGVorbis::_bind_methods() {
 AudioStreamOGGVorbis::AudioStreamOGGVorbis() {}
 
 AudioStreamOGGVorbis::~AudioStreamOGGVorbis() {
+	AudioDecodedCache::erase(get_instance_id());
 	clear_data();
 }
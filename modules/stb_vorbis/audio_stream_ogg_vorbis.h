@@ -33,38 +33,32 @@
 
 #include "core/io/resource_loader.h"
 #include "servers/audio/audio_stream.h"
+#include "servers/audio/audio_stream_decoded.h"
 
 #include "thirdparty/misc/stb_vorbis.h"
 
 class AudioStreamOGGVorbis;
 
-class AudioStreamPlaybackOGGVorbis : public AudioStreamPlaybackResampled {
-	GDCLASS(AudioStreamPlaybackOGGVorbis, AudioStreamPlaybackResampled);
+class AudioStreamPlaybackOGGVorbis : public AudioStreamPlaybackDecoded {
+	GDCLASS(AudioStreamPlaybackOGGVorbis, AudioStreamPlaybackDecoded);
 
 	stb_vorbis *ogg_stream = nullptr;
 	stb_vorbis_alloc ogg_alloc;
-	uint32_t frames_mixed = 0;
-	bool active = false;
-	int loops = 0;
 
 	friend class AudioStreamOGGVorbis;
 
 	Ref<AudioStreamOGGVorbis> vorbis_stream;
 
 protected:
-	virtual void _mix_internal(AudioFrame *p_buffer, int p_frames) override;
-	virtual float get_stream_sampling_rate() override;
+	virtual int _decode(AudioFrame *p_buffer, int p_frames) override;
+	virtual void _decoder_seek(uint32_t p_frame) override;
 
-public:
-	virtual void start(float p_from_pos = 0.0) override;
-	virtual void stop() override;
-	virtual bool is_playing() const override;
-
-	virtual int get_loop_count() const override; //times it looped
-
-	virtual float get_playback_position() const override;
-	virtual void seek(float p_time) override;
+	virtual float _get_length() const override;
+	virtual float _get_sample_rate() const override;
+	virtual bool _has_loop() const override;
+	virtual float _get_loop_offset() const override;
 
+public:
 	AudioStreamPlaybackOGGVorbis() {}
 	~AudioStreamPlaybackOGGVorbis();
 };
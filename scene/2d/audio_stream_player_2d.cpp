@@ -33,6 +33,7 @@
 #include "core/config/engine.h"
 #include "scene/2d/area_2d.h"
 #include "scene/main/window.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 void AudioStreamPlayer2D::_mix_audio() {
 	if (!stream_playback.is_valid() || !active.is_set() ||
@@ -97,10 +98,7 @@ void AudioStreamPlayer2D::_mix_audio() {
 
 			AudioFrame *target = AudioServer::get_singleton()->thread_get_channel_mix_buffer(current.bus_index, 0);
 
-			for (int j = 0; j < buffer_size; j++) {
-				target[j] += buffer[j] * vol;
-				vol += vol_inc;
-			}
+			AudioMixKernels::mix_ramp(target, buffer, buffer_size, vol, vol_inc);
 
 		} else {
 			AudioFrame *targets[4];
@@ -31,18 +31,19 @@
 #include "cpu_particles_2d.h"
 
 #include "core/core_string_names.h"
+#include "core/math/simd.h"
 #include "scene/2d/gpu_particles_2d.h"
 #include "scene/main/canvas_item.h"
 #include "scene/resources/particles_material.h"
 #include "servers/rendering_server.h"
 
 void CPUParticles2D::set_emitting(bool p_emitting) {
-	if (emitting == p_emitting) {
+	if (simulation.emitting == p_emitting) {
 		return;
 	}
 
-	emitting = p_emitting;
-	if (emitting) {
+	simulation.emitting = p_emitting;
+	if (simulation.emitting) {
 		set_process_internal(true);
 	}
 }
@@ -50,14 +51,7 @@ void CPUParticles2D::set_emitting(bool p_emitting) {
 void CPUParticles2D::set_amount(int p_amount) {
 	ERR_FAIL_COND_MSG(p_amount < 1, "Amount of particles must be greater than 0.");
 
-	particles.resize(p_amount);
-	{
-		Particle *w = particles.ptrw();
-
-		for (int i = 0; i < p_amount; i++) {
-			w[i].active = false;
-		}
-	}
+	simulation.set_amount(p_amount);
 
 	particle_data.resize((8 + 4 + 4) * p_amount);
 	RS::get_singleton()->multimesh_allocate_data(multimesh, p_amount, RS::MULTIMESH_TRANSFORM_2D, true, true);
@@ -67,11 +61,11 @@ void CPUParticles2D::set_amount(int p_amount) {
 
 void CPUParticles2D::set_lifetime(float p_lifetime) {
 	ERR_FAIL_COND_MSG(p_lifetime <= 0, "Particles lifetime must be greater than 0.");
-	lifetime = p_lifetime;
+	simulation.lifetime = p_lifetime;
 }
 
 void CPUParticles2D::set_one_shot(bool p_one_shot) {
-	one_shot = p_one_shot;
+	simulation.one_shot = p_one_shot;
 }
 
 void CPUParticles2D::set_pre_process_time(float p_time) {
@@ -79,40 +73,40 @@ void CPUParticles2D::set_pre_process_time(float p_time) {
 }
 
 void CPUParticles2D::set_explosiveness_ratio(real_t p_ratio) {
-	explosiveness_ratio = p_ratio;
+	simulation.explosiveness_ratio = p_ratio;
 }
 
 void CPUParticles2D::set_randomness_ratio(real_t p_ratio) {
-	randomness_ratio = p_ratio;
+	simulation.randomness_ratio = p_ratio;
 }
 
 void CPUParticles2D::set_lifetime_randomness(float p_random) {
-	lifetime_randomness = p_random;
+	simulation.lifetime_randomness = p_random;
 }
 
 void CPUParticles2D::set_use_local_coordinates(bool p_enable) {
-	local_coords = p_enable;
+	simulation.local_coords = p_enable;
 	set_notify_transform(!p_enable);
 }
 
 void CPUParticles2D::set_speed_scale(real_t p_scale) {
-	speed_scale = p_scale;
+	simulation.speed_scale = p_scale;
 }
 
 bool CPUParticles2D::is_emitting() const {
-	return emitting;
+	return simulation.emitting;
 }
 
 int CPUParticles2D::get_amount() const {
-	return particles.size();
+	return simulation.particles.size();
 }
 
 float CPUParticles2D::get_lifetime() const {
-	return lifetime;
+	return simulation.lifetime;
 }
 
 bool CPUParticles2D::get_one_shot() const {
-	return one_shot;
+	return simulation.one_shot;
 }
 
 float CPUParticles2D::get_pre_process_time() const {
@@ -120,23 +114,23 @@ float CPUParticles2D::get_pre_process_time() const {
 }
 
 real_t CPUParticles2D::get_explosiveness_ratio() const {
-	return explosiveness_ratio;
+	return simulation.explosiveness_ratio;
 }
 
 real_t CPUParticles2D::get_randomness_ratio() const {
-	return randomness_ratio;
+	return simulation.randomness_ratio;
 }
 
 float CPUParticles2D::get_lifetime_randomness() const {
-	return lifetime_randomness;
+	return simulation.lifetime_randomness;
 }
 
 bool CPUParticles2D::get_use_local_coordinates() const {
-	return local_coords;
+	return simulation.local_coords;
 }
 
 real_t CPUParticles2D::get_speed_scale() const {
-	return speed_scale;
+	return simulation.speed_scale;
 }
 
 void CPUParticles2D::set_draw_order(DrawOrder p_order) {
@@ -237,11 +231,11 @@ int CPUParticles2D::get_fixed_fps() const {
 }
 
 void CPUParticles2D::set_fractional_delta(bool p_enable) {
-	fractional_delta = p_enable;
+	simulation.fractional_delta = p_enable;
 }
 
 bool CPUParticles2D::get_fractional_delta() const {
-	return fractional_delta;
+	return simulation.fractional_delta;
 }
 
 TypedArray<String> CPUParticles2D::get_configuration_warnings() const {
@@ -260,62 +254,55 @@ TypedArray<String> CPUParticles2D::get_configuration_warnings() const {
 }
 
 void CPUParticles2D::restart() {
-	time = 0;
+	simulation.time = 0;
 	inactive_time = 0;
 	frame_remainder = 0;
-	cycle = 0;
-	emitting = false;
-
-	{
-		int pc = particles.size();
-		Particle *w = particles.ptrw();
+	simulation.cycle = 0;
+	simulation.emitting = false;
 
-		for (int i = 0; i < pc; i++) {
-			w[i].active = false;
-		}
-	}
+	simulation.deactivate();
 
 	set_emitting(true);
 }
 
 void CPUParticles2D::set_direction(Vector2 p_direction) {
-	direction = p_direction;
+	simulation.direction = p_direction;
 }
 
 Vector2 CPUParticles2D::get_direction() const {
-	return direction;
+	return simulation.direction;
 }
 
 void CPUParticles2D::set_spread(real_t p_spread) {
-	spread = p_spread;
+	simulation.spread = p_spread;
 }
 
 real_t CPUParticles2D::get_spread() const {
-	return spread;
+	return simulation.spread;
 }
 
 void CPUParticles2D::set_param(Parameter p_param, real_t p_value) {
 	ERR_FAIL_INDEX(p_param, PARAM_MAX);
 
-	parameters[p_param] = p_value;
+	simulation.parameters[p_param] = p_value;
 }
 
 real_t CPUParticles2D::get_param(Parameter p_param) const {
 	ERR_FAIL_INDEX_V(p_param, PARAM_MAX, 0);
 
-	return parameters[p_param];
+	return simulation.parameters[p_param];
 }
 
 void CPUParticles2D::set_param_randomness(Parameter p_param, real_t p_value) {
 	ERR_FAIL_INDEX(p_param, PARAM_MAX);
 
-	randomness[p_param] = p_value;
+	simulation.randomness[p_param] = p_value;
 }
 
 real_t CPUParticles2D::get_param_randomness(Parameter p_param) const {
 	ERR_FAIL_INDEX_V(p_param, PARAM_MAX, 0);
 
-	return randomness[p_param];
+	return simulation.randomness[p_param];
 }
 
 static void _adjust_curve_range(const Ref<Curve> &p_curve, real_t p_min, real_t p_max) {
@@ -330,7 +317,7 @@ static void _adjust_curve_range(const Ref<Curve> &p_curve, real_t p_min, real_t
 void CPUParticles2D::set_param_curve(Parameter p_param, const Ref<Curve> &p_curve) {
 	ERR_FAIL_INDEX(p_param, PARAM_MAX);
 
-	curve_parameters[p_param] = p_curve;
+	simulation.curve_parameters[p_param] = p_curve;
 
 	switch (p_param) {
 		case PARAM_INITIAL_LINEAR_VELOCITY: {
@@ -375,119 +362,119 @@ void CPUParticles2D::set_param_curve(Parameter p_param, const Ref<Curve> &p_curv
 Ref<Curve> CPUParticles2D::get_param_curve(Parameter p_param) const {
 	ERR_FAIL_INDEX_V(p_param, PARAM_MAX, Ref<Curve>());
 
-	return curve_parameters[p_param];
+	return simulation.curve_parameters[p_param];
 }
 
 void CPUParticles2D::set_color(const Color &p_color) {
-	color = p_color;
+	simulation.color = p_color;
 }
 
 Color CPUParticles2D::get_color() const {
-	return color;
+	return simulation.color;
 }
 
 void CPUParticles2D::set_color_ramp(const Ref<Gradient> &p_ramp) {
-	color_ramp = p_ramp;
+	simulation.color_ramp = p_ramp;
 }
 
 Ref<Gradient> CPUParticles2D::get_color_ramp() const {
-	return color_ramp;
+	return simulation.color_ramp;
 }
 
 void CPUParticles2D::set_particle_flag(ParticleFlags p_particle_flag, bool p_enable) {
 	ERR_FAIL_INDEX(p_particle_flag, PARTICLE_FLAG_MAX);
-	particle_flags[p_particle_flag] = p_enable;
+	simulation.particle_flags[p_particle_flag] = p_enable;
 }
 
 bool CPUParticles2D::get_particle_flag(ParticleFlags p_particle_flag) const {
 	ERR_FAIL_INDEX_V(p_particle_flag, PARTICLE_FLAG_MAX, false);
-	return particle_flags[p_particle_flag];
+	return simulation.particle_flags[p_particle_flag];
 }
 
 void CPUParticles2D::set_emission_shape(EmissionShape p_shape) {
 	ERR_FAIL_INDEX(p_shape, EMISSION_SHAPE_MAX);
-	emission_shape = p_shape;
+	simulation.emission_shape = p_shape;
 	notify_property_list_changed();
 }
 
 void CPUParticles2D::set_emission_sphere_radius(real_t p_radius) {
-	emission_sphere_radius = p_radius;
+	simulation.emission_sphere_radius = p_radius;
 }
 
 void CPUParticles2D::set_emission_rect_extents(Vector2 p_extents) {
-	emission_rect_extents = p_extents;
+	simulation.emission_rect_extents = p_extents;
 }
 
 void CPUParticles2D::set_emission_points(const Vector<Vector2> &p_points) {
-	emission_points = p_points;
+	simulation.emission_points = p_points;
 }
 
 void CPUParticles2D::set_emission_normals(const Vector<Vector2> &p_normals) {
-	emission_normals = p_normals;
+	simulation.emission_normals = p_normals;
 }
 
 void CPUParticles2D::set_emission_colors(const Vector<Color> &p_colors) {
-	emission_colors = p_colors;
+	simulation.emission_colors = p_colors;
 }
 
 real_t CPUParticles2D::get_emission_sphere_radius() const {
-	return emission_sphere_radius;
+	return simulation.emission_sphere_radius;
 }
 
 Vector2 CPUParticles2D::get_emission_rect_extents() const {
-	return emission_rect_extents;
+	return simulation.emission_rect_extents;
 }
 
 Vector<Vector2> CPUParticles2D::get_emission_points() const {
-	return emission_points;
+	return simulation.emission_points;
 }
 
 Vector<Vector2> CPUParticles2D::get_emission_normals() const {
-	return emission_normals;
+	return simulation.emission_normals;
 }
 
 Vector<Color> CPUParticles2D::get_emission_colors() const {
-	return emission_colors;
+	return simulation.emission_colors;
 }
 
 CPUParticles2D::EmissionShape CPUParticles2D::get_emission_shape() const {
-	return emission_shape;
+	return simulation.emission_shape;
 }
 
 void CPUParticles2D::set_gravity(const Vector2 &p_gravity) {
-	gravity = p_gravity;
+	simulation.gravity = p_gravity;
 }
 
 Vector2 CPUParticles2D::get_gravity() const {
-	return gravity;
+	return simulation.gravity;
 }
 
 void CPUParticles2D::_validate_property(PropertyInfo &property) const {
-	if (property.name == "color" && color_ramp.is_valid()) {
+	if (property.name == "color" && simulation.color_ramp.is_valid()) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_sphere_radius" && emission_shape != EMISSION_SHAPE_SPHERE) {
+	if (property.name == "emission_sphere_radius" && simulation.emission_shape != EMISSION_SHAPE_SPHERE) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_rect_extents" && emission_shape != EMISSION_SHAPE_RECTANGLE) {
+	if (property.name == "emission_rect_extents" && simulation.emission_shape != EMISSION_SHAPE_RECTANGLE) {
 		property.usage = 0;
 	}
 
-	if ((property.name == "emission_point_texture" || property.name == "emission_color_texture") && (emission_shape < EMISSION_SHAPE_POINTS)) {
+	if ((property.name == "emission_point_texture" || property.name == "emission_color_texture") && (simulation.emission_shape < EMISSION_SHAPE_POINTS)) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_normals" && emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
+	if (property.name == "emission_normals" && simulation.emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_points" && emission_shape != EMISSION_SHAPE_POINTS && emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
+	if (property.name == "emission_points" && simulation.emission_shape != EMISSION_SHAPE_POINTS && simulation.emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_colors" && emission_shape != EMISSION_SHAPE_POINTS && emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
+	if (property.name == "emission_colors" && simulation.emission_shape != EMISSION_SHAPE_POINTS && simulation.emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
 		property.usage = 0;
 	}
 }
@@ -515,31 +502,33 @@ static real_t rand_from_seed(uint32_t &seed) {
 }
 
 void CPUParticles2D::_update_internal() {
-	if (particles.size() == 0 || !is_visible_in_tree()) {
+	if (simulation.particles.size() == 0 || !is_visible_in_tree()) {
 		_set_redraw(false);
 		return;
 	}
 
 	float delta = get_process_delta_time();
-	if (emitting) {
+	if (simulation.emitting) {
 		inactive_time = 0;
 	} else {
 		inactive_time += delta;
-		if (inactive_time > lifetime * 1.2) {
+		if (inactive_time > simulation.lifetime * 1.2) {
 			set_process_internal(false);
 			_set_redraw(false);
 
 			//reset variables
-			time = 0;
+			simulation.time = 0;
 			inactive_time = 0;
 			frame_remainder = 0;
-			cycle = 0;
+			simulation.cycle = 0;
 			return;
 		}
 	}
 	_set_redraw(true);
 
-	if (time == 0 && pre_process_time > 0.0) {
+	bool processed = false;
+
+	if (simulation.time == 0 && pre_process_time > 0.0) {
 		float frame_time;
 		if (fixed_fps > 0) {
 			frame_time = 1.0 / fixed_fps;
@@ -551,6 +540,7 @@ void CPUParticles2D::_update_internal() {
 
 		while (todo >= 0) {
 			_particles_process(frame_time);
+			processed = true;
 			todo -= frame_time;
 		}
 	}
@@ -569,6 +559,7 @@ void CPUParticles2D::_update_internal() {
 
 		while (todo >= frame_time) {
 			_particles_process(frame_time);
+			processed = true;
 			todo -= decr;
 		}
 
@@ -576,18 +567,202 @@ void CPUParticles2D::_update_internal() {
 
 	} else {
 		_particles_process(delta);
+		processed = true;
 	}
 
-	_update_particle_data_buffer();
+	if (processed) {
+		_update_particle_data_buffer();
+	}
 }
 
 void CPUParticles2D::_particles_process(float p_delta) {
+	bool was_emitting = simulation.emitting;
+
+	simulation.process(p_delta, simulation.local_coords ? Transform2D() : get_global_transform(), _get_work_pool(simulation.particles.size()));
+
+	if (was_emitting && !simulation.emitting) {
+		// A one shot system finished its cycle.
+		notify_property_list_changed();
+	}
+}
+
+void CPUParticles2D::_update_particle_data_buffer() {
+	MutexLock lock(update_mutex);
+
+	int pc = simulation.particles.size();
+
+	int *ow;
+	int *order = nullptr;
+
+	float *w = particle_data.ptrw();
+
+	if (draw_order != DRAW_ORDER_INDEX) {
+		ow = particle_order.ptrw();
+		order = ow;
+
+		for (int i = 0; i < pc; i++) {
+			order[i] = i;
+		}
+		if (draw_order == DRAW_ORDER_LIFETIME) {
+			SortArray<int, SortLifetime> sorter;
+			sorter.compare.particles = simulation.particles.ptr();
+			sorter.sort(order, pc);
+		}
+	}
+
+	ProcessChunks chunks;
+	chunks.order = order;
+	chunks.data = w;
+	chunks.count = pc;
+
+	uint32_t chunk_count = (chunks.count + PROCESS_CHUNK_SIZE - 1) / PROCESS_CHUNK_SIZE;
+	ThreadWorkPool *pool = _get_work_pool(chunks.count);
+	if (pool) {
+		pool->do_work(chunk_count, this, &CPUParticles2D::_update_particle_data_chunk, &chunks);
+	} else {
+		for (uint32_t i = 0; i < chunk_count; i++) {
+			_update_particle_data_chunk(i, &chunks);
+		}
+	}
+
+	can_update.set();
+}
+
+void CPUParticles2D::_update_particle_data_chunk(uint32_t p_chunk, ProcessChunks *p_chunks) {
+	uint32_t from = p_chunk * PROCESS_CHUNK_SIZE;
+	uint32_t to = MIN(from + PROCESS_CHUNK_SIZE, p_chunks->count);
+
+	const int *order = p_chunks->order;
+	float *ptr = p_chunks->data + from * 16;
+
+	for (uint32_t i = from; i < to; i++) {
+		uint32_t idx = order ? uint32_t(order[i]) : i;
+
+		_write_particle_transform(idx, ptr);
+
+		Color c = simulation.get_color(idx);
+
+		ptr[8] = c.r;
+		ptr[9] = c.g;
+		ptr[10] = c.b;
+		ptr[11] = c.a;
+
+		const Particle &p = simulation.particles[idx];
+		ptr[12] = p.custom[0];
+		ptr[13] = p.custom[1];
+		ptr[14] = p.custom[2];
+		ptr[15] = p.custom[3];
+
+		ptr += 16;
+	}
+}
+
+void CPUParticles2D::_write_particle_transform(uint32_t p_index, float *r_data) const {
+	if (!simulation.particles[p_index].active) {
+		memset(r_data, 0, sizeof(float) * 8);
+		return;
+	}
+
+	Transform2D t = simulation.get_transform(p_index);
+
+	if (!simulation.local_coords) {
+		t = inv_emission_transform * t;
+	}
+
+	r_data[0] = t.elements[0][0];
+	r_data[1] = t.elements[1][0];
+	r_data[2] = 0;
+	r_data[3] = t.elements[2][0];
+	r_data[4] = t.elements[0][1];
+	r_data[5] = t.elements[1][1];
+	r_data[6] = 0;
+	r_data[7] = t.elements[2][1];
+}
+
+ThreadWorkPool *CPUParticles2D::_get_work_pool(uint32_t p_count) {
+	if (p_count <= PROCESS_CHUNK_SIZE) {
+		return nullptr;
+	}
+
+	if (!work_pool) {
+		work_pool = memnew(ThreadWorkPool);
+		work_pool->init();
+	}
+	return work_pool;
+}
+
+/* SIMULATION */
+
+template <class T>
+static void _resize_cleared(LocalVector<T> &r_array, uint32_t p_size) {
+	r_array.resize(p_size);
+	if (p_size) {
+		memset(r_array.ptr(), 0, sizeof(T) * p_size);
+	}
+}
+
+void CPUParticles2D::Simulation::set_amount(int p_amount) {
+	particles.resize(p_amount);
+	for (int i = 0; i < p_amount; i++) {
+		particles[i].active = false;
+	}
+
+	for (int i = 0; i < 4; i++) {
+		_resize_cleared(axes[i], p_amount);
+		_resize_cleared(colors[i], p_amount);
+		_resize_cleared(ramp_colors[i], p_amount);
+		_resize_cleared(base_colors[i], p_amount);
+	}
+	for (int i = 0; i < 2; i++) {
+		_resize_cleared(origin[i], p_amount);
+		_resize_cleared(velocity[i], p_amount);
+		_resize_cleared(hue_rotations[i], p_amount);
+	}
+	_resize_cleared(steps, p_amount);
+	_resize_cleared(deltas, p_amount);
+	_resize_cleared(scales, p_amount);
+}
+
+void CPUParticles2D::Simulation::deactivate() {
+	for (uint32_t i = 0; i < particles.size(); i++) {
+		particles[i].active = false;
+	}
+}
+
+Transform2D CPUParticles2D::Simulation::get_transform(uint32_t p_index) const {
+	Transform2D t;
+	t.elements[0] = Vector2(axes[0][p_index], axes[1][p_index]);
+	t.elements[1] = Vector2(axes[2][p_index], axes[3][p_index]);
+	t.elements[2] = Vector2(origin[0][p_index], origin[1][p_index]);
+	return t;
+}
+
+void CPUParticles2D::Simulation::set_transform(uint32_t p_index, const Transform2D &p_transform) {
+	axes[0][p_index] = p_transform.elements[0].x;
+	axes[1][p_index] = p_transform.elements[0].y;
+	axes[2][p_index] = p_transform.elements[1].x;
+	axes[3][p_index] = p_transform.elements[1].y;
+	origin[0][p_index] = p_transform.elements[2].x;
+	origin[1][p_index] = p_transform.elements[2].y;
+}
+
+Vector2 CPUParticles2D::Simulation::get_velocity(uint32_t p_index) const {
+	return Vector2(velocity[0][p_index], velocity[1][p_index]);
+}
+
+void CPUParticles2D::Simulation::set_velocity(uint32_t p_index, const Vector2 &p_velocity) {
+	velocity[0][p_index] = p_velocity.x;
+	velocity[1][p_index] = p_velocity.y;
+}
+
+Color CPUParticles2D::Simulation::get_color(uint32_t p_index) const {
+	return Color(colors[0][p_index], colors[1][p_index], colors[2][p_index], colors[3][p_index]);
+}
+
+void CPUParticles2D::Simulation::process(float p_delta, const Transform2D &p_emission_xform, ThreadWorkPool *p_pool) {
 	p_delta *= speed_scale;
 
 	int pcount = particles.size();
-	Particle *w = particles.ptrw();
-
-	Particle *parray = w;
 
 	float prev_time = time;
 	time += p_delta;
@@ -595,23 +770,22 @@ void CPUParticles2D::_particles_process(float p_delta) {
 		time = Math::fmod(time, lifetime);
 		cycle++;
 		if (one_shot && cycle > 0) {
-			set_emitting(false);
-			notify_property_list_changed();
+			emitting = false;
 		}
 	}
 
 	Transform2D emission_xform;
-	Transform2D velocity_xform;
 	if (!local_coords) {
-		emission_xform = get_global_transform();
-		velocity_xform = emission_xform;
-		velocity_xform[2] = Vector2();
+		emission_xform = p_emission_xform;
 	}
+	emission_origin = emission_xform[2];
 
 	float system_phase = time / lifetime;
 
 	for (int i = 0; i < pcount; i++) {
-		Particle &p = parray[i];
+		Particle &p = particles[i];
+		steps[i] = PARTICLE_STEP_SKIP;
+		deltas[i] = 0.0;
 
 		if (!emitting && !p.active) {
 			continue;
@@ -668,104 +842,163 @@ void CPUParticles2D::_particles_process(float p_delta) {
 			restart = true;
 		}
 
-		float tv = 0.0;
-
 		if (restart) {
 			if (!emitting) {
 				p.active = false;
 				continue;
 			}
 			p.active = true;
+			steps[i] = PARTICLE_STEP_RESTARTED;
+			_emit(i, emission_xform);
+		} else if (!p.active) {
+			continue;
+		} else if (p.time > p.lifetime) {
+			p.active = false;
+			steps[i] = PARTICLE_STEP_EXPIRED;
+		} else {
+			steps[i] = PARTICLE_STEP_UPDATE;
+		}
 
-			/*real_t tex_linear_velocity = 0;
-			if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
-				tex_linear_velocity = curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY]->interpolate(0);
-			}*/
+		deltas[i] = local_delta;
+	}
 
-			real_t tex_angle = 0.0;
-			if (curve_parameters[PARAM_ANGLE].is_valid()) {
-				tex_angle = curve_parameters[PARAM_ANGLE]->interpolate(tv);
-			}
+	if (color_ramp.is_valid()) {
+		// Sorts the gradient points if needed, so the workers only read them.
+		color_ramp->get_color_at_offset(0.0);
+	}
 
-			real_t tex_anim_offset = 0.0;
-			if (curve_parameters[PARAM_ANGLE].is_valid()) {
-				tex_anim_offset = curve_parameters[PARAM_ANGLE]->interpolate(tv);
-			}
+	uint32_t chunk_count = (pcount + PROCESS_CHUNK_SIZE - 1) / PROCESS_CHUNK_SIZE;
+	if (p_pool && chunk_count > 1) {
+		p_pool->do_work(chunk_count, this, &Simulation::_process_chunk, uint32_t(pcount));
+	} else {
+		for (uint32_t i = 0; i < chunk_count; i++) {
+			_process_chunk(i, pcount);
+		}
+	}
+}
 
-			p.seed = Math::rand();
+void CPUParticles2D::Simulation::_emit(uint32_t p_index, const Transform2D &p_emission_xform) {
+	Particle &p = particles[p_index];
+	float tv = 0.0;
 
-			p.angle_rand = Math::randf();
-			p.scale_rand = Math::randf();
-			p.hue_rot_rand = Math::randf();
-			p.anim_offset_rand = Math::randf();
+	/*real_t tex_linear_velocity = 0;
+	if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
+		tex_linear_velocity = curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY]->interpolate(0);
+	}*/
 
-			real_t angle1_rad = Math::atan2(direction.y, direction.x) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * spread);
-			Vector2 rot = Vector2(Math::cos(angle1_rad), Math::sin(angle1_rad));
-			p.velocity = rot * parameters[PARAM_INITIAL_LINEAR_VELOCITY] * Math::lerp((real_t)1.0, real_t(Math::randf()), randomness[PARAM_INITIAL_LINEAR_VELOCITY]);
+	real_t tex_angle = 0.0;
+	if (curve_parameters[PARAM_ANGLE].is_valid()) {
+		tex_angle = curve_parameters[PARAM_ANGLE]->interpolate(tv);
+	}
 
-			real_t base_angle = (parameters[PARAM_ANGLE] + tex_angle) * Math::lerp((real_t)1.0, p.angle_rand, randomness[PARAM_ANGLE]);
-			p.rotation = Math::deg2rad(base_angle);
-
-			p.custom[0] = 0.0; // unused
-			p.custom[1] = 0.0; // phase [0..1]
-			p.custom[2] = (parameters[PARAM_ANIM_OFFSET] + tex_anim_offset) * Math::lerp((real_t)1.0, p.anim_offset_rand, randomness[PARAM_ANIM_OFFSET]); //animation phase [0..1]
-			p.custom[3] = 0.0;
-			p.transform = Transform2D();
-			p.time = 0;
-			p.lifetime = lifetime * (1.0 - Math::randf() * lifetime_randomness);
-			p.base_color = Color(1, 1, 1, 1);
-
-			switch (emission_shape) {
-				case EMISSION_SHAPE_POINT: {
-					//do none
-				} break;
-				case EMISSION_SHAPE_SPHERE: {
-					real_t s = Math::randf(), t = Math_TAU * Math::randf();
-					real_t radius = emission_sphere_radius * Math::sqrt(1.0 - s * s);
-					p.transform[2] = Vector2(Math::cos(t), Math::sin(t)) * radius;
-				} break;
-				case EMISSION_SHAPE_RECTANGLE: {
-					p.transform[2] = Vector2(Math::randf() * 2.0 - 1.0, Math::randf() * 2.0 - 1.0) * emission_rect_extents;
-				} break;
-				case EMISSION_SHAPE_POINTS:
-				case EMISSION_SHAPE_DIRECTED_POINTS: {
-					int pc = emission_points.size();
-					if (pc == 0) {
-						break;
-					}
-
-					int random_idx = Math::rand() % pc;
-
-					p.transform[2] = emission_points.get(random_idx);
-
-					if (emission_shape == EMISSION_SHAPE_DIRECTED_POINTS && emission_normals.size() == pc) {
-						Vector2 normal = emission_normals.get(random_idx);
-						Transform2D m2;
-						m2.set_axis(0, normal);
-						m2.set_axis(1, normal.orthogonal());
-						p.velocity = m2.basis_xform(p.velocity);
-					}
-
-					if (emission_colors.size() == pc) {
-						p.base_color = emission_colors.get(random_idx);
-					}
-				} break;
-				case EMISSION_SHAPE_MAX: { // Max value for validity check.
-					break;
-				}
+	real_t tex_anim_offset = 0.0;
+	if (curve_parameters[PARAM_ANGLE].is_valid()) {
+		tex_anim_offset = curve_parameters[PARAM_ANGLE]->interpolate(tv);
+	}
+
+	p.seed = Math::rand();
+
+	p.angle_rand = Math::randf();
+	p.scale_rand = Math::randf();
+	p.hue_rot_rand = Math::randf();
+	p.anim_offset_rand = Math::randf();
+
+	real_t angle1_rad = Math::atan2(direction.y, direction.x) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * spread);
+	Vector2 rot = Vector2(Math::cos(angle1_rad), Math::sin(angle1_rad));
+	Vector2 vel = rot * parameters[PARAM_INITIAL_LINEAR_VELOCITY] * Math::lerp((real_t)1.0, real_t(Math::randf()), randomness[PARAM_INITIAL_LINEAR_VELOCITY]);
+
+	real_t base_angle = (parameters[PARAM_ANGLE] + tex_angle) * Math::lerp((real_t)1.0, p.angle_rand, randomness[PARAM_ANGLE]);
+	p.rotation = Math::deg2rad(base_angle);
+
+	p.custom[0] = 0.0; // unused
+	p.custom[1] = 0.0; // phase [0..1]
+	p.custom[2] = (parameters[PARAM_ANIM_OFFSET] + tex_anim_offset) * Math::lerp((real_t)1.0, p.anim_offset_rand, randomness[PARAM_ANIM_OFFSET]); //animation phase [0..1]
+	p.custom[3] = 0.0;
+	Transform2D xform;
+	p.time = 0;
+	p.lifetime = lifetime * (1.0 - Math::randf() * lifetime_randomness);
+	Color base_color = Color(1, 1, 1, 1);
+
+	switch (emission_shape) {
+		case EMISSION_SHAPE_POINT: {
+			//do none
+		} break;
+		case EMISSION_SHAPE_SPHERE: {
+			real_t s = Math::randf(), t = Math_TAU * Math::randf();
+			real_t radius = emission_sphere_radius * Math::sqrt(1.0 - s * s);
+			xform[2] = Vector2(Math::cos(t), Math::sin(t)) * radius;
+		} break;
+		case EMISSION_SHAPE_RECTANGLE: {
+			xform[2] = Vector2(Math::randf() * 2.0 - 1.0, Math::randf() * 2.0 - 1.0) * emission_rect_extents;
+		} break;
+		case EMISSION_SHAPE_POINTS:
+		case EMISSION_SHAPE_DIRECTED_POINTS: {
+			int pc = emission_points.size();
+			if (pc == 0) {
+				break;
 			}
 
-			if (!local_coords) {
-				p.velocity = velocity_xform.xform(p.velocity);
-				p.transform = emission_xform * p.transform;
+			int random_idx = Math::rand() % pc;
+
+			xform[2] = emission_points.get(random_idx);
+
+			if (emission_shape == EMISSION_SHAPE_DIRECTED_POINTS && emission_normals.size() == pc) {
+				Vector2 normal = emission_normals.get(random_idx);
+				Transform2D m2;
+				m2.set_axis(0, normal);
+				m2.set_axis(1, normal.orthogonal());
+				vel = m2.basis_xform(vel);
 			}
 
-		} else if (!p.active) {
+			if (emission_colors.size() == pc) {
+				base_color = emission_colors.get(random_idx);
+			}
+		} break;
+		case EMISSION_SHAPE_MAX: { // Max value for validity check.
+			break;
+		}
+	}
+
+	if (!local_coords) {
+		vel = p_emission_xform.basis_xform(vel);
+		xform = p_emission_xform * xform;
+	}
+
+	set_transform(p_index, xform);
+	set_velocity(p_index, vel);
+	base_colors[0][p_index] = base_color.r;
+	base_colors[1][p_index] = base_color.g;
+	base_colors[2][p_index] = base_color.b;
+	base_colors[3][p_index] = base_color.a;
+}
+
+void CPUParticles2D::Simulation::_process_chunk(uint32_t p_chunk, uint32_t p_count) {
+	uint32_t from = p_chunk * PROCESS_CHUNK_SIZE;
+	uint32_t to = MIN(from + PROCESS_CHUNK_SIZE, p_count);
+
+	_update(from, to);
+	_scale(from, to);
+	_integrate(from, to);
+	_color(from, to);
+}
+
+void CPUParticles2D::Simulation::_update(uint32_t p_from, uint32_t p_to) {
+	for (uint32_t i = p_from; i < p_to; i++) {
+		Particle &p = particles[i];
+		float local_delta = deltas[i];
+		float tv = 0.0;
+
+		if (steps[i] == PARTICLE_STEP_SKIP) {
+			scales[i] = 1.0;
 			continue;
-		} else if (p.time > p.lifetime) {
-			p.active = false;
+		}
+
+		Transform2D xform = get_transform(i);
+		Vector2 vel = get_velocity(i);
+
+		if (steps[i] == PARTICLE_STEP_EXPIRED) {
 			tv = 1.0;
-		} else {
+		} else if (steps[i] == PARTICLE_STEP_UPDATE) {
 			uint32_t alt_seed = p.seed;
 
 			p.time += local_delta;
@@ -822,19 +1055,19 @@ void CPUParticles2D::_particles_process(float p_delta) {
 			}
 
 			Vector2 force = gravity;
-			Vector2 pos = p.transform[2];
+			Vector2 pos = xform[2];
 
 			//apply linear acceleration
-			force += p.velocity.length() > 0.0 ? p.velocity.normalized() * (parameters[PARAM_LINEAR_ACCEL] + tex_linear_accel) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_LINEAR_ACCEL]) : Vector2();
+			force += vel.length() > 0.0 ? vel.normalized() * (parameters[PARAM_LINEAR_ACCEL] + tex_linear_accel) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_LINEAR_ACCEL]) : Vector2();
 			//apply radial acceleration
-			Vector2 org = emission_xform[2];
+			Vector2 org = emission_origin;
 			Vector2 diff = pos - org;
 			force += diff.length() > 0.0 ? diff.normalized() * (parameters[PARAM_RADIAL_ACCEL] + tex_radial_accel) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_RADIAL_ACCEL]) : Vector2();
 			//apply tangential acceleration;
 			Vector2 yx = Vector2(diff.y, diff.x);
 			force += yx.length() > 0.0 ? (yx * Vector2(-1.0, 1.0)).normalized() * ((parameters[PARAM_TANGENTIAL_ACCEL] + tex_tangential_accel) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_TANGENTIAL_ACCEL])) : Vector2();
 			//apply attractor forces
-			p.velocity += force * local_delta;
+			vel += force * local_delta;
 			//orbit velocity
 			real_t orbit_amount = (parameters[PARAM_ORBIT_VELOCITY] + tex_orbit_velocity) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_ORBIT_VELOCITY]);
 			if (orbit_amount != 0.0) {
@@ -842,21 +1075,21 @@ void CPUParticles2D::_particles_process(float p_delta) {
 				// Not sure why the ParticlesMaterial code uses a clockwise rotation matrix,
 				// but we use -ang here to reproduce its behavior.
 				Transform2D rot = Transform2D(-ang, Vector2());
-				p.transform[2] -= diff;
-				p.transform[2] += rot.basis_xform(diff);
+				xform[2] -= diff;
+				xform[2] += rot.basis_xform(diff);
 			}
 			if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
-				p.velocity = p.velocity.normalized() * tex_linear_velocity;
+				vel = vel.normalized() * tex_linear_velocity;
 			}
 
 			if (parameters[PARAM_DAMPING] + tex_damping > 0.0) {
-				real_t v = p.velocity.length();
+				real_t v = vel.length();
 				real_t damp = (parameters[PARAM_DAMPING] + tex_damping) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_DAMPING]);
 				v -= damp * local_delta;
 				if (v < 0.0) {
-					p.velocity = Vector2();
+					vel = Vector2();
 				} else {
-					p.velocity = p.velocity.normalized() * v;
+					vel = vel.normalized() * v;
 				}
 			}
 			real_t base_angle = (parameters[PARAM_ANGLE] + tex_angle) * Math::lerp((real_t)1.0, p.angle_rand, randomness[PARAM_ANGLE]);
@@ -865,6 +1098,7 @@ void CPUParticles2D::_particles_process(float p_delta) {
 			real_t animation_phase = (parameters[PARAM_ANIM_OFFSET] + tex_anim_offset) * Math::lerp((real_t)1.0, p.anim_offset_rand, randomness[PARAM_ANIM_OFFSET]) + p.custom[1] * (parameters[PARAM_ANIM_SPEED] + tex_anim_speed) * Math::lerp((real_t)1.0, rand_from_seed(alt_seed), randomness[PARAM_ANIM_SPEED]);
 			p.custom[2] = animation_phase;
 		}
+
 		//apply color
 		//apply hue rotation
 
@@ -879,42 +1113,27 @@ void CPUParticles2D::_particles_process(float p_delta) {
 		}
 
 		real_t hue_rot_angle = (parameters[PARAM_HUE_VARIATION] + tex_hue_variation) * Math_TAU * Math::lerp(1.0f, p.hue_rot_rand * 2.0f - 1.0f, randomness[PARAM_HUE_VARIATION]);
-		real_t hue_rot_c = Math::cos(hue_rot_angle);
-		real_t hue_rot_s = Math::sin(hue_rot_angle);
-
-		Basis hue_rot_mat;
-		{
-			Basis mat1(0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114);
-			Basis mat2(0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886);
-			Basis mat3(0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203);
-
-			for (int j = 0; j < 3; j++) {
-				hue_rot_mat[j] = mat1[j] + mat2[j] * hue_rot_c + mat3[j] * hue_rot_s;
-			}
-		}
+		hue_rotations[0][i] = Math::cos(hue_rot_angle);
+		hue_rotations[1][i] = Math::sin(hue_rot_angle);
 
+		Color ramp_color = color;
 		if (color_ramp.is_valid()) {
-			p.color = color_ramp->get_color_at_offset(tv) * color;
-		} else {
-			p.color = color;
+			ramp_color = color_ramp->get_color_at_offset(tv) * color;
 		}
-
-		Vector3 color_rgb = hue_rot_mat.xform_inv(Vector3(p.color.r, p.color.g, p.color.b));
-		p.color.r = color_rgb.x;
-		p.color.g = color_rgb.y;
-		p.color.b = color_rgb.z;
-
-		p.color *= p.base_color;
+		ramp_colors[0][i] = ramp_color.r;
+		ramp_colors[1][i] = ramp_color.g;
+		ramp_colors[2][i] = ramp_color.b;
+		ramp_colors[3][i] = ramp_color.a;
 
 		if (particle_flags[PARTICLE_FLAG_ALIGN_Y_TO_VELOCITY]) {
-			if (p.velocity.length() > 0.0) {
-				p.transform.elements[1] = p.velocity.normalized();
-				p.transform.elements[0] = p.transform.elements[1].orthogonal();
+			if (vel.length() > 0.0) {
+				xform.elements[1] = vel.normalized();
+				xform.elements[0] = xform.elements[1].orthogonal();
 			}
 
 		} else {
-			p.transform.elements[0] = Vector2(Math::cos(p.rotation), -Math::sin(p.rotation));
-			p.transform.elements[1] = Vector2(Math::sin(p.rotation), Math::cos(p.rotation));
+			xform.elements[0] = Vector2(Math::cos(p.rotation), -Math::sin(p.rotation));
+			xform.elements[1] = Vector2(Math::sin(p.rotation), Math::cos(p.rotation));
 		}
 
 		//scale by scale
@@ -922,76 +1141,126 @@ void CPUParticles2D::_particles_process(float p_delta) {
 		if (base_scale < 0.000001) {
 			base_scale = 0.000001;
 		}
+		scales[i] = base_scale;
 
-		p.transform.elements[0] *= base_scale;
-		p.transform.elements[1] *= base_scale;
-
-		p.transform[2] += p.velocity * local_delta;
+		set_transform(i, xform);
+		set_velocity(i, vel);
 	}
 }
 
-void CPUParticles2D::_update_particle_data_buffer() {
-	MutexLock lock(update_mutex);
-
-	int pc = particles.size();
-
-	int *ow;
-	int *order = nullptr;
-
-	float *w = particle_data.ptrw();
-	const Particle *r = particles.ptr();
-	float *ptr = w;
+void CPUParticles2D::Simulation::_scale(uint32_t p_from, uint32_t p_to) {
+	uint32_t i = p_from;
 
-	if (draw_order != DRAW_ORDER_INDEX) {
-		ow = particle_order.ptrw();
-		order = ow;
-
-		for (int i = 0; i < pc; i++) {
-			order[i] = i;
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const __m128 scale = _mm_loadu_ps(scales.ptr() + i);
+		for (int j = 0; j < 4; j++) {
+			real_t *a = axes[j].ptr() + i;
+			_mm_storeu_ps(a, _mm_mul_ps(_mm_loadu_ps(a), scale));
 		}
-		if (draw_order == DRAW_ORDER_LIFETIME) {
-			SortArray<int, SortLifetime> sorter;
-			sorter.compare.particles = r;
-			sorter.sort(order, pc);
+	}
+#elif defined(SIMD_NEON) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const float32x4_t scale = vld1q_f32(scales.ptr() + i);
+		for (int j = 0; j < 4; j++) {
+			real_t *a = axes[j].ptr() + i;
+			vst1q_f32(a, vmulq_f32(vld1q_f32(a), scale));
 		}
 	}
+#endif
 
-	for (int i = 0; i < pc; i++) {
-		int idx = order ? order[i] : i;
-
-		Transform2D t = r[idx].transform;
-
-		if (!local_coords) {
-			t = inv_emission_transform * t;
+	for (; i < p_to; i++) {
+		for (int j = 0; j < 4; j++) {
+			axes[j][i] *= scales[i];
 		}
+	}
+}
 
-		if (r[idx].active) {
-			ptr[0] = t.elements[0][0];
-			ptr[1] = t.elements[1][0];
-			ptr[2] = 0;
-			ptr[3] = t.elements[2][0];
-			ptr[4] = t.elements[0][1];
-			ptr[5] = t.elements[1][1];
-			ptr[6] = 0;
-			ptr[7] = t.elements[2][1];
+void CPUParticles2D::Simulation::_integrate(uint32_t p_from, uint32_t p_to) {
+	uint32_t i = p_from;
 
-		} else {
-			memset(ptr, 0, sizeof(float) * 8);
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const __m128 delta = _mm_loadu_ps(deltas.ptr() + i);
+		for (int j = 0; j < 2; j++) {
+			real_t *o = origin[j].ptr() + i;
+			_mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_mul_ps(_mm_loadu_ps(velocity[j].ptr() + i), delta)));
 		}
+	}
+#elif defined(SIMD_NEON) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const float32x4_t delta = vld1q_f32(deltas.ptr() + i);
+		for (int j = 0; j < 2; j++) {
+			real_t *o = origin[j].ptr() + i;
+			vst1q_f32(o, vaddq_f32(vld1q_f32(o), vmulq_f32(vld1q_f32(velocity[j].ptr() + i), delta)));
+		}
+	}
+#endif
 
-		Color c = r[idx].color;
-
-		ptr[8] = c.r;
-		ptr[9] = c.g;
-		ptr[10] = c.b;
-		ptr[11] = c.a;
-
-		ptr[12] = r[idx].custom[0];
-		ptr[13] = r[idx].custom[1];
-		ptr[14] = r[idx].custom[2];
-		ptr[15] = r[idx].custom[3];
+	for (; i < p_to; i++) {
+		for (int j = 0; j < 2; j++) {
+			origin[j][i] += velocity[j][i] * deltas[i];
+		}
+	}
+}
 
-		ptr += 16;
+// Rotates the hue by blending three matrices with the cosine and sine of the angle, row major.
+static const float hue_rotation_matrices[3][9] = {
+	{ 0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114 },
+	{ 0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886 },
+	{ 0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203 },
+};
+
+void CPUParticles2D::Simulation::_color(uint32_t p_from, uint32_t p_to) {
+	const float(*m)[9] = hue_rotation_matrices;
+	uint32_t i = p_from;
+
+	// Each output channel is the ramp color times a column of the blended matrix, as Basis::xform_inv().
+#if defined(SIMD_SSE2)
+	for (; i + 4 <= p_to; i += 4) {
+		const __m128 c = _mm_loadu_ps(hue_rotations[0].ptr() + i);
+		const __m128 s = _mm_loadu_ps(hue_rotations[1].ptr() + i);
+		for (int j = 0; j < 3; j++) {
+			__m128 channel = _mm_setzero_ps();
+			for (int k = 0; k < 3; k++) {
+				const int e = k * 3 + j;
+				__m128 weight = _mm_add_ps(_mm_add_ps(_mm_set1_ps(m[0][e]), _mm_mul_ps(_mm_set1_ps(m[1][e]), c)), _mm_mul_ps(_mm_set1_ps(m[2][e]), s));
+				channel = _mm_add_ps(channel, _mm_mul_ps(weight, _mm_loadu_ps(ramp_colors[k].ptr() + i)));
+			}
+			_mm_storeu_ps(colors[j].ptr() + i, _mm_mul_ps(channel, _mm_loadu_ps(base_colors[j].ptr() + i)));
+		}
+		_mm_storeu_ps(colors[3].ptr() + i, _mm_mul_ps(_mm_loadu_ps(ramp_colors[3].ptr() + i), _mm_loadu_ps(base_colors[3].ptr() + i)));
+	}
+#elif defined(SIMD_NEON)
+	for (; i + 4 <= p_to; i += 4) {
+		const float32x4_t c = vld1q_f32(hue_rotations[0].ptr() + i);
+		const float32x4_t s = vld1q_f32(hue_rotations[1].ptr() + i);
+		for (int j = 0; j < 3; j++) {
+			float32x4_t channel = vdupq_n_f32(0.0);
+			for (int k = 0; k < 3; k++) {
+				const int e = k * 3 + j;
+				float32x4_t weight = vaddq_f32(vaddq_f32(vdupq_n_f32(m[0][e]), vmulq_n_f32(c, m[1][e])), vmulq_n_f32(s, m[2][e]));
+				channel = vaddq_f32(channel, vmulq_f32(weight, vld1q_f32(ramp_colors[k].ptr() + i)));
+			}
+			vst1q_f32(colors[j].ptr() + i, vmulq_f32(channel, vld1q_f32(base_colors[j].ptr() + i)));
+		}
+		vst1q_f32(colors[3].ptr() + i, vmulq_f32(vld1q_f32(ramp_colors[3].ptr() + i), vld1q_f32(base_colors[3].ptr() + i)));
+	}
+#endif
+
+	for (; i < p_to; i++) {
+		const float c = hue_rotations[0][i];
+		const float s = hue_rotations[1][i];
+		for (int j = 0; j < 3; j++) {
+			float channel = 0.0;
+			for (int k = 0; k < 3; k++) {
+				const int e = k * 3 + j;
+				float weight = (m[0][e] + m[1][e] * c) + m[2][e] * s;
+				channel += weight * ramp_colors[k][i];
+			}
+			colors[j][i] = channel * base_colors[j][i];
+		}
+		colors[3][i] = ramp_colors[3][i] * base_colors[3][i];
 	}
 }
 
@@ -1025,20 +1294,24 @@ void CPUParticles2D::_set_redraw(bool p_redraw) {
 void CPUParticles2D::_update_render_thread() {
 	MutexLock lock(update_mutex);
 
-	RS::get_singleton()->multimesh_set_buffer(multimesh, particle_data);
+	// Frames with fixed FPS may not process at all, so only upload the buffer when it changed.
+	if (can_update.is_set()) {
+		RS::get_singleton()->multimesh_set_buffer(multimesh, particle_data);
+		can_update.clear();
+	}
 }
 
 void CPUParticles2D::_notification(int p_what) {
 	switch (p_what) {
 		case NOTIFICATION_ENTER_TREE: {
-			set_process_internal(emitting);
+			set_process_internal(simulation.emitting);
 		} break;
 		case NOTIFICATION_EXIT_TREE: {
 			_set_redraw(false);
 		} break;
 		case NOTIFICATION_DRAW: {
 			// first update before rendering to avoid one frame delay after emitting starts
-			if (emitting && (time == 0)) {
+			if (simulation.emitting && (simulation.time == 0)) {
 				_update_internal();
 			}
 
@@ -1059,32 +1332,17 @@ void CPUParticles2D::_notification(int p_what) {
 		case NOTIFICATION_TRANSFORM_CHANGED: {
 			inv_emission_transform = get_global_transform().affine_inverse();
 
-			if (!local_coords) {
-				int pc = particles.size();
+			if (!simulation.local_coords) {
+				int pc = simulation.particles.size();
 
-				float *w = particle_data.ptrw();
-				const Particle *r = particles.ptr();
-				float *ptr = w;
+				float *ptr = particle_data.ptrw();
 
 				for (int i = 0; i < pc; i++) {
-					Transform2D t = inv_emission_transform * r[i].transform;
-
-					if (r[i].active) {
-						ptr[0] = t.elements[0][0];
-						ptr[1] = t.elements[1][0];
-						ptr[2] = 0;
-						ptr[3] = t.elements[2][0];
-						ptr[4] = t.elements[0][1];
-						ptr[5] = t.elements[1][1];
-						ptr[6] = 0;
-						ptr[7] = t.elements[2][1];
-
-					} else {
-						memset(ptr, 0, sizeof(float) * 8);
-					}
-
+					_write_particle_transform(i, ptr);
 					ptr += 16;
 				}
+
+				can_update.set();
 			}
 		} break;
 	}
@@ -1363,6 +1621,15 @@ void CPUParticles2D::_bind_methods() {
 	BIND_ENUM_CONSTANT(EMISSION_SHAPE_MAX);
 }
 
+void CPUParticles2D::finish_work_pool() {
+	if (work_pool) {
+		memdelete(work_pool);
+		work_pool = nullptr;
+	}
+}
+
+ThreadWorkPool *CPUParticles2D::work_pool = nullptr;
+
 CPUParticles2D::CPUParticles2D() {
 	mesh = RenderingServer::get_singleton()->mesh_create();
 	multimesh = RenderingServer::get_singleton()->multimesh_create();
@@ -1390,7 +1657,7 @@ CPUParticles2D::CPUParticles2D() {
 	}
 
 	for (int i = 0; i < PARTICLE_FLAG_MAX; i++) {
-		particle_flags[i] = false;
+		simulation.particle_flags[i] = false;
 	}
 
 	set_color(Color(1, 1, 1, 1));
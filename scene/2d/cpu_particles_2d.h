@@ -31,7 +31,10 @@
 #ifndef CPU_PARTICLES_2D_H
 #define CPU_PARTICLES_2D_H
 
+#include "core/templates/local_vector.h"
 #include "core/templates/rid.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/thread_work_pool.h"
 #include "scene/2d/node_2d.h"
 #include "scene/resources/texture.h"
 
@@ -77,15 +80,18 @@ public:
 		EMISSION_SHAPE_MAX
 	};
 
-private:
-	bool emitting = false;
+	// Restarts draw from the global random generator, so they are decided in order on the main thread.
+	// The rest of each particle's update only touches that particle, and is split in chunks across threads.
+	enum ParticleStep : uint8_t {
+		PARTICLE_STEP_SKIP,
+		PARTICLE_STEP_RESTARTED,
+		PARTICLE_STEP_EXPIRED,
+		PARTICLE_STEP_UPDATE,
+	};
 
 	struct Particle {
-		Transform2D transform;
-		Color color;
 		float custom[4] = {};
 		real_t rotation = 0.0;
-		Vector2 velocity;
 		bool active = false;
 		real_t angle_rand = 0.0;
 		real_t scale_rand = 0.0;
@@ -93,21 +99,104 @@ private:
 		real_t anim_offset_rand = 0.0;
 		float time = 0.0;
 		float lifetime = 0.0;
-		Color base_color;
 
 		uint32_t seed = 0;
 	};
 
-	float time = 0.0;
+	enum {
+		PROCESS_CHUNK_SIZE = 256,
+	};
+
+	// The particle simulation, apart from the node and its multimesh so it can also run headless.
+	// The node forwards its properties here and packs the result into the multimesh buffer.
+	struct Simulation {
+		bool emitting = false;
+		bool one_shot = false;
+
+		float lifetime = 1.0;
+		real_t explosiveness_ratio = 0.0;
+		real_t randomness_ratio = 0.0;
+		real_t lifetime_randomness = 0.0;
+		real_t speed_scale = 1.0;
+		bool local_coords = true;
+		bool fractional_delta = true;
+
+		Vector2 direction = Vector2(1, 0);
+		real_t spread = 45.0;
+
+		real_t parameters[PARAM_MAX] = {};
+		real_t randomness[PARAM_MAX] = {};
+
+		Ref<Curve> curve_parameters[PARAM_MAX];
+		Color color = Color(1, 1, 1, 1);
+		Ref<Gradient> color_ramp;
+
+		bool particle_flags[PARTICLE_FLAG_MAX] = {};
+
+		EmissionShape emission_shape = EMISSION_SHAPE_POINT;
+		real_t emission_sphere_radius = 1.0;
+		Vector2 emission_rect_extents = Vector2(1, 1);
+		Vector<Vector2> emission_points;
+		Vector<Vector2> emission_normals;
+		Vector<Color> emission_colors;
+
+		Vector2 gravity = Vector2(0, 980);
+
+		float time = 0.0;
+		int cycle = 0;
+
+		LocalVector<Particle> particles;
+
+		// Transforms, velocities and colors have one array per component, so the scale,
+		// integrate and color stages run over four consecutive particles at a time.
+		LocalVector<real_t> axes[4]; // X then Y axis, like the first two Transform2D::elements.
+		LocalVector<real_t> origin[2];
+		LocalVector<real_t> velocity[2];
+		LocalVector<float> colors[4];
+
+		// Inputs of the color stage, only written when a particle is updated. The stage
+		// runs over whole chunks, and gives the same color again for skipped particles.
+		LocalVector<float> ramp_colors[4];
+		LocalVector<float> base_colors[4];
+		LocalVector<float> hue_rotations[2]; // Cosine and sine.
+
+		// Written for every particle on each step, skipped ones get a scale of 1 and a delta of 0.
+		LocalVector<ParticleStep> steps;
+		LocalVector<real_t> deltas;
+		LocalVector<real_t> scales;
+
+		Vector2 emission_origin;
+
+		void set_amount(int p_amount);
+		int get_amount() const { return particles.size(); }
+		void deactivate();
+
+		Transform2D get_transform(uint32_t p_index) const;
+		void set_transform(uint32_t p_index, const Transform2D &p_transform);
+		Vector2 get_velocity(uint32_t p_index) const;
+		void set_velocity(uint32_t p_index, const Vector2 &p_velocity);
+		Color get_color(uint32_t p_index) const;
+
+		// Advances every particle by p_delta. Chunks run on the threads of p_pool if given, on the calling thread otherwise.
+		void process(float p_delta, const Transform2D &p_emission_xform, ThreadWorkPool *p_pool = nullptr);
+		void _emit(uint32_t p_index, const Transform2D &p_emission_xform);
+		void _process_chunk(uint32_t p_chunk, uint32_t p_count);
+		void _update(uint32_t p_from, uint32_t p_to);
+		void _scale(uint32_t p_from, uint32_t p_to);
+		void _integrate(uint32_t p_from, uint32_t p_to);
+		void _color(uint32_t p_from, uint32_t p_to);
+	};
+
+private:
+	Simulation simulation;
+
 	float inactive_time = 0.0;
 	float frame_remainder = 0.0;
-	int cycle = 0;
 	bool redraw = false;
 
 	RID mesh;
 	RID multimesh;
 
-	Vector<Particle> particles;
 	Vector<float> particle_data;
 	Vector<int> particle_order;
 
@@ -120,60 +209,42 @@ private:
 	};
 
 	struct SortAxis {
-		const Particle *particles = nullptr;
+		const real_t *origin[2] = {};
 		Vector2 axis;
 		bool operator()(int p_a, int p_b) const {
-			return axis.dot(particles[p_a].transform[2]) < axis.dot(particles[p_b].transform[2]);
+			return axis.dot(Vector2(origin[0][p_a], origin[1][p_a])) < axis.dot(Vector2(origin[0][p_b], origin[1][p_b]));
 		}
 	};
 
 	//
 
-	bool one_shot = false;
-
-	float lifetime = 1.0;
 	float pre_process_time = 0.0;
-	real_t explosiveness_ratio = 0.0;
-	real_t randomness_ratio = 0.0;
-	real_t lifetime_randomness = 0.0;
-	real_t speed_scale = 1.0;
-	bool local_coords;
 	int fixed_fps = 0;
-	bool fractional_delta = true;
 
 	Transform2D inv_emission_transform;
 
+	SafeFlag can_update;
+
 	DrawOrder draw_order = DRAW_ORDER_INDEX;
 
 	Ref<Texture2D> texture;
 
-	////////
-
-	Vector2 direction = Vector2(1, 0);
-	real_t spread = 45.0;
-
-	real_t parameters[PARAM_MAX];
-	real_t randomness[PARAM_MAX];
-
-	Ref<Curve> curve_parameters[PARAM_MAX];
-	Color color;
-	Ref<Gradient> color_ramp;
-
-	bool particle_flags[PARTICLE_FLAG_MAX];
-
-	EmissionShape emission_shape = EMISSION_SHAPE_POINT;
-	real_t emission_sphere_radius = 1.0;
-	Vector2 emission_rect_extents = Vector2(1, 1);
-	Vector<Vector2> emission_points;
-	Vector<Vector2> emission_normals;
-	Vector<Color> emission_colors;
 	int emission_point_count = 0;
 
-	Vector2 gravity = Vector2(0, 980);
+	struct ProcessChunks {
+		const int *order = nullptr;
+		float *data = nullptr;
+		uint32_t count = 0;
+	};
+
+	static ThreadWorkPool *work_pool;
+	static ThreadWorkPool *_get_work_pool(uint32_t p_count);
 
 	void _update_internal();
 	void _particles_process(float p_delta);
 	void _update_particle_data_buffer();
+	void _update_particle_data_chunk(uint32_t p_chunk, ProcessChunks *p_chunks);
+	void _write_particle_transform(uint32_t p_index, float *r_data) const;
 
 	Mutex update_mutex;
 
@@ -281,6 +352,8 @@ public:
 
 	void convert_from_particles(Node *p_particles);
 
+	static void finish_work_pool();
+
 	CPUParticles2D();
 	~CPUParticles2D();
 };
@@ -35,6 +35,7 @@
 #include "scene/3d/camera_3d.h"
 #include "scene/3d/listener_3d.h"
 #include "scene/main/window.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 // Based on "A Novel Multichannel Panning Method for Standard and Arbitrary Loudspeaker Configurations" by Ramy Sadek and Chris Kyriakakis (2004)
 // Speaker-Placement Correction Amplitude Panning (SPCAP)
@@ -148,6 +149,7 @@ void AudioStreamPlayer3D::_mix_audio() {
 		stream_playback->start(setseek.get());
 		setseek.set(-1.0); //reset seek
 		started = true;
+		virtual_time = 0.0;
 	}
 
 	//get data
@@ -159,6 +161,31 @@ void AudioStreamPlayer3D::_mix_audio() {
 		buffer_size = MIN(buffer_size, 128);
 	}
 
+	// A virtual voice fades out over one mix, then only keeps track of the time that passes.
+	bool virtualized = voice.virtualized.is_set() && !stream_paused_fade_out;
+	if (virtualized && voice_faded_out) {
+		if (output_count.get() > 0 || out_of_range_mode == OUT_OF_RANGE_MIX) {
+			virtual_time += buffer_size * pitch_scale / (AudioServer::get_singleton()->get_mix_rate() * AudioServer::get_singleton()->get_global_rate_scale());
+
+			// Let the playback loop or stop once the skipped time reaches the end of the stream.
+			float length = stream->get_length();
+			if (length > 0 && stream_playback->get_playback_position() + virtual_time >= length) {
+				stream_playback->skip(virtual_time);
+				virtual_time = 0.0;
+				if (!stream_playback->is_playing()) {
+					active.clear();
+				}
+			}
+		}
+		output_ready.clear();
+		return;
+	}
+
+	if (virtual_time > 0.0) {
+		stream_playback->skip(virtual_time);
+		virtual_time = 0.0;
+	}
+
 	// Mix if we're not paused or we're fading out
 	if ((output_count.get() > 0 || out_of_range_mode == OUT_OF_RANGE_MIX)) {
 		float output_pitch_scale = 0.0;
@@ -208,8 +235,8 @@ void AudioStreamPlayer3D::_mix_audio() {
 		int buffers = AudioServer::get_singleton()->get_channel_count();
 
 		for (int k = 0; k < buffers; k++) {
-			AudioFrame target_volume = stream_paused_fade_out ? AudioFrame(0.f, 0.f) : current.vol[k];
-			AudioFrame vol_prev = stream_paused_fade_in ? AudioFrame(0.f, 0.f) : prev_outputs[i].vol[k];
+			AudioFrame target_volume = stream_paused_fade_out || virtualized ? AudioFrame(0.f, 0.f) : current.vol[k];
+			AudioFrame vol_prev = stream_paused_fade_in || voice_faded_out ? AudioFrame(0.f, 0.f) : prev_outputs[i].vol[k];
 			AudioFrame vol_inc = (target_volume - vol_prev) / float(buffer_size);
 			AudioFrame vol = vol_prev;
 
@@ -265,19 +292,15 @@ void AudioStreamPlayer3D::_mix_audio() {
 
 				AudioFrame *rtarget = AudioServer::get_singleton()->thread_get_channel_mix_buffer(current.reverb_bus_index, k);
 
-				if (current.reverb_bus_index == prev_outputs[i].reverb_bus_index) {
-					AudioFrame rvol_inc = (current.reverb_vol[k] - prev_outputs[i].reverb_vol[k]) / float(buffer_size);
-					AudioFrame rvol = prev_outputs[i].reverb_vol[k];
+				if (current.reverb_bus_index == prev_outputs[i].reverb_bus_index || virtualized || voice_faded_out) {
+					AudioFrame rvol_target = virtualized ? AudioFrame(0.f, 0.f) : current.reverb_vol[k];
+					AudioFrame rvol = voice_faded_out ? AudioFrame(0.f, 0.f) : prev_outputs[i].reverb_vol[k];
+					AudioFrame rvol_inc = (rvol_target - rvol) / float(buffer_size);
 
-					for (int j = 0; j < buffer_size; j++) {
-						rtarget[j] += buffer[j] * rvol;
-						rvol += rvol_inc;
-					}
+					AudioMixKernels::mix_ramp(rtarget, buffer, buffer_size, rvol, rvol_inc);
 				} else {
 					AudioFrame rvol = current.reverb_vol[k];
-					for (int j = 0; j < buffer_size; j++) {
-						rtarget[j] += buffer[j] * rvol;
-					}
+					AudioMixKernels::mix_ramp(rtarget, buffer, buffer_size, rvol, AudioFrame(0, 0));
 				}
 			}
 		}
@@ -295,6 +318,7 @@ void AudioStreamPlayer3D::_mix_audio() {
 	output_ready.clear();
 	stream_paused_fade_in = false;
 	stream_paused_fade_out = false;
+	voice_faded_out = virtualized;
 }
 
 float AudioStreamPlayer3D::_get_attenuation_db(float p_distance) const {
@@ -331,6 +355,7 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 	if (p_what == NOTIFICATION_ENTER_TREE) {
 		velocity_tracker->reset(get_global_transform().origin);
 		AudioServer::get_singleton()->add_callback(_mix_audios, this);
+		AudioServer::get_singleton()->add_voice(&voice);
 		if (autoplay && !Engine::get_singleton()->is_editor_hint()) {
 			play();
 		}
@@ -338,6 +363,7 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 
 	if (p_what == NOTIFICATION_EXIT_TREE) {
 		AudioServer::get_singleton()->remove_callback(_mix_audios, this);
+		AudioServer::get_singleton()->remove_voice(&voice);
 	}
 
 	if (p_what == NOTIFICATION_PAUSED) {
@@ -372,6 +398,7 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 			ERR_FAIL_COND(world_3d.is_null());
 
 			int new_output_count = 0;
+			float audibility = 0.0;
 
 			Vector3 global_pos = get_global_transform().origin;
 
@@ -476,6 +503,7 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 				unsigned int cc = AudioServer::get_singleton()->get_channel_count();
 				for (unsigned int k = 0; k < cc; k++) {
 					output.vol[k] *= multiplier;
+					audibility = MAX(audibility, MAX(output.vol[k].l, output.vol[k].r));
 				}
 
 				bool filled_reverb = false;
@@ -598,6 +626,9 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 
 			output_count.set(new_output_count);
 			output_ready.set();
+
+			// Ranked against the other voices by its loudest output.
+			voice.volume_db = audibility > 0 ? Math::linear2db(audibility) : AUDIO_MIN_PEAK_DB;
 		}
 
 		//start playing if requested
@@ -607,6 +638,8 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 			setplay.set(-1);
 		}
 
+		voice.playing = active.is_set() && !stream_paused;
+
 		//stop playing if no longer active
 		if (!active.is_set()) {
 			set_physics_process_internal(false);
@@ -698,6 +731,7 @@ void AudioStreamPlayer3D::seek(float p_seconds) {
 void AudioStreamPlayer3D::stop() {
 	if (stream_playback.is_valid()) {
 		active.clear();
+		voice.playing = false;
 		set_physics_process_internal(false);
 		setplay.set(-1);
 	}
@@ -717,7 +751,7 @@ float AudioStreamPlayer3D::get_playback_position() {
 		if (ss >= 0.0) {
 			return ss;
 		}
-		return stream_playback->get_playback_position();
+		return stream_playback->get_playback_position() + virtual_time;
 	}
 
 	return 0;
@@ -883,6 +917,7 @@ void AudioStreamPlayer3D::set_stream_paused(bool p_pause) {
 		stream_paused = p_pause;
 		stream_paused_fade_in = !stream_paused;
 		stream_paused_fade_out = stream_paused;
+		voice.playing = active.is_set() && !stream_paused;
 	}
 }
 
@@ -890,6 +925,14 @@ bool AudioStreamPlayer3D::get_stream_paused() const {
 	return stream_paused;
 }
 
+void AudioStreamPlayer3D::set_voice_priority(int p_priority) {
+	voice.priority = p_priority;
+}
+
+int AudioStreamPlayer3D::get_voice_priority() const {
+	return voice.priority;
+}
+
 Ref<AudioStreamPlayback> AudioStreamPlayer3D::get_stream_playback() {
 	return stream_playback;
 }
@@ -959,6 +1002,9 @@ void AudioStreamPlayer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_stream_paused", "pause"), &AudioStreamPlayer3D::set_stream_paused);
 	ClassDB::bind_method(D_METHOD("get_stream_paused"), &AudioStreamPlayer3D::get_stream_paused);
 
+	ClassDB::bind_method(D_METHOD("set_voice_priority", "priority"), &AudioStreamPlayer3D::set_voice_priority);
+	ClassDB::bind_method(D_METHOD("get_voice_priority"), &AudioStreamPlayer3D::get_voice_priority);
+
 	ClassDB::bind_method(D_METHOD("get_stream_playback"), &AudioStreamPlayer3D::get_stream_playback);
 
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "stream", PROPERTY_HINT_RESOURCE_TYPE, "AudioStream"), "set_stream", "get_stream");
@@ -973,6 +1019,7 @@ void AudioStreamPlayer3D::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "max_distance", PROPERTY_HINT_EXP_RANGE, "0,4096,1,or_greater"), "set_max_distance", "get_max_distance");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "out_of_range_mode", PROPERTY_HINT_ENUM, "Mix,Pause"), "set_out_of_range_mode", "get_out_of_range_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "bus", PROPERTY_HINT_ENUM, ""), "set_bus", "get_bus");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "voice_priority"), "set_voice_priority", "get_voice_priority");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "area_mask", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_area_mask", "get_area_mask");
 	ADD_GROUP("Emission Angle", "emission_angle");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "emission_angle_enabled"), "set_emission_angle_enabled", "is_emission_angle_enabled");
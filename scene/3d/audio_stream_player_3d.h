@@ -132,6 +132,11 @@ private:
 
 	OutOfRangeMode out_of_range_mode = OUT_OF_RANGE_MIX;
 
+	AudioServer::Voice voice;
+	// Used by the audio thread: stream time skipped while virtual, and whether the last mix faded out for it.
+	float virtual_time = 0.0;
+	bool voice_faded_out = false;
+
 	float _get_attenuation_db(float p_distance) const;
 
 protected:
@@ -200,6 +205,9 @@ public:
 	void set_stream_paused(bool p_pause);
 	bool get_stream_paused() const;
 
+	void set_voice_priority(int p_priority);
+	int get_voice_priority() const;
+
 	Ref<AudioStreamPlayback> get_stream_playback();
 
 	AudioStreamPlayer3D();
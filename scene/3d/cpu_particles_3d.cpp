@@ -30,6 +30,7 @@
 
 #include "cpu_particles_3d.h"
 
+#include "core/math/simd.h"
 #include "scene/3d/camera_3d.h"
 #include "scene/3d/gpu_particles_3d.h"
 #include "scene/resources/particles_material.h"
@@ -44,16 +45,16 @@ Vector<Face3> CPUParticles3D::get_faces(uint32_t p_usage_particle_flags) const {
 }
 
 void CPUParticles3D::set_emitting(bool p_emitting) {
-	if (emitting == p_emitting) {
+	if (simulation.emitting == p_emitting) {
 		return;
 	}
 
-	emitting = p_emitting;
-	if (emitting) {
+	simulation.emitting = p_emitting;
+	if (simulation.emitting) {
 		set_process_internal(true);
 
 		// first update before rendering to avoid one frame delay after emitting starts
-		if (time == 0) {
+		if (simulation.time == 0) {
 			_update_internal();
 		}
 	}
@@ -62,15 +63,7 @@ void CPUParticles3D::set_emitting(bool p_emitting) {
 void CPUParticles3D::set_amount(int p_amount) {
 	ERR_FAIL_COND_MSG(p_amount < 1, "Amount of particles must be greater than 0.");
 
-	particles.resize(p_amount);
-	{
-		Particle *w = particles.ptrw();
-
-		for (int i = 0; i < p_amount; i++) {
-			w[i].active = false;
-			w[i].custom[3] = 0.0; // Make sure w component isn't garbage data
-		}
-	}
+	simulation.set_amount(p_amount);
 
 	particle_data.resize((12 + 4 + 4) * p_amount);
 	RS::get_singleton()->multimesh_allocate_data(multimesh, p_amount, RS::MULTIMESH_TRANSFORM_3D, true, true);
@@ -80,11 +73,11 @@ void CPUParticles3D::set_amount(int p_amount) {
 
 void CPUParticles3D::set_lifetime(float p_lifetime) {
 	ERR_FAIL_COND_MSG(p_lifetime <= 0, "Particles lifetime must be greater than 0.");
-	lifetime = p_lifetime;
+	simulation.lifetime = p_lifetime;
 }
 
 void CPUParticles3D::set_one_shot(bool p_one_shot) {
-	one_shot = p_one_shot;
+	simulation.one_shot = p_one_shot;
 }
 
 void CPUParticles3D::set_pre_process_time(float p_time) {
@@ -92,39 +85,39 @@ void CPUParticles3D::set_pre_process_time(float p_time) {
 }
 
 void CPUParticles3D::set_explosiveness_ratio(float p_ratio) {
-	explosiveness_ratio = p_ratio;
+	simulation.explosiveness_ratio = p_ratio;
 }
 
 void CPUParticles3D::set_randomness_ratio(float p_ratio) {
-	randomness_ratio = p_ratio;
+	simulation.randomness_ratio = p_ratio;
 }
 
 void CPUParticles3D::set_lifetime_randomness(float p_random) {
-	lifetime_randomness = p_random;
+	simulation.lifetime_randomness = p_random;
 }
 
 void CPUParticles3D::set_use_local_coordinates(bool p_enable) {
-	local_coords = p_enable;
+	simulation.local_coords = p_enable;
 }
 
 void CPUParticles3D::set_speed_scale(float p_scale) {
-	speed_scale = p_scale;
+	simulation.speed_scale = p_scale;
 }
 
 bool CPUParticles3D::is_emitting() const {
-	return emitting;
+	return simulation.emitting;
 }
 
 int CPUParticles3D::get_amount() const {
-	return particles.size();
+	return simulation.particles.size();
 }
 
 float CPUParticles3D::get_lifetime() const {
-	return lifetime;
+	return simulation.lifetime;
 }
 
 bool CPUParticles3D::get_one_shot() const {
-	return one_shot;
+	return simulation.one_shot;
 }
 
 float CPUParticles3D::get_pre_process_time() const {
@@ -132,23 +125,23 @@ float CPUParticles3D::get_pre_process_time() const {
 }
 
 float CPUParticles3D::get_explosiveness_ratio() const {
-	return explosiveness_ratio;
+	return simulation.explosiveness_ratio;
 }
 
 float CPUParticles3D::get_randomness_ratio() const {
-	return randomness_ratio;
+	return simulation.randomness_ratio;
 }
 
 float CPUParticles3D::get_lifetime_randomness() const {
-	return lifetime_randomness;
+	return simulation.lifetime_randomness;
 }
 
 bool CPUParticles3D::get_use_local_coordinates() const {
-	return local_coords;
+	return simulation.local_coords;
 }
 
 float CPUParticles3D::get_speed_scale() const {
-	return speed_scale;
+	return simulation.speed_scale;
 }
 
 void CPUParticles3D::set_draw_order(DrawOrder p_order) {
@@ -182,11 +175,11 @@ int CPUParticles3D::get_fixed_fps() const {
 }
 
 void CPUParticles3D::set_fractional_delta(bool p_enable) {
-	fractional_delta = p_enable;
+	simulation.fractional_delta = p_enable;
 }
 
 bool CPUParticles3D::get_fractional_delta() const {
-	return fractional_delta;
+	return simulation.fractional_delta;
 }
 
 TypedArray<String> CPUParticles3D::get_configuration_warnings() const {
@@ -221,70 +214,63 @@ TypedArray<String> CPUParticles3D::get_configuration_warnings() const {
 }
 
 void CPUParticles3D::restart() {
-	time = 0;
+	simulation.time = 0;
 	inactive_time = 0;
 	frame_remainder = 0;
-	cycle = 0;
-	emitting = false;
+	simulation.cycle = 0;
+	simulation.emitting = false;
 
-	{
-		int pc = particles.size();
-		Particle *w = particles.ptrw();
-
-		for (int i = 0; i < pc; i++) {
-			w[i].active = false;
-		}
-	}
+	simulation.deactivate();
 
 	set_emitting(true);
 }
 
 void CPUParticles3D::set_direction(Vector3 p_direction) {
-	direction = p_direction;
+	simulation.direction = p_direction;
 }
 
 Vector3 CPUParticles3D::get_direction() const {
-	return direction;
+	return simulation.direction;
 }
 
 void CPUParticles3D::set_spread(float p_spread) {
-	spread = p_spread;
+	simulation.spread = p_spread;
 }
 
 float CPUParticles3D::get_spread() const {
-	return spread;
+	return simulation.spread;
 }
 
 void CPUParticles3D::set_flatness(float p_flatness) {
-	flatness = p_flatness;
+	simulation.flatness = p_flatness;
 }
 
 float CPUParticles3D::get_flatness() const {
-	return flatness;
+	return simulation.flatness;
 }
 
 void CPUParticles3D::set_param(Parameter p_param, float p_value) {
 	ERR_FAIL_INDEX(p_param, PARAM_MAX);
 
-	parameters[p_param] = p_value;
+	simulation.parameters[p_param] = p_value;
 }
 
 float CPUParticles3D::get_param(Parameter p_param) const {
 	ERR_FAIL_INDEX_V(p_param, PARAM_MAX, 0);
 
-	return parameters[p_param];
+	return simulation.parameters[p_param];
 }
 
 void CPUParticles3D::set_param_randomness(Parameter p_param, float p_value) {
 	ERR_FAIL_INDEX(p_param, PARAM_MAX);
 
-	randomness[p_param] = p_value;
+	simulation.randomness[p_param] = p_value;
 }
 
 float CPUParticles3D::get_param_randomness(Parameter p_param) const {
 	ERR_FAIL_INDEX_V(p_param, PARAM_MAX, 0);
 
-	return randomness[p_param];
+	return simulation.randomness[p_param];
 }
 
 static void _adjust_curve_range(const Ref<Curve> &p_curve, float p_min, float p_max) {
@@ -299,7 +285,7 @@ static void _adjust_curve_range(const Ref<Curve> &p_curve, float p_min, float p_
 void CPUParticles3D::set_param_curve(Parameter p_param, const Ref<Curve> &p_curve) {
 	ERR_FAIL_INDEX(p_param, PARAM_MAX);
 
-	curve_parameters[p_param] = p_curve;
+	simulation.curve_parameters[p_param] = p_curve;
 
 	switch (p_param) {
 		case PARAM_INITIAL_LINEAR_VELOCITY: {
@@ -344,28 +330,28 @@ void CPUParticles3D::set_param_curve(Parameter p_param, const Ref<Curve> &p_curv
 Ref<Curve> CPUParticles3D::get_param_curve(Parameter p_param) const {
 	ERR_FAIL_INDEX_V(p_param, PARAM_MAX, Ref<Curve>());
 
-	return curve_parameters[p_param];
+	return simulation.curve_parameters[p_param];
 }
 
 void CPUParticles3D::set_color(const Color &p_color) {
-	color = p_color;
+	simulation.color = p_color;
 }
 
 Color CPUParticles3D::get_color() const {
-	return color;
+	return simulation.color;
 }
 
 void CPUParticles3D::set_color_ramp(const Ref<Gradient> &p_ramp) {
-	color_ramp = p_ramp;
+	simulation.color_ramp = p_ramp;
 }
 
 Ref<Gradient> CPUParticles3D::get_color_ramp() const {
-	return color_ramp;
+	return simulation.color_ramp;
 }
 
 void CPUParticles3D::set_particle_flag(ParticleFlags p_particle_flag, bool p_enable) {
 	ERR_FAIL_INDEX(p_particle_flag, PARTICLE_FLAG_MAX);
-	particle_flags[p_particle_flag] = p_enable;
+	simulation.particle_flags[p_particle_flag] = p_enable;
 	if (p_particle_flag == PARTICLE_FLAG_DISABLE_Z) {
 		notify_property_list_changed();
 	}
@@ -373,88 +359,88 @@ void CPUParticles3D::set_particle_flag(ParticleFlags p_particle_flag, bool p_ena
 
 bool CPUParticles3D::get_particle_flag(ParticleFlags p_particle_flag) const {
 	ERR_FAIL_INDEX_V(p_particle_flag, PARTICLE_FLAG_MAX, false);
-	return particle_flags[p_particle_flag];
+	return simulation.particle_flags[p_particle_flag];
 }
 
 void CPUParticles3D::set_emission_shape(EmissionShape p_shape) {
 	ERR_FAIL_INDEX(p_shape, EMISSION_SHAPE_MAX);
-	emission_shape = p_shape;
+	simulation.emission_shape = p_shape;
 }
 
 void CPUParticles3D::set_emission_sphere_radius(float p_radius) {
-	emission_sphere_radius = p_radius;
+	simulation.emission_sphere_radius = p_radius;
 }
 
 void CPUParticles3D::set_emission_box_extents(Vector3 p_extents) {
-	emission_box_extents = p_extents;
+	simulation.emission_box_extents = p_extents;
 }
 
 void CPUParticles3D::set_emission_points(const Vector<Vector3> &p_points) {
-	emission_points = p_points;
+	simulation.emission_points = p_points;
 }
 
 void CPUParticles3D::set_emission_normals(const Vector<Vector3> &p_normals) {
-	emission_normals = p_normals;
+	simulation.emission_normals = p_normals;
 }
 
 void CPUParticles3D::set_emission_colors(const Vector<Color> &p_colors) {
-	emission_colors = p_colors;
+	simulation.emission_colors = p_colors;
 }
 
 float CPUParticles3D::get_emission_sphere_radius() const {
-	return emission_sphere_radius;
+	return simulation.emission_sphere_radius;
 }
 
 Vector3 CPUParticles3D::get_emission_box_extents() const {
-	return emission_box_extents;
+	return simulation.emission_box_extents;
 }
 
 Vector<Vector3> CPUParticles3D::get_emission_points() const {
-	return emission_points;
+	return simulation.emission_points;
 }
 
 Vector<Vector3> CPUParticles3D::get_emission_normals() const {
-	return emission_normals;
+	return simulation.emission_normals;
 }
 
 Vector<Color> CPUParticles3D::get_emission_colors() const {
-	return emission_colors;
+	return simulation.emission_colors;
 }
 
 CPUParticles3D::EmissionShape CPUParticles3D::get_emission_shape() const {
-	return emission_shape;
+	return simulation.emission_shape;
 }
 
 void CPUParticles3D::set_gravity(const Vector3 &p_gravity) {
-	gravity = p_gravity;
+	simulation.gravity = p_gravity;
 }
 
 Vector3 CPUParticles3D::get_gravity() const {
-	return gravity;
+	return simulation.gravity;
 }
 
 void CPUParticles3D::_validate_property(PropertyInfo &property) const {
-	if (property.name == "color" && color_ramp.is_valid()) {
+	if (property.name == "color" && simulation.color_ramp.is_valid()) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_sphere_radius" && emission_shape != EMISSION_SHAPE_SPHERE) {
+	if (property.name == "emission_sphere_radius" && simulation.emission_shape != EMISSION_SHAPE_SPHERE) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_box_extents" && emission_shape != EMISSION_SHAPE_BOX) {
+	if (property.name == "emission_box_extents" && simulation.emission_shape != EMISSION_SHAPE_BOX) {
 		property.usage = 0;
 	}
 
-	if ((property.name == "emission_point_texture" || property.name == "emission_color_texture") && (emission_shape < EMISSION_SHAPE_POINTS)) {
+	if ((property.name == "emission_point_texture" || property.name == "emission_color_texture") && (simulation.emission_shape < EMISSION_SHAPE_POINTS)) {
 		property.usage = 0;
 	}
 
-	if (property.name == "emission_normals" && emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
+	if (property.name == "emission_normals" && simulation.emission_shape != EMISSION_SHAPE_DIRECTED_POINTS) {
 		property.usage = 0;
 	}
 
-	if (property.name.begins_with("orbit_") && !particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
+	if (property.name.begins_with("orbit_") && !simulation.particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
 		property.usage = 0;
 	}
 }
@@ -482,25 +468,25 @@ static float rand_from_seed(uint32_t &seed) {
 }
 
 void CPUParticles3D::_update_internal() {
-	if (particles.size() == 0 || !is_visible_in_tree()) {
+	if (simulation.particles.size() == 0 || !is_visible_in_tree()) {
 		_set_redraw(false);
 		return;
 	}
 
 	float delta = get_process_delta_time();
-	if (emitting) {
+	if (simulation.emitting) {
 		inactive_time = 0;
 	} else {
 		inactive_time += delta;
-		if (inactive_time > lifetime * 1.2) {
+		if (inactive_time > simulation.lifetime * 1.2) {
 			set_process_internal(false);
 			_set_redraw(false);
 
 			//reset variables
-			time = 0;
+			simulation.time = 0;
 			inactive_time = 0;
 			frame_remainder = 0;
-			cycle = 0;
+			simulation.cycle = 0;
 			return;
 		}
 	}
@@ -508,7 +494,7 @@ void CPUParticles3D::_update_internal() {
 
 	bool processed = false;
 
-	if (time == 0 && pre_process_time > 0.0) {
+	if (simulation.time == 0 && pre_process_time > 0.0) {
 		float frame_time;
 		if (fixed_fps > 0) {
 			frame_time = 1.0 / fixed_fps;
@@ -556,12 +542,227 @@ void CPUParticles3D::_update_internal() {
 }
 
 void CPUParticles3D::_particles_process(float p_delta) {
+	bool was_emitting = simulation.emitting;
+
+	simulation.process(p_delta, simulation.local_coords ? Transform() : get_global_transform(), _get_work_pool(simulation.particles.size()));
+
+	if (was_emitting && !simulation.emitting) {
+		// A one shot system finished its cycle.
+		notify_property_list_changed();
+	}
+}
+
+void CPUParticles3D::_update_particle_data_buffer() {
+	MutexLock lock(update_mutex);
+
+	int pc = simulation.particles.size();
+
+	int *ow;
+	int *order = nullptr;
+
+	float *w = particle_data.ptrw();
+
+	if (draw_order != DRAW_ORDER_INDEX) {
+		ow = particle_order.ptrw();
+		order = ow;
+
+		for (int i = 0; i < pc; i++) {
+			order[i] = i;
+		}
+		if (draw_order == DRAW_ORDER_LIFETIME) {
+			SortArray<int, SortLifetime> sorter;
+			sorter.compare.particles = simulation.particles.ptr();
+			sorter.sort(order, pc);
+		} else if (draw_order == DRAW_ORDER_VIEW_DEPTH) {
+			ERR_FAIL_NULL(get_viewport());
+			Camera3D *c = get_viewport()->get_camera();
+			if (c) {
+				Vector3 dir = c->get_global_transform().basis.get_axis(2); //far away to close
+
+				if (simulation.local_coords) {
+					// will look different from Particles in editor as this is based on the camera in the scenetree
+					// and not the editor camera
+					dir = inv_emission_transform.xform(dir).normalized();
+				} else {
+					dir = dir.normalized();
+				}
+
+				SortArray<int, SortAxis> sorter;
+				for (int i = 0; i < 3; i++) {
+					sorter.compare.origin[i] = simulation.origin[i].ptr();
+				}
+				sorter.compare.axis = dir;
+				sorter.sort(order, pc);
+			}
+		}
+	}
+
+	ProcessChunks chunks;
+	chunks.order = order;
+	chunks.data = w;
+	chunks.count = pc;
+
+	uint32_t chunk_count = (chunks.count + PROCESS_CHUNK_SIZE - 1) / PROCESS_CHUNK_SIZE;
+	ThreadWorkPool *pool = _get_work_pool(chunks.count);
+	if (pool) {
+		pool->do_work(chunk_count, this, &CPUParticles3D::_update_particle_data_chunk, &chunks);
+	} else {
+		for (uint32_t i = 0; i < chunk_count; i++) {
+			_update_particle_data_chunk(i, &chunks);
+		}
+	}
+
+	can_update.set();
+}
+
+void CPUParticles3D::_update_particle_data_chunk(uint32_t p_chunk, ProcessChunks *p_chunks) {
+	uint32_t from = p_chunk * PROCESS_CHUNK_SIZE;
+	uint32_t to = MIN(from + PROCESS_CHUNK_SIZE, p_chunks->count);
+
+	const int *order = p_chunks->order;
+	float *ptr = p_chunks->data + from * 20;
+
+	for (uint32_t i = from; i < to; i++) {
+		uint32_t idx = order ? uint32_t(order[i]) : i;
+
+		_write_particle_transform(idx, ptr);
+
+		Color c = simulation.get_color(idx);
+
+		ptr[12] = c.r;
+		ptr[13] = c.g;
+		ptr[14] = c.b;
+		ptr[15] = c.a;
+
+		const Particle &p = simulation.particles[idx];
+		ptr[16] = p.custom[0];
+		ptr[17] = p.custom[1];
+		ptr[18] = p.custom[2];
+		ptr[19] = p.custom[3];
+
+		ptr += 20;
+	}
+}
+
+void CPUParticles3D::_write_particle_transform(uint32_t p_index, float *r_data) const {
+	if (!simulation.particles[p_index].active) {
+		memset(r_data, 0, sizeof(float) * 12);
+		return;
+	}
+
+	Transform t = simulation.get_transform(p_index);
+
+	if (!simulation.local_coords) {
+		t = inv_emission_transform * t;
+	}
+
+	r_data[0] = t.basis.elements[0][0];
+	r_data[1] = t.basis.elements[0][1];
+	r_data[2] = t.basis.elements[0][2];
+	r_data[3] = t.origin.x;
+	r_data[4] = t.basis.elements[1][0];
+	r_data[5] = t.basis.elements[1][1];
+	r_data[6] = t.basis.elements[1][2];
+	r_data[7] = t.origin.y;
+	r_data[8] = t.basis.elements[2][0];
+	r_data[9] = t.basis.elements[2][1];
+	r_data[10] = t.basis.elements[2][2];
+	r_data[11] = t.origin.z;
+}
+
+ThreadWorkPool *CPUParticles3D::_get_work_pool(uint32_t p_count) {
+	if (p_count <= PROCESS_CHUNK_SIZE) {
+		return nullptr;
+	}
+
+	if (!work_pool) {
+		work_pool = memnew(ThreadWorkPool);
+		work_pool->init();
+	}
+	return work_pool;
+}
+
+/* SIMULATION */
+
+template <class T>
+static void _resize_cleared(LocalVector<T> &r_array, uint32_t p_size) {
+	r_array.resize(p_size);
+	if (p_size) {
+		memset(r_array.ptr(), 0, sizeof(T) * p_size);
+	}
+}
+
+void CPUParticles3D::Simulation::set_amount(int p_amount) {
+	particles.resize(p_amount);
+	for (int i = 0; i < p_amount; i++) {
+		particles[i].active = false;
+		particles[i].custom[3] = 0.0; // Make sure w component isn't garbage data
+	}
+
+	for (int i = 0; i < 9; i++) {
+		_resize_cleared(basis[i], p_amount);
+	}
+	for (int i = 0; i < 3; i++) {
+		_resize_cleared(origin[i], p_amount);
+		_resize_cleared(velocity[i], p_amount);
+	}
+	for (int i = 0; i < 4; i++) {
+		_resize_cleared(colors[i], p_amount);
+		_resize_cleared(ramp_colors[i], p_amount);
+		_resize_cleared(base_colors[i], p_amount);
+	}
+	for (int i = 0; i < 2; i++) {
+		_resize_cleared(hue_rotations[i], p_amount);
+	}
+	_resize_cleared(steps, p_amount);
+	_resize_cleared(deltas, p_amount);
+	_resize_cleared(scales, p_amount);
+}
+
+void CPUParticles3D::Simulation::deactivate() {
+	for (uint32_t i = 0; i < particles.size(); i++) {
+		particles[i].active = false;
+	}
+}
+
+Transform CPUParticles3D::Simulation::get_transform(uint32_t p_index) const {
+	Transform t;
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			t.basis.elements[i][j] = basis[i * 3 + j][p_index];
+		}
+		t.origin[i] = origin[i][p_index];
+	}
+	return t;
+}
+
+void CPUParticles3D::Simulation::set_transform(uint32_t p_index, const Transform &p_transform) {
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			basis[i * 3 + j][p_index] = p_transform.basis.elements[i][j];
+		}
+		origin[i][p_index] = p_transform.origin[i];
+	}
+}
+
+Vector3 CPUParticles3D::Simulation::get_velocity(uint32_t p_index) const {
+	return Vector3(velocity[0][p_index], velocity[1][p_index], velocity[2][p_index]);
+}
+
+void CPUParticles3D::Simulation::set_velocity(uint32_t p_index, const Vector3 &p_velocity) {
+	for (int i = 0; i < 3; i++) {
+		velocity[i][p_index] = p_velocity[i];
+	}
+}
+
+Color CPUParticles3D::Simulation::get_color(uint32_t p_index) const {
+	return Color(colors[0][p_index], colors[1][p_index], colors[2][p_index], colors[3][p_index]);
+}
+
+void CPUParticles3D::Simulation::process(float p_delta, const Transform &p_emission_xform, ThreadWorkPool *p_pool) {
 	p_delta *= speed_scale;
 
 	int pcount = particles.size();
-	Particle *w = particles.ptrw();
-
-	Particle *parray = w;
 
 	float prev_time = time;
 	time += p_delta;
@@ -569,22 +770,22 @@ void CPUParticles3D::_particles_process(float p_delta) {
 		time = Math::fmod(time, lifetime);
 		cycle++;
 		if (one_shot && cycle > 0) {
-			set_emitting(false);
-			notify_property_list_changed();
+			emitting = false;
 		}
 	}
 
 	Transform emission_xform;
-	Basis velocity_xform;
 	if (!local_coords) {
-		emission_xform = get_global_transform();
-		velocity_xform = emission_xform.basis;
+		emission_xform = p_emission_xform;
 	}
+	emission_origin = emission_xform.origin;
 
 	float system_phase = time / lifetime;
 
 	for (int i = 0; i < pcount; i++) {
-		Particle &p = parray[i];
+		Particle &p = particles[i];
+		steps[i] = PARTICLE_STEP_SKIP;
+		deltas[i] = 0.0;
 
 		if (!emitting && !p.active) {
 			continue;
@@ -641,136 +842,196 @@ void CPUParticles3D::_particles_process(float p_delta) {
 			restart = true;
 		}
 
-		float tv = 0.0;
-
 		if (restart) {
 			if (!emitting) {
 				p.active = false;
 				continue;
 			}
 			p.active = true;
+			steps[i] = PARTICLE_STEP_RESTARTED;
+			_emit(i, emission_xform);
+		} else if (!p.active) {
+			continue;
+		} else if (p.time > p.lifetime) {
+			p.active = false;
+			steps[i] = PARTICLE_STEP_EXPIRED;
+		} else {
+			steps[i] = PARTICLE_STEP_UPDATE;
+		}
 
-			/*float tex_linear_velocity = 0;
-			if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
-				tex_linear_velocity = curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY]->interpolate(0);
-			}*/
+		deltas[i] = local_delta;
+	}
 
-			float tex_angle = 0.0;
-			if (curve_parameters[PARAM_ANGLE].is_valid()) {
-				tex_angle = curve_parameters[PARAM_ANGLE]->interpolate(tv);
-			}
+	if (color_ramp.is_valid()) {
+		// Sorts the gradient points if needed, so the workers only read them.
+		color_ramp->get_color_at_offset(0.0);
+	}
 
-			float tex_anim_offset = 0.0;
-			if (curve_parameters[PARAM_ANGLE].is_valid()) {
-				tex_anim_offset = curve_parameters[PARAM_ANGLE]->interpolate(tv);
-			}
+	uint32_t chunk_count = (pcount + PROCESS_CHUNK_SIZE - 1) / PROCESS_CHUNK_SIZE;
+	if (p_pool && chunk_count > 1) {
+		p_pool->do_work(chunk_count, this, &Simulation::_process_chunk, uint32_t(pcount));
+	} else {
+		for (uint32_t i = 0; i < chunk_count; i++) {
+			_process_chunk(i, pcount);
+		}
+	}
+}
 
-			p.seed = Math::rand();
+void CPUParticles3D::Simulation::_emit(uint32_t p_index, const Transform &p_emission_xform) {
+	Particle &p = particles[p_index];
+	float tv = 0.0;
 
-			p.angle_rand = Math::randf();
-			p.scale_rand = Math::randf();
-			p.hue_rot_rand = Math::randf();
-			p.anim_offset_rand = Math::randf();
+	/*float tex_linear_velocity = 0;
+	if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
+		tex_linear_velocity = curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY]->interpolate(0);
+	}*/
 
-			if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
-				float angle1_rad = Math::atan2(direction.y, direction.x) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * spread);
-				Vector3 rot = Vector3(Math::cos(angle1_rad), Math::sin(angle1_rad), 0.0);
-				p.velocity = rot * parameters[PARAM_INITIAL_LINEAR_VELOCITY] * Math::lerp(1.0f, float(Math::randf()), randomness[PARAM_INITIAL_LINEAR_VELOCITY]);
-			} else {
-				//initiate velocity spread in 3D
-				float angle1_rad = Math::atan2(direction.x, direction.z) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * spread);
-				float angle2_rad = Math::atan2(direction.y, Math::abs(direction.z)) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * (1.0 - flatness) * spread);
-
-				Vector3 direction_xz = Vector3(Math::sin(angle1_rad), 0, Math::cos(angle1_rad));
-				Vector3 direction_yz = Vector3(0, Math::sin(angle2_rad), Math::cos(angle2_rad));
-				direction_yz.z = direction_yz.z / MAX(0.0001, Math::sqrt(ABS(direction_yz.z))); //better uniform distribution
-				Vector3 direction = Vector3(direction_xz.x * direction_yz.z, direction_yz.y, direction_xz.z * direction_yz.z);
-				direction.normalize();
-				p.velocity = direction * parameters[PARAM_INITIAL_LINEAR_VELOCITY] * Math::lerp(1.0f, float(Math::randf()), randomness[PARAM_INITIAL_LINEAR_VELOCITY]);
+	float tex_angle = 0.0;
+	if (curve_parameters[PARAM_ANGLE].is_valid()) {
+		tex_angle = curve_parameters[PARAM_ANGLE]->interpolate(tv);
+	}
+
+	float tex_anim_offset = 0.0;
+	if (curve_parameters[PARAM_ANGLE].is_valid()) {
+		tex_anim_offset = curve_parameters[PARAM_ANGLE]->interpolate(tv);
+	}
+
+	p.seed = Math::rand();
+
+	p.angle_rand = Math::randf();
+	p.scale_rand = Math::randf();
+	p.hue_rot_rand = Math::randf();
+	p.anim_offset_rand = Math::randf();
+
+	Vector3 vel;
+	if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
+		float angle1_rad = Math::atan2(direction.y, direction.x) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * spread);
+		Vector3 rot = Vector3(Math::cos(angle1_rad), Math::sin(angle1_rad), 0.0);
+		vel = rot * parameters[PARAM_INITIAL_LINEAR_VELOCITY] * Math::lerp(1.0f, float(Math::randf()), randomness[PARAM_INITIAL_LINEAR_VELOCITY]);
+	} else {
+		//initiate velocity spread in 3D
+		float angle1_rad = Math::atan2(direction.x, direction.z) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * spread);
+		float angle2_rad = Math::atan2(direction.y, Math::abs(direction.z)) + Math::deg2rad((Math::randf() * 2.0 - 1.0) * (1.0 - flatness) * spread);
+
+		Vector3 direction_xz = Vector3(Math::sin(angle1_rad), 0, Math::cos(angle1_rad));
+		Vector3 direction_yz = Vector3(0, Math::sin(angle2_rad), Math::cos(angle2_rad));
+		direction_yz.z = direction_yz.z / MAX(0.0001, Math::sqrt(ABS(direction_yz.z))); //better uniform distribution
+		Vector3 spread_direction = Vector3(direction_xz.x * direction_yz.z, direction_yz.y, direction_xz.z * direction_yz.z);
+		spread_direction.normalize();
+		vel = spread_direction * parameters[PARAM_INITIAL_LINEAR_VELOCITY] * Math::lerp(1.0f, float(Math::randf()), randomness[PARAM_INITIAL_LINEAR_VELOCITY]);
+	}
+
+	float base_angle = (parameters[PARAM_ANGLE] + tex_angle) * Math::lerp(1.0f, p.angle_rand, randomness[PARAM_ANGLE]);
+	p.custom[0] = Math::deg2rad(base_angle); //angle
+	p.custom[1] = 0.0; //phase
+	p.custom[2] = (parameters[PARAM_ANIM_OFFSET] + tex_anim_offset) * Math::lerp(1.0f, p.anim_offset_rand, randomness[PARAM_ANIM_OFFSET]); //animation offset (0-1)
+	Transform xform;
+	p.time = 0;
+	p.lifetime = lifetime * (1.0 - Math::randf() * lifetime_randomness);
+	Color base_color = Color(1, 1, 1, 1);
+
+	switch (emission_shape) {
+		case EMISSION_SHAPE_POINT: {
+			//do none
+		} break;
+		case EMISSION_SHAPE_SPHERE: {
+			real_t s = 2.0 * Math::randf() - 1.0;
+			real_t t = Math_TAU * Math::randf();
+			real_t radius = emission_sphere_radius * Math::sqrt(1.0 - s * s);
+			xform.origin = Vector3(radius * Math::cos(t), radius * Math::sin(t), emission_sphere_radius * s);
+		} break;
+		case EMISSION_SHAPE_BOX: {
+			xform.origin = Vector3(Math::randf() * 2.0 - 1.0, Math::randf() * 2.0 - 1.0, Math::randf() * 2.0 - 1.0) * emission_box_extents;
+		} break;
+		case EMISSION_SHAPE_POINTS:
+		case EMISSION_SHAPE_DIRECTED_POINTS: {
+			int pc = emission_points.size();
+			if (pc == 0) {
+				break;
 			}
 
-			float base_angle = (parameters[PARAM_ANGLE] + tex_angle) * Math::lerp(1.0f, p.angle_rand, randomness[PARAM_ANGLE]);
-			p.custom[0] = Math::deg2rad(base_angle); //angle
-			p.custom[1] = 0.0; //phase
-			p.custom[2] = (parameters[PARAM_ANIM_OFFSET] + tex_anim_offset) * Math::lerp(1.0f, p.anim_offset_rand, randomness[PARAM_ANIM_OFFSET]); //animation offset (0-1)
-			p.transform = Transform();
-			p.time = 0;
-			p.lifetime = lifetime * (1.0 - Math::randf() * lifetime_randomness);
-			p.base_color = Color(1, 1, 1, 1);
-
-			switch (emission_shape) {
-				case EMISSION_SHAPE_POINT: {
-					//do none
-				} break;
-				case EMISSION_SHAPE_SPHERE: {
-					real_t s = 2.0 * Math::randf() - 1.0;
-					real_t t = Math_TAU * Math::randf();
-					real_t radius = emission_sphere_radius * Math::sqrt(1.0 - s * s);
-					p.transform.origin = Vector3(radius * Math::cos(t), radius * Math::sin(t), emission_sphere_radius * s);
-				} break;
-				case EMISSION_SHAPE_BOX: {
-					p.transform.origin = Vector3(Math::randf() * 2.0 - 1.0, Math::randf() * 2.0 - 1.0, Math::randf() * 2.0 - 1.0) * emission_box_extents;
-				} break;
-				case EMISSION_SHAPE_POINTS:
-				case EMISSION_SHAPE_DIRECTED_POINTS: {
-					int pc = emission_points.size();
-					if (pc == 0) {
-						break;
-					}
-
-					int random_idx = Math::rand() % pc;
-
-					p.transform.origin = emission_points.get(random_idx);
-
-					if (emission_shape == EMISSION_SHAPE_DIRECTED_POINTS && emission_normals.size() == pc) {
-						if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
-							Vector3 normal = emission_normals.get(random_idx);
-							Vector2 normal_2d(normal.x, normal.y);
-							Transform2D m2;
-							m2.set_axis(0, normal_2d);
-							m2.set_axis(1, normal_2d.orthogonal());
-							Vector2 velocity_2d(p.velocity.x, p.velocity.y);
-							velocity_2d = m2.basis_xform(velocity_2d);
-							p.velocity.x = velocity_2d.x;
-							p.velocity.y = velocity_2d.y;
-						} else {
-							Vector3 normal = emission_normals.get(random_idx);
-							Vector3 v0 = Math::abs(normal.z) < 0.999 ? Vector3(0.0, 0.0, 1.0) : Vector3(0, 1.0, 0.0);
-							Vector3 tangent = v0.cross(normal).normalized();
-							Vector3 bitangent = tangent.cross(normal).normalized();
-							Basis m3;
-							m3.set_axis(0, tangent);
-							m3.set_axis(1, bitangent);
-							m3.set_axis(2, normal);
-							p.velocity = m3.xform(p.velocity);
-						}
-					}
-
-					if (emission_colors.size() == pc) {
-						p.base_color = emission_colors.get(random_idx);
-					}
-				} break;
-				case EMISSION_SHAPE_MAX: { // Max value for validity check.
-					break;
+			int random_idx = Math::rand() % pc;
+
+			xform.origin = emission_points.get(random_idx);
+
+			if (emission_shape == EMISSION_SHAPE_DIRECTED_POINTS && emission_normals.size() == pc) {
+				if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
+					Vector3 normal = emission_normals.get(random_idx);
+					Vector2 normal_2d(normal.x, normal.y);
+					Transform2D m2;
+					m2.set_axis(0, normal_2d);
+					m2.set_axis(1, normal_2d.orthogonal());
+					Vector2 velocity_2d(vel.x, vel.y);
+					velocity_2d = m2.basis_xform(velocity_2d);
+					vel.x = velocity_2d.x;
+					vel.y = velocity_2d.y;
+				} else {
+					Vector3 normal = emission_normals.get(random_idx);
+					Vector3 v0 = Math::abs(normal.z) < 0.999 ? Vector3(0.0, 0.0, 1.0) : Vector3(0, 1.0, 0.0);
+					Vector3 tangent = v0.cross(normal).normalized();
+					Vector3 bitangent = tangent.cross(normal).normalized();
+					Basis m3;
+					m3.set_axis(0, tangent);
+					m3.set_axis(1, bitangent);
+					m3.set_axis(2, normal);
+					vel = m3.xform(vel);
 				}
 			}
 
-			if (!local_coords) {
-				p.velocity = velocity_xform.xform(p.velocity);
-				p.transform = emission_xform * p.transform;
+			if (emission_colors.size() == pc) {
+				base_color = emission_colors.get(random_idx);
 			}
+		} break;
+		case EMISSION_SHAPE_MAX: { // Max value for validity check.
+			break;
+		}
+	}
 
-			if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
-				p.velocity.z = 0.0;
-				p.transform.origin.z = 0.0;
-			}
+	if (!local_coords) {
+		vel = p_emission_xform.basis.xform(vel);
+		xform = p_emission_xform * xform;
+	}
 
-		} else if (!p.active) {
+	if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
+		vel.z = 0.0;
+		xform.origin.z = 0.0;
+	}
+
+	set_transform(p_index, xform);
+	set_velocity(p_index, vel);
+	base_colors[0][p_index] = base_color.r;
+	base_colors[1][p_index] = base_color.g;
+	base_colors[2][p_index] = base_color.b;
+	base_colors[3][p_index] = base_color.a;
+}
+
+void CPUParticles3D::Simulation::_process_chunk(uint32_t p_chunk, uint32_t p_count) {
+	uint32_t from = p_chunk * PROCESS_CHUNK_SIZE;
+	uint32_t to = MIN(from + PROCESS_CHUNK_SIZE, p_count);
+
+	_update(from, to);
+	_scale(from, to);
+	_integrate(from, to);
+	_color(from, to);
+}
+
+void CPUParticles3D::Simulation::_update(uint32_t p_from, uint32_t p_to) {
+	for (uint32_t i = p_from; i < p_to; i++) {
+		Particle &p = particles[i];
+		float local_delta = deltas[i];
+		float tv = 0.0;
+
+		if (steps[i] == PARTICLE_STEP_SKIP) {
+			scales[i] = 1.0;
 			continue;
-		} else if (p.time > p.lifetime) {
-			p.active = false;
+		}
+
+		Transform xform = get_transform(i);
+		Vector3 vel = get_velocity(i);
+
+		if (steps[i] == PARTICLE_STEP_EXPIRED) {
 			tv = 1.0;
-		} else {
+		} else if (steps[i] == PARTICLE_STEP_UPDATE) {
 			uint32_t alt_seed = p.seed;
 
 			p.time += local_delta;
@@ -829,14 +1090,14 @@ void CPUParticles3D::_particles_process(float p_delta) {
 			}
 
 			Vector3 force = gravity;
-			Vector3 position = p.transform.origin;
+			Vector3 position = xform.origin;
 			if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
 				position.z = 0.0;
 			}
 			//apply linear acceleration
-			force += p.velocity.length() > 0.0 ? p.velocity.normalized() * (parameters[PARAM_LINEAR_ACCEL] + tex_linear_accel) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_LINEAR_ACCEL]) : Vector3();
+			force += vel.length() > 0.0 ? vel.normalized() * (parameters[PARAM_LINEAR_ACCEL] + tex_linear_accel) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_LINEAR_ACCEL]) : Vector3();
 			//apply radial acceleration
-			Vector3 org = emission_xform.origin;
+			Vector3 org = emission_origin;
 			Vector3 diff = position - org;
 			force += diff.length() > 0.0 ? diff.normalized() * (parameters[PARAM_RADIAL_ACCEL] + tex_radial_accel) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_RADIAL_ACCEL]) : Vector3();
 			//apply tangential acceleration;
@@ -850,7 +1111,7 @@ void CPUParticles3D::_particles_process(float p_delta) {
 				force += crossDiff.length() > 0.0 ? crossDiff.normalized() * ((parameters[PARAM_TANGENTIAL_ACCEL] + tex_tangential_accel) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_TANGENTIAL_ACCEL])) : Vector3();
 			}
 			//apply attractor forces
-			p.velocity += force * local_delta;
+			vel += force * local_delta;
 			//orbit velocity
 			if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
 				float orbit_amount = (parameters[PARAM_ORBIT_VELOCITY] + tex_orbit_velocity) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_ORBIT_VELOCITY]);
@@ -860,21 +1121,21 @@ void CPUParticles3D::_particles_process(float p_delta) {
 					// but we use -ang here to reproduce its behavior.
 					Transform2D rot = Transform2D(-ang, Vector2());
 					Vector2 rotv = rot.basis_xform(Vector2(diff.x, diff.y));
-					p.transform.origin -= Vector3(diff.x, diff.y, 0);
-					p.transform.origin += Vector3(rotv.x, rotv.y, 0);
+					xform.origin -= Vector3(diff.x, diff.y, 0);
+					xform.origin += Vector3(rotv.x, rotv.y, 0);
 				}
 			}
 			if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
-				p.velocity = p.velocity.normalized() * tex_linear_velocity;
+				vel = vel.normalized() * tex_linear_velocity;
 			}
 			if (parameters[PARAM_DAMPING] + tex_damping > 0.0) {
-				float v = p.velocity.length();
+				float v = vel.length();
 				float damp = (parameters[PARAM_DAMPING] + tex_damping) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_DAMPING]);
 				v -= damp * local_delta;
 				if (v < 0.0) {
-					p.velocity = Vector3();
+					vel = Vector3();
 				} else {
-					p.velocity = p.velocity.normalized() * v;
+					vel = vel.normalized() * v;
 				}
 			}
 			float base_angle = (parameters[PARAM_ANGLE] + tex_angle) * Math::lerp(1.0f, p.angle_rand, randomness[PARAM_ANGLE]);
@@ -882,6 +1143,7 @@ void CPUParticles3D::_particles_process(float p_delta) {
 			p.custom[0] = Math::deg2rad(base_angle); //angle
 			p.custom[2] = (parameters[PARAM_ANIM_OFFSET] + tex_anim_offset) * Math::lerp(1.0f, p.anim_offset_rand, randomness[PARAM_ANIM_OFFSET]) + p.custom[1] * (parameters[PARAM_ANIM_SPEED] + tex_anim_speed) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_ANIM_SPEED]); //angle
 		}
+
 		//apply color
 		//apply hue rotation
 
@@ -896,72 +1158,57 @@ void CPUParticles3D::_particles_process(float p_delta) {
 		}
 
 		float hue_rot_angle = (parameters[PARAM_HUE_VARIATION] + tex_hue_variation) * Math_TAU * Math::lerp(1.0f, p.hue_rot_rand * 2.0f - 1.0f, randomness[PARAM_HUE_VARIATION]);
-		float hue_rot_c = Math::cos(hue_rot_angle);
-		float hue_rot_s = Math::sin(hue_rot_angle);
-
-		Basis hue_rot_mat;
-		{
-			Basis mat1(0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114);
-			Basis mat2(0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886);
-			Basis mat3(0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203);
-
-			for (int j = 0; j < 3; j++) {
-				hue_rot_mat[j] = mat1[j] + mat2[j] * hue_rot_c + mat3[j] * hue_rot_s;
-			}
-		}
+		hue_rotations[0][i] = Math::cos(hue_rot_angle);
+		hue_rotations[1][i] = Math::sin(hue_rot_angle);
 
+		Color ramp_color = color;
 		if (color_ramp.is_valid()) {
-			p.color = color_ramp->get_color_at_offset(tv) * color;
-		} else {
-			p.color = color;
+			ramp_color = color_ramp->get_color_at_offset(tv) * color;
 		}
-
-		Vector3 color_rgb = hue_rot_mat.xform_inv(Vector3(p.color.r, p.color.g, p.color.b));
-		p.color.r = color_rgb.x;
-		p.color.g = color_rgb.y;
-		p.color.b = color_rgb.z;
-
-		p.color *= p.base_color;
+		ramp_colors[0][i] = ramp_color.r;
+		ramp_colors[1][i] = ramp_color.g;
+		ramp_colors[2][i] = ramp_color.b;
+		ramp_colors[3][i] = ramp_color.a;
 
 		if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
 			if (particle_flags[PARTICLE_FLAG_ALIGN_Y_TO_VELOCITY]) {
-				if (p.velocity.length() > 0.0) {
-					p.transform.basis.set_axis(1, p.velocity.normalized());
+				if (vel.length() > 0.0) {
+					xform.basis.set_axis(1, vel.normalized());
 				} else {
-					p.transform.basis.set_axis(1, p.transform.basis.get_axis(1));
+					xform.basis.set_axis(1, xform.basis.get_axis(1));
 				}
-				p.transform.basis.set_axis(0, p.transform.basis.get_axis(1).cross(p.transform.basis.get_axis(2)).normalized());
-				p.transform.basis.set_axis(2, Vector3(0, 0, 1));
+				xform.basis.set_axis(0, xform.basis.get_axis(1).cross(xform.basis.get_axis(2)).normalized());
+				xform.basis.set_axis(2, Vector3(0, 0, 1));
 
 			} else {
-				p.transform.basis.set_axis(0, Vector3(Math::cos(p.custom[0]), -Math::sin(p.custom[0]), 0.0));
-				p.transform.basis.set_axis(1, Vector3(Math::sin(p.custom[0]), Math::cos(p.custom[0]), 0.0));
-				p.transform.basis.set_axis(2, Vector3(0, 0, 1));
+				xform.basis.set_axis(0, Vector3(Math::cos(p.custom[0]), -Math::sin(p.custom[0]), 0.0));
+				xform.basis.set_axis(1, Vector3(Math::sin(p.custom[0]), Math::cos(p.custom[0]), 0.0));
+				xform.basis.set_axis(2, Vector3(0, 0, 1));
 			}
 
 		} else {
 			//orient particle Y towards velocity
 			if (particle_flags[PARTICLE_FLAG_ALIGN_Y_TO_VELOCITY]) {
-				if (p.velocity.length() > 0.0) {
-					p.transform.basis.set_axis(1, p.velocity.normalized());
+				if (vel.length() > 0.0) {
+					xform.basis.set_axis(1, vel.normalized());
 				} else {
-					p.transform.basis.set_axis(1, p.transform.basis.get_axis(1).normalized());
+					xform.basis.set_axis(1, xform.basis.get_axis(1).normalized());
 				}
-				if (p.transform.basis.get_axis(1) == p.transform.basis.get_axis(0)) {
-					p.transform.basis.set_axis(0, p.transform.basis.get_axis(1).cross(p.transform.basis.get_axis(2)).normalized());
-					p.transform.basis.set_axis(2, p.transform.basis.get_axis(0).cross(p.transform.basis.get_axis(1)).normalized());
+				if (xform.basis.get_axis(1) == xform.basis.get_axis(0)) {
+					xform.basis.set_axis(0, xform.basis.get_axis(1).cross(xform.basis.get_axis(2)).normalized());
+					xform.basis.set_axis(2, xform.basis.get_axis(0).cross(xform.basis.get_axis(1)).normalized());
 				} else {
-					p.transform.basis.set_axis(2, p.transform.basis.get_axis(0).cross(p.transform.basis.get_axis(1)).normalized());
-					p.transform.basis.set_axis(0, p.transform.basis.get_axis(1).cross(p.transform.basis.get_axis(2)).normalized());
+					xform.basis.set_axis(2, xform.basis.get_axis(0).cross(xform.basis.get_axis(1)).normalized());
+					xform.basis.set_axis(0, xform.basis.get_axis(1).cross(xform.basis.get_axis(2)).normalized());
 				}
 			} else {
-				p.transform.basis.orthonormalize();
+				xform.basis.orthonormalize();
 			}
 
 			//turn particle by rotation in Y
 			if (particle_flags[PARTICLE_FLAG_ROTATE_Y]) {
 				Basis rot_y(Vector3(0, 1, 0), p.custom[0]);
-				p.transform.basis = p.transform.basis * rot_y;
+				xform.basis = xform.basis * rot_y;
 			}
 		}
 
@@ -970,105 +1217,132 @@ void CPUParticles3D::_particles_process(float p_delta) {
 		if (base_scale < 0.000001) {
 			base_scale = 0.000001;
 		}
-
-		p.transform.basis.scale(Vector3(1, 1, 1) * base_scale);
+		scales[i] = base_scale;
 
 		if (particle_flags[PARTICLE_FLAG_DISABLE_Z]) {
-			p.velocity.z = 0.0;
-			p.transform.origin.z = 0.0;
+			vel.z = 0.0;
+			xform.origin.z = 0.0;
 		}
 
-		p.transform.origin += p.velocity * local_delta;
+		set_transform(i, xform);
+		set_velocity(i, vel);
 	}
 }
 
-void CPUParticles3D::_update_particle_data_buffer() {
-	MutexLock lock(update_mutex);
-
-	int pc = particles.size();
+void CPUParticles3D::Simulation::_scale(uint32_t p_from, uint32_t p_to) {
+	uint32_t i = p_from;
 
-	int *ow;
-	int *order = nullptr;
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const __m128 scale = _mm_loadu_ps(scales.ptr() + i);
+		for (int j = 0; j < 9; j++) {
+			real_t *b = basis[j].ptr() + i;
+			_mm_storeu_ps(b, _mm_mul_ps(_mm_loadu_ps(b), scale));
+		}
+	}
+#elif defined(SIMD_NEON) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const float32x4_t scale = vld1q_f32(scales.ptr() + i);
+		for (int j = 0; j < 9; j++) {
+			real_t *b = basis[j].ptr() + i;
+			vst1q_f32(b, vmulq_f32(vld1q_f32(b), scale));
+		}
+	}
+#endif
 
-	float *w = particle_data.ptrw();
-	const Particle *r = particles.ptr();
-	float *ptr = w;
+	for (; i < p_to; i++) {
+		for (int j = 0; j < 9; j++) {
+			basis[j][i] *= scales[i];
+		}
+	}
+}
 
-	if (draw_order != DRAW_ORDER_INDEX) {
-		ow = particle_order.ptrw();
-		order = ow;
+void CPUParticles3D::Simulation::_integrate(uint32_t p_from, uint32_t p_to) {
+	uint32_t i = p_from;
 
-		for (int i = 0; i < pc; i++) {
-			order[i] = i;
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const __m128 delta = _mm_loadu_ps(deltas.ptr() + i);
+		for (int j = 0; j < 3; j++) {
+			real_t *o = origin[j].ptr() + i;
+			_mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_mul_ps(_mm_loadu_ps(velocity[j].ptr() + i), delta)));
 		}
-		if (draw_order == DRAW_ORDER_LIFETIME) {
-			SortArray<int, SortLifetime> sorter;
-			sorter.compare.particles = r;
-			sorter.sort(order, pc);
-		} else if (draw_order == DRAW_ORDER_VIEW_DEPTH) {
-			ERR_FAIL_NULL(get_viewport());
-			Camera3D *c = get_viewport()->get_camera();
-			if (c) {
-				Vector3 dir = c->get_global_transform().basis.get_axis(2); //far away to close
+	}
+#elif defined(SIMD_NEON) && !defined(REAL_T_IS_DOUBLE)
+	for (; i + 4 <= p_to; i += 4) {
+		const float32x4_t delta = vld1q_f32(deltas.ptr() + i);
+		for (int j = 0; j < 3; j++) {
+			real_t *o = origin[j].ptr() + i;
+			vst1q_f32(o, vaddq_f32(vld1q_f32(o), vmulq_f32(vld1q_f32(velocity[j].ptr() + i), delta)));
+		}
+	}
+#endif
 
-				if (local_coords) {
-					// will look different from Particles in editor as this is based on the camera in the scenetree
-					// and not the editor camera
-					dir = inv_emission_transform.xform(dir).normalized();
-				} else {
-					dir = dir.normalized();
-				}
+	for (; i < p_to; i++) {
+		for (int j = 0; j < 3; j++) {
+			origin[j][i] += velocity[j][i] * deltas[i];
+		}
+	}
+}
 
-				SortArray<int, SortAxis> sorter;
-				sorter.compare.particles = r;
-				sorter.compare.axis = dir;
-				sorter.sort(order, pc);
+// Rotates the hue by blending three matrices with the cosine and sine of the angle, row major.
+static const float hue_rotation_matrices[3][9] = {
+	{ 0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114 },
+	{ 0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886 },
+	{ 0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203 },
+};
+
+void CPUParticles3D::Simulation::_color(uint32_t p_from, uint32_t p_to) {
+	const float(*m)[9] = hue_rotation_matrices;
+	uint32_t i = p_from;
+
+	// Each output channel is the ramp color times a column of the blended matrix, as Basis::xform_inv().
+#if defined(SIMD_SSE2)
+	for (; i + 4 <= p_to; i += 4) {
+		const __m128 c = _mm_loadu_ps(hue_rotations[0].ptr() + i);
+		const __m128 s = _mm_loadu_ps(hue_rotations[1].ptr() + i);
+		for (int j = 0; j < 3; j++) {
+			__m128 channel = _mm_setzero_ps();
+			for (int k = 0; k < 3; k++) {
+				const int e = k * 3 + j;
+				__m128 weight = _mm_add_ps(_mm_add_ps(_mm_set1_ps(m[0][e]), _mm_mul_ps(_mm_set1_ps(m[1][e]), c)), _mm_mul_ps(_mm_set1_ps(m[2][e]), s));
+				channel = _mm_add_ps(channel, _mm_mul_ps(weight, _mm_loadu_ps(ramp_colors[k].ptr() + i)));
 			}
+			_mm_storeu_ps(colors[j].ptr() + i, _mm_mul_ps(channel, _mm_loadu_ps(base_colors[j].ptr() + i)));
 		}
+		_mm_storeu_ps(colors[3].ptr() + i, _mm_mul_ps(_mm_loadu_ps(ramp_colors[3].ptr() + i), _mm_loadu_ps(base_colors[3].ptr() + i)));
 	}
-
-	for (int i = 0; i < pc; i++) {
-		int idx = order ? order[i] : i;
-
-		Transform t = r[idx].transform;
-
-		if (!local_coords) {
-			t = inv_emission_transform * t;
+#elif defined(SIMD_NEON)
+	for (; i + 4 <= p_to; i += 4) {
+		const float32x4_t c = vld1q_f32(hue_rotations[0].ptr() + i);
+		const float32x4_t s = vld1q_f32(hue_rotations[1].ptr() + i);
+		for (int j = 0; j < 3; j++) {
+			float32x4_t channel = vdupq_n_f32(0.0);
+			for (int k = 0; k < 3; k++) {
+				const int e = k * 3 + j;
+				float32x4_t weight = vaddq_f32(vaddq_f32(vdupq_n_f32(m[0][e]), vmulq_n_f32(c, m[1][e])), vmulq_n_f32(s, m[2][e]));
+				channel = vaddq_f32(channel, vmulq_f32(weight, vld1q_f32(ramp_colors[k].ptr() + i)));
+			}
+			vst1q_f32(colors[j].ptr() + i, vmulq_f32(channel, vld1q_f32(base_colors[j].ptr() + i)));
 		}
-
-		if (r[idx].active) {
-			ptr[0] = t.basis.elements[0][0];
-			ptr[1] = t.basis.elements[0][1];
-			ptr[2] = t.basis.elements[0][2];
-			ptr[3] = t.origin.x;
-			ptr[4] = t.basis.elements[1][0];
-			ptr[5] = t.basis.elements[1][1];
-			ptr[6] = t.basis.elements[1][2];
-			ptr[7] = t.origin.y;
-			ptr[8] = t.basis.elements[2][0];
-			ptr[9] = t.basis.elements[2][1];
-			ptr[10] = t.basis.elements[2][2];
-			ptr[11] = t.origin.z;
-		} else {
-			memset(ptr, 0, sizeof(float) * 12);
+		vst1q_f32(colors[3].ptr() + i, vmulq_f32(vld1q_f32(ramp_colors[3].ptr() + i), vld1q_f32(base_colors[3].ptr() + i)));
+	}
+#endif
+
+	for (; i < p_to; i++) {
+		const float c = hue_rotations[0][i];
+		const float s = hue_rotations[1][i];
+		for (int j = 0; j < 3; j++) {
+			float channel = 0.0;
+			for (int k = 0; k < 3; k++) {
+				const int e = k * 3 + j;
+				float weight = (m[0][e] + m[1][e] * c) + m[2][e] * s;
+				channel += weight * ramp_colors[k][i];
+			}
+			colors[j][i] = channel * base_colors[j][i];
 		}
-
-		Color c = r[idx].color;
-
-		ptr[12] = c.r;
-		ptr[13] = c.g;
-		ptr[14] = c.b;
-		ptr[15] = c.a;
-
-		ptr[16] = r[idx].custom[0];
-		ptr[17] = r[idx].custom[1];
-		ptr[18] = r[idx].custom[2];
-		ptr[19] = r[idx].custom[3];
-
-		ptr += 20;
+		colors[3][i] = ramp_colors[3][i] * base_colors[3][i];
 	}
-
-	can_update.set();
 }
 
 void CPUParticles3D::_set_redraw(bool p_redraw) {
@@ -1105,10 +1379,10 @@ void CPUParticles3D::_update_render_thread() {
 
 void CPUParticles3D::_notification(int p_what) {
 	if (p_what == NOTIFICATION_ENTER_TREE) {
-		set_process_internal(emitting);
+		set_process_internal(simulation.emitting);
 
 		// first update before rendering to avoid one frame delay after emitting starts
-		if (emitting && (time == 0)) {
+		if (simulation.emitting && (simulation.time == 0)) {
 			_update_internal();
 		}
 	}
@@ -1119,7 +1393,7 @@ void CPUParticles3D::_notification(int p_what) {
 
 	if (p_what == NOTIFICATION_VISIBILITY_CHANGED) {
 		// first update before rendering to avoid one frame delay after emitting starts
-		if (emitting && (time == 0)) {
+		if (simulation.emitting && (simulation.time == 0)) {
 			_update_internal();
 		}
 	}
@@ -1131,33 +1405,13 @@ void CPUParticles3D::_notification(int p_what) {
 	if (p_what == NOTIFICATION_TRANSFORM_CHANGED) {
 		inv_emission_transform = get_global_transform().affine_inverse();
 
-		if (!local_coords) {
-			int pc = particles.size();
+		if (!simulation.local_coords) {
+			int pc = simulation.particles.size();
 
-			float *w = particle_data.ptrw();
-			const Particle *r = particles.ptr();
-			float *ptr = w;
+			float *ptr = particle_data.ptrw();
 
 			for (int i = 0; i < pc; i++) {
-				Transform t = inv_emission_transform * r[i].transform;
-
-				if (r[i].active) {
-					ptr[0] = t.basis.elements[0][0];
-					ptr[1] = t.basis.elements[0][1];
-					ptr[2] = t.basis.elements[0][2];
-					ptr[3] = t.origin.x;
-					ptr[4] = t.basis.elements[1][0];
-					ptr[5] = t.basis.elements[1][1];
-					ptr[6] = t.basis.elements[1][2];
-					ptr[7] = t.origin.y;
-					ptr[8] = t.basis.elements[2][0];
-					ptr[9] = t.basis.elements[2][1];
-					ptr[10] = t.basis.elements[2][2];
-					ptr[11] = t.origin.z;
-				} else {
-					memset(ptr, 0, sizeof(float) * 12);
-				}
-
+				_write_particle_transform(i, ptr);
 				ptr += 20;
 			}
 
@@ -1440,6 +1694,15 @@ void CPUParticles3D::_bind_methods() {
 	BIND_ENUM_CONSTANT(EMISSION_SHAPE_MAX);
 }
 
+void CPUParticles3D::finish_work_pool() {
+	if (work_pool) {
+		memdelete(work_pool);
+		work_pool = nullptr;
+	}
+}
+
+ThreadWorkPool *CPUParticles3D::work_pool = nullptr;
+
 CPUParticles3D::CPUParticles3D() {
 	set_notify_transform(true);
 
@@ -1473,7 +1736,7 @@ CPUParticles3D::CPUParticles3D() {
 	}
 
 	for (int i = 0; i < PARTICLE_FLAG_MAX; i++) {
-		particle_flags[i] = false;
+		simulation.particle_flags[i] = false;
 	}
 
 	set_color(Color(1, 1, 1, 1));
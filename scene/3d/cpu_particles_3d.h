@@ -31,8 +31,10 @@
 #ifndef CPU_PARTICLES_H
 #define CPU_PARTICLES_H
 
+#include "core/templates/local_vector.h"
 #include "core/templates/rid.h"
 #include "core/templates/safe_refcount.h"
+#include "core/templates/thread_work_pool.h"
 #include "scene/3d/visual_instance_3d.h"
 
 class CPUParticles3D : public GeometryInstance3D {
@@ -79,14 +81,17 @@ public:
 		EMISSION_SHAPE_MAX
 	};
 
-private:
-	bool emitting = false;
+	// Restarts draw from the global random generator, so they are decided in order on the main thread.
+	// The rest of each particle's update only touches that particle, and is split in chunks across threads.
+	enum ParticleStep : uint8_t {
+		PARTICLE_STEP_SKIP,
+		PARTICLE_STEP_RESTARTED,
+		PARTICLE_STEP_EXPIRED,
+		PARTICLE_STEP_UPDATE,
+	};
 
 	struct Particle {
-		Transform transform;
-		Color color;
 		float custom[4] = {};
-		Vector3 velocity;
 		bool active = false;
 		float angle_rand = 0.0;
 		float scale_rand = 0.0;
@@ -94,20 +99,104 @@ private:
 		float anim_offset_rand = 0.0;
 		float time = 0.0;
 		float lifetime = 0.0;
-		Color base_color;
 
 		uint32_t seed = 0;
 	};
 
-	float time = 0.0;
+	enum {
+		PROCESS_CHUNK_SIZE = 256,
+	};
+
+	// The particle simulation, apart from the node and its multimesh so it can also run headless.
+	// The node forwards its properties here and packs the result into the multimesh buffer.
+	struct Simulation {
+		bool emitting = false;
+		bool one_shot = false;
+
+		float lifetime = 1.0;
+		float explosiveness_ratio = 0.0;
+		float randomness_ratio = 0.0;
+		float lifetime_randomness = 0.0;
+		float speed_scale = 1.0;
+		bool local_coords = true;
+		bool fractional_delta = true;
+
+		Vector3 direction = Vector3(1, 0, 0);
+		float spread = 45.0;
+		float flatness = 0.0;
+
+		float parameters[PARAM_MAX] = {};
+		float randomness[PARAM_MAX] = {};
+
+		Ref<Curve> curve_parameters[PARAM_MAX];
+		Color color = Color(1, 1, 1, 1);
+		Ref<Gradient> color_ramp;
+
+		bool particle_flags[PARTICLE_FLAG_MAX] = {};
+
+		EmissionShape emission_shape = EMISSION_SHAPE_POINT;
+		float emission_sphere_radius = 1.0;
+		Vector3 emission_box_extents = Vector3(1, 1, 1);
+		Vector<Vector3> emission_points;
+		Vector<Vector3> emission_normals;
+		Vector<Color> emission_colors;
+
+		Vector3 gravity = Vector3(0, -9.8, 0);
+
+		float time = 0.0;
+		int cycle = 0;
+
+		LocalVector<Particle> particles;
+
+		// Transforms, velocities and colors have one array per component, so the scale,
+		// integrate and color stages run over four consecutive particles at a time.
+		LocalVector<real_t> basis[9]; // Row major, like Basis::elements.
+		LocalVector<real_t> origin[3];
+		LocalVector<real_t> velocity[3];
+		LocalVector<float> colors[4];
+
+		// Inputs of the color stage, only written when a particle is updated. The stage
+		// runs over whole chunks, and gives the same color again for skipped particles.
+		LocalVector<float> ramp_colors[4];
+		LocalVector<float> base_colors[4];
+		LocalVector<float> hue_rotations[2]; // Cosine and sine.
+
+		// Written for every particle on each step, skipped ones get a scale of 1 and a delta of 0.
+		LocalVector<ParticleStep> steps;
+		LocalVector<real_t> deltas;
+		LocalVector<real_t> scales;
+
+		Vector3 emission_origin;
+
+		void set_amount(int p_amount);
+		int get_amount() const { return particles.size(); }
+		void deactivate();
+
+		Transform get_transform(uint32_t p_index) const;
+		void set_transform(uint32_t p_index, const Transform &p_transform);
+		Vector3 get_velocity(uint32_t p_index) const;
+		void set_velocity(uint32_t p_index, const Vector3 &p_velocity);
+		Color get_color(uint32_t p_index) const;
+
+		// Advances every particle by p_delta. Chunks run on the threads of p_pool if given, on the calling thread otherwise.
+		void process(float p_delta, const Transform &p_emission_xform, ThreadWorkPool *p_pool = nullptr);
+		void _emit(uint32_t p_index, const Transform &p_emission_xform);
+		void _process_chunk(uint32_t p_chunk, uint32_t p_count);
+		void _update(uint32_t p_from, uint32_t p_to);
+		void _scale(uint32_t p_from, uint32_t p_to);
+		void _integrate(uint32_t p_from, uint32_t p_to);
+		void _color(uint32_t p_from, uint32_t p_to);
+	};
+
+private:
+	Simulation simulation;
+
 	float inactive_time = 0.0;
 	float frame_remainder = 0.0;
-	int cycle = 0;
 	bool redraw = false;
 
 	RID multimesh;
 
-	Vector<Particle> particles;
 	Vector<float> particle_data;
 	Vector<int> particle_order;
 
@@ -120,26 +209,17 @@ private:
 	};
 
 	struct SortAxis {
-		const Particle *particles = nullptr;
+		const real_t *origin[3] = {};
 		Vector3 axis;
 		bool operator()(int p_a, int p_b) const {
-			return axis.dot(particles[p_a].transform.origin) < axis.dot(particles[p_b].transform.origin);
+			return axis.dot(Vector3(origin[0][p_a], origin[1][p_a], origin[2][p_a])) < axis.dot(Vector3(origin[0][p_b], origin[1][p_b], origin[2][p_b]));
 		}
 	};
 
 	//
 
-	bool one_shot = false;
-
-	float lifetime = 1.0;
 	float pre_process_time = 0.0;
-	float explosiveness_ratio = 0.0;
-	float randomness_ratio = 0.0;
-	float lifetime_randomness = 0.0;
-	float speed_scale = 1.0;
-	bool local_coords = true;
 	int fixed_fps = 0;
-	bool fractional_delta = true;
 
 	Transform inv_emission_transform;
 
@@ -149,34 +229,22 @@ private:
 
 	Ref<Mesh> mesh;
 
-	////////
-
-	Vector3 direction = Vector3(1, 0, 0);
-	float spread = 45.0;
-	float flatness = 0.0;
-
-	float parameters[PARAM_MAX];
-	float randomness[PARAM_MAX] = {};
-
-	Ref<Curve> curve_parameters[PARAM_MAX];
-	Color color = Color(1, 1, 1, 1);
-	Ref<Gradient> color_ramp;
-
-	bool particle_flags[PARTICLE_FLAG_MAX] = {};
-
-	EmissionShape emission_shape = EMISSION_SHAPE_POINT;
-	float emission_sphere_radius = 1.0;
-	Vector3 emission_box_extents = Vector3(1, 1, 1);
-	Vector<Vector3> emission_points;
-	Vector<Vector3> emission_normals;
-	Vector<Color> emission_colors;
 	int emission_point_count = 0;
 
-	Vector3 gravity = Vector3(0, -9.8, 0);
+	struct ProcessChunks {
+		const int *order = nullptr;
+		float *data = nullptr;
+		uint32_t count = 0;
+	};
+
+	static ThreadWorkPool *work_pool;
+	static ThreadWorkPool *_get_work_pool(uint32_t p_count);
 
 	void _update_internal();
 	void _particles_process(float p_delta);
 	void _update_particle_data_buffer();
+	void _update_particle_data_chunk(uint32_t p_chunk, ProcessChunks *p_chunks);
+	void _write_particle_transform(uint32_t p_index, float *r_data) const;
 
 	Mutex update_mutex;
 
@@ -286,6 +354,8 @@ public:
 
 	void convert_from_particles(Node *p_particles);
 
+	static void finish_work_pool();
+
 	CPUParticles3D();
 	~CPUParticles3D();
 };
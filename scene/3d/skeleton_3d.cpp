@@ -234,58 +234,46 @@ void Skeleton3D::_notification(int p_what) {
 
 			const int *order = process_order.ptr();
 
+			// Only bones that were posed, or whose parent was recomputed, need a new global pose.
+			bool update_all = all_global_poses_dirty;
+			global_pose_pass++;
+
 			for (int i = 0; i < len; i++) {
 				Bone &b = bonesptr[order[i]];
 
-				if (b.disable_rest) {
-					if (b.enabled) {
-						Transform pose = b.pose;
-						if (b.custom_pose_enable) {
-							pose = b.custom_pose * pose;
-						}
-						if (b.parent >= 0) {
-							b.pose_global = bonesptr[b.parent].pose_global * pose;
-							b.pose_global_no_override = bonesptr[b.parent].pose_global * pose;
-						} else {
-							b.pose_global = pose;
-							b.pose_global_no_override = pose;
-						}
-					} else {
-						if (b.parent >= 0) {
-							b.pose_global = bonesptr[b.parent].pose_global;
-							b.pose_global_no_override = bonesptr[b.parent].pose_global;
-						} else {
-							b.pose_global = Transform();
-							b.pose_global_no_override = Transform();
-						}
+				if (!update_all && !b.global_pose_dirty && (b.parent < 0 || bonesptr[b.parent].global_pose_pass != global_pose_pass)) {
+					continue;
+				}
+				b.global_pose_dirty = false;
+				b.global_pose_pass = global_pose_pass;
+
+				Transform local;
+				if (b.enabled) {
+					local = b.pose;
+					if (b.custom_pose_enable) {
+						local = b.custom_pose * local;
+					}
+					if (!b.disable_rest) {
+						local = b.rest * local;
 					}
+				} else if (!b.disable_rest) {
+					local = b.rest;
+				}
 
+				if (b.parent >= 0) {
+					b.pose_global = bonesptr[b.parent].pose_global * local;
 				} else {
-					if (b.enabled) {
-						Transform pose = b.pose;
-						if (b.custom_pose_enable) {
-							pose = b.custom_pose * pose;
-						}
-						if (b.parent >= 0) {
-							b.pose_global = bonesptr[b.parent].pose_global * (b.rest * pose);
-							b.pose_global_no_override = bonesptr[b.parent].pose_global * (b.rest * pose);
-						} else {
-							b.pose_global = b.rest * pose;
-							b.pose_global_no_override = b.rest * pose;
-						}
-					} else {
-						if (b.parent >= 0) {
-							b.pose_global = bonesptr[b.parent].pose_global * b.rest;
-							b.pose_global_no_override = bonesptr[b.parent].pose_global * b.rest;
-						} else {
-							b.pose_global = b.rest;
-							b.pose_global_no_override = b.rest;
-						}
-					}
+					b.pose_global = local;
 				}
+				b.pose_global_no_override = b.pose_global;
 
 				if (b.global_pose_override_amount >= CMP_EPSILON) {
 					b.pose_global = b.pose_global.interpolate_with(b.global_pose_override, b.global_pose_override_amount);
+
+					if (b.global_pose_override_reset) {
+						// Goes back to the regular pose on the next update.
+						b.global_pose_dirty = true;
+					}
 				}
 
 				if (b.global_pose_override_reset) {
@@ -306,8 +294,10 @@ void Skeleton3D::_notification(int p_what) {
 				const Skin *skin = E->get()->skin.operator->();
 				RID skeleton = E->get()->skeleton;
 				uint32_t bind_count = skin->get_bind_count();
+				bool update_all_binds = update_all;
 
 				if (E->get()->bind_count != bind_count) {
+					update_all_binds = true;
 					RS::get_singleton()->skeleton_allocate_data(skeleton, bind_count);
 					E->get()->bind_count = bind_count;
 					E->get()->skin_bone_indices.resize(bind_count);
@@ -315,6 +305,7 @@ void Skeleton3D::_notification(int p_what) {
 				}
 
 				if (E->get()->skeleton_version != version) {
+					update_all_binds = true;
 					for (uint32_t i = 0; i < bind_count; i++) {
 						StringName bind_name = skin->get_bind_name(i);
 
@@ -353,11 +344,15 @@ void Skeleton3D::_notification(int p_what) {
 				for (uint32_t i = 0; i < bind_count; i++) {
 					uint32_t bone_index = E->get()->skin_bone_indices_ptrs[i];
 					ERR_CONTINUE(bone_index >= (uint32_t)len);
+					if (!update_all_binds && bonesptr[bone_index].global_pose_pass != global_pose_pass) {
+						continue;
+					}
 					rs->skeleton_bone_set_transform(skeleton, i, bonesptr[bone_index].pose_global * skin->get_bind_pose(i));
 				}
 			}
 
 			dirty = false;
+			all_global_poses_dirty = false;
 
 #ifdef TOOLS_ENABLED
 			emit_signal(SceneStringNames::get_singleton()->pose_updated);
@@ -401,7 +396,7 @@ void Skeleton3D::set_bone_global_pose_override(int p_bone, const Transform &p_po
 	bones.write[p_bone].global_pose_override_amount = p_amount;
 	bones.write[p_bone].global_pose_override = p_pose;
 	bones.write[p_bone].global_pose_override_reset = !p_persistent;
-	_make_dirty();
+	_make_bone_dirty(p_bone);
 }
 
 Transform Skeleton3D::get_bone_global_pose(int p_bone) const {
@@ -511,6 +506,7 @@ void Skeleton3D::unparent_bone_and_rest(int p_bone) {
 void Skeleton3D::set_bone_disable_rest(int p_bone, bool p_disable) {
 	ERR_FAIL_INDEX(p_bone, bones.size());
 	bones.write[p_bone].disable_rest = p_disable;
+	_make_bone_dirty(p_bone);
 }
 
 bool Skeleton3D::is_bone_rest_disabled(int p_bone) const {
@@ -528,7 +524,7 @@ void Skeleton3D::set_bone_rest(int p_bone, const Transform &p_rest) {
 	ERR_FAIL_INDEX(p_bone, bones.size());
 
 	bones.write[p_bone].rest = p_rest;
-	_make_dirty();
+	_make_bone_dirty(p_bone);
 }
 
 Transform Skeleton3D::get_bone_rest(int p_bone) const {
@@ -541,7 +537,7 @@ void Skeleton3D::set_bone_enabled(int p_bone, bool p_enabled) {
 	ERR_FAIL_INDEX(p_bone, bones.size());
 
 	bones.write[p_bone].enabled = p_enabled;
-	_make_dirty();
+	_make_bone_dirty(p_bone);
 }
 
 bool Skeleton3D::is_bone_enabled(int p_bone) const {
@@ -562,6 +558,7 @@ void Skeleton3D::bind_child_node_to_bone(int p_bone, Node *p_node) {
 	}
 
 	bones.write[p_bone].nodes_bound.push_back(id);
+	_make_bone_dirty(p_bone); // So the node is placed on the next update.
 }
 
 void Skeleton3D::unbind_child_node_from_bone(int p_bone, Node *p_node) {
@@ -595,8 +592,9 @@ void Skeleton3D::set_bone_pose(int p_bone, const Transform &p_pose) {
 	ERR_FAIL_INDEX(p_bone, bones.size());
 
 	bones.write[p_bone].pose = p_pose;
+	bones.write[p_bone].global_pose_dirty = true;
 	if (is_inside_tree()) {
-		_make_dirty();
+		_queue_update();
 	}
 }
 
@@ -605,6 +603,70 @@ Transform Skeleton3D::get_bone_pose(int p_bone) const {
 	return bones[p_bone].pose;
 }
 
+void Skeleton3D::set_bone_poses(const Transform *p_poses, int p_count) {
+	ERR_FAIL_COND(p_count != bones.size());
+
+	Bone *bonesptr = bones.ptrw();
+	bool changed = false;
+	for (int i = 0; i < p_count; i++) {
+		// Bones holding still don't need their chains recomputed.
+		if (bonesptr[i].pose != p_poses[i]) {
+			bonesptr[i].pose = p_poses[i];
+			bonesptr[i].global_pose_dirty = true;
+			changed = true;
+		}
+	}
+
+	if (changed && is_inside_tree()) {
+		_queue_update();
+	}
+}
+
+void Skeleton3D::set_bone_pose_buffer(const Vector<float> &p_buffer) {
+	ERR_FAIL_COND_MSG(p_buffer.size() != bones.size() * 12, "Pose buffer must hold 12 floats per bone.");
+
+	const float *r = p_buffer.ptr();
+	LocalVector<Transform> poses;
+	poses.resize(bones.size());
+	for (uint32_t i = 0; i < poses.size(); i++) {
+		const float *data = &r[i * 12];
+		Transform &t = poses[i];
+		t.basis.elements[0] = Vector3(data[0], data[1], data[2]);
+		t.origin.x = data[3];
+		t.basis.elements[1] = Vector3(data[4], data[5], data[6]);
+		t.origin.y = data[7];
+		t.basis.elements[2] = Vector3(data[8], data[9], data[10]);
+		t.origin.z = data[11];
+	}
+
+	set_bone_poses(poses.ptr(), poses.size());
+}
+
+Vector<float> Skeleton3D::get_bone_pose_buffer() const {
+	Vector<float> buffer;
+	buffer.resize(bones.size() * 12);
+
+	float *w = buffer.ptrw();
+	for (int i = 0; i < bones.size(); i++) {
+		const Transform &t = bones[i].pose;
+		float *data = &w[i * 12];
+		data[0] = t.basis.elements[0][0];
+		data[1] = t.basis.elements[0][1];
+		data[2] = t.basis.elements[0][2];
+		data[3] = t.origin.x;
+		data[4] = t.basis.elements[1][0];
+		data[5] = t.basis.elements[1][1];
+		data[6] = t.basis.elements[1][2];
+		data[7] = t.origin.y;
+		data[8] = t.basis.elements[2][0];
+		data[9] = t.basis.elements[2][1];
+		data[10] = t.basis.elements[2][2];
+		data[11] = t.origin.z;
+	}
+
+	return buffer;
+}
+
 void Skeleton3D::set_bone_custom_pose(int p_bone, const Transform &p_custom_pose) {
 	ERR_FAIL_INDEX(p_bone, bones.size());
 	//ERR_FAIL_COND( !is_inside_scene() );
@@ -612,7 +674,7 @@ void Skeleton3D::set_bone_custom_pose(int p_bone, const Transform &p_custom_pose
 	bones.write[p_bone].custom_pose_enable = (p_custom_pose != Transform());
 	bones.write[p_bone].custom_pose = p_custom_pose;
 
-	_make_dirty();
+	_make_bone_dirty(p_bone);
 }
 
 Transform Skeleton3D::get_bone_custom_pose(int p_bone) const {
@@ -621,6 +683,16 @@ Transform Skeleton3D::get_bone_custom_pose(int p_bone) const {
 }
 
 void Skeleton3D::_make_dirty() {
+	all_global_poses_dirty = true;
+	_queue_update();
+}
+
+void Skeleton3D::_make_bone_dirty(int p_bone) {
+	bones.write[p_bone].global_pose_dirty = true;
+	_queue_update();
+}
+
+void Skeleton3D::_queue_update() {
 	if (dirty) {
 		return;
 	}
@@ -921,6 +993,9 @@ void Skeleton3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_bone_pose", "bone_idx"), &Skeleton3D::get_bone_pose);
 	ClassDB::bind_method(D_METHOD("set_bone_pose", "bone_idx", "pose"), &Skeleton3D::set_bone_pose);
 
+	ClassDB::bind_method(D_METHOD("get_bone_pose_buffer"), &Skeleton3D::get_bone_pose_buffer);
+	ClassDB::bind_method(D_METHOD("set_bone_pose_buffer", "buffer"), &Skeleton3D::set_bone_pose_buffer);
+
 	ClassDB::bind_method(D_METHOD("clear_bones_global_pose_override"), &Skeleton3D::clear_bones_global_pose_override);
 	ClassDB::bind_method(D_METHOD("set_bone_global_pose_override", "bone_idx", "pose", "amount", "persistent"), &Skeleton3D::set_bone_global_pose_override, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("get_bone_global_pose", "bone_idx"), &Skeleton3D::get_bone_global_pose);
@@ -84,6 +84,8 @@ private:
 		Transform pose;
 		Transform pose_global;
 		Transform pose_global_no_override;
+		bool global_pose_dirty = true; // Recomputed with its children on the next update.
+		uint64_t global_pose_pass = 0; // Last update that recomputed it.
 
 		bool custom_pose_enable = false;
 		Transform custom_pose;
@@ -110,7 +112,11 @@ private:
 	bool process_order_dirty = true;
 
 	void _make_dirty();
+	void _make_bone_dirty(int p_bone);
+	void _queue_update();
 	bool dirty = false;
+	bool all_global_poses_dirty = true;
+	uint64_t global_pose_pass = 0;
 
 	uint64_t version = 1;
 
@@ -180,6 +186,10 @@ public:
 	void set_bone_pose(int p_bone, const Transform &p_pose);
 	Transform get_bone_pose(int p_bone) const;
 
+	void set_bone_poses(const Transform *p_poses, int p_count);
+	void set_bone_pose_buffer(const Vector<float> &p_buffer);
+	Vector<float> get_bone_pose_buffer() const;
+
 	void set_bone_custom_pose(int p_bone, const Transform &p_custom_pose);
 	Transform get_bone_custom_pose(int p_bone) const;
 
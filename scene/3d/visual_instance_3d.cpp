@@ -186,7 +186,40 @@ float GeometryInstance3D::get_lod_max_hysteresis() const {
 	return lod_max_hysteresis;
 }
 
+void GeometryInstance3D::set_lod_proxy(const NodePath &p_proxy) {
+	lod_proxy = p_proxy;
+	if (is_inside_tree()) {
+		_update_lod_proxy();
+	}
+}
+
+NodePath GeometryInstance3D::get_lod_proxy() const {
+	return lod_proxy;
+}
+
+void GeometryInstance3D::_update_lod_proxy() {
+	RID proxy_instance;
+	if (!lod_proxy.is_empty()) {
+		GeometryInstance3D *proxy = Object::cast_to<GeometryInstance3D>(get_node_or_null(lod_proxy));
+		ERR_FAIL_COND_MSG(!proxy, "LOD proxy node path must point to a GeometryInstance3D node.");
+		proxy_instance = proxy->get_instance();
+	}
+	RS::get_singleton()->instance_geometry_set_as_instance_lod(get_instance(), proxy_instance);
+}
+
 void GeometryInstance3D::_notification(int p_what) {
+	switch (p_what) {
+		case NOTIFICATION_ENTER_TREE: {
+			if (!lod_proxy.is_empty()) {
+				_update_lod_proxy();
+			}
+		} break;
+		case NOTIFICATION_EXIT_TREE: {
+			if (!lod_proxy.is_empty()) {
+				RS::get_singleton()->instance_geometry_set_as_instance_lod(get_instance(), RID());
+			}
+		} break;
+	}
 }
 
 const StringName *GeometryInstance3D::_instance_uniform_get_remap(const StringName p_name) const {
@@ -369,6 +402,9 @@ void GeometryInstance3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_lod_min_distance", "mode"), &GeometryInstance3D::set_lod_min_distance);
 	ClassDB::bind_method(D_METHOD("get_lod_min_distance"), &GeometryInstance3D::get_lod_min_distance);
 
+	ClassDB::bind_method(D_METHOD("set_lod_proxy", "proxy"), &GeometryInstance3D::set_lod_proxy);
+	ClassDB::bind_method(D_METHOD("get_lod_proxy"), &GeometryInstance3D::get_lod_proxy);
+
 	ClassDB::bind_method(D_METHOD("set_shader_instance_uniform", "uniform", "value"), &GeometryInstance3D::set_shader_instance_uniform);
 	ClassDB::bind_method(D_METHOD("get_shader_instance_uniform", "uniform"), &GeometryInstance3D::get_shader_instance_uniform);
 
@@ -403,6 +439,7 @@ void GeometryInstance3D::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_min_hysteresis", PROPERTY_HINT_RANGE, "0,32768,0.01"), "set_lod_min_hysteresis", "get_lod_min_hysteresis");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_max_distance", PROPERTY_HINT_RANGE, "0,32768,0.01"), "set_lod_max_distance", "get_lod_max_distance");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_max_hysteresis", PROPERTY_HINT_RANGE, "0,32768,0.01"), "set_lod_max_hysteresis", "get_lod_max_hysteresis");
+	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "lod_proxy", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "GeometryInstance3D"), "set_lod_proxy", "get_lod_proxy");
 
 	//ADD_SIGNAL( MethodInfo("visibility_changed"));
 
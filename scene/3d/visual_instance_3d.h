@@ -111,6 +111,7 @@ private:
 	float lod_max_distance = 0.0;
 	float lod_min_hysteresis = 0.0;
 	float lod_max_hysteresis = 0.0;
+	NodePath lod_proxy;
 
 	float lod_bias = 1.0;
 
@@ -123,6 +124,7 @@ private:
 	bool ignore_occlusion_culling = false;
 
 	const StringName *_instance_uniform_get_remap(const StringName p_name) const;
+	void _update_lod_proxy();
 
 protected:
 	bool _set(const StringName &p_name, const Variant &p_value);
@@ -148,6 +150,9 @@ public:
 	void set_lod_max_hysteresis(float p_dist);
 	float get_lod_max_hysteresis() const;
 
+	void set_lod_proxy(const NodePath &p_proxy);
+	NodePath get_lod_proxy() const;
+
 	void set_material_override(const Ref<Material> &p_material);
 	Ref<Material> get_material_override() const;
 
@@ -32,6 +32,7 @@
 
 #include "core/config/engine.h"
 #include "core/object/message_queue.h"
+#include "scene/animation/animation_process_batch.h"
 #include "scene/scene_string_names.h"
 #include "servers/audio/audio_stream.h"
 
@@ -198,6 +199,9 @@ void AnimationPlayer::_notification(int p_what) {
 			}
 			//_set_process(false);
 			clear_caches();
+			if (use_threads) {
+				AnimationProcessBatch::register_threaded_node(this);
+			}
 		} break;
 		case NOTIFICATION_READY: {
 			if (!Engine::get_singleton()->is_editor_hint() && animation_set.has(autoplay)) {
@@ -211,7 +215,11 @@ void AnimationPlayer::_notification(int p_what) {
 			}
 
 			if (processing) {
-				_animation_process(get_process_delta_time());
+				if (use_threads) {
+					AnimationProcessBatch::process_threaded_nodes(false);
+				} else {
+					_animation_process(get_process_delta_time());
+				}
 			}
 		} break;
 		case NOTIFICATION_INTERNAL_PHYSICS_PROCESS: {
@@ -220,11 +228,18 @@ void AnimationPlayer::_notification(int p_what) {
 			}
 
 			if (processing) {
-				_animation_process(get_physics_process_delta_time());
+				if (use_threads) {
+					AnimationProcessBatch::process_threaded_nodes(true);
+				} else {
+					_animation_process(get_physics_process_delta_time());
+				}
 			}
 		} break;
 		case NOTIFICATION_EXIT_TREE: {
 			clear_caches();
+			if (use_threads) {
+				AnimationProcessBatch::unregister_threaded_node(this);
+			}
 		} break;
 	}
 }
@@ -242,9 +257,11 @@ void AnimationPlayer::_ensure_node_caches(AnimationData *p_anim, Node *p_root_ov
 	Animation *a = p_anim->animation.operator->();
 
 	p_anim->node_cache.resize(a->get_track_count());
+	p_anim->key_cursors.resize(a->get_track_count());
 
 	for (int i = 0; i < a->get_track_count(); i++) {
 		p_anim->node_cache.write[i] = nullptr;
+		p_anim->key_cursors[i] = -1;
 		RES resource;
 		Vector<StringName> leftover_path;
 		Node *child = parent->get_node_and_resource(a->track_get_path(i), resource, leftover_path);
@@ -341,6 +358,18 @@ void AnimationPlayer::_animation_process_animation(AnimationData *p_anim, float
 	_ensure_node_caches(p_anim);
 	ERR_FAIL_COND(p_anim->node_cache.size() != p_anim->animation->get_track_count());
 
+	if (track_pass == TRACK_PASS_BLEND) {
+		DeferredTracks deferred;
+		deferred.anim = p_anim;
+		deferred.time = p_time;
+		deferred.delta = p_delta;
+		deferred.interp = p_interp;
+		deferred.is_current = p_is_current;
+		deferred.seeked = p_seeked;
+		deferred.started = p_started;
+		deferred_tracks.push_back(deferred);
+	}
+
 	Animation *a = p_anim->animation.operator->();
 	bool can_call = is_inside_tree() && !Engine::get_singleton()->is_editor_hint();
 
@@ -357,6 +386,8 @@ void AnimationPlayer::_animation_process_animation(AnimationData *p_anim, float
 			continue; // no node cache for this track, skip it
 		}
 
+		int *cursor = &p_anim->key_cursors[i];
+
 		if (!a->track_is_enabled(i)) {
 			continue; // do nothing if the track is disabled
 		}
@@ -365,6 +396,10 @@ void AnimationPlayer::_animation_process_animation(AnimationData *p_anim, float
 			continue; // do nothing if track is empty
 		}
 
+		if (track_pass != TRACK_PASS_ALL && AnimationProcessBatch::is_blended_track(a, i, p_delta, true) != (track_pass == TRACK_PASS_BLEND)) {
+			continue; // processed in the other pass
+		}
+
 		switch (a->track_get_type(i)) {
 			case Animation::TYPE_TRANSFORM: {
 				if (!nc->spatial) {
@@ -375,7 +410,7 @@ void AnimationPlayer::_animation_process_animation(AnimationData *p_anim, float
 				Quat rot;
 				Vector3 scale;
 
-				Error err = a->transform_track_interpolate(i, p_time, &loc, &rot, &scale);
+				Error err = a->transform_track_interpolate(i, p_time, &loc, &rot, &scale, cursor);
 				//ERR_CONTINUE(err!=OK); //used for testing, should be removed
 
 				if (err != OK) {
@@ -456,7 +491,7 @@ void AnimationPlayer::_animation_process_animation(AnimationData *p_anim, float
 
 				if (update_mode == Animation::UPDATE_CONTINUOUS || update_mode == Animation::UPDATE_CAPTURE || (p_delta == 0 && update_mode == Animation::UPDATE_DISCRETE)) { //delta == 0 means seek
 
-					Variant value = a->value_track_interpolate(i, p_time);
+					Variant value = a->value_track_interpolate(i, p_time, cursor);
 
 					if (value == Variant()) {
 						continue;
@@ -585,7 +620,7 @@ void AnimationPlayer::_animation_process_animation(AnimationData *p_anim, float
 
 				TrackNodeCache::BezierAnim *ba = &E->get();
 
-				float bezier = a->bezier_track_interpolate(i, p_time);
+				float bezier = a->bezier_track_interpolate(i, p_time, cursor);
 				if (ba->accum_pass != accum_pass) {
 					ERR_CONTINUE(cache_update_bezier_size >= NODE_CACHE_UPDATE_MAX);
 					cache_update_bezier[cache_update_bezier_size++] = ba;
@@ -925,29 +960,73 @@ void AnimationPlayer::_animation_process(float p_delta) {
 		}
 
 		_animation_update_transforms();
-		if (end_reached) {
-			if (queued.size()) {
-				String old = playback.assigned;
-				play(queued.front()->get());
-				String new_name = playback.assigned;
-				queued.pop_front();
-				if (end_notify) {
-					emit_signal(SceneStringNames::get_singleton()->animation_changed, old, new_name);
-				}
-			} else {
-				//stop();
-				playing = false;
-				_set_process(false);
-				if (end_notify) {
-					emit_signal(SceneStringNames::get_singleton()->animation_finished, playback.assigned);
-				}
+		_animation_process_end();
+
+	} else {
+		_set_process(false);
+	}
+}
+
+void AnimationPlayer::_animation_process_end() {
+	if (end_reached) {
+		if (queued.size()) {
+			String old = playback.assigned;
+			play(queued.front()->get());
+			String new_name = playback.assigned;
+			queued.pop_front();
+			if (end_notify) {
+				emit_signal(SceneStringNames::get_singleton()->animation_changed, old, new_name);
+			}
+		} else {
+			//stop();
+			playing = false;
+			_set_process(false);
+			if (end_notify) {
+				emit_signal(SceneStringNames::get_singleton()->animation_finished, playback.assigned);
 			}
-			end_reached = false;
 		}
+		end_reached = false;
+	}
+}
 
-	} else {
+bool AnimationPlayer::_threaded_process_begin() {
+	if (!playback.current.from) {
 		_set_process(false);
+		return false;
 	}
+
+	// Resolving caches looks up and connects to nodes, so it can't happen on the worker thread.
+	_ensure_node_caches(playback.current.from);
+	for (List<Blend>::Element *E = playback.blend.front(); E; E = E->next()) {
+		_ensure_node_caches(E->get().data.from);
+	}
+	deferred_tracks.clear();
+	return true;
+}
+
+void AnimationPlayer::_threaded_process(float p_delta) {
+	end_reached = false;
+	end_notify = false;
+	track_pass = TRACK_PASS_BLEND;
+	_animation_process2(p_delta, playback.started);
+	track_pass = TRACK_PASS_ALL;
+}
+
+void AnimationPlayer::_threaded_process_end() {
+	track_pass = TRACK_PASS_MAIN_THREAD;
+	for (uint32_t i = 0; i < deferred_tracks.size(); i++) {
+		const DeferredTracks &d = deferred_tracks[i];
+		_animation_process_animation(d.anim, d.time, d.delta, d.interp, d.is_current, d.seeked, d.started);
+	}
+	track_pass = TRACK_PASS_ALL;
+	deferred_tracks.clear();
+
+	if (playback.started) {
+		playback.started = false;
+	}
+
+	_animation_update_transforms();
+	_animation_process_end();
 }
 
 Error AnimationPlayer::add_animation(const StringName &p_name, const Ref<Animation> &p_animation) {
@@ -1373,6 +1452,25 @@ bool AnimationPlayer::is_active() const {
 	return active;
 }
 
+void AnimationPlayer::set_use_threads(bool p_use) {
+	if (use_threads == p_use) {
+		return;
+	}
+
+	use_threads = p_use;
+	if (is_inside_tree()) {
+		if (use_threads) {
+			AnimationProcessBatch::register_threaded_node(this);
+		} else {
+			AnimationProcessBatch::unregister_threaded_node(this);
+		}
+	}
+}
+
+bool AnimationPlayer::is_using_threads() const {
+	return use_threads;
+}
+
 StringName AnimationPlayer::find_animation(const Ref<Animation> &p_animation) const {
 	for (Map<StringName, AnimationData>::Element *E = animation_set.front(); E; E = E->next()) {
 		if (E->get().animation == p_animation) {
@@ -1620,6 +1718,9 @@ void AnimationPlayer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_active", "active"), &AnimationPlayer::set_active);
 	ClassDB::bind_method(D_METHOD("is_active"), &AnimationPlayer::is_active);
 
+	ClassDB::bind_method(D_METHOD("set_use_threads", "enable"), &AnimationPlayer::set_use_threads);
+	ClassDB::bind_method(D_METHOD("is_using_threads"), &AnimationPlayer::is_using_threads);
+
 	ClassDB::bind_method(D_METHOD("set_speed_scale", "speed"), &AnimationPlayer::set_speed_scale);
 	ClassDB::bind_method(D_METHOD("get_speed_scale"), &AnimationPlayer::get_speed_scale);
 	ClassDB::bind_method(D_METHOD("get_playing_speed"), &AnimationPlayer::get_playing_speed);
@@ -1654,6 +1755,7 @@ void AnimationPlayer::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "assigned_animation", PROPERTY_HINT_NONE, "", 0), "set_assigned_animation", "get_assigned_animation");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "autoplay", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR), "set_autoplay", "get_autoplay");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "reset_on_save", PROPERTY_HINT_NONE, ""), "set_reset_on_save_enabled", "is_reset_on_save_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_threads"), "set_use_threads", "is_using_threads");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "current_animation_length", PROPERTY_HINT_NONE, "", 0), "", "get_current_animation_length");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "current_animation_position", PROPERTY_HINT_NONE, "", 0), "", "get_current_animation_position");
 
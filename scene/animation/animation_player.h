@@ -166,6 +166,7 @@ private:
 		String name;
 		StringName next;
 		Vector<TrackNodeCache *> node_cache;
+		LocalVector<int> key_cursors; // Last key sampled in each track, see Animation::transform_track_interpolate().
 		Ref<Animation> animation;
 	};
 
@@ -210,9 +211,31 @@ private:
 	AnimationMethodCallMode method_call_mode = ANIMATION_METHOD_CALL_DEFERRED;
 	bool processing = false;
 	bool active = true;
+	bool use_threads = false;
 
 	NodePath root;
 
+	// With use_threads, animations are blended on a worker thread, and the tracks that call into
+	// other nodes are left for the main thread to process afterwards.
+	enum TrackPass {
+		TRACK_PASS_ALL,
+		TRACK_PASS_BLEND,
+		TRACK_PASS_MAIN_THREAD,
+	};
+
+	struct DeferredTracks {
+		AnimationData *anim = nullptr;
+		float time = 0.0;
+		float delta = 0.0;
+		float interp = 0.0;
+		bool is_current = false;
+		bool seeked = false;
+		bool started = false;
+	};
+
+	TrackPass track_pass = TRACK_PASS_ALL;
+	LocalVector<DeferredTracks> deferred_tracks;
+
 	void _animation_process_animation(AnimationData *p_anim, float p_time, float p_delta, float p_interp, bool p_is_current = true, bool p_seeked = false, bool p_started = false);
 
 	void _ensure_node_caches(AnimationData *p_anim, Node *p_root_override = nullptr);
@@ -220,6 +243,12 @@ private:
 	void _animation_process2(float p_delta, bool p_started);
 	void _animation_update_transforms();
 	void _animation_process(float p_delta);
+	void _animation_process_end();
+
+	bool _threaded_process_begin();
+	void _threaded_process(float p_delta);
+	void _threaded_process_end();
+	friend class AnimationProcessBatch;
 
 	void _node_removed(Node *p_node);
 	void _stop_playing_caches();
@@ -286,6 +315,9 @@ public:
 	void stop_all();
 	void set_active(bool p_active);
 	bool is_active() const;
+
+	void set_use_threads(bool p_use);
+	bool is_using_threads() const;
 	bool is_valid() const;
 
 	void set_speed_scale(float p_speed);
@@ -0,0 +1,269 @@
+/*************************************************************************/
+/*  animation_process_batch.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "animation_process_batch.h"
+
+#include "core/config/engine.h"
+#include "scene/animation/animation_player.h"
+#include "scene/animation/animation_tree.h"
+
+LocalVector<Node *> AnimationProcessBatch::threaded_nodes;
+AnimationProcessBatch *AnimationProcessBatch::threaded_batch = nullptr;
+bool AnimationProcessBatch::processing_threaded_batch = false;
+uint64_t AnimationProcessBatch::last_process_frame = UINT64_MAX;
+uint64_t AnimationProcessBatch::last_physics_frame = UINT64_MAX;
+
+bool AnimationProcessBatch::is_blended_track(const Animation *p_anim, int p_track, float p_delta, bool p_capture_reads_property) {
+	switch (p_anim->track_get_type(p_track)) {
+		case Animation::TYPE_TRANSFORM:
+		case Animation::TYPE_BEZIER: {
+			return true;
+		}
+		case Animation::TYPE_VALUE: {
+			Animation::UpdateMode update_mode = p_anim->value_track_get_update_mode(p_track);
+			if (update_mode == Animation::UPDATE_CONTINUOUS) {
+				return true;
+			}
+			if (update_mode == Animation::UPDATE_CAPTURE) {
+				return !p_capture_reads_property;
+			}
+			return p_delta == 0;
+		}
+		default: {
+			return false;
+		}
+	}
+}
+
+static void _collect_animation_nodes(AnimationNode *p_node, Set<AnimationNode *> &r_nodes) {
+	if (r_nodes.has(p_node)) {
+		return;
+	}
+	r_nodes.insert(p_node);
+
+	List<AnimationNode::ChildNode> children;
+	p_node->get_child_nodes(&children);
+	for (List<AnimationNode::ChildNode>::Element *E = children.front(); E; E = E->next()) {
+		if (E->get().node.is_valid()) {
+			_collect_animation_nodes(E->get().node.ptr(), r_nodes);
+		}
+	}
+}
+
+struct AnimationTreeGroupSort {
+	_FORCE_INLINE_ bool operator()(const Pair<uint32_t, AnimationTree *> &p_a, const Pair<uint32_t, AnimationTree *> &p_b) const {
+		return p_a.first < p_b.first;
+	}
+};
+
+void AnimationProcessBatch::_evaluate_job(uint32_t p_index, void *p_userdata) {
+	if (p_index < players.size()) {
+		players[p_index]->_threaded_process(delta);
+		return;
+	}
+
+	uint32_t group = p_index - players.size();
+	uint32_t from = tree_groups[group];
+	uint32_t to = group + 1 < tree_groups.size() ? tree_groups[group + 1] : sorted_trees.size();
+	for (uint32_t i = from; i < to; i++) {
+		sorted_trees[i]->_threaded_process(delta);
+	}
+}
+
+uint32_t AnimationProcessBatch::_find_tree_group(uint32_t p_tree) {
+	while (tree_parents[p_tree] != p_tree) {
+		tree_parents[p_tree] = tree_parents[tree_parents[p_tree]];
+		p_tree = tree_parents[p_tree];
+	}
+	return p_tree;
+}
+
+// AnimationNodes keep their state and blends while processing, so trees using the same node, at
+// any depth and not just as their root, can't be evaluated at the same time. Trees are grouped by
+// the nodes they share, and each group runs on a single thread.
+void AnimationProcessBatch::_group_trees() {
+	tree_parents.resize(trees.size());
+	Map<AnimationNode *, uint32_t> node_trees;
+	for (uint32_t i = 0; i < trees.size(); i++) {
+		tree_parents[i] = i;
+
+		Set<AnimationNode *> nodes;
+		_collect_animation_nodes(trees[i]->root.ptr(), nodes);
+		for (Set<AnimationNode *>::Element *E = nodes.front(); E; E = E->next()) {
+			Map<AnimationNode *, uint32_t>::Element *F = node_trees.find(E->get());
+			if (F) {
+				tree_parents[_find_tree_group(i)] = _find_tree_group(F->get());
+			} else {
+				node_trees.insert(E->get(), i);
+			}
+		}
+	}
+
+	LocalVector<Pair<uint32_t, AnimationTree *>> grouped;
+	grouped.resize(trees.size());
+	for (uint32_t i = 0; i < trees.size(); i++) {
+		grouped[i] = Pair<uint32_t, AnimationTree *>(_find_tree_group(i), trees[i]);
+	}
+	grouped.sort_custom<AnimationTreeGroupSort>();
+
+	sorted_trees.resize(grouped.size());
+	tree_groups.clear();
+	for (uint32_t i = 0; i < grouped.size(); i++) {
+		sorted_trees[i] = grouped[i].second;
+		if (i == 0 || grouped[i].first != grouped[i - 1].first) {
+			tree_groups.push_back(i);
+		}
+	}
+}
+
+void AnimationProcessBatch::add_player(AnimationPlayer *p_player) {
+	players.push_back(p_player);
+	player_ids.push_back(p_player->get_instance_id());
+}
+
+void AnimationProcessBatch::add_tree(AnimationTree *p_tree) {
+	trees.push_back(p_tree);
+	tree_ids.push_back(p_tree->get_instance_id());
+}
+
+void AnimationProcessBatch::process(float p_delta) {
+	// Resolve the caches on the main thread, and drop whatever has nothing to evaluate.
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < players.size(); i++) {
+		if (players[i]->_threaded_process_begin()) {
+			player_ids[count] = player_ids[i];
+			players[count++] = players[i];
+		}
+	}
+	players.resize(count);
+	player_ids.resize(count);
+
+	count = 0;
+	for (uint32_t i = 0; i < trees.size(); i++) {
+		if (trees[i]->_threaded_process_begin()) {
+			tree_ids[count] = tree_ids[i];
+			trees[count++] = trees[i];
+		}
+	}
+	trees.resize(count);
+	tree_ids.resize(count);
+
+	_group_trees();
+
+	delta = p_delta;
+	uint32_t job_count = players.size() + tree_groups.size();
+	if (job_count) {
+		if (work_pool.get_thread_count() == 0) {
+			work_pool.init();
+		}
+		work_pool.do_work(job_count, this, &AnimationProcessBatch::_evaluate_job, nullptr);
+	}
+
+	// Back on the main thread. The remaining tracks may call into anything, including freeing
+	// nodes of this batch, so check they still exist.
+	for (uint32_t i = 0; i < players.size(); i++) {
+		if (ObjectDB::get_instance(player_ids[i])) {
+			players[i]->_threaded_process_end();
+		}
+	}
+	for (uint32_t i = 0; i < trees.size(); i++) {
+		if (ObjectDB::get_instance(tree_ids[i])) {
+			trees[i]->_threaded_process_end();
+		}
+	}
+
+	players.clear();
+	player_ids.clear();
+	trees.clear();
+	tree_ids.clear();
+	sorted_trees.clear();
+}
+
+void AnimationProcessBatch::register_threaded_node(Node *p_node) {
+	if (threaded_nodes.find(p_node) >= 0) {
+		return;
+	}
+	threaded_nodes.push_back(p_node);
+	if (!threaded_batch) {
+		threaded_batch = memnew(AnimationProcessBatch);
+	}
+}
+
+void AnimationProcessBatch::unregister_threaded_node(Node *p_node) {
+	threaded_nodes.erase(p_node);
+	if (threaded_nodes.is_empty() && threaded_batch && !processing_threaded_batch) {
+		memdelete(threaded_batch);
+		threaded_batch = nullptr;
+	}
+}
+
+void AnimationProcessBatch::process_threaded_nodes(bool p_physics) {
+	ERR_FAIL_COND(!threaded_batch);
+
+	uint64_t frame = p_physics ? Engine::get_singleton()->get_physics_frames() : Engine::get_singleton()->get_process_frames();
+	uint64_t &last_frame = p_physics ? last_physics_frame : last_process_frame;
+	if (frame == last_frame) {
+		return; // Another node already processed the batch this frame.
+	}
+	last_frame = frame;
+
+	float delta = 0.0;
+	for (uint32_t i = 0; i < threaded_nodes.size(); i++) {
+		Node *node = threaded_nodes[i];
+		if (!node->can_process()) {
+			continue;
+		}
+
+		AnimationPlayer *player = Object::cast_to<AnimationPlayer>(node);
+		if (player) {
+			if (!player->processing || player->process_callback != (p_physics ? AnimationPlayer::ANIMATION_PROCESS_PHYSICS : AnimationPlayer::ANIMATION_PROCESS_IDLE)) {
+				continue;
+			}
+			threaded_batch->add_player(player);
+		} else {
+			AnimationTree *tree = Object::cast_to<AnimationTree>(node);
+			if (!tree || !tree->active || tree->process_callback != (p_physics ? AnimationTree::ANIMATION_PROCESS_PHYSICS : AnimationTree::ANIMATION_PROCESS_IDLE)) {
+				continue;
+			}
+			threaded_batch->add_tree(tree);
+		}
+
+		delta = p_physics ? node->get_physics_process_delta_time() : node->get_process_delta_time();
+	}
+
+	processing_threaded_batch = true;
+	threaded_batch->process(delta);
+	processing_threaded_batch = false;
+
+	if (threaded_nodes.is_empty()) {
+		memdelete(threaded_batch);
+		threaded_batch = nullptr;
+	}
+}
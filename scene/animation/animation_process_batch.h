@@ -0,0 +1,88 @@
+/*************************************************************************/
+/*  animation_process_batch.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef ANIMATION_PROCESS_BATCH_H
+#define ANIMATION_PROCESS_BATCH_H
+
+#include "core/object/object_id.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/thread_work_pool.h"
+
+class Animation;
+class AnimationNode;
+class AnimationPlayer;
+class AnimationTree;
+class Node;
+
+// Evaluates many AnimationPlayers and AnimationTrees together, sampling and blending their
+// animations on worker threads. Resolving the track caches, running the tracks that call into
+// other nodes and writing the results back stay on the main thread, before and after that.
+class AnimationProcessBatch {
+	ThreadWorkPool work_pool;
+
+	LocalVector<AnimationPlayer *> players;
+	LocalVector<ObjectID> player_ids;
+	LocalVector<AnimationTree *> trees;
+	LocalVector<ObjectID> tree_ids;
+	LocalVector<AnimationTree *> sorted_trees; // By group.
+	LocalVector<uint32_t> tree_groups; // First tree of each group sharing animation nodes.
+	LocalVector<uint32_t> tree_parents; // Union-find over trees, to build the groups.
+	float delta = 0.0;
+
+	void _evaluate_job(uint32_t p_index, void *p_userdata);
+	uint32_t _find_tree_group(uint32_t p_tree);
+	void _group_trees();
+
+	static LocalVector<Node *> threaded_nodes;
+	static AnimationProcessBatch *threaded_batch;
+	static bool processing_threaded_batch;
+	static uint64_t last_process_frame;
+	static uint64_t last_physics_frame;
+
+public:
+	// Whether a track only blends into the caches, so it can be evaluated on a worker thread. The
+	// others call into nodes and run on the main thread afterwards. Seeking (p_delta == 0) blends
+	// discrete values too. AnimationPlayer reads the animated property when a capture track starts,
+	// so it passes p_capture_reads_property, while AnimationTree blends capture tracks like
+	// continuous ones.
+	static bool is_blended_track(const Animation *p_anim, int p_track, float p_delta, bool p_capture_reads_property);
+
+	void add_player(AnimationPlayer *p_player);
+	void add_tree(AnimationTree *p_tree);
+	void process(float p_delta);
+
+	// Nodes with use_threads enabled register here. The first of them notified for processing in a
+	// frame runs the batch for all of them.
+	static void register_threaded_node(Node *p_node);
+	static void unregister_threaded_node(Node *p_node);
+	static void process_threaded_nodes(bool p_physics);
+};
+
+#endif // ANIMATION_PROCESS_BATCH_H
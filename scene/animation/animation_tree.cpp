@@ -32,6 +32,8 @@
 
 #include "animation_blend_tree.h"
 #include "core/config/engine.h"
+#include "core/math/simd.h"
+#include "scene/animation/animation_process_batch.h"
 #include "scene/scene_string_names.h"
 #include "servers/audio/audio_stream.h"
 
@@ -690,11 +692,20 @@ bool AnimationTree::_update_caches(AnimationPlayer *player) {
 
 	K = nullptr;
 	int idx = 0;
+	uint32_t pose_count = 0;
 	while ((K = track_cache.next(K))) {
 		state.track_map[*K] = idx;
 		idx++;
+
+		TrackCache *tc = track_cache[*K];
+		if (tc->type == Animation::TYPE_TRANSFORM) {
+			static_cast<TrackCacheTransform *>(tc)->pose_idx = pose_count++;
+		}
 	}
 
+	pose.resize(pose_count);
+	pose_samples.resize(pose_count);
+
 	state.track_count = idx;
 
 	cache_valid = true;
@@ -710,10 +721,27 @@ void AnimationTree::_clear_caches() {
 	playing_caches.clear();
 
 	track_cache.clear();
+	key_cursors.clear();
+	pose.resize(0);
+	pose_samples.resize(0);
 	cache_valid = false;
 }
 
 void AnimationTree::_process_graph(float p_delta) {
+	if (!_prepare_graph()) {
+		return;
+	}
+
+	_evaluate_graph(p_delta);
+	if (!state.valid) {
+		return; //state is not valid. do nothing.
+	}
+
+	_process_tracks(TRACK_PASS_ALL);
+	_apply_tracks();
+}
+
+bool AnimationTree::_prepare_graph() {
 	_update_properties(); //if properties need updating, update them
 
 	//check all tracks, see if they need modification
@@ -724,14 +752,14 @@ void AnimationTree::_process_graph(float p_delta) {
 		ERR_PRINT("AnimationTree: root AnimationNode is not set, disabling playback.");
 		set_active(false);
 		cache_valid = false;
-		return;
+		return false;
 	}
 
 	if (!has_node(animation_player)) {
 		ERR_PRINT("AnimationTree: no valid AnimationPlayer path set, disabling playback");
 		set_active(false);
 		cache_valid = false;
-		return;
+		return false;
 	}
 
 	AnimationPlayer *player = Object::cast_to<AnimationPlayer>(get_node(animation_player));
@@ -761,12 +789,12 @@ void AnimationTree::_process_graph(float p_delta) {
 		ERR_PRINT("AnimationTree: path points to a node not an AnimationPlayer, disabling playback");
 		set_active(false);
 		cache_valid = false;
-		return;
+		return false;
 	}
 
 	if (!cache_valid) {
 		if (!_update_caches(player)) {
-			return;
+			return false;
 		}
 	}
 
@@ -791,21 +819,206 @@ void AnimationTree::_process_graph(float p_delta) {
 		}
 	}
 
-	//process
+	return true;
+}
 
-	{
-		if (started) {
-			//if started, seek
-			root->_pre_process(SceneStringNames::get_singleton()->parameters_base_path, nullptr, &state, 0, true, Vector<StringName>());
-			started = false;
-		}
+void AnimationTree::_evaluate_graph(float p_delta) {
+	if (started) {
+		//if started, seek
+		root->_pre_process(SceneStringNames::get_singleton()->parameters_base_path, nullptr, &state, 0, true, Vector<StringName>());
+		started = false;
+	}
+
+	root->_pre_process(SceneStringNames::get_singleton()->parameters_base_path, nullptr, &state, p_delta, false, Vector<StringName>());
+}
 
-		root->_pre_process(SceneStringNames::get_singleton()->parameters_base_path, nullptr, &state, p_delta, false, Vector<StringName>());
+void AnimationTree::PoseBuffer::resize(uint32_t p_size) {
+	LocalVector<float> *components[11] = { &loc_x, &loc_y, &loc_z, &rot_x, &rot_y, &rot_z, &rot_w, &scale_x, &scale_y, &scale_z, &weight };
+	const float defaults[11] = { 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0 };
+	for (int i = 0; i < 11; i++) {
+		components[i]->resize(p_size);
+		for (uint32_t j = 0; j < p_size; j++) {
+			(*components[i])[j] = defaults[i];
+		}
 	}
+}
 
-	if (!state.valid) {
-		return; //state is not valid. do nothing.
+void AnimationTree::PoseBuffer::set(uint32_t p_idx, const Vector3 &p_loc, const Quat &p_rot, const Vector3 &p_scale, float p_weight) {
+	loc_x[p_idx] = p_loc.x;
+	loc_y[p_idx] = p_loc.y;
+	loc_z[p_idx] = p_loc.z;
+	rot_x[p_idx] = p_rot.x;
+	rot_y[p_idx] = p_rot.y;
+	rot_z[p_idx] = p_rot.z;
+	rot_w[p_idx] = p_rot.w;
+	scale_x[p_idx] = p_scale.x;
+	scale_y[p_idx] = p_scale.y;
+	scale_z[p_idx] = p_scale.z;
+	weight[p_idx] = p_weight;
+}
+
+Transform AnimationTree::PoseBuffer::get_transform(uint32_t p_idx) const {
+	Transform xform;
+	xform.origin = Vector3(loc_x[p_idx], loc_y[p_idx], loc_z[p_idx]);
+	xform.basis.set_quat_scale(Quat(rot_x[p_idx], rot_y[p_idx], rot_z[p_idx], rot_w[p_idx]), Vector3(scale_x[p_idx], scale_y[p_idx], scale_z[p_idx]));
+	return xform;
+}
+
+// Blends the samples into the pose by their weight and resets the weights. Locations and scales are
+// lerped, rotations are averaged with nlerp weighted by the blend accumulated so far.
+// Samples with no weight leave the pose untouched.
+void AnimationTree::_blend_pose(PoseBuffer &r_pose, PoseBuffer &r_samples, uint32_t p_from, uint32_t p_to) {
+	uint32_t i = p_from;
+
+#if defined(SIMD_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0);
+	const __m128 sign_mask = _mm_set1_ps(-0.0);
+
+	for (; i + 4 <= p_to; i += 4) {
+		__m128 w = _mm_loadu_ps(&r_samples.weight[i]);
+		__m128 accum = _mm_loadu_ps(&r_pose.weight[i]);
+		__m128 total = _mm_add_ps(accum, w);
+		__m128 unweighted = _mm_cmpeq_ps(w, zero);
+
+		float *lerped[6][2] = {
+			{ &r_pose.loc_x[i], &r_samples.loc_x[i] },
+			{ &r_pose.loc_y[i], &r_samples.loc_y[i] },
+			{ &r_pose.loc_z[i], &r_samples.loc_z[i] },
+			{ &r_pose.scale_x[i], &r_samples.scale_x[i] },
+			{ &r_pose.scale_y[i], &r_samples.scale_y[i] },
+			{ &r_pose.scale_z[i], &r_samples.scale_z[i] },
+		};
+		for (int j = 0; j < 6; j++) {
+			__m128 from = _mm_loadu_ps(lerped[j][0]);
+			__m128 to = _mm_loadu_ps(lerped[j][1]);
+			_mm_storeu_ps(lerped[j][0], _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), w)));
+		}
+
+		__m128 px = _mm_loadu_ps(&r_pose.rot_x[i]), py = _mm_loadu_ps(&r_pose.rot_y[i]), pz = _mm_loadu_ps(&r_pose.rot_z[i]), pw = _mm_loadu_ps(&r_pose.rot_w[i]);
+		__m128 sx = _mm_loadu_ps(&r_samples.rot_x[i]), sy = _mm_loadu_ps(&r_samples.rot_y[i]), sz = _mm_loadu_ps(&r_samples.rot_z[i]), sw = _mm_loadu_ps(&r_samples.rot_w[i]);
+
+		// Take the shortest path by flipping samples in the other hemisphere.
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, sx), _mm_mul_ps(py, sy)), _mm_add_ps(_mm_mul_ps(pz, sz), _mm_mul_ps(pw, sw)));
+		__m128 flip = _mm_and_ps(dot, sign_mask);
+		sx = _mm_xor_ps(sx, flip);
+		sy = _mm_xor_ps(sy, flip);
+		sz = _mm_xor_ps(sz, flip);
+		sw = _mm_xor_ps(sw, flip);
+
+		// Unweighted lanes keep the pose rotation, which avoids dividing by a zero total.
+		__m128 f = _mm_div_ps(accum, _mm_or_ps(_mm_and_ps(unweighted, one), _mm_andnot_ps(unweighted, total)));
+		f = _mm_or_ps(_mm_and_ps(unweighted, one), _mm_andnot_ps(unweighted, f));
+
+		__m128 rx = _mm_add_ps(sx, _mm_mul_ps(_mm_sub_ps(px, sx), f));
+		__m128 ry = _mm_add_ps(sy, _mm_mul_ps(_mm_sub_ps(py, sy), f));
+		__m128 rz = _mm_add_ps(sz, _mm_mul_ps(_mm_sub_ps(pz, sz), f));
+		__m128 rw = _mm_add_ps(sw, _mm_mul_ps(_mm_sub_ps(pw, sw), f));
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw))));
+		__m128 inv_len = _mm_div_ps(one, len);
+
+		_mm_storeu_ps(&r_pose.rot_x[i], _mm_mul_ps(rx, inv_len));
+		_mm_storeu_ps(&r_pose.rot_y[i], _mm_mul_ps(ry, inv_len));
+		_mm_storeu_ps(&r_pose.rot_z[i], _mm_mul_ps(rz, inv_len));
+		_mm_storeu_ps(&r_pose.rot_w[i], _mm_mul_ps(rw, inv_len));
+		_mm_storeu_ps(&r_pose.weight[i], total);
+		_mm_storeu_ps(&r_samples.weight[i], zero);
+	}
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+	const float32x4_t zero = vdupq_n_f32(0);
+	const float32x4_t one = vdupq_n_f32(1.0);
+	const uint32x4_t sign_mask = vdupq_n_u32(0x80000000);
+
+	for (; i + 4 <= p_to; i += 4) {
+		float32x4_t w = vld1q_f32(&r_samples.weight[i]);
+		float32x4_t accum = vld1q_f32(&r_pose.weight[i]);
+		float32x4_t total = vaddq_f32(accum, w);
+		uint32x4_t unweighted = vceqq_f32(w, zero);
+
+		float *lerped[6][2] = {
+			{ &r_pose.loc_x[i], &r_samples.loc_x[i] },
+			{ &r_pose.loc_y[i], &r_samples.loc_y[i] },
+			{ &r_pose.loc_z[i], &r_samples.loc_z[i] },
+			{ &r_pose.scale_x[i], &r_samples.scale_x[i] },
+			{ &r_pose.scale_y[i], &r_samples.scale_y[i] },
+			{ &r_pose.scale_z[i], &r_samples.scale_z[i] },
+		};
+		for (int j = 0; j < 6; j++) {
+			float32x4_t from = vld1q_f32(lerped[j][0]);
+			float32x4_t to = vld1q_f32(lerped[j][1]);
+			vst1q_f32(lerped[j][0], vmlaq_f32(from, vsubq_f32(to, from), w));
+		}
+
+		float32x4_t px = vld1q_f32(&r_pose.rot_x[i]), py = vld1q_f32(&r_pose.rot_y[i]), pz = vld1q_f32(&r_pose.rot_z[i]), pw = vld1q_f32(&r_pose.rot_w[i]);
+		float32x4_t sx = vld1q_f32(&r_samples.rot_x[i]), sy = vld1q_f32(&r_samples.rot_y[i]), sz = vld1q_f32(&r_samples.rot_z[i]), sw = vld1q_f32(&r_samples.rot_w[i]);
+
+		// Take the shortest path by flipping samples in the other hemisphere.
+		float32x4_t dot = vaddq_f32(vaddq_f32(vmulq_f32(px, sx), vmulq_f32(py, sy)), vaddq_f32(vmulq_f32(pz, sz), vmulq_f32(pw, sw)));
+		uint32x4_t flip = vandq_u32(vreinterpretq_u32_f32(dot), sign_mask);
+		sx = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sx), flip));
+		sy = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sy), flip));
+		sz = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sz), flip));
+		sw = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sw), flip));
+
+		// Unweighted lanes keep the pose rotation, which avoids dividing by a zero total.
+		float32x4_t f = vbslq_f32(unweighted, one, vdivq_f32(accum, vbslq_f32(unweighted, one, total)));
+
+		float32x4_t rx = vmlaq_f32(sx, vsubq_f32(px, sx), f);
+		float32x4_t ry = vmlaq_f32(sy, vsubq_f32(py, sy), f);
+		float32x4_t rz = vmlaq_f32(sz, vsubq_f32(pz, sz), f);
+		float32x4_t rw = vmlaq_f32(sw, vsubq_f32(pw, sw), f);
+		float32x4_t len = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(rx, rx), vmulq_f32(ry, ry)), vaddq_f32(vmulq_f32(rz, rz), vmulq_f32(rw, rw))));
+		float32x4_t inv_len = vdivq_f32(one, len);
+
+		vst1q_f32(&r_pose.rot_x[i], vmulq_f32(rx, inv_len));
+		vst1q_f32(&r_pose.rot_y[i], vmulq_f32(ry, inv_len));
+		vst1q_f32(&r_pose.rot_z[i], vmulq_f32(rz, inv_len));
+		vst1q_f32(&r_pose.rot_w[i], vmulq_f32(rw, inv_len));
+		vst1q_f32(&r_pose.weight[i], total);
+		vst1q_f32(&r_samples.weight[i], zero);
+	}
+#endif
+
+	for (; i < p_to; i++) {
+		float w = r_samples.weight[i];
+		if (w == 0) {
+			continue;
+		}
+
+		r_pose.loc_x[i] += (r_samples.loc_x[i] - r_pose.loc_x[i]) * w;
+		r_pose.loc_y[i] += (r_samples.loc_y[i] - r_pose.loc_y[i]) * w;
+		r_pose.loc_z[i] += (r_samples.loc_z[i] - r_pose.loc_z[i]) * w;
+		r_pose.scale_x[i] += (r_samples.scale_x[i] - r_pose.scale_x[i]) * w;
+		r_pose.scale_y[i] += (r_samples.scale_y[i] - r_pose.scale_y[i]) * w;
+		r_pose.scale_z[i] += (r_samples.scale_z[i] - r_pose.scale_z[i]) * w;
+
+		float sx = r_samples.rot_x[i], sy = r_samples.rot_y[i], sz = r_samples.rot_z[i], sw = r_samples.rot_w[i];
+		float px = r_pose.rot_x[i], py = r_pose.rot_y[i], pz = r_pose.rot_z[i], pw = r_pose.rot_w[i];
+		if (px * sx + py * sy + pz * sz + pw * sw < 0) {
+			sx = -sx;
+			sy = -sy;
+			sz = -sz;
+			sw = -sw;
+		}
+
+		float total = r_pose.weight[i] + w;
+		float f = r_pose.weight[i] / total;
+		float rx = sx + (px - sx) * f;
+		float ry = sy + (py - sy) * f;
+		float rz = sz + (pz - sz) * f;
+		float rw = sw + (pw - sw) * f;
+		float inv_len = 1.0 / Math::sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+
+		r_pose.rot_x[i] = rx * inv_len;
+		r_pose.rot_y[i] = ry * inv_len;
+		r_pose.rot_z[i] = rz * inv_len;
+		r_pose.rot_w[i] = rw * inv_len;
+		r_pose.weight[i] = total;
+		r_samples.weight[i] = 0;
 	}
+}
+
+void AnimationTree::_process_tracks(TrackPass p_pass) {
 	//apply value/transform/bezier blends to track caches and execute method/audio/animation tracks
 
 	{
@@ -820,6 +1033,16 @@ void AnimationTree::_process_graph(float p_delta) {
 			float weight = as.blend;
 			bool seeked = as.seeked;
 
+			KeyCursors &key_cursor = key_cursors[a->get_instance_id()];
+			key_cursor.last_pass = process_pass;
+			LocalVector<int> &cursors = key_cursor.cursors;
+			if (cursors.size() != (uint32_t)a->get_track_count()) {
+				cursors.resize(a->get_track_count());
+				for (uint32_t i = 0; i < cursors.size(); i++) {
+					cursors[i] = -1;
+				}
+			}
+
 			for (int i = 0; i < a->get_track_count(); i++) {
 				NodePath path = a->track_get_path(i);
 
@@ -843,6 +1066,10 @@ void AnimationTree::_process_graph(float p_delta) {
 					continue; //nothing to blend
 				}
 
+				if (p_pass != TRACK_PASS_ALL && AnimationProcessBatch::is_blended_track(a.ptr(), i, delta, false) != (p_pass == TRACK_PASS_BLEND)) {
+					continue; // processed in the other pass
+				}
+
 				switch (track->type) {
 					case Animation::TYPE_TRANSFORM: {
 						TrackCacheTransform *t = static_cast<TrackCacheTransform *>(track);
@@ -890,7 +1117,7 @@ void AnimationTree::_process_graph(float p_delta) {
 								continue;
 							}
 
-							a->transform_track_interpolate(i, time, &loc[1], &rot[1], &scale[1]);
+							a->transform_track_interpolate(i, time, &loc[1], &rot[1], &scale[1], &cursors[i]);
 
 							t->loc += (loc[1] - loc[0]) * blend;
 							t->scale += (scale[1] - scale[0]) * blend;
@@ -904,31 +1131,22 @@ void AnimationTree::_process_graph(float p_delta) {
 							Quat rot;
 							Vector3 scale;
 
-							Error err = a->transform_track_interpolate(i, time, &loc, &rot, &scale);
+							Error err = a->transform_track_interpolate(i, time, &loc, &rot, &scale, &cursors[i]);
 							//ERR_CONTINUE(err!=OK); //used for testing, should be removed
 
 							if (t->process_pass != process_pass) {
 								t->process_pass = process_pass;
-								t->loc = loc;
-								t->rot = rot;
-								t->rot_blend_accum = 0;
-								t->scale = scale;
+								pose.set(t->pose_idx, loc, rot, scale, 0);
 							}
 
 							if (err != OK) {
 								continue;
 							}
 
-							t->loc = t->loc.lerp(loc, blend);
-							if (t->rot_blend_accum == 0) {
-								t->rot = rot;
-								t->rot_blend_accum = blend;
-							} else {
-								float rot_total = t->rot_blend_accum + blend;
-								t->rot = rot.slerp(t->rot, t->rot_blend_accum / rot_total).normalized();
-								t->rot_blend_accum = rot_total;
-							}
-							t->scale = t->scale.lerp(scale, blend);
+							// Blended together with the rest of the animation's transforms once all are sampled.
+							pose_samples.set(t->pose_idx, loc, rot, scale, blend);
+							pose_samples_from = MIN(pose_samples_from, (uint32_t)t->pose_idx);
+							pose_samples_to = MAX(pose_samples_to, (uint32_t)t->pose_idx + 1);
 						}
 
 					} break;
@@ -939,7 +1157,7 @@ void AnimationTree::_process_graph(float p_delta) {
 
 						if (update_mode == Animation::UPDATE_CONTINUOUS || update_mode == Animation::UPDATE_CAPTURE) { //delta == 0 means seek
 
-							Variant value = a->value_track_interpolate(i, time);
+							Variant value = a->value_track_interpolate(i, time, &cursors[i]);
 
 							if (value == Variant()) {
 								continue;
@@ -995,7 +1213,7 @@ void AnimationTree::_process_graph(float p_delta) {
 					case Animation::TYPE_BEZIER: {
 						TrackCacheBezier *t = static_cast<TrackCacheBezier *>(track);
 
-						float bezier = a->bezier_track_interpolate(i, time);
+						float bezier = a->bezier_track_interpolate(i, time, &cursors[i]);
 
 						if (t->process_pass != process_pass) {
 							t->value = bezier;
@@ -1175,9 +1393,17 @@ void AnimationTree::_process_graph(float p_delta) {
 					} break;
 				}
 			}
+
+			if (pose_samples_from < pose_samples_to) {
+				_blend_pose(pose, pose_samples, pose_samples_from, pose_samples_to);
+				pose_samples_from = UINT32_MAX;
+				pose_samples_to = 0;
+			}
 		}
 	}
+}
 
+void AnimationTree::_apply_tracks() {
 	{
 		// finally, set the tracks
 		const NodePath *K = nullptr;
@@ -1192,9 +1418,12 @@ void AnimationTree::_process_graph(float p_delta) {
 					TrackCacheTransform *t = static_cast<TrackCacheTransform *>(track);
 
 					Transform xform;
-					xform.origin = t->loc;
-
-					xform.basis.set_quat_scale(t->rot, t->scale);
+					if (t->root_motion) {
+						xform.origin = t->loc;
+						xform.basis.set_quat_scale(t->rot, t->scale);
+					} else {
+						xform = pose.get_transform(t->pose_idx);
+					}
 
 					if (t->root_motion) {
 						root_motion_transform = xform;
@@ -1227,23 +1456,67 @@ void AnimationTree::_process_graph(float p_delta) {
 			}
 		}
 	}
+
+	// Every animation processed this pass has a cursor, so any extra one belongs to an animation
+	// that is no longer playing. Forget those, or the map grows with every animation ever played.
+	if (key_cursors.size() > (uint32_t)state.animation_states.size()) {
+		LocalVector<ObjectID> unused;
+		const ObjectID *K = nullptr;
+		while ((K = key_cursors.next(K))) {
+			if (key_cursors[*K].last_pass != process_pass) {
+				unused.push_back(*K);
+			}
+		}
+		for (uint32_t i = 0; i < unused.size(); i++) {
+			key_cursors.erase(unused[i]);
+		}
+	}
 }
 
 void AnimationTree::advance(float p_time) {
 	_process_graph(p_time);
 }
 
+bool AnimationTree::_threaded_process_begin() {
+	return _prepare_graph();
+}
+
+void AnimationTree::_threaded_process(float p_delta) {
+	_evaluate_graph(p_delta);
+	if (state.valid) {
+		_process_tracks(TRACK_PASS_BLEND);
+	}
+}
+
+void AnimationTree::_threaded_process_end() {
+	if (state.valid) {
+		_process_tracks(TRACK_PASS_MAIN_THREAD);
+		_apply_tracks();
+	}
+}
+
 void AnimationTree::_notification(int p_what) {
 	if (active && p_what == NOTIFICATION_INTERNAL_PHYSICS_PROCESS && process_callback == ANIMATION_PROCESS_PHYSICS) {
-		_process_graph(get_physics_process_delta_time());
+		if (use_threads) {
+			AnimationProcessBatch::process_threaded_nodes(true);
+		} else {
+			_process_graph(get_physics_process_delta_time());
+		}
 	}
 
 	if (active && p_what == NOTIFICATION_INTERNAL_PROCESS && process_callback == ANIMATION_PROCESS_IDLE) {
-		_process_graph(get_process_delta_time());
+		if (use_threads) {
+			AnimationProcessBatch::process_threaded_nodes(false);
+		} else {
+			_process_graph(get_process_delta_time());
+		}
 	}
 
 	if (p_what == NOTIFICATION_EXIT_TREE) {
 		_clear_caches();
+		if (use_threads) {
+			AnimationProcessBatch::unregister_threaded_node(this);
+		}
 		if (last_animation_player.is_valid()) {
 			Object *player = ObjectDB::get_instance(last_animation_player);
 			if (player) {
@@ -1257,9 +1530,31 @@ void AnimationTree::_notification(int p_what) {
 				player->connect("caches_cleared", callable_mp(this, &AnimationTree::_clear_caches));
 			}
 		}
+		if (use_threads) {
+			AnimationProcessBatch::register_threaded_node(this);
+		}
 	}
 }
 
+void AnimationTree::set_use_threads(bool p_use) {
+	if (use_threads == p_use) {
+		return;
+	}
+
+	use_threads = p_use;
+	if (is_inside_tree()) {
+		if (use_threads) {
+			AnimationProcessBatch::register_threaded_node(this);
+		} else {
+			AnimationProcessBatch::unregister_threaded_node(this);
+		}
+	}
+}
+
+bool AnimationTree::is_using_threads() const {
+	return use_threads;
+}
+
 void AnimationTree::set_animation_player(const NodePath &p_player) {
 	animation_player = p_player;
 	update_configuration_warnings();
@@ -1457,6 +1752,9 @@ void AnimationTree::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_active", "active"), &AnimationTree::set_active);
 	ClassDB::bind_method(D_METHOD("is_active"), &AnimationTree::is_active);
 
+	ClassDB::bind_method(D_METHOD("set_use_threads", "enable"), &AnimationTree::set_use_threads);
+	ClassDB::bind_method(D_METHOD("is_using_threads"), &AnimationTree::is_using_threads);
+
 	ClassDB::bind_method(D_METHOD("set_tree_root", "root"), &AnimationTree::set_tree_root);
 	ClassDB::bind_method(D_METHOD("get_tree_root"), &AnimationTree::get_tree_root);
 
@@ -1481,6 +1779,7 @@ void AnimationTree::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "anim_player", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "AnimationPlayer"), "set_animation_player", "get_animation_player");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "active"), "set_active", "is_active");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "process_callback", PROPERTY_HINT_ENUM, "Physics,Idle,Manual"), "set_process_callback", "get_process_callback");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_threads"), "set_use_threads", "is_using_threads");
 	ADD_GROUP("Root Motion", "root_motion_");
 	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "root_motion_track"), "set_root_motion_track", "get_root_motion_track");
 
@@ -187,6 +187,8 @@ private:
 		Node3D *spatial = nullptr;
 		Skeleton3D *skeleton = nullptr;
 		int bone_idx = -1;
+		int pose_idx = -1;
+		// Only used for root motion, other transforms are blended in the pose buffer.
 		Vector3 loc;
 		Quat rot;
 		float rot_blend_accum = 0.0;
@@ -235,11 +237,40 @@ private:
 
 	HashMap<NodePath, TrackCache *> track_cache;
 	Set<TrackCache *> playing_caches;
+	// Last key sampled in each track of each animation, see Animation::transform_track_interpolate().
+	// Track caches are shared by every animation blended into them, so they can't hold these.
+	// Animations that were not processed in the last pass are dropped, see _apply_tracks().
+	struct KeyCursors {
+		LocalVector<int> cursors;
+		uint64_t last_pass = 0;
+	};
+	HashMap<ObjectID, KeyCursors> key_cursors;
+
+	// Transforms of every transform track, one array per component so they can be blended in bulk.
+	// The samples hold what one animation contributes, with its blend amount as weight.
+	struct PoseBuffer {
+		LocalVector<float> loc_x, loc_y, loc_z;
+		LocalVector<float> rot_x, rot_y, rot_z, rot_w;
+		LocalVector<float> scale_x, scale_y, scale_z;
+		LocalVector<float> weight;
+
+		void resize(uint32_t p_size);
+		void set(uint32_t p_idx, const Vector3 &p_loc, const Quat &p_rot, const Vector3 &p_scale, float p_weight);
+		Transform get_transform(uint32_t p_idx) const;
+	};
+
+	PoseBuffer pose;
+	PoseBuffer pose_samples;
+	uint32_t pose_samples_from = UINT32_MAX;
+	uint32_t pose_samples_to = 0;
+
+	static void _blend_pose(PoseBuffer &r_pose, PoseBuffer &r_samples, uint32_t p_from, uint32_t p_to);
 
 	Ref<AnimationNode> root;
 
 	AnimationProcessCallback process_callback = ANIMATION_PROCESS_IDLE;
 	bool active = false;
+	bool use_threads = false;
 	NodePath animation_player;
 
 	AnimationNode::State state;
@@ -251,6 +282,24 @@ private:
 	bool _update_caches(AnimationPlayer *player);
 	void _process_graph(float p_delta);
 
+	// With use_threads, the graph is evaluated and blended on a worker thread, and the tracks that
+	// call into other nodes are left for the main thread to process afterwards.
+	enum TrackPass {
+		TRACK_PASS_ALL,
+		TRACK_PASS_BLEND,
+		TRACK_PASS_MAIN_THREAD,
+	};
+
+	bool _prepare_graph();
+	void _evaluate_graph(float p_delta);
+	void _process_tracks(TrackPass p_pass);
+	void _apply_tracks();
+
+	bool _threaded_process_begin();
+	void _threaded_process(float p_delta);
+	void _threaded_process_end();
+	friend class AnimationProcessBatch;
+
 	uint64_t setup_pass = 1;
 	uint64_t process_pass = 1;
 
@@ -294,6 +343,9 @@ public:
 	void set_active(bool p_active);
 	bool is_active() const;
 
+	void set_use_threads(bool p_use);
+	bool is_using_threads() const;
+
 	void set_process_callback(AnimationProcessCallback p_mode);
 	AnimationProcessCallback get_process_callback() const;
 
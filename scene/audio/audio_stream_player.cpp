@@ -31,6 +31,7 @@
 #include "audio_stream_player.h"
 
 #include "core/config/engine.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 void AudioStreamPlayer::_mix_to_bus(const AudioFrame *p_frames, int p_amount) {
 	int bus_index = AudioServer::get_singleton()->thread_find_bus_index(bus);
@@ -59,9 +60,7 @@ void AudioStreamPlayer::_mix_to_bus(const AudioFrame *p_frames, int p_amount) {
 		if (!targets[c]) {
 			break;
 		}
-		for (int i = 0; i < p_amount; i++) {
-			targets[c][i] += p_frames[i];
-		}
+		AudioMixKernels::add(targets[c], p_frames, p_amount);
 	}
 }
 
@@ -82,10 +81,7 @@ void AudioStreamPlayer::_mix_internal(bool p_fadeout) {
 	float vol = Math::db2linear(mix_volume_db);
 	float vol_inc = (Math::db2linear(target_volume) - vol) / float(buffer_size);
 
-	for (int i = 0; i < buffer_size; i++) {
-		buffer[i] *= vol;
-		vol += vol_inc;
-	}
+	AudioMixKernels::scale_ramp(buffer, buffer, buffer_size, AudioFrame(vol, vol), AudioFrame(vol_inc, vol_inc));
 
 	//set volume for next mix
 	mix_volume_db = target_volume;
@@ -183,10 +179,7 @@ void AudioStreamPlayer::set_stream(Ref<AudioStream> p_stream) {
 		float vol = Math::db2linear(mix_volume_db);
 		float vol_inc = (Math::db2linear(target_volume) - vol) / float(buffer_size);
 
-		for (int i = 0; i < buffer_size; i++) {
-			buffer[i] *= vol;
-			vol += vol_inc;
-		}
+		AudioMixKernels::scale_ramp(buffer, buffer, buffer_size, AudioFrame(vol, vol), AudioFrame(vol_inc, vol_inc));
 
 		use_fadeout = true;
 	}
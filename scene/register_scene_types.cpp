@@ -1033,10 +1033,12 @@ void unregister_scene_types() {
 	//StandardMaterial3D is not initialised when 3D is disabled, so it shouldn't be cleaned up either
 #ifndef _3D_DISABLED
 	BaseMaterial3D::finish_shaders();
+	CPUParticles3D::finish_work_pool();
 #endif // _3D_DISABLED
 
 	ParticlesMaterial::finish_shaders();
 	CanvasItemMaterial::finish_shaders();
+	CPUParticles2D::finish_work_pool();
 	ColorPicker::finish_shaders();
 	SceneStringNames::free();
 }
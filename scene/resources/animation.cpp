@@ -36,7 +36,9 @@
 bool Animation::_set(const StringName &p_name, const Variant &p_value) {
 	String name = p_name;
 
-	if (name.begins_with("tracks/")) {
+	if (name == "compressed_data") {
+		compressed_data = p_value;
+	} else if (name.begins_with("tracks/")) {
 		int track = name.get_slicec('/', 1).to_int();
 		String what = name.get_slicec('/', 2);
 
@@ -74,9 +76,15 @@ bool Animation::_set(const StringName &p_name, const Variant &p_value) {
 			track_set_imported(track, p_value);
 		} else if (what == "enabled") {
 			track_set_enabled(track, p_value);
+		} else if (what == "compressed_offset") {
+			ERR_FAIL_COND_V(track_get_type(track) != TYPE_TRANSFORM, false);
+			TransformTrack *tt = static_cast<TransformTrack *>(tracks[track]);
+			tt->transforms.clear();
+			tt->compressed_offset = p_value;
 		} else if (what == "keys" || what == "key_values") {
 			if (track_get_type(track) == TYPE_TRANSFORM) {
 				TransformTrack *tt = static_cast<TransformTrack *>(tracks[track]);
+				tt->compressed_offset = -1;
 				Vector<float> values = p_value;
 				int vcount = values.size();
 				ERR_FAIL_COND_V(vcount % 12, false); // should be multiple of 11
@@ -312,6 +320,8 @@ bool Animation::_get(const StringName &p_name, Variant &r_ret) const {
 		r_ret = loop;
 	} else if (name == "step") {
 		r_ret = step;
+	} else if (name == "compressed_data") {
+		r_ret = compressed_data;
 	} else if (name.begins_with("tracks/")) {
 		int track = name.get_slicec('/', 1).to_int();
 		String what = name.get_slicec('/', 2);
@@ -350,6 +360,9 @@ bool Animation::_get(const StringName &p_name, Variant &r_ret) const {
 			r_ret = track_is_imported(track);
 		} else if (what == "enabled") {
 			r_ret = track_is_enabled(track);
+		} else if (what == "compressed_offset") {
+			ERR_FAIL_COND_V(track_get_type(track) != TYPE_TRANSFORM, false);
+			r_ret = static_cast<const TransformTrack *>(tracks[track])->compressed_offset;
 		} else if (what == "keys") {
 			if (track_get_type(track) == TYPE_TRANSFORM) {
 				Vector<float> keys;
@@ -569,6 +582,9 @@ bool Animation::_get(const StringName &p_name, Variant &r_ret) const {
 }
 
 void Animation::_get_property_list(List<PropertyInfo> *p_list) const {
+	if (compressed_data.size()) {
+		p_list->push_back(PropertyInfo(Variant::PACKED_BYTE_ARRAY, "compressed_data", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
+	}
 	for (int i = 0; i < tracks.size(); i++) {
 		p_list->push_back(PropertyInfo(Variant::STRING, "tracks/" + itos(i) + "/type", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
 		p_list->push_back(PropertyInfo(Variant::NODE_PATH, "tracks/" + itos(i) + "/path", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
@@ -576,7 +592,11 @@ void Animation::_get_property_list(List<PropertyInfo> *p_list) const {
 		p_list->push_back(PropertyInfo(Variant::BOOL, "tracks/" + itos(i) + "/loop_wrap", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
 		p_list->push_back(PropertyInfo(Variant::BOOL, "tracks/" + itos(i) + "/imported", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
 		p_list->push_back(PropertyInfo(Variant::BOOL, "tracks/" + itos(i) + "/enabled", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
-		p_list->push_back(PropertyInfo(Variant::ARRAY, "tracks/" + itos(i) + "/keys", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
+		if (tracks[i]->type == TYPE_TRANSFORM && static_cast<const TransformTrack *>(tracks[i])->compressed_offset >= 0) {
+			p_list->push_back(PropertyInfo(Variant::INT, "tracks/" + itos(i) + "/compressed_offset", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
+		} else {
+			p_list->push_back(PropertyInfo(Variant::ARRAY, "tracks/" + itos(i) + "/keys", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
+		}
 	}
 }
 
@@ -779,16 +799,25 @@ Error Animation::transform_track_get_key(int p_track, int p_key, Vector3 *r_loc,
 
 	TransformTrack *tt = static_cast<TransformTrack *>(t);
 	ERR_FAIL_COND_V(t->type != TYPE_TRANSFORM, ERR_INVALID_PARAMETER);
-	ERR_FAIL_INDEX_V(p_key, tt->transforms.size(), ERR_INVALID_PARAMETER);
+
+	TransformKey key;
+	if (tt->compressed_offset >= 0) {
+		CompressedTransformKeys keys = _get_compressed_keys(tt);
+		ERR_FAIL_INDEX_V(p_key, keys.size(), ERR_INVALID_PARAMETER);
+		key = keys.get_value(p_key);
+	} else {
+		ERR_FAIL_INDEX_V(p_key, tt->transforms.size(), ERR_INVALID_PARAMETER);
+		key = tt->transforms[p_key].value;
+	}
 
 	if (r_loc) {
-		*r_loc = tt->transforms[p_key].value.loc;
+		*r_loc = key.loc;
 	}
 	if (r_rot) {
-		*r_rot = tt->transforms[p_key].value.rot;
+		*r_rot = key.rot;
 	}
 	if (r_scale) {
-		*r_scale = tt->transforms[p_key].value.scale;
+		*r_scale = key.scale;
 	}
 
 	return OK;
@@ -800,6 +829,7 @@ int Animation::transform_track_insert_key(int p_track, float p_time, const Vecto
 	ERR_FAIL_COND_V(t->type != TYPE_TRANSFORM, -1);
 
 	TransformTrack *tt = static_cast<TransformTrack *>(t);
+	ERR_FAIL_COND_V_MSG(tt->compressed_offset >= 0, -1, "Compressed transform tracks can't be edited, call decompress() first.");
 
 	TKey<TransformKey> tkey;
 	tkey.time = p_time;
@@ -825,6 +855,7 @@ void Animation::track_remove_key(int p_track, int p_idx) {
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			ERR_FAIL_COND_MSG(tt->compressed_offset >= 0, "Compressed transform tracks can't be edited, call decompress() first.");
 			ERR_FAIL_INDEX(p_idx, tt->transforms.size());
 			tt->transforms.remove(p_idx);
 
@@ -871,6 +902,17 @@ int Animation::track_find_key(int p_track, float p_time, bool p_exact) const {
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed_offset >= 0) {
+				CompressedTransformKeys keys = _get_compressed_keys(tt);
+				int k = _find(keys, p_time);
+				if (k < 0 || k >= keys.size()) {
+					return -1;
+				}
+				if (keys[k].time != p_time && p_exact) {
+					return -1;
+				}
+				return k;
+			}
 			int k = _find(tt->transforms, p_time);
 			if (k < 0 || k >= tt->transforms.size()) {
 				return -1;
@@ -1055,6 +1097,9 @@ int Animation::track_get_key_count(int p_track) const {
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed_offset >= 0) {
+				return _get_compressed_keys(tt).size();
+			}
 			return tt->transforms.size();
 		} break;
 		case TYPE_VALUE: {
@@ -1089,13 +1134,15 @@ Variant Animation::track_get_key_value(int p_track, int p_key_idx) const {
 
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
-			TransformTrack *tt = static_cast<TransformTrack *>(t);
-			ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), Variant());
+			Vector3 loc;
+			Quat rot;
+			Vector3 scale;
+			ERR_FAIL_COND_V(transform_track_get_key(p_track, p_key_idx, &loc, &rot, &scale) != OK, Variant());
 
 			Dictionary d;
-			d["location"] = tt->transforms[p_key_idx].value.loc;
-			d["rotation"] = tt->transforms[p_key_idx].value.rot;
-			d["scale"] = tt->transforms[p_key_idx].value.scale;
+			d["location"] = loc;
+			d["rotation"] = rot;
+			d["scale"] = scale;
 
 			return d;
 		} break;
@@ -1158,6 +1205,11 @@ float Animation::track_get_key_time(int p_track, int p_key_idx) const {
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed_offset >= 0) {
+				CompressedTransformKeys keys = _get_compressed_keys(tt);
+				ERR_FAIL_INDEX_V(p_key_idx, keys.size(), -1);
+				return keys[p_key_idx].time;
+			}
 			ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), -1);
 			return tt->transforms[p_key_idx].time;
 		} break;
@@ -1203,6 +1255,7 @@ void Animation::track_set_key_time(int p_track, int p_key_idx, float p_time) {
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			ERR_FAIL_COND_MSG(tt->compressed_offset >= 0, "Compressed transform tracks can't be edited, call decompress() first.");
 			ERR_FAIL_INDEX(p_key_idx, tt->transforms.size());
 			TKey<TransformKey> key = tt->transforms[p_key_idx];
 			key.time = p_time;
@@ -1267,6 +1320,10 @@ float Animation::track_get_key_transition(int p_track, int p_key_idx) const {
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed_offset >= 0) {
+				ERR_FAIL_INDEX_V(p_key_idx, _get_compressed_keys(tt).size(), -1);
+				return 1.0; // Only tracks without transitions are compressed.
+			}
 			ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), -1);
 			return tt->transforms[p_key_idx].transition;
 		} break;
@@ -1303,6 +1360,7 @@ void Animation::track_set_key_value(int p_track, int p_key_idx, const Variant &p
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			ERR_FAIL_COND_MSG(tt->compressed_offset >= 0, "Compressed transform tracks can't be edited, call decompress() first.");
 			ERR_FAIL_INDEX(p_key_idx, tt->transforms.size());
 
 			Dictionary d = p_value;
@@ -1386,6 +1444,7 @@ void Animation::track_set_key_transition(int p_track, int p_key_idx, float p_tra
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			ERR_FAIL_COND_MSG(tt->compressed_offset >= 0, "Compressed transform tracks can't be edited, call decompress() first.");
 			ERR_FAIL_INDEX(p_key_idx, tt->transforms.size());
 			tt->transforms.write[p_key_idx].transition = p_transition;
 		} break;
@@ -1449,6 +1508,77 @@ int Animation::_find(const Vector<K> &p_keys, float p_time) const {
 	return middle;
 }
 
+int Animation::_find(const CompressedTransformKeys &p_keys, float p_time) const {
+	int len = p_keys.size();
+	if (len == 0) {
+		return -2;
+	}
+
+	int low = 0;
+	int high = len - 1;
+	int middle = 0;
+
+	while (low <= high) {
+		middle = (low + high) / 2;
+
+		float time = p_keys[middle].time;
+		if (Math::is_equal_approx(p_time, time)) { //match
+			return middle;
+		} else if (p_time < time) {
+			high = middle - 1; //search low end of array
+		} else {
+			low = middle + 1; //search high end of array
+		}
+	}
+
+	if (p_keys[middle].time > p_time) {
+		middle--;
+	}
+
+	return middle;
+}
+
+template <class C>
+int Animation::_find(const C &p_keys, float p_time, int *r_cursor) const {
+	if (!r_cursor) {
+		return _find(p_keys, p_time);
+	}
+
+	// During playback the key is almost always the one from the previous call or a neighbor, so
+	// step from it. Keys are at or before p_time up to the result, and after it past the result.
+	int len = p_keys.size();
+	int idx = *r_cursor;
+	if (idx >= -1 && idx < len) {
+		int steps = 0;
+		while (idx + 1 < len && (p_keys[idx + 1].time < p_time || Math::is_equal_approx(p_keys[idx + 1].time, p_time)) && steps < 4) {
+			idx++;
+			steps++;
+		}
+		while (idx >= 0 && p_keys[idx].time > p_time && !Math::is_equal_approx(p_keys[idx].time, p_time) && steps < 4) {
+			idx--;
+			steps++;
+		}
+		if (steps < 4 && len > 0) {
+			*r_cursor = idx;
+			return idx;
+		}
+	}
+
+	// Seeked too far away, search all keys.
+	idx = _find(p_keys, p_time);
+	*r_cursor = idx;
+	return idx;
+}
+
+template <class C>
+int Animation::_get_key_count_in_length(const C &p_keys) const {
+	int len = p_keys.size();
+	if (len && p_keys[len - 1].time > length) {
+		len = _find(p_keys, length) + 1; // there are keys past the end
+	}
+	return len;
+}
+
 Animation::TransformKey Animation::_interpolate(const Animation::TransformKey &p_a, const Animation::TransformKey &p_b, float p_c) const {
 	TransformKey ret;
 	ret.loc = _interpolate(p_a.loc, p_b.loc, p_c);
@@ -1583,28 +1713,24 @@ float Animation::_cubic_interpolate(const float &p_pre_a, const float &p_a, cons
 	return _interpolate(p_a, p_b, p_c);
 }
 
-template <class T>
-T Animation::_interpolate(const Vector<TKey<T>> &p_keys, float p_time, InterpolationType p_interp, bool p_loop_wrap, bool *p_ok) const {
-	int len = _find(p_keys, length) + 1; // try to find last key (there may be more past the end)
+template <class C>
+bool Animation::_find_interpolation_keys(const C &p_keys, float p_time, bool p_loop_wrap, int *r_cursor, int *r_len, int *r_idx, int *r_next, float *r_c) const {
+	int len = _get_key_count_in_length(p_keys);
 
 	if (len <= 0) {
-		// (-1 or -2 returned originally) (plus one above)
-		// meaning no keys, or only key time is larger than length
-		if (p_ok) {
-			*p_ok = false;
-		}
-		return T();
+		// no keys, or only key time is larger than length
+		return false;
 	} else if (len == 1) { // one key found (0+1), return it
-
-		if (p_ok) {
-			*p_ok = true;
-		}
-		return p_keys[0].value;
+		*r_len = 1;
+		*r_idx = 0;
+		*r_next = 0;
+		*r_c = 0;
+		return true;
 	}
 
-	int idx = _find(p_keys, p_time);
+	int idx = _find(p_keys, p_time, r_cursor);
 
-	ERR_FAIL_COND_V(idx == -2, T());
+	ERR_FAIL_COND_V(idx == -2, false);
 
 	bool result = true;
 	int next = 0;
@@ -1683,6 +1809,21 @@ T Animation::_interpolate(const Vector<TKey<T>> &p_keys, float p_time, Interpola
 		}
 	}
 
+	*r_len = len;
+	*r_idx = idx;
+	*r_next = next;
+	*r_c = c;
+	return result;
+}
+
+template <class T>
+T Animation::_interpolate(const Vector<TKey<T>> &p_keys, float p_time, InterpolationType p_interp, bool p_loop_wrap, bool *p_ok, int *r_cursor) const {
+	int len = 0;
+	int idx = 0;
+	int next = 0;
+	float c = 0.0;
+	bool result = _find_interpolation_keys(p_keys, p_time, p_loop_wrap, r_cursor, &len, &idx, &next, &c);
+
 	if (p_ok) {
 		*p_ok = result;
 	}
@@ -1728,19 +1869,43 @@ T Animation::_interpolate(const Vector<TKey<T>> &p_keys, float p_time, Interpola
 	// do a barrel roll
 }
 
-Error Animation::transform_track_interpolate(int p_track, float p_time, Vector3 *r_loc, Quat *r_rot, Vector3 *r_scale) const {
+Error Animation::transform_track_interpolate(int p_track, float p_time, Vector3 *r_loc, Quat *r_rot, Vector3 *r_scale, int *r_cursor) const {
 	ERR_FAIL_INDEX_V(p_track, tracks.size(), ERR_INVALID_PARAMETER);
 	Track *t = tracks[p_track];
 	ERR_FAIL_COND_V(t->type != TYPE_TRANSFORM, ERR_INVALID_PARAMETER);
 
 	TransformTrack *tt = static_cast<TransformTrack *>(t);
 
-	bool ok = false;
+	TransformKey tk;
+
+	if (tt->compressed_offset >= 0) {
+		// Sample the compressed keys in place, only decoding the ones needed.
+		CompressedTransformKeys keys = _get_compressed_keys(tt);
+		int len = 0;
+		int idx = 0;
+		int next = 0;
+		float c = 0.0;
+		if (!_find_interpolation_keys(keys, p_time, tt->loop_wrap, r_cursor, &len, &idx, &next, &c)) {
+			return ERR_UNAVAILABLE;
+		}
+
+		if (idx == next || tt->interpolation == INTERPOLATION_NEAREST) {
+			tk = keys.get_value(idx);
+		} else if (tt->interpolation == INTERPOLATION_CUBIC) {
+			int pre = MAX(idx - 1, 0);
+			int post = next + 1 < len ? next + 1 : next;
+			tk = _cubic_interpolate(keys.get_value(pre), keys.get_value(idx), keys.get_value(next), keys.get_value(post), c);
+		} else {
+			tk = _interpolate(keys.get_value(idx), keys.get_value(next), c);
+		}
+	} else {
+		bool ok = false;
 
-	TransformKey tk = _interpolate(tt->transforms, p_time, tt->interpolation, tt->loop_wrap, &ok);
+		tk = _interpolate(tt->transforms, p_time, tt->interpolation, tt->loop_wrap, &ok, r_cursor);
 
-	if (!ok) {
-		return ERR_UNAVAILABLE;
+		if (!ok) {
+			return ERR_UNAVAILABLE;
+		}
 	}
 
 	if (r_loc) {
@@ -1758,7 +1923,7 @@ Error Animation::transform_track_interpolate(int p_track, float p_time, Vector3
 	return OK;
 }
 
-Variant Animation::value_track_interpolate(int p_track, float p_time) const {
+Variant Animation::value_track_interpolate(int p_track, float p_time, int *r_cursor) const {
 	ERR_FAIL_INDEX_V(p_track, tracks.size(), 0);
 	Track *t = tracks[p_track];
 	ERR_FAIL_COND_V(t->type != TYPE_VALUE, Variant());
@@ -1766,7 +1931,7 @@ Variant Animation::value_track_interpolate(int p_track, float p_time) const {
 
 	bool ok = false;
 
-	Variant res = _interpolate(vt->values, p_time, (vt->update_mode == UPDATE_CONTINUOUS || vt->update_mode == UPDATE_CAPTURE) ? vt->interpolation : INTERPOLATION_NEAREST, vt->loop_wrap, &ok);
+	Variant res = _interpolate(vt->values, p_time, (vt->update_mode == UPDATE_CONTINUOUS || vt->update_mode == UPDATE_CAPTURE) ? vt->interpolation : INTERPOLATION_NEAREST, vt->loop_wrap, &ok, r_cursor);
 
 	if (ok) {
 		return res;
@@ -1874,8 +2039,8 @@ Animation::UpdateMode Animation::value_track_get_update_mode(int p_track) const
 	return vt->update_mode;
 }
 
-template <class T>
-void Animation::_track_get_key_indices_in_range(const Vector<T> &p_array, float from_time, float to_time, List<int> *p_indices) const {
+template <class C>
+void Animation::_track_get_key_indices_in_range(const C &p_array, float from_time, float to_time, List<int> *p_indices) const {
 	if (from_time != length && to_time == length) {
 		to_time = length * 1.01; //include a little more if at the end
 	}
@@ -1934,8 +2099,14 @@ void Animation::track_get_key_indices_in_range(int p_track, float p_time, float
 			switch (t->type) {
 				case TYPE_TRANSFORM: {
 					const TransformTrack *tt = static_cast<const TransformTrack *>(t);
-					_track_get_key_indices_in_range(tt->transforms, from_time, length, p_indices);
-					_track_get_key_indices_in_range(tt->transforms, 0, to_time, p_indices);
+					if (tt->compressed_offset >= 0) {
+						CompressedTransformKeys keys = _get_compressed_keys(tt);
+						_track_get_key_indices_in_range(keys, from_time, length, p_indices);
+						_track_get_key_indices_in_range(keys, 0, to_time, p_indices);
+					} else {
+						_track_get_key_indices_in_range(tt->transforms, from_time, length, p_indices);
+						_track_get_key_indices_in_range(tt->transforms, 0, to_time, p_indices);
+					}
 
 				} break;
 				case TYPE_VALUE: {
@@ -1990,7 +2161,11 @@ void Animation::track_get_key_indices_in_range(int p_track, float p_time, float
 	switch (t->type) {
 		case TYPE_TRANSFORM: {
 			const TransformTrack *tt = static_cast<const TransformTrack *>(t);
-			_track_get_key_indices_in_range(tt->transforms, from_time, to_time, p_indices);
+			if (tt->compressed_offset >= 0) {
+				_track_get_key_indices_in_range(_get_compressed_keys(tt), from_time, to_time, p_indices);
+			} else {
+				_track_get_key_indices_in_range(tt->transforms, from_time, to_time, p_indices);
+			}
 
 		} break;
 		case TYPE_VALUE: {
@@ -2246,7 +2421,7 @@ static _FORCE_INLINE_ Vector2 _bezier_interp(real_t t, const Vector2 &start, con
 	return start * omt3 + control_1 * omt2 * t * 3.0 + control_2 * omt * t2 * 3.0 + end * t3;
 }
 
-float Animation::bezier_track_interpolate(int p_track, float p_time) const {
+float Animation::bezier_track_interpolate(int p_track, float p_time, int *r_cursor) const {
 	//this uses a different interpolation scheme
 	ERR_FAIL_INDEX_V(p_track, tracks.size(), 0);
 	Track *track = tracks[p_track];
@@ -2254,16 +2429,15 @@ float Animation::bezier_track_interpolate(int p_track, float p_time) const {
 
 	BezierTrack *bt = static_cast<BezierTrack *>(track);
 
-	int len = _find(bt->values, length) + 1; // try to find last key (there may be more past the end)
+	int len = _get_key_count_in_length(bt->values);
 
 	if (len <= 0) {
-		// (-1 or -2 returned originally) (plus one above)
 		return 0;
 	} else if (len == 1) { // one key found (0+1), return it
 		return bt->values[0].value.value;
 	}
 
-	int idx = _find(bt->values, p_time);
+	int idx = _find(bt->values, p_time, r_cursor);
 
 	ERR_FAIL_COND_V(idx == -2, 0);
 
@@ -2632,7 +2806,7 @@ void Animation::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("value_track_get_update_mode", "track_idx"), &Animation::value_track_get_update_mode);
 
 	ClassDB::bind_method(D_METHOD("value_track_get_key_indices", "track_idx", "time_sec", "delta"), &Animation::_value_track_get_key_indices);
-	ClassDB::bind_method(D_METHOD("value_track_interpolate", "track_idx", "time_sec"), &Animation::value_track_interpolate);
+	ClassDB::bind_method(D_METHOD("value_track_interpolate", "track_idx", "time_sec"), &Animation::_value_track_interpolate);
 
 	ClassDB::bind_method(D_METHOD("method_track_get_key_indices", "track_idx", "time_sec", "delta"), &Animation::_method_track_get_key_indices);
 	ClassDB::bind_method(D_METHOD("method_track_get_name", "track_idx", "key_idx"), &Animation::method_track_get_name);
@@ -2648,7 +2822,7 @@ void Animation::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("bezier_track_get_key_in_handle", "track_idx", "key_idx"), &Animation::bezier_track_get_key_in_handle);
 	ClassDB::bind_method(D_METHOD("bezier_track_get_key_out_handle", "track_idx", "key_idx"), &Animation::bezier_track_get_key_out_handle);
 
-	ClassDB::bind_method(D_METHOD("bezier_track_interpolate", "track_idx", "time"), &Animation::bezier_track_interpolate);
+	ClassDB::bind_method(D_METHOD("bezier_track_interpolate", "track_idx", "time"), &Animation::_bezier_track_interpolate);
 
 	ClassDB::bind_method(D_METHOD("audio_track_insert_key", "track_idx", "time", "stream", "start_offset", "end_offset"), &Animation::audio_track_insert_key, DEFVAL(0), DEFVAL(0));
 	ClassDB::bind_method(D_METHOD("audio_track_set_key_stream", "track_idx", "key_idx", "stream"), &Animation::audio_track_set_key_stream);
@@ -2674,6 +2848,10 @@ void Animation::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("clear"), &Animation::clear);
 	ClassDB::bind_method(D_METHOD("copy_track", "track_idx", "to_animation"), &Animation::copy_track);
 
+	ClassDB::bind_method(D_METHOD("compress"), &Animation::compress);
+	ClassDB::bind_method(D_METHOD("decompress"), &Animation::decompress);
+	ClassDB::bind_method(D_METHOD("is_compressed"), &Animation::is_compressed);
+
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "length", PROPERTY_HINT_RANGE, "0.001,99999,0.001"), "set_length", "get_length");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "loop"), "set_loop", "has_loop");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "step", PROPERTY_HINT_RANGE, "0,4096,0.001"), "set_step", "get_step");
@@ -2702,6 +2880,7 @@ void Animation::clear() {
 		memdelete(tracks[i]);
 	}
 	tracks.clear();
+	compressed_data.clear();
 	loop = false;
 	length = 1;
 	emit_changed();
@@ -2923,6 +3102,341 @@ void Animation::optimize(float p_allowed_linear_err, float p_allowed_angular_err
 	}
 }
 
+/* TRANSFORM TRACK COMPRESSION */
+
+static _FORCE_INLINE_ uint16_t _compress_quantize(float p_value, float p_min, float p_step) {
+	if (p_step <= 0.0) {
+		return 0;
+	}
+	return (uint16_t)CLAMP(Math::round((p_value - p_min) / p_step), 0.0f, 65535.0f);
+}
+
+// Rotations keep their three smallest components in 15 bits each, the largest one is rebuilt
+// from them. Its index goes in the top bits of the first two words.
+static _FORCE_INLINE_ void _compress_rotation(const Quat &p_rot, uint16_t *r_words) {
+	Quat q = p_rot.normalized();
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (Math::abs(q[i]) > Math::abs(q[largest])) {
+			largest = i;
+		}
+	}
+	if (q[largest] < 0.0) {
+		q = -q;
+	}
+
+	int word = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) {
+			continue;
+		}
+		// The smallest components are within [-sqrt(1/2), sqrt(1/2)].
+		float v = CLAMP(q[i] * (float)Math_SQRT12 + 0.5f, 0.0f, 1.0f);
+		r_words[word++] = (uint16_t)Math::round(v * 32767.0f);
+	}
+	r_words[0] |= (largest & 1) << 15;
+	r_words[1] |= (largest >> 1) << 15;
+}
+
+static _FORCE_INLINE_ Quat _decompress_rotation(const uint8_t *p_data) {
+	uint16_t words[3] = { decode_uint16(p_data), decode_uint16(p_data + 2), decode_uint16(p_data + 4) };
+	int largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+	Quat q;
+	real_t sq = 0.0;
+	int word = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) {
+			continue;
+		}
+		real_t v = ((words[word++] & 0x7FFF) / 32767.0f - 0.5f) * (real_t)Math_SQRT2;
+		q[i] = v;
+		sq += v * v;
+	}
+	q[largest] = Math::sqrt(MAX(0.0f, 1.0f - sq));
+	return q;
+}
+
+Animation::TransformKey Animation::CompressedTransformKeys::get_value(int p_idx) const {
+	TransformKey tk;
+	if (locs) {
+		const uint8_t *l = locs + p_idx * 3 * sizeof(uint16_t);
+		tk.loc = Vector3(header.loc_min[0] + decode_uint16(l) * header.loc_step[0], header.loc_min[1] + decode_uint16(l + 2) * header.loc_step[1], header.loc_min[2] + decode_uint16(l + 4) * header.loc_step[2]);
+	} else {
+		tk.loc = Vector3(header.loc_min[0], header.loc_min[1], header.loc_min[2]);
+	}
+	if (rots) {
+		tk.rot = _decompress_rotation(rots + p_idx * 3 * sizeof(uint16_t));
+	} else {
+		tk.rot = Quat(header.rot[0], header.rot[1], header.rot[2], header.rot[3]);
+	}
+	if (scales) {
+		const uint8_t *s = scales + p_idx * 3 * sizeof(uint16_t);
+		tk.scale = Vector3(header.scale_min[0] + decode_uint16(s) * header.scale_step[0], header.scale_min[1] + decode_uint16(s + 2) * header.scale_step[1], header.scale_min[2] + decode_uint16(s + 4) * header.scale_step[2]);
+	} else {
+		tk.scale = Vector3(header.scale_min[0], header.scale_min[1], header.scale_min[2]);
+	}
+	return tk;
+}
+
+uint32_t Animation::_get_compressed_size(const CompressedTransformHeader &p_header) {
+	uint32_t channels = 0;
+	for (uint32_t flag = COMPRESSED_LOC_CONSTANT; flag <= COMPRESSED_SCALE_CONSTANT; flag <<= 1) {
+		if (!(p_header.flags & flag)) {
+			channels++;
+		}
+	}
+	uint32_t size = CompressedTransformHeader::SIZE + p_header.key_count * (sizeof(float) + sizeof(uint16_t) * channels * 3);
+	return (size + 3) & ~3; // Keep the next track aligned.
+}
+
+void Animation::_encode_compressed_header(const CompressedTransformHeader &p_header, uint8_t *r_data) {
+	r_data += encode_uint32(p_header.key_count, r_data);
+	r_data += encode_uint32(p_header.flags, r_data);
+	for (int i = 0; i < 3; i++) {
+		r_data += encode_float(p_header.loc_min[i], r_data);
+		r_data += encode_float(p_header.loc_step[i], r_data);
+		r_data += encode_float(p_header.scale_min[i], r_data);
+		r_data += encode_float(p_header.scale_step[i], r_data);
+	}
+	for (int i = 0; i < 4; i++) {
+		r_data += encode_float(p_header.rot[i], r_data);
+	}
+}
+
+void Animation::_decode_compressed_header(const uint8_t *p_data, CompressedTransformHeader &r_header) {
+	r_header.key_count = decode_uint32(p_data);
+	r_header.flags = decode_uint32(p_data + 4);
+	p_data += 8;
+	for (int i = 0; i < 3; i++) {
+		r_header.loc_min[i] = decode_float(p_data);
+		r_header.loc_step[i] = decode_float(p_data + 4);
+		r_header.scale_min[i] = decode_float(p_data + 8);
+		r_header.scale_step[i] = decode_float(p_data + 12);
+		p_data += 16;
+	}
+	for (int i = 0; i < 4; i++) {
+		r_header.rot[i] = decode_float(p_data);
+		p_data += 4;
+	}
+}
+
+Animation::CompressedTransformKeys Animation::_get_compressed_keys(const TransformTrack *p_track) const {
+	CompressedTransformKeys keys;
+	int offset = p_track->compressed_offset;
+	ERR_FAIL_COND_V(offset < 0 || offset + (int)CompressedTransformHeader::SIZE > compressed_data.size(), keys);
+
+	const uint8_t *data = compressed_data.ptr() + offset;
+	_decode_compressed_header(data, keys.header);
+	ERR_FAIL_COND_V_MSG(keys.header.key_count == 0 || keys.header.key_count > (uint32_t)compressed_data.size() || offset + (int64_t)_get_compressed_size(keys.header) > compressed_data.size(), keys, "Corrupt compressed transform track data.");
+
+	const uint8_t *ptr = data + CompressedTransformHeader::SIZE;
+	const uint32_t channel_size = keys.header.key_count * 3 * sizeof(uint16_t);
+	keys.times = ptr;
+	ptr += keys.header.key_count * sizeof(float);
+	if (!(keys.header.flags & COMPRESSED_LOC_CONSTANT)) {
+		keys.locs = ptr;
+		ptr += channel_size;
+	}
+	if (!(keys.header.flags & COMPRESSED_ROT_CONSTANT)) {
+		keys.rots = ptr;
+		ptr += channel_size;
+	}
+	if (!(keys.header.flags & COMPRESSED_SCALE_CONSTANT)) {
+		keys.scales = ptr;
+	}
+	keys.data = data;
+	return keys;
+}
+
+void Animation::_compress_transform_track(const TransformTrack *p_track, LocalVector<uint8_t> &r_data) const {
+	const Vector<TKey<TransformKey>> &keys = p_track->transforms;
+	int key_count = keys.size();
+
+	const TransformKey &first = keys[0].value;
+	Vector3 loc_min = first.loc;
+	Vector3 loc_max = first.loc;
+	Vector3 scale_min = first.scale;
+	Vector3 scale_max = first.scale;
+	bool loc_constant = true;
+	bool rot_constant = true;
+	bool scale_constant = true;
+
+	for (int i = 1; i < key_count; i++) {
+		const TransformKey &tk = keys[i].value;
+		for (int j = 0; j < 3; j++) {
+			loc_min[j] = MIN(loc_min[j], tk.loc[j]);
+			loc_max[j] = MAX(loc_max[j], tk.loc[j]);
+			scale_min[j] = MIN(scale_min[j], tk.scale[j]);
+			scale_max[j] = MAX(scale_max[j], tk.scale[j]);
+		}
+		loc_constant = loc_constant && tk.loc.is_equal_approx(first.loc);
+		rot_constant = rot_constant && tk.rot.is_equal_approx(first.rot);
+		scale_constant = scale_constant && tk.scale.is_equal_approx(first.scale);
+	}
+
+	CompressedTransformHeader header;
+	header.key_count = key_count;
+	if (loc_constant) {
+		header.flags |= COMPRESSED_LOC_CONSTANT;
+	}
+	if (rot_constant) {
+		header.flags |= COMPRESSED_ROT_CONSTANT;
+	}
+	if (scale_constant) {
+		header.flags |= COMPRESSED_SCALE_CONSTANT;
+	}
+	for (int j = 0; j < 3; j++) {
+		header.loc_min[j] = loc_constant ? first.loc[j] : loc_min[j];
+		header.loc_step[j] = loc_constant ? 0.0 : (loc_max[j] - loc_min[j]) / 65535.0;
+		header.scale_min[j] = scale_constant ? first.scale[j] : scale_min[j];
+		header.scale_step[j] = scale_constant ? 0.0 : (scale_max[j] - scale_min[j]) / 65535.0;
+	}
+	Quat rot = first.rot.normalized();
+	for (int j = 0; j < 4; j++) {
+		header.rot[j] = rot[j];
+	}
+
+	uint32_t offset = r_data.size();
+	r_data.resize(offset + _get_compressed_size(header));
+	memset(&r_data[offset], 0, r_data.size() - offset);
+	_encode_compressed_header(header, &r_data[offset]);
+
+	// Times are kept exact, so keys can still be found by time and never collapse into each other.
+	uint8_t *ptr = &r_data[offset + CompressedTransformHeader::SIZE];
+	for (int i = 0; i < key_count; i++) {
+		ptr += encode_float(keys[i].time, ptr);
+	}
+	if (!loc_constant) {
+		for (int i = 0; i < key_count; i++) {
+			for (int j = 0; j < 3; j++) {
+				ptr += encode_uint16(_compress_quantize(keys[i].value.loc[j], header.loc_min[j], header.loc_step[j]), ptr);
+			}
+		}
+	}
+	if (!rot_constant) {
+		for (int i = 0; i < key_count; i++) {
+			uint16_t words[3];
+			_compress_rotation(keys[i].value.rot, words);
+			for (int j = 0; j < 3; j++) {
+				ptr += encode_uint16(words[j], ptr);
+			}
+		}
+	}
+	if (!scale_constant) {
+		for (int i = 0; i < key_count; i++) {
+			for (int j = 0; j < 3; j++) {
+				ptr += encode_uint16(_compress_quantize(keys[i].value.scale[j], header.scale_min[j], header.scale_step[j]), ptr);
+			}
+		}
+	}
+}
+
+void Animation::compress() {
+	LocalVector<uint8_t> data;
+	LocalVector<int> offsets;
+	offsets.resize(tracks.size());
+
+	for (int i = 0; i < tracks.size(); i++) {
+		offsets[i] = -1;
+		if (tracks[i]->type != TYPE_TRANSFORM) {
+			continue;
+		}
+		TransformTrack *tt = static_cast<TransformTrack *>(tracks[i]);
+
+		if (tt->compressed_offset >= 0) {
+			// Already compressed, move its block over as is.
+			CompressedTransformKeys keys = _get_compressed_keys(tt);
+			if (keys.data) {
+				uint32_t size = _get_compressed_size(keys.header);
+				offsets[i] = data.size();
+				data.resize(data.size() + size);
+				memcpy(&data[offsets[i]], keys.data, size);
+			}
+			continue;
+		}
+
+		// Transitions aren't stored.
+		if (tt->transforms.is_empty()) {
+			continue;
+		}
+		bool has_transitions = false;
+		for (int j = 0; j < tt->transforms.size(); j++) {
+			if (tt->transforms[j].transition != 1.0) {
+				has_transitions = true;
+				break;
+			}
+		}
+		if (has_transitions) {
+			continue;
+		}
+
+		offsets[i] = data.size();
+		_compress_transform_track(tt, data);
+	}
+
+	compressed_data.resize(data.size());
+	if (data.size()) {
+		memcpy(compressed_data.ptrw(), data.ptr(), data.size());
+	}
+
+	for (int i = 0; i < tracks.size(); i++) {
+		if (tracks[i]->type != TYPE_TRANSFORM) {
+			continue;
+		}
+		TransformTrack *tt = static_cast<TransformTrack *>(tracks[i]);
+		tt->compressed_offset = offsets[i];
+		if (offsets[i] >= 0) {
+			tt->transforms.clear();
+		}
+	}
+
+	emit_changed();
+}
+
+void Animation::decompress() {
+	for (int i = 0; i < tracks.size(); i++) {
+		if (tracks[i]->type != TYPE_TRANSFORM) {
+			continue;
+		}
+		TransformTrack *tt = static_cast<TransformTrack *>(tracks[i]);
+		if (tt->compressed_offset < 0) {
+			continue;
+		}
+
+		CompressedTransformKeys keys = _get_compressed_keys(tt);
+		tt->transforms.resize(keys.size());
+		for (int j = 0; j < keys.size(); j++) {
+			TKey<TransformKey> &key = tt->transforms.write[j];
+			key.time = keys[j].time;
+			key.transition = 1.0;
+			key.value = keys.get_value(j);
+		}
+		tt->compressed_offset = -1;
+	}
+
+	compressed_data.clear();
+	emit_changed();
+}
+
+bool Animation::is_compressed() const {
+	for (int i = 0; i < tracks.size(); i++) {
+		if (tracks[i]->type == TYPE_TRANSFORM && static_cast<const TransformTrack *>(tracks[i])->compressed_offset >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t Animation::get_transform_key_memory_usage() const {
+	uint64_t usage = compressed_data.size();
+	for (int i = 0; i < tracks.size(); i++) {
+		if (tracks[i]->type == TYPE_TRANSFORM) {
+			usage += static_cast<const TransformTrack *>(tracks[i])->transforms.size() * sizeof(TKey<TransformKey>);
+		}
+	}
+	return usage;
+}
+
 Animation::Animation() {}
 
 Animation::~Animation() {
@@ -31,7 +31,9 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
+#include "core/io/marshalls.h"
 #include "core/io/resource.h"
+#include "core/templates/local_vector.h"
 
 #define ANIM_MIN_LENGTH 0.001
 
@@ -96,6 +98,7 @@ private:
 
 	struct TransformTrack : public Track {
 		Vector<TKey<TransformKey>> transforms;
+		int compressed_offset = -1; // In compressed_data, or -1 if the track uses transforms.
 
 		TransformTrack() { type = TYPE_TRANSFORM; }
 	};
@@ -170,6 +173,59 @@ private:
 
 	Vector<Track *> tracks;
 
+	/* TRANSFORM TRACK COMPRESSION */
+
+	// Compressed transform tracks keep their keys in compressed_data, which is shared by the whole
+	// animation. Each one starts with a CompressedTransformHeader, followed by the exact key times
+	// as floats, then three 16-bit values per key for each channel that changes. Locations and
+	// scales are quantized within the range the track covers, and rotations are stored as their
+	// three smallest components. Everything is stored little endian, so it's read with the
+	// marshalling helpers rather than cast in place.
+	enum {
+		COMPRESSED_LOC_CONSTANT = 1,
+		COMPRESSED_ROT_CONSTANT = 2,
+		COMPRESSED_SCALE_CONSTANT = 4,
+	};
+
+	struct CompressedTransformHeader {
+		uint32_t key_count = 0;
+		uint32_t flags = 0;
+		float loc_min[3] = {};
+		float loc_step[3] = {};
+		float scale_min[3] = {};
+		float scale_step[3] = {};
+		float rot[4] = {}; // When constant.
+
+		enum {
+			SIZE = 18 * sizeof(uint32_t), // Stored size, all fields are 32 bits.
+		};
+	};
+
+	struct CompressedTransformKeys {
+		CompressedTransformHeader header;
+		const uint8_t *data = nullptr; // Start of the track, nullptr if it's invalid.
+		const uint8_t *times = nullptr;
+		const uint8_t *locs = nullptr;
+		const uint8_t *rots = nullptr;
+		const uint8_t *scales = nullptr;
+
+		_FORCE_INLINE_ int size() const { return data ? header.key_count : 0; }
+		_FORCE_INLINE_ Key operator[](int p_idx) const {
+			Key key;
+			key.time = decode_float(times + p_idx * sizeof(float));
+			return key;
+		}
+		TransformKey get_value(int p_idx) const;
+	};
+
+	Vector<uint8_t> compressed_data;
+
+	static uint32_t _get_compressed_size(const CompressedTransformHeader &p_header);
+	static void _encode_compressed_header(const CompressedTransformHeader &p_header, uint8_t *r_data);
+	static void _decode_compressed_header(const uint8_t *p_data, CompressedTransformHeader &r_header);
+	CompressedTransformKeys _get_compressed_keys(const TransformTrack *p_track) const;
+	void _compress_transform_track(const TransformTrack *p_track, LocalVector<uint8_t> &r_data) const;
+
 	/*
 	template<class T>
 	int _insert_pos(float p_time, T& p_keys);*/
@@ -182,6 +238,11 @@ private:
 
 	template <class K>
 	inline int _find(const Vector<K> &p_keys, float p_time) const;
+	int _find(const CompressedTransformKeys &p_keys, float p_time) const;
+	template <class C>
+	_FORCE_INLINE_ int _find(const C &p_keys, float p_time, int *r_cursor) const;
+	template <class C>
+	_FORCE_INLINE_ int _get_key_count_in_length(const C &p_keys) const;
 
 	_FORCE_INLINE_ Animation::TransformKey _interpolate(const Animation::TransformKey &p_a, const Animation::TransformKey &p_b, float p_c) const;
 
@@ -196,11 +257,14 @@ private:
 	_FORCE_INLINE_ Variant _cubic_interpolate(const Variant &p_pre_a, const Variant &p_a, const Variant &p_b, const Variant &p_post_b, float p_c) const;
 	_FORCE_INLINE_ float _cubic_interpolate(const float &p_pre_a, const float &p_a, const float &p_b, const float &p_post_b, float p_c) const;
 
-	template <class T>
-	_FORCE_INLINE_ T _interpolate(const Vector<TKey<T>> &p_keys, float p_time, InterpolationType p_interp, bool p_loop_wrap, bool *p_ok) const;
+	template <class C>
+	_FORCE_INLINE_ bool _find_interpolation_keys(const C &p_keys, float p_time, bool p_loop_wrap, int *r_cursor, int *r_len, int *r_idx, int *r_next, float *r_c) const;
 
 	template <class T>
-	_FORCE_INLINE_ void _track_get_key_indices_in_range(const Vector<T> &p_array, float from_time, float to_time, List<int> *p_indices) const;
+	_FORCE_INLINE_ T _interpolate(const Vector<TKey<T>> &p_keys, float p_time, InterpolationType p_interp, bool p_loop_wrap, bool *p_ok, int *r_cursor) const;
+
+	template <class C>
+	_FORCE_INLINE_ void _track_get_key_indices_in_range(const C &p_array, float from_time, float to_time, List<int> *p_indices) const;
 
 	_FORCE_INLINE_ void _value_track_get_key_indices_in_range(const ValueTrack *vt, float from_time, float to_time, List<int> *p_indices) const;
 	_FORCE_INLINE_ void _method_track_get_key_indices_in_range(const MethodTrack *mt, float from_time, float to_time, List<int> *p_indices) const;
@@ -223,6 +287,14 @@ private:
 		return ret;
 	}
 
+	Variant _value_track_interpolate(int p_track, float p_time) const {
+		return value_track_interpolate(p_track, p_time);
+	}
+
+	float _bezier_track_interpolate(int p_track, float p_time) const {
+		return bezier_track_interpolate(p_track, p_time);
+	}
+
 	Vector<int> _value_track_get_key_indices(int p_track, float p_time, float p_delta) const {
 		List<int> idxs;
 		value_track_get_key_indices(p_track, p_time, p_delta, &idxs);
@@ -304,7 +376,7 @@ public:
 	Vector2 bezier_track_get_key_in_handle(int p_track, int p_index) const;
 	Vector2 bezier_track_get_key_out_handle(int p_track, int p_index) const;
 
-	float bezier_track_interpolate(int p_track, float p_time) const;
+	float bezier_track_interpolate(int p_track, float p_time, int *r_cursor = nullptr) const;
 
 	int audio_track_insert_key(int p_track, float p_time, const RES &p_stream, float p_start_offset = 0, float p_end_offset = 0);
 	void audio_track_set_key_stream(int p_track, int p_key, const RES &p_stream);
@@ -321,9 +393,13 @@ public:
 	void track_set_interpolation_loop_wrap(int p_track, bool p_enable);
 	bool track_get_interpolation_loop_wrap(int p_track) const;
 
-	Error transform_track_interpolate(int p_track, float p_time, Vector3 *r_loc, Quat *r_rot, Vector3 *r_scale) const;
+	// The interpolate functions optionally take a cursor, which keeps the key found by the previous
+	// call on the same track. Sampling at nearby times then only needs to step from it instead of
+	// searching all keys. Cursors start at -1, and are only hints, so they stay safe to use after
+	// the keys are edited.
+	Error transform_track_interpolate(int p_track, float p_time, Vector3 *r_loc, Quat *r_rot, Vector3 *r_scale, int *r_cursor = nullptr) const;
 
-	Variant value_track_interpolate(int p_track, float p_time) const;
+	Variant value_track_interpolate(int p_track, float p_time, int *r_cursor = nullptr) const;
 	void value_track_get_key_indices(int p_track, float p_time, float p_delta, List<int> *p_indices) const;
 	void value_track_set_update_mode(int p_track, UpdateMode p_mode);
 	UpdateMode value_track_get_update_mode(int p_track) const;
@@ -349,6 +425,11 @@ public:
 
 	void optimize(float p_allowed_linear_err = 0.05, float p_allowed_angular_err = 0.01, float p_max_optimizable_angle = Math_PI * 0.125);
 
+	void compress();
+	void decompress();
+	bool is_compressed() const;
+	uint64_t get_transform_key_memory_usage() const;
+
 	Animation();
 	~Animation();
 };
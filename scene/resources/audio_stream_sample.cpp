@@ -86,6 +86,67 @@ void AudioStreamPlaybackSample::seek(float p_time) {
 	offset = uint64_t(p_time * base->mix_rate) << MIX_FRAC_BITS;
 }
 
+void AudioStreamPlaybackSample::skip(float p_time) {
+	if (!active || base->format == AudioStreamSample::FORMAT_IMA_ADPCM) {
+		return; //no seeking in ima-adpcm, it resumes where it was
+	}
+
+	int64_t loop_begin_fp = ((int64_t)base->loop_begin << MIX_FRAC_BITS);
+	int64_t loop_end_fp = ((int64_t)base->loop_end << MIX_FRAC_BITS);
+	int64_t loop_length_fp = loop_end_fp - loop_begin_fp;
+	int64_t length_fp = ((int64_t)base->_get_frame_count() << MIX_FRAC_BITS);
+	int64_t delta = int64_t(double(p_time) * base->mix_rate * MIX_FRAC_LEN);
+
+	// Same loop handling as mix(), but folded with a modulo so long skips are cheap.
+	switch (base->loop_mode) {
+		case AudioStreamSample::LOOP_DISABLED: {
+			offset += delta;
+			if (offset >= length_fp) {
+				active = false;
+			}
+		} break;
+		case AudioStreamSample::LOOP_FORWARD: {
+			if (loop_length_fp <= 0) {
+				break;
+			}
+			offset += delta;
+			if (offset >= loop_end_fp) {
+				offset = loop_begin_fp + (offset - loop_begin_fp) % loop_length_fp;
+			}
+		} break;
+		case AudioStreamSample::LOOP_BACKWARD: {
+			if (loop_length_fp <= 0) {
+				break;
+			}
+			sign = -1;
+			offset -= delta;
+			if (offset < loop_begin_fp) {
+				offset = loop_end_fp - (loop_begin_fp - offset) % loop_length_fp;
+			}
+		} break;
+		case AudioStreamSample::LOOP_PING_PONG: {
+			if (loop_length_fp <= 0) {
+				break;
+			}
+			// Unfold the bounces: the first loop length plays forward, the second one backward.
+			int64_t unfolded = (sign > 0 ? offset - loop_begin_fp : 2 * loop_length_fp - (offset - loop_begin_fp)) + delta;
+			if (unfolded < 0) {
+				// Still playing the part before the loop.
+				offset = loop_begin_fp + unfolded;
+				break;
+			}
+			unfolded %= 2 * loop_length_fp;
+			if (unfolded < loop_length_fp) {
+				offset = loop_begin_fp + unfolded;
+				sign = 1;
+			} else {
+				offset = loop_begin_fp + 2 * loop_length_fp - unfolded;
+				sign = -1;
+			}
+		} break;
+	}
+}
+
 template <class Depth, bool is_stereo, bool is_ima_adpcm>
 void AudioStreamPlaybackSample::do_resample(const Depth *p_src, AudioFrame *p_dst, int64_t &offset, int32_t &increment, uint32_t amount, IMA_ADPCM_State *ima_adpcm) {
 	// this function will be compiled branchless by any decent compiler
@@ -229,22 +290,7 @@ void AudioStreamPlaybackSample::mix(AudioFrame *p_buffer, float p_rate_scale, in
 		return;
 	}
 
-	int len = base->data_bytes;
-	switch (base->format) {
-		case AudioStreamSample::FORMAT_8_BITS:
-			len /= 1;
-			break;
-		case AudioStreamSample::FORMAT_16_BITS:
-			len /= 2;
-			break;
-		case AudioStreamSample::FORMAT_IMA_ADPCM:
-			len *= 2;
-			break;
-	}
-
-	if (base->stereo) {
-		len /= 2;
-	}
+	int len = base->_get_frame_count();
 
 	/* some 64-bit fixed point precaches */
 
@@ -456,7 +502,7 @@ bool AudioStreamSample::is_stereo() const {
 	return stereo;
 }
 
-float AudioStreamSample::get_length() const {
+int AudioStreamSample::_get_frame_count() const {
 	int len = data_bytes;
 	switch (format) {
 		case AudioStreamSample::FORMAT_8_BITS:
@@ -474,11 +520,19 @@ float AudioStreamSample::get_length() const {
 		len /= 2;
 	}
 
-	return float(len) / mix_rate;
+	return len;
+}
+
+float AudioStreamSample::get_length() const {
+	return float(_get_frame_count()) / mix_rate;
 }
 
 void AudioStreamSample::set_data(const Vector<uint8_t> &p_data) {
-	AudioServer::get_singleton()->lock();
+	// Without an AudioServer, nothing can be mixing the data.
+	AudioServer *audio_server = AudioServer::get_singleton();
+	if (audio_server) {
+		audio_server->lock();
+	}
 	if (data) {
 		memfree(data);
 		data = nullptr;
@@ -496,7 +550,9 @@ void AudioStreamSample::set_data(const Vector<uint8_t> &p_data) {
 		data_bytes = datalen;
 	}
 
-	AudioServer::get_singleton()->unlock();
+	if (audio_server) {
+		audio_server->unlock();
+	}
 }
 
 Vector<uint8_t> AudioStreamSample::get_data() const {
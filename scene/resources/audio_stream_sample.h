@@ -72,6 +72,7 @@ public:
 
 	virtual float get_playback_position() const override;
 	virtual void seek(float p_time) override;
+	virtual void skip(float p_time) override;
 
 	virtual void mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) override;
 
@@ -112,6 +113,8 @@ private:
 	void *data = nullptr;
 	uint32_t data_bytes = 0;
 
+	int _get_frame_count() const;
+
 protected:
 	static void _bind_methods();
 
@@ -33,6 +33,8 @@
 #include "core/config/project_settings.h"
 #include "core/os/os.h"
 
+AudioDriverDummy *AudioDriverDummy::singleton = nullptr;
+
 Error AudioDriverDummy::init() {
 	active = false;
 	thread_exited = false;
@@ -48,7 +50,9 @@ Error AudioDriverDummy::init() {
 
 	samples_in = memnew_arr(int32_t, buffer_frames * channels);
 
-	thread.start(AudioDriverDummy::thread_func, this);
+	if (use_threads) {
+		thread.start(AudioDriverDummy::thread_func, this);
+	}
 
 	return OK;
 };
@@ -95,9 +99,37 @@ void AudioDriverDummy::unlock() {
 
 void AudioDriverDummy::finish() {
 	exit_thread = true;
-	thread.wait_to_finish();
+	if (thread.is_started()) {
+		thread.wait_to_finish();
+	}
 
 	if (samples_in) {
 		memdelete_arr(samples_in);
+		samples_in = nullptr;
 	};
 };
+
+void AudioDriverDummy::set_use_threads(bool p_use_threads) {
+	use_threads = p_use_threads;
+}
+
+void AudioDriverDummy::mix_audio(int p_frames, int32_t *p_buffer) {
+	ERR_FAIL_COND(!active);
+	ERR_FAIL_COND_MSG(use_threads, "The dummy audio driver is already mixing on its own thread.");
+
+	while (p_frames > 0) {
+		int to_mix = MIN(p_frames, int(buffer_frames));
+
+		lock();
+		audio_server_process(to_mix, samples_in);
+		unlock();
+
+		memcpy(p_buffer, samples_in, sizeof(int32_t) * to_mix * channels);
+		p_buffer += to_mix * channels;
+		p_frames -= to_mix;
+	}
+}
+
+AudioDriverDummy::AudioDriverDummy() {
+	singleton = this;
+}
@@ -40,7 +40,7 @@ class AudioDriverDummy : public AudioDriver {
 	Thread thread;
 	Mutex mutex;
 
-	int32_t *samples_in;
+	int32_t *samples_in = nullptr;
 
 	static void thread_func(void *p_udata);
 
@@ -50,9 +50,13 @@ class AudioDriverDummy : public AudioDriver {
 
 	int channels;
 
-	bool active;
-	bool thread_exited;
-	mutable bool exit_thread;
+	bool active = false;
+	bool thread_exited = false;
+	mutable bool exit_thread = false;
+
+	bool use_threads = true;
+
+	static AudioDriverDummy *singleton;
 
 public:
 	const char *get_name() const {
@@ -67,7 +71,14 @@ public:
 	virtual void unlock();
 	virtual void finish();
 
-	AudioDriverDummy() {}
+	// Without threads, nothing is mixed until mix_audio() is called, which tests use to mix deterministically.
+	void set_use_threads(bool p_use_threads);
+	void mix_audio(int p_frames, int32_t *p_buffer);
+	int get_channels() const { return channels; }
+
+	static AudioDriverDummy *get_dummy_singleton() { return singleton; }
+
+	AudioDriverDummy();
 	~AudioDriverDummy() {}
 };
 
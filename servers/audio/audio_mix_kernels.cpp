@@ -0,0 +1,248 @@
+/*************************************************************************/
+/*  audio_mix_kernels.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "audio_mix_kernels.h"
+
+#include "core/math/simd.h"
+
+// The vector paths treat a pair of AudioFrames as four packed floats (l, r, l, r).
+
+void AudioMixKernels::add(AudioFrame *r_dst, const AudioFrame *p_src, int p_frames) {
+	int i = 0;
+
+#if defined(SIMD_SSE2)
+	float *dst = &r_dst[0].l;
+	const float *src = &p_src[0].l;
+	for (; i + 2 <= p_frames; i += 2) {
+		_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_loadu_ps(src + i * 2)));
+	}
+#elif defined(SIMD_NEON)
+	float *dst = &r_dst[0].l;
+	const float *src = &p_src[0].l;
+	for (; i + 2 <= p_frames; i += 2) {
+		vst1q_f32(dst + i * 2, vaddq_f32(vld1q_f32(dst + i * 2), vld1q_f32(src + i * 2)));
+	}
+#endif
+
+	for (; i < p_frames; i++) {
+		r_dst[i] += p_src[i];
+	}
+}
+
+void AudioMixKernels::mix_ramp(AudioFrame *r_dst, const AudioFrame *p_src, int p_frames, const AudioFrame &p_from, const AudioFrame &p_inc) {
+	int i = 0;
+
+	// The gain is computed from the frame index rather than accumulated,
+	// so the vector and scalar paths agree regardless of where the tail starts.
+#if defined(SIMD_SSE2)
+	float *dst = &r_dst[0].l;
+	const float *src = &p_src[0].l;
+	const __m128 from = _mm_setr_ps(p_from.l, p_from.r, p_from.l, p_from.r);
+	const __m128 inc = _mm_setr_ps(p_inc.l, p_inc.r, p_inc.l, p_inc.r);
+	const __m128 two = _mm_set1_ps(2.0);
+	__m128 index = _mm_setr_ps(0.0, 0.0, 1.0, 1.0);
+	for (; i + 2 <= p_frames; i += 2) {
+		__m128 gain = _mm_add_ps(from, _mm_mul_ps(inc, index));
+		_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_mul_ps(_mm_loadu_ps(src + i * 2), gain)));
+		index = _mm_add_ps(index, two);
+	}
+#elif defined(SIMD_NEON)
+	float *dst = &r_dst[0].l;
+	const float *src = &p_src[0].l;
+	const float from_v[4] = { p_from.l, p_from.r, p_from.l, p_from.r };
+	const float inc_v[4] = { p_inc.l, p_inc.r, p_inc.l, p_inc.r };
+	const float index_v[4] = { 0.0, 0.0, 1.0, 1.0 };
+	const float32x4_t from = vld1q_f32(from_v);
+	const float32x4_t inc = vld1q_f32(inc_v);
+	const float32x4_t two = vdupq_n_f32(2.0);
+	float32x4_t index = vld1q_f32(index_v);
+	for (; i + 2 <= p_frames; i += 2) {
+		float32x4_t gain = vaddq_f32(from, vmulq_f32(inc, index));
+		vst1q_f32(dst + i * 2, vaddq_f32(vld1q_f32(dst + i * 2), vmulq_f32(vld1q_f32(src + i * 2), gain)));
+		index = vaddq_f32(index, two);
+	}
+#endif
+
+	for (; i < p_frames; i++) {
+		r_dst[i] += p_src[i] * (p_from + p_inc * float(i));
+	}
+}
+
+void AudioMixKernels::scale_ramp(AudioFrame *r_dst, const AudioFrame *p_src, int p_frames, const AudioFrame &p_from, const AudioFrame &p_inc) {
+	int i = 0;
+
+#if defined(SIMD_SSE2)
+	float *dst = &r_dst[0].l;
+	const float *src = &p_src[0].l;
+	const __m128 from = _mm_setr_ps(p_from.l, p_from.r, p_from.l, p_from.r);
+	const __m128 inc = _mm_setr_ps(p_inc.l, p_inc.r, p_inc.l, p_inc.r);
+	const __m128 two = _mm_set1_ps(2.0);
+	__m128 index = _mm_setr_ps(0.0, 0.0, 1.0, 1.0);
+	for (; i + 2 <= p_frames; i += 2) {
+		__m128 gain = _mm_add_ps(from, _mm_mul_ps(inc, index));
+		_mm_storeu_ps(dst + i * 2, _mm_mul_ps(_mm_loadu_ps(src + i * 2), gain));
+		index = _mm_add_ps(index, two);
+	}
+#elif defined(SIMD_NEON)
+	float *dst = &r_dst[0].l;
+	const float *src = &p_src[0].l;
+	const float from_v[4] = { p_from.l, p_from.r, p_from.l, p_from.r };
+	const float inc_v[4] = { p_inc.l, p_inc.r, p_inc.l, p_inc.r };
+	const float index_v[4] = { 0.0, 0.0, 1.0, 1.0 };
+	const float32x4_t from = vld1q_f32(from_v);
+	const float32x4_t inc = vld1q_f32(inc_v);
+	const float32x4_t two = vdupq_n_f32(2.0);
+	float32x4_t index = vld1q_f32(index_v);
+	for (; i + 2 <= p_frames; i += 2) {
+		float32x4_t gain = vaddq_f32(from, vmulq_f32(inc, index));
+		vst1q_f32(dst + i * 2, vmulq_f32(vld1q_f32(src + i * 2), gain));
+		index = vaddq_f32(index, two);
+	}
+#endif
+
+	for (; i < p_frames; i++) {
+		r_dst[i] = p_src[i] * (p_from + p_inc * float(i));
+	}
+}
+
+AudioFrame AudioMixKernels::scale_peak(AudioFrame *r_buffer, int p_frames, float p_volume) {
+	AudioFrame peak = AudioFrame(0, 0);
+	int i = 0;
+
+#if defined(SIMD_SSE2)
+	float *buf = &r_buffer[0].l;
+	const __m128 volume = _mm_set1_ps(p_volume);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 peak_v = _mm_setzero_ps();
+	for (; i + 2 <= p_frames; i += 2) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(buf + i * 2), volume);
+		_mm_storeu_ps(buf + i * 2, v);
+		peak_v = _mm_max_ps(peak_v, _mm_and_ps(v, abs_mask));
+	}
+	float peaks[4];
+	_mm_storeu_ps(peaks, peak_v);
+	peak = AudioFrame(MAX(peaks[0], peaks[2]), MAX(peaks[1], peaks[3]));
+#elif defined(SIMD_NEON)
+	float *buf = &r_buffer[0].l;
+	const float32x4_t volume = vdupq_n_f32(p_volume);
+	float32x4_t peak_v = vdupq_n_f32(0.0);
+	for (; i + 2 <= p_frames; i += 2) {
+		float32x4_t v = vmulq_f32(vld1q_f32(buf + i * 2), volume);
+		vst1q_f32(buf + i * 2, v);
+		peak_v = vmaxq_f32(peak_v, vabsq_f32(v));
+	}
+	float peaks[4];
+	vst1q_f32(peaks, peak_v);
+	peak = AudioFrame(MAX(peaks[0], peaks[2]), MAX(peaks[1], peaks[3]));
+#endif
+
+	for (; i < p_frames; i++) {
+		r_buffer[i] *= p_volume;
+
+		float l = ABS(r_buffer[i].l);
+		if (l > peak.l) {
+			peak.l = l;
+		}
+		float r = ABS(r_buffer[i].r);
+		if (r > peak.r) {
+			peak.r = r;
+		}
+	}
+
+	return peak;
+}
+
+void AudioMixKernels::to_int32(int32_t *r_dst, int p_stride, const AudioFrame *p_src, int p_frames) {
+	int i = 0;
+
+#if defined(SIMD_SSE2)
+	const float *src = &p_src[0].l;
+	const __m128 one = _mm_set1_ps(1.0);
+	const __m128 minus_one = _mm_set1_ps(-1.0);
+	const __m128 scale = _mm_set1_ps((1 << 20) - 1);
+	for (; i + 2 <= p_frames; i += 2) {
+		__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i * 2), minus_one), one);
+		__m128i iv = _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(v, scale)), 11);
+		if (p_stride == 2) {
+			_mm_storeu_si128((__m128i *)(r_dst + i * 2), iv);
+		} else {
+			_mm_storel_epi64((__m128i *)(r_dst + i * p_stride), iv);
+			_mm_storel_epi64((__m128i *)(r_dst + (i + 1) * p_stride), _mm_unpackhi_epi64(iv, iv));
+		}
+	}
+#elif defined(SIMD_NEON)
+	const float *src = &p_src[0].l;
+	const float32x4_t one = vdupq_n_f32(1.0);
+	const float32x4_t minus_one = vdupq_n_f32(-1.0);
+	const float32x4_t scale = vdupq_n_f32((1 << 20) - 1);
+	for (; i + 2 <= p_frames; i += 2) {
+		float32x4_t v = vminq_f32(vmaxq_f32(vld1q_f32(src + i * 2), minus_one), one);
+		int32x4_t iv = vshlq_n_s32(vcvtq_s32_f32(vmulq_f32(v, scale)), 11);
+		if (p_stride == 2) {
+			vst1q_s32(r_dst + i * 2, iv);
+		} else {
+			vst1_s32(r_dst + i * p_stride, vget_low_s32(iv));
+			vst1_s32(r_dst + (i + 1) * p_stride, vget_high_s32(iv));
+		}
+	}
+#endif
+
+	for (; i < p_frames; i++) {
+		float l = CLAMP(p_src[i].l, -1.0, 1.0);
+		int32_t vl = l * ((1 << 20) - 1);
+		r_dst[i * p_stride + 0] = vl * (1 << 11);
+
+		float r = CLAMP(p_src[i].r, -1.0, 1.0);
+		int32_t vr = r * ((1 << 20) - 1);
+		r_dst[i * p_stride + 1] = vr * (1 << 11);
+	}
+}
+
+void AudioMixKernels::int32_to_int16(int16_t *r_dst, const int32_t *p_src, int p_samples) {
+	int i = 0;
+
+#if defined(SIMD_SSE2)
+	for (; i + 8 <= p_samples; i += 8) {
+		__m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(p_src + i)), 16);
+		__m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(p_src + i + 4)), 16);
+		_mm_storeu_si128((__m128i *)(r_dst + i), _mm_packs_epi32(a, b));
+	}
+#elif defined(SIMD_NEON)
+	for (; i + 8 <= p_samples; i += 8) {
+		int16x4_t a = vshrn_n_s32(vld1q_s32(p_src + i), 16);
+		int16x4_t b = vshrn_n_s32(vld1q_s32(p_src + i + 4), 16);
+		vst1q_s16(r_dst + i, vcombine_s16(a, b));
+	}
+#endif
+
+	for (; i < p_samples; i++) {
+		r_dst[i] = p_src[i] >> 16;
+	}
+}
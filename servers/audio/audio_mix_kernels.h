@@ -0,0 +1,57 @@
+/*************************************************************************/
+/*  audio_mix_kernels.h                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef AUDIO_MIX_KERNELS_H
+#define AUDIO_MIX_KERNELS_H
+
+#include "core/math/audio_frame.h"
+#include "core/typedefs.h"
+
+// Inner loops shared by the audio server, players, effects and drivers.
+// Buffers may not overlap unless stated otherwise; SSE2 and NEON builds
+// process two frames per step and fall back to scalar code for the tail.
+class AudioMixKernels {
+public:
+	// r_dst[i] += p_src[i]
+	static void add(AudioFrame *r_dst, const AudioFrame *p_src, int p_frames);
+	// r_dst[i] += p_src[i] * (p_from + p_inc * i)
+	static void mix_ramp(AudioFrame *r_dst, const AudioFrame *p_src, int p_frames, const AudioFrame &p_from, const AudioFrame &p_inc);
+	// r_dst[i] = p_src[i] * (p_from + p_inc * i), r_dst may be p_src.
+	static void scale_ramp(AudioFrame *r_dst, const AudioFrame *p_src, int p_frames, const AudioFrame &p_from, const AudioFrame &p_inc);
+	// Scales r_buffer in place and returns the absolute peak of the scaled frames.
+	static AudioFrame scale_peak(AudioFrame *r_buffer, int p_frames, float p_volume);
+	// Clamps to [-1, 1] and writes left/right as 32-bit samples (20 significant bits),
+	// placing frame i at r_dst[i * p_stride].
+	static void to_int32(int32_t *r_dst, int p_stride, const AudioFrame *p_src, int p_frames);
+	// Keeps the 16 most significant bits of each sample.
+	static void int32_to_int16(int16_t *r_dst, const int32_t *p_src, int p_samples);
+};
+
+#endif // AUDIO_MIX_KERNELS_H
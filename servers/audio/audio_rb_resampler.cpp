@@ -30,6 +30,7 @@
 
 #include "audio_rb_resampler.h"
 #include "core/math/math_funcs.h"
+#include "core/math/simd.h"
 #include "core/os/os.h"
 #include "servers/audio_server.h"
 
@@ -47,8 +48,41 @@ int AudioRBResampler::get_channel_count() const {
 template <int C>
 uint32_t AudioRBResampler::_resample(AudioFrame *p_dest, int p_todo, int32_t p_increment) {
 	uint32_t read = offset & MIX_FRAC_MASK;
+	int i = 0;
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+	if (C >= 2) {
+		// The left and right samples of a source frame are adjacent in the ring buffer,
+		// so two output frames can be interpolated at once as four packed floats.
+		for (; i + 2 <= p_todo; i += 2) {
+			uint32_t pos[2];
+			uint32_t pos_next[2];
+			float frac[2];
+			for (int j = 0; j < 2; j++) {
+				offset = (offset + p_increment) & (((1 << (rb_bits + MIX_FRAC_BITS)) - 1));
+				read += p_increment;
+				pos[j] = offset >> MIX_FRAC_BITS;
+				frac[j] = float(offset & MIX_FRAC_MASK) / float(MIX_FRAC_LEN);
+				ERR_FAIL_COND_V(pos[j] >= rb_len, 0);
+				pos_next[j] = (pos[j] + 1) & rb_mask;
+			}
+
+#if defined(SIMD_SSE2)
+			__m128 v = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&rb[pos[0] * C]), (const __m64 *)&rb[pos[1] * C]);
+			__m128 vn = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&rb[pos_next[0] * C]), (const __m64 *)&rb[pos_next[1] * C]);
+			__m128 f = _mm_setr_ps(frac[0], frac[0], frac[1], frac[1]);
+			_mm_storeu_ps(&p_dest[i].l, _mm_add_ps(v, _mm_mul_ps(_mm_sub_ps(vn, v), f)));
+#else
+			float32x4_t v = vcombine_f32(vld1_f32(&rb[pos[0] * C]), vld1_f32(&rb[pos[1] * C]));
+			float32x4_t vn = vcombine_f32(vld1_f32(&rb[pos_next[0] * C]), vld1_f32(&rb[pos_next[1] * C]));
+			float32x4_t f = vcombine_f32(vdup_n_f32(frac[0]), vdup_n_f32(frac[1]));
+			vst1q_f32(&p_dest[i].l, vaddq_f32(v, vmulq_f32(vsubq_f32(vn, v), f)));
+#endif
+		}
+	}
+#endif
 
-	for (int i = 0; i < p_todo; i++) {
+	for (; i < p_todo; i++) {
 		offset = (offset + p_increment) & (((1 << (rb_bits + MIX_FRAC_BITS)) - 1));
 		read += p_increment;
 		uint32_t pos = offset >> MIX_FRAC_BITS;
@@ -35,6 +35,12 @@
 
 //////////////////////////////
 
+void AudioStreamPlayback::skip(float p_time) {
+	seek(get_playback_position() + p_time);
+}
+
+//////////////////////////////
+
 void AudioStreamPlaybackResampled::_begin_resample() {
 	//clear cubic interpolation history
 	internal_buffer[0] = AudioFrame(0.0, 0.0);
@@ -345,6 +351,12 @@ void AudioStreamPlaybackRandomPitch::seek(float p_time) {
 	}
 }
 
+void AudioStreamPlaybackRandomPitch::skip(float p_time) {
+	if (playing.is_valid()) {
+		playing->skip(p_time * pitch_scale);
+	}
+}
+
 void AudioStreamPlaybackRandomPitch::mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) {
 	if (playing.is_valid()) {
 		playing->mix(p_buffer, p_rate_scale * pitch_scale, p_frames);
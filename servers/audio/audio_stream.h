@@ -48,6 +48,9 @@ public:
 
 	virtual float get_playback_position() const = 0;
 	virtual void seek(float p_time) = 0;
+	// Advances by p_time seconds of stream time as if it had been mixed, looping or stopping
+	// like mix() would. Used to keep virtual voices in sync without decoding them.
+	virtual void skip(float p_time);
 
 	virtual void mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) = 0;
 };
@@ -190,6 +193,7 @@ public:
 
 	virtual float get_playback_position() const override;
 	virtual void seek(float p_time) override;
+	virtual void skip(float p_time) override;
 
 	virtual void mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) override;
 
@@ -0,0 +1,489 @@
+/*************************************************************************/
+/*  audio_stream_decoded.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "audio_stream_decoded.h"
+
+#include "core/os/os.h"
+
+Mutex AudioDecodedCache::mutex;
+uint64_t AudioDecodedCache::budget = 16 * 1024 * 1024;
+uint64_t AudioDecodedCache::used_bytes = 0;
+float AudioDecodedCache::max_stream_length = 5.0;
+LRUCache<ObjectID, Vector<AudioFrame>, AudioDecodedCache::_evicted> AudioDecodedCache::cache(INT32_MAX);
+
+void AudioDecodedCache::_evicted(ObjectID &p_stream, Vector<AudioFrame> &p_frames) {
+	used_bytes -= p_frames.size() * sizeof(AudioFrame);
+}
+
+void AudioDecodedCache::_enforce_budget() {
+	if (used_bytes <= budget) {
+		return;
+	}
+
+	// The cache is only bounded by memory, so shrink its capacity until enough entries are gone.
+	size_t capacity = cache.get_capacity();
+	while (used_bytes > budget && cache.get_size() > 1) {
+		cache.set_capacity(cache.get_size() - 1);
+	}
+	cache.set_capacity(capacity);
+
+	if (used_bytes > budget) {
+		cache.clear();
+		used_bytes = 0;
+	}
+}
+
+bool AudioDecodedCache::get(ObjectID p_stream, Vector<AudioFrame> &r_frames) {
+	MutexLock lock(mutex);
+	const Vector<AudioFrame> *frames = cache.getptr(p_stream);
+	if (!frames) {
+		return false;
+	}
+	r_frames = *frames;
+	return true;
+}
+
+void AudioDecodedCache::put(ObjectID p_stream, const Vector<AudioFrame> &p_frames) {
+	MutexLock lock(mutex);
+	uint64_t bytes = p_frames.size() * sizeof(AudioFrame);
+	if (bytes > budget) {
+		cache.erase(p_stream);
+		return;
+	}
+	cache.insert(p_stream, p_frames);
+	used_bytes += bytes;
+	_enforce_budget();
+}
+
+void AudioDecodedCache::erase(ObjectID p_stream) {
+	MutexLock lock(mutex);
+	cache.erase(p_stream);
+}
+
+void AudioDecodedCache::clear() {
+	MutexLock lock(mutex);
+	cache.clear();
+	used_bytes = 0;
+}
+
+void AudioDecodedCache::set_budget(uint64_t p_bytes) {
+	MutexLock lock(mutex);
+	budget = p_bytes;
+	_enforce_budget();
+}
+
+uint64_t AudioDecodedCache::get_budget() {
+	MutexLock lock(mutex);
+	return budget;
+}
+
+uint64_t AudioDecodedCache::get_used_bytes() {
+	MutexLock lock(mutex);
+	return used_bytes;
+}
+
+void AudioDecodedCache::set_max_stream_length(float p_seconds) {
+	MutexLock lock(mutex);
+	max_stream_length = p_seconds;
+}
+
+float AudioDecodedCache::get_max_stream_length() {
+	MutexLock lock(mutex);
+	return max_stream_length;
+}
+
+////////////////////////////////
+
+bool AudioStreamPlaybackDecoded::prefetch_enabled = false;
+float AudioStreamPlaybackDecoded::prefetch_min_length = 10.0;
+Mutex AudioStreamPlaybackDecoded::prefetch_mutex;
+Set<AudioStreamPlaybackDecoded *> AudioStreamPlaybackDecoded::prefetch_playbacks;
+Thread AudioStreamPlaybackDecoded::prefetch_thread;
+SafeFlag AudioStreamPlaybackDecoded::prefetch_exit;
+
+void AudioStreamPlaybackDecoded::_prefetch_thread_func(void *p_user) {
+	LocalVector<AudioStreamPlaybackDecoded *> playbacks;
+
+	while (!prefetch_exit.is_set()) {
+		bool decoded_any = false;
+
+		playbacks.clear();
+		prefetch_mutex.lock();
+		for (Set<AudioStreamPlaybackDecoded *>::Element *E = prefetch_playbacks.front(); E; E = E->next()) {
+			playbacks.push_back(E->get());
+		}
+		prefetch_mutex.unlock();
+
+		// Decode without holding prefetch_mutex, so starting or stopping playbacks never waits on a decoder.
+		// A playback is only touched if it's still in the set when its decoder is taken, and
+		// _stop_prefetch() waits for the decoder after removing it.
+		for (uint32_t i = 0; i < playbacks.size(); i++) {
+			AudioStreamPlaybackDecoded *playback = playbacks[i];
+
+			prefetch_mutex.lock();
+			if (!prefetch_playbacks.has(playback) || playback->decoder_mutex.try_lock() != OK) {
+				// Stopped, or the audio thread is decoding it right now.
+				prefetch_mutex.unlock();
+				continue;
+			}
+			prefetch_mutex.unlock();
+
+			decoded_any = playback->_prefetch_step() || decoded_any;
+			playback->decoder_mutex.unlock();
+		}
+
+		if (!decoded_any) {
+			OS::get_singleton()->delay_usec(PREFETCH_IDLE_USEC);
+		}
+	}
+}
+
+Vector<AudioFrame> AudioStreamPlaybackDecoded::_decode_all() {
+	Vector<AudioFrame> frames;
+	int count = 0;
+
+	_decoder_seek(0);
+	frames.resize(MAX(int(Math::ceil(_get_length() * _get_sample_rate())), DECODE_ALL_CHUNK_SIZE));
+	while (true) {
+		if (frames.size() - count < DECODE_ALL_CHUNK_SIZE) {
+			frames.resize(frames.size() * 2);
+		}
+		int decoded_frames = _decode(frames.ptrw() + count, DECODE_ALL_CHUNK_SIZE);
+		if (decoded_frames == 0) {
+			break;
+		}
+		count += decoded_frames;
+	}
+	frames.resize(count);
+	_decoder_seek(0);
+
+	return frames;
+}
+
+int AudioStreamPlaybackDecoded::_decode_looped(AudioFrame *p_buffer, int p_frames) {
+	int done = 0;
+	bool looped = false;
+
+	while (done < p_frames && !decoder_finished.is_set()) {
+		int decoded_frames = _decode(p_buffer + done, p_frames - done);
+		if (decoded_frames > 0) {
+			done += decoded_frames;
+			looped = false;
+		} else if (_has_loop() && !looped) {
+			_decoder_seek(uint32_t(_get_loop_offset() * _get_sample_rate()));
+			looped = true;
+		} else {
+			// End of stream, or nothing to decode after looping back.
+			decoder_finished.set();
+		}
+	}
+
+	return done;
+}
+
+int AudioStreamPlaybackDecoded::_read_decoded(AudioFrame *p_buffer, int p_frames) {
+	int available = decoded.size() - int(frames_mixed);
+	if (available <= 0) {
+		return 0;
+	}
+
+	int todo = MIN(p_frames, available);
+	memcpy(p_buffer, decoded.ptr() + frames_mixed, todo * sizeof(AudioFrame));
+	return todo;
+}
+
+int AudioStreamPlaybackDecoded::_read_prefetched(AudioFrame *p_buffer, int p_frames) {
+	if (seek_requested.get() != seek_applied.get()) {
+		// The ring buffer still holds frames for the old position.
+		if (decoder_mutex.try_lock() != OK) {
+			return -1;
+		}
+		_apply_pending_seek();
+		decoder_mutex.unlock();
+	}
+
+	uint32_t read = prefetch_read.get();
+	uint32_t available = prefetch_write.get() - read;
+
+	if (available == 0) {
+		// The prefetch thread fell behind or the decoder reached the end. Decode here until the
+		// ring buffer is filled again, but only if the decoder is free: the audio thread must
+		// not wait for the prefetch thread to finish a chunk.
+		if (decoder_mutex.try_lock() != OK) {
+			return -1;
+		}
+		_apply_pending_seek();
+		available = prefetch_write.get() - read;
+		if (available == 0) {
+			int decoded_frames = _decode_looped(p_buffer, p_frames);
+			decoder_mutex.unlock();
+			return decoded_frames;
+		}
+		decoder_mutex.unlock();
+	}
+
+	uint32_t ofs = read & PREFETCH_BUFFER_MASK;
+	int todo = MIN(uint32_t(p_frames), MIN(available, PREFETCH_BUFFER_SIZE - ofs));
+	memcpy(p_buffer, prefetch_buffer.ptr() + ofs, todo * sizeof(AudioFrame));
+	prefetch_read.set(read + todo);
+	return todo;
+}
+
+void AudioStreamPlaybackDecoded::_apply_pending_seek() {
+	uint32_t requested = seek_requested.get();
+	if (requested == seek_applied.get()) {
+		return;
+	}
+
+	// If another seek comes in meanwhile, its frame is applied again on the next call, which is harmless.
+	_decoder_seek(seek_frame.get());
+	decoder_finished.clear();
+	// Drop whatever was prefetched for the old position. The mix doesn't read the ring buffer
+	// until the seek is applied.
+	prefetch_write.set(prefetch_read.get());
+	seek_applied.set(requested);
+}
+
+bool AudioStreamPlaybackDecoded::_prefetch_step() {
+	_apply_pending_seek();
+
+	if (!active.is_set() || decoder_finished.is_set()) {
+		return false;
+	}
+
+	uint32_t write = prefetch_write.get();
+	uint32_t free = PREFETCH_BUFFER_SIZE - (write - prefetch_read.get());
+	if (free < PREFETCH_CHUNK_SIZE) {
+		return false;
+	}
+
+	uint32_t ofs = write & PREFETCH_BUFFER_MASK;
+	int todo = MIN(uint32_t(PREFETCH_CHUNK_SIZE), PREFETCH_BUFFER_SIZE - ofs);
+	int decoded_frames = _decode_looped(prefetch_buffer.ptr() + ofs, todo);
+	prefetch_write.set(write + decoded_frames);
+
+	return decoded_frames > 0;
+}
+
+void AudioStreamPlaybackDecoded::_advance(int p_frames) {
+	frames_mixed += p_frames;
+
+	uint32_t length = is_cached() ? decoded.size() : uint32_t(Math::round(_get_length() * _get_sample_rate()));
+	if (frames_mixed < length || !_has_loop()) {
+		return;
+	}
+
+	uint32_t loop_start = MIN(uint32_t(_get_loop_offset() * _get_sample_rate()), length);
+	uint32_t loop_length = length - loop_start;
+	if (loop_length == 0) {
+		return;
+	}
+	loops += 1 + (frames_mixed - length) / loop_length;
+	frames_mixed = loop_start + (frames_mixed - length) % loop_length;
+}
+
+void AudioStreamPlaybackDecoded::_setup_source(ObjectID p_stream) {
+	float length = _get_length();
+	uint64_t decoded_bytes = uint64_t(length * _get_sample_rate()) * sizeof(AudioFrame);
+
+	if (length > 0 && length <= AudioDecodedCache::get_max_stream_length() && decoded_bytes <= AudioDecodedCache::get_budget()) {
+		if (!AudioDecodedCache::get(p_stream, decoded)) {
+			decoded = _decode_all();
+			AudioDecodedCache::put(p_stream, decoded);
+		}
+		if (!decoded.is_empty()) {
+			return;
+		}
+	}
+
+	if (prefetch_enabled && length >= prefetch_min_length) {
+		prefetch_buffer.resize(PREFETCH_BUFFER_SIZE);
+		prefetching = true;
+
+		MutexLock lock(prefetch_mutex);
+		prefetch_playbacks.insert(this);
+		if (!prefetch_thread.is_started()) {
+			prefetch_exit.clear();
+			prefetch_thread.start(_prefetch_thread_func, nullptr);
+		}
+	}
+}
+
+void AudioStreamPlaybackDecoded::_stop_prefetch() {
+	if (!prefetching) {
+		return;
+	}
+
+	prefetch_mutex.lock();
+	prefetch_playbacks.erase(this);
+	prefetching = false;
+	prefetch_mutex.unlock();
+
+	// Once removed, the prefetch thread no longer takes the decoder, but may still be finishing a chunk.
+	MutexLock lock(decoder_mutex);
+}
+
+void AudioStreamPlaybackDecoded::_mix_internal(AudioFrame *p_buffer, int p_frames) {
+	ERR_FAIL_COND(!active.is_set());
+
+	int mixed = 0;
+	while (mixed < p_frames) {
+		int read;
+		if (is_cached()) {
+			read = _read_decoded(p_buffer + mixed, p_frames - mixed);
+		} else if (prefetching) {
+			read = _read_prefetched(p_buffer + mixed, p_frames - mixed);
+			if (read < 0) {
+				// The prefetch thread is refilling the ring buffer, play silence until the next mix.
+				for (int i = mixed; i < p_frames; i++) {
+					p_buffer[i] = AudioFrame(0, 0);
+				}
+				return;
+			}
+		} else {
+			read = _decode_looped(p_buffer + mixed, p_frames - mixed);
+		}
+		if (read == 0) {
+			break;
+		}
+		_advance(read);
+		mixed += read;
+	}
+
+	if (mixed < p_frames) {
+		//end of stream, fill remainder with silence
+		for (int i = mixed; i < p_frames; i++) {
+			p_buffer[i] = AudioFrame(0, 0);
+		}
+		active.clear();
+	}
+}
+
+float AudioStreamPlaybackDecoded::get_stream_sampling_rate() {
+	return _get_sample_rate();
+}
+
+void AudioStreamPlaybackDecoded::start(float p_from_pos) {
+	active.set();
+	seek(p_from_pos);
+	loops = 0;
+	_begin_resample();
+}
+
+void AudioStreamPlaybackDecoded::stop() {
+	active.clear();
+}
+
+bool AudioStreamPlaybackDecoded::is_playing() const {
+	return active.is_set();
+}
+
+int AudioStreamPlaybackDecoded::get_loop_count() const {
+	return loops;
+}
+
+float AudioStreamPlaybackDecoded::get_playback_position() const {
+	return float(frames_mixed) / _get_sample_rate();
+}
+
+void AudioStreamPlaybackDecoded::seek(float p_time) {
+	if (!active.is_set()) {
+		return;
+	}
+
+	if (p_time >= _get_length()) {
+		p_time = 0;
+	}
+	frames_mixed = uint32_t(_get_sample_rate() * p_time);
+
+	if (is_cached()) {
+		return;
+	}
+
+	if (prefetching) {
+		// The prefetch thread may be decoding, so leave the seek to whoever takes the decoder next.
+		seek_frame.set(frames_mixed);
+		seek_requested.increment();
+		return;
+	}
+
+	_decoder_seek(frames_mixed);
+	decoder_finished.clear();
+}
+
+void AudioStreamPlaybackDecoded::skip(float p_time) {
+	if (!active.is_set()) {
+		return;
+	}
+
+	float length = _get_length();
+	float pos = get_playback_position() + p_time;
+	if (pos >= length) {
+		float loop_offset = _get_loop_offset();
+		float loop_length = length - loop_offset;
+		if (!_has_loop() || loop_length <= 0) {
+			active.clear();
+			return;
+		}
+		loops += int((pos - loop_offset) / loop_length);
+		pos = loop_offset + Math::fmod(pos - loop_offset, loop_length);
+	}
+
+	seek(pos);
+	// Drop the frames that were decoded ahead for the old position.
+	_begin_resample();
+}
+
+void AudioStreamPlaybackDecoded::set_prefetch_enabled(bool p_enabled) {
+	prefetch_enabled = p_enabled;
+}
+
+bool AudioStreamPlaybackDecoded::is_prefetch_enabled() {
+	return prefetch_enabled;
+}
+
+void AudioStreamPlaybackDecoded::set_prefetch_min_length(float p_seconds) {
+	prefetch_min_length = p_seconds;
+}
+
+float AudioStreamPlaybackDecoded::get_prefetch_min_length() {
+	return prefetch_min_length;
+}
+
+void AudioStreamPlaybackDecoded::finish_prefetch() {
+	if (prefetch_thread.is_started()) {
+		prefetch_exit.set();
+		prefetch_thread.wait_to_finish();
+	}
+}
+
+AudioStreamPlaybackDecoded::~AudioStreamPlaybackDecoded() {
+	_stop_prefetch();
+}
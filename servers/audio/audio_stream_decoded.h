@@ -0,0 +1,169 @@
+/*************************************************************************/
+/*  audio_stream_decoded.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef AUDIO_STREAM_DECODED_H
+#define AUDIO_STREAM_DECODED_H
+
+#include "core/os/mutex.h"
+#include "core/os/thread.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/lru.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/set.h"
+#include "servers/audio/audio_stream.h"
+
+// Decoded PCM of short compressed streams, shared by all their playbacks.
+// Entries are keyed by the stream's instance ID and evicted in LRU order
+// once the total size goes over the memory budget.
+class AudioDecodedCache {
+	static Mutex mutex;
+	static uint64_t budget;
+	static uint64_t used_bytes;
+	static float max_stream_length;
+
+	static void _evicted(ObjectID &p_stream, Vector<AudioFrame> &p_frames);
+	static LRUCache<ObjectID, Vector<AudioFrame>, _evicted> cache;
+
+	static void _enforce_budget();
+
+public:
+	static bool get(ObjectID p_stream, Vector<AudioFrame> &r_frames);
+	static void put(ObjectID p_stream, const Vector<AudioFrame> &p_frames);
+	static void erase(ObjectID p_stream);
+	static void clear();
+
+	// Budget in bytes. 0 disables the cache.
+	static void set_budget(uint64_t p_bytes);
+	static uint64_t get_budget();
+	static uint64_t get_used_bytes();
+
+	// Streams longer than this (in seconds) are never cached.
+	static void set_max_stream_length(float p_seconds);
+	static float get_max_stream_length();
+};
+
+// Base for playbacks of compressed streams. Depending on the stream length, frames come from:
+// - the decoded PCM of the whole stream, shared through AudioDecodedCache,
+// - a ring buffer filled ahead of time by a background thread,
+// - the decoder itself, on the mixing thread.
+// Implementations provide the decoder; they must call _stop_prefetch() from their destructor
+// before freeing it.
+class AudioStreamPlaybackDecoded : public AudioStreamPlaybackResampled {
+	GDCLASS(AudioStreamPlaybackDecoded, AudioStreamPlaybackResampled);
+
+	enum {
+		PREFETCH_BUFFER_BITS = 15,
+		PREFETCH_BUFFER_SIZE = 1 << PREFETCH_BUFFER_BITS, // Frames, about 0.7 seconds at 44.1 KHz.
+		PREFETCH_BUFFER_MASK = PREFETCH_BUFFER_SIZE - 1,
+		PREFETCH_CHUNK_SIZE = 1024,
+		PREFETCH_IDLE_USEC = 2000,
+		DECODE_ALL_CHUNK_SIZE = 4096,
+	};
+
+	static bool prefetch_enabled;
+	static float prefetch_min_length;
+	static Mutex prefetch_mutex;
+	static Set<AudioStreamPlaybackDecoded *> prefetch_playbacks;
+	static Thread prefetch_thread;
+	static SafeFlag prefetch_exit;
+
+	static void _prefetch_thread_func(void *p_user);
+
+	Vector<AudioFrame> decoded;
+
+	bool prefetching = false;
+	Mutex decoder_mutex;
+	SafeFlag decoder_finished;
+	LocalVector<AudioFrame> prefetch_buffer;
+	SafeNumeric<uint32_t> prefetch_read;
+	SafeNumeric<uint32_t> prefetch_write;
+	// Seeks of prefetched playbacks are applied by whichever thread takes the decoder next,
+	// so seeking never waits for the prefetch thread. A seek is pending while the two differ.
+	SafeNumeric<uint32_t> seek_frame;
+	SafeNumeric<uint32_t> seek_requested;
+	SafeNumeric<uint32_t> seek_applied;
+
+	SafeFlag active;
+	uint32_t frames_mixed = 0;
+	int loops = 0;
+
+	Vector<AudioFrame> _decode_all();
+	int _decode_looped(AudioFrame *p_buffer, int p_frames);
+	int _read_decoded(AudioFrame *p_buffer, int p_frames);
+	// Returns -1 if the decoder is busy prefetching.
+	int _read_prefetched(AudioFrame *p_buffer, int p_frames);
+	// Must be called with decoder_mutex held.
+	void _apply_pending_seek();
+	// Must be called with decoder_mutex held.
+	bool _prefetch_step();
+	void _advance(int p_frames);
+
+protected:
+	// Decodes up to p_frames from the current decoder position, returns 0 only at the end of the stream.
+	virtual int _decode(AudioFrame *p_buffer, int p_frames) = 0;
+	virtual void _decoder_seek(uint32_t p_frame) = 0;
+
+	virtual float _get_length() const = 0;
+	virtual float _get_sample_rate() const = 0;
+	virtual bool _has_loop() const = 0;
+	virtual float _get_loop_offset() const = 0;
+
+	// To be called once the decoder is ready, before the playback is started.
+	void _setup_source(ObjectID p_stream);
+	void _stop_prefetch();
+
+	virtual void _mix_internal(AudioFrame *p_buffer, int p_frames) override final;
+	virtual float get_stream_sampling_rate() override;
+
+public:
+	virtual void start(float p_from_pos = 0.0) override;
+	virtual void stop() override;
+	virtual bool is_playing() const override;
+
+	virtual int get_loop_count() const override; //times it looped
+
+	virtual float get_playback_position() const override;
+	virtual void seek(float p_time) override;
+	virtual void skip(float p_time) override;
+
+	bool is_cached() const { return !decoded.is_empty(); }
+	bool is_prefetching() const { return prefetching; }
+
+	static void set_prefetch_enabled(bool p_enabled);
+	static bool is_prefetch_enabled();
+	static void set_prefetch_min_length(float p_seconds);
+	static float get_prefetch_min_length();
+	static void finish_prefetch();
+
+	AudioStreamPlaybackDecoded() {}
+	~AudioStreamPlaybackDecoded();
+};
+
+#endif // AUDIO_STREAM_DECODED_H
@@ -30,16 +30,16 @@
 
 #include "audio_effect_amplify.h"
 
+#include "servers/audio/audio_mix_kernels.h"
+
 void AudioEffectAmplifyInstance::process(const AudioFrame *p_src_frames, AudioFrame *p_dst_frames, int p_frame_count) {
 	//multiply volume interpolating to avoid clicks if this changes
 	float volume_db = base->volume_db;
 	float vol = Math::db2linear(mix_volume_db);
 	float vol_inc = (Math::db2linear(volume_db) - vol) / float(p_frame_count);
 
-	for (int i = 0; i < p_frame_count; i++) {
-		p_dst_frames[i] = p_src_frames[i] * vol;
-		vol += vol_inc;
-	}
+	AudioMixKernels::scale_ramp(p_dst_frames, p_src_frames, p_frame_count, AudioFrame(vol, vol), AudioFrame(vol_inc, vol_inc));
+
 	//set volume for next mix
 	mix_volume_db = volume_db;
 }
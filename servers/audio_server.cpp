@@ -37,6 +37,8 @@
 #include "core/os/os.h"
 #include "scene/resources/audio_stream_sample.h"
 #include "servers/audio/audio_driver_dummy.h"
+#include "servers/audio/audio_mix_kernels.h"
+#include "servers/audio/audio_stream_decoded.h"
 #include "servers/audio/effects/audio_effect_compressor.h"
 
 #ifdef TOOLS_ENABLED
@@ -265,17 +267,7 @@ void AudioServer::_driver_process(int p_frames, int32_t *p_buffer) {
 			if (master->channels[k].active) {
 				const AudioFrame *buf = master->channels[k].buffer.ptr();
 
-				for (int j = 0; j < to_copy; j++) {
-					float l = CLAMP(buf[from + j].l, -1.0, 1.0);
-					int32_t vl = l * ((1 << 20) - 1);
-					int32_t vl2 = (vl < 0 ? -1 : 1) * (ABS(vl) << 11);
-					p_buffer[(from_buf + j) * (cs * 2) + k * 2 + 0] = vl2;
-
-					float r = CLAMP(buf[from + j].r, -1.0, 1.0);
-					int32_t vr = r * ((1 << 20) - 1);
-					int32_t vr2 = (vr < 0 ? -1 : 1) * (ABS(vr) << 11);
-					p_buffer[(from_buf + j) * (cs * 2) + k * 2 + 1] = vr2;
-				}
+				AudioMixKernels::to_int32(&p_buffer[from_buf * (cs * 2) + k * 2], cs * 2, &buf[from], to_copy);
 
 			} else {
 				for (int j = 0; j < to_copy; j++) {
@@ -332,136 +324,169 @@ void AudioServer::_mix_step() {
 		}
 	}
 
+	mix_solo_mode = solo_mode;
+
 	//make callbacks for mixing the audio
 	for (Set<CallbackItem>::Element *E = callbacks.front(); E; E = E->next()) {
 		E->get().callback(E->get().userdata);
 	}
 
-	for (int i = buses.size() - 1; i >= 0; i--) {
-		//go bus by bus
+	// Buses only send to buses before them, so each one is mixed after everything sending to it.
+	// Buses the same number of sends away from master don't depend on each other, and are mixed
+	// together, deepest first. Sends are added serially afterwards in the usual order.
+	int max_depth = 0;
+	for (int i = 0; i < buses.size(); i++) {
 		Bus *bus = buses[i];
+		bus->mix_send = i > 0 ? _get_bus_send(bus) : nullptr;
+		bus->mix_depth = bus->mix_send ? bus->mix_send->mix_depth + 1 : 0;
+		max_depth = MAX(max_depth, bus->mix_depth);
+	}
 
-		for (int k = 0; k < bus->channels.size(); k++) {
-			if (bus->channels[k].active && !bus->channels[k].used) {
-				//buffer was not used, but it's still active, so it must be cleaned
-				AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
-
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					buf[j] = AudioFrame(0, 0);
-				}
+	for (int depth = max_depth; depth >= 0; depth--) {
+		mix_level.clear();
+		uint64_t level_usec = 0;
+		for (int i = buses.size() - 1; i >= 0; i--) {
+			if (buses[i]->mix_depth == depth) {
+				mix_level.push_back(buses[i]);
+				level_usec += buses[i]->mix_usec;
 			}
 		}
 
-		//process effects
-		if (!bus->bypass) {
-			for (int j = 0; j < bus->effects.size(); j++) {
-				if (!bus->effects[j].enabled) {
-					continue;
-				}
+		if (mix_thread_pool.get_thread_count() > 0 && mix_level.size() > 1 && level_usec >= MIX_THREADS_MIN_USEC) {
+			// Start with the buses that took longest last time, so the slowest one doesn't start last.
+			mix_schedule = mix_level;
+			mix_schedule.sort_custom<BusMixCostSort>();
+			mix_thread_pool.do_work(mix_schedule.size(), this, &AudioServer::_mix_bus_threaded, mix_schedule.ptr());
+		} else {
+			for (uint32_t i = 0; i < mix_level.size(); i++) {
+				_mix_bus(mix_level[i]);
+			}
+		}
 
-#ifdef DEBUG_ENABLED
-				uint64_t ticks = OS::get_singleton()->get_ticks_usec();
-#endif
+		for (uint32_t i = 0; i < mix_level.size(); i++) {
+			Bus *bus = mix_level[i];
+			if (!bus->mix_send) {
+				continue;
+			}
 
-				for (int k = 0; k < bus->channels.size(); k++) {
-					if (!(bus->channels[k].active || bus->channels[k].effect_instances[j]->process_silence())) {
-						continue;
-					}
-					bus->channels.write[k].effect_instances.write[j]->process(bus->channels[k].buffer.ptr(), temp_buffer.write[k].ptrw(), buffer_size);
+			for (int k = 0; k < bus->channels.size(); k++) {
+				if (!bus->channels[k].active) {
+					continue;
 				}
 
-				//swap buffers, so internal buffer always has the right data
-				for (int k = 0; k < bus->channels.size(); k++) {
-					if (!(buses[i]->channels[k].active || bus->channels[k].effect_instances[j]->process_silence())) {
-						continue;
-					}
-					SWAP(bus->channels.write[k].buffer, temp_buffer.write[k]);
-				}
+				//if not master bus, send
+				const AudioFrame *buf = bus->channels[k].buffer.ptr();
+				AudioFrame *target_buf = thread_get_channel_mix_buffer(bus->mix_send->index_cache, k);
 
-#ifdef DEBUG_ENABLED
-				bus->effects.write[j].prof_time += OS::get_singleton()->get_ticks_usec() - ticks;
-#endif
+				AudioMixKernels::add(target_buf, buf, buffer_size);
 			}
 		}
+	}
 
-		//process send
+	mix_frames += buffer_size;
+	to_mix = buffer_size;
+}
 
-		Bus *send = nullptr;
+AudioServer::Bus *AudioServer::_get_bus_send(Bus *p_bus) {
+	//everything has a send save for master bus
+	if (!bus_map.has(p_bus->send)) {
+		return buses[0];
+	}
 
-		if (i > 0) {
-			//everything has a send save for master bus
-			if (!bus_map.has(bus->send)) {
-				send = buses[0];
-			} else {
-				send = bus_map[bus->send];
-				if (send->index_cache >= bus->index_cache) { //invalid, send to master
-					send = buses[0];
-				}
+	Bus *send = bus_map[p_bus->send];
+	if (send->index_cache >= p_bus->index_cache) { //invalid, send to master
+		return buses[0];
+	}
+	return send;
+}
+
+void AudioServer::_mix_bus(Bus *p_bus) {
+	uint64_t mix_ticks = OS::get_singleton()->get_ticks_usec();
+
+	for (int k = 0; k < p_bus->channels.size(); k++) {
+		if (p_bus->channels[k].active && !p_bus->channels[k].used) {
+			//buffer was not used, but it's still active, so it must be cleaned
+			AudioFrame *buf = p_bus->channels.write[k].buffer.ptrw();
+
+			for (uint32_t j = 0; j < buffer_size; j++) {
+				buf[j] = AudioFrame(0, 0);
 			}
 		}
+	}
 
-		for (int k = 0; k < bus->channels.size(); k++) {
-			if (!bus->channels[k].active) {
-				bus->channels.write[k].peak_volume = AudioFrame(AUDIO_MIN_PEAK_DB, AUDIO_MIN_PEAK_DB);
+	//process effects
+	if (!p_bus->bypass) {
+		for (int j = 0; j < p_bus->effects.size(); j++) {
+			if (!p_bus->effects[j].enabled) {
 				continue;
 			}
 
-			AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
-
-			AudioFrame peak = AudioFrame(0, 0);
-
-			float volume = Math::db2linear(bus->volume_db);
+#ifdef DEBUG_ENABLED
+			uint64_t ticks = OS::get_singleton()->get_ticks_usec();
+#endif
 
-			if (solo_mode) {
-				if (!bus->soloed) {
-					volume = 0.0;
-				}
-			} else {
-				if (bus->mute) {
-					volume = 0.0;
+			for (int k = 0; k < p_bus->channels.size(); k++) {
+				if (!(p_bus->channels[k].active || p_bus->channels[k].effect_instances[j]->process_silence())) {
+					continue;
 				}
+				p_bus->channels.write[k].effect_instances.write[j]->process(p_bus->channels[k].buffer.ptr(), p_bus->channels.write[k].effect_buffer.ptrw(), buffer_size);
 			}
 
-			//apply volume and compute peak
-			for (uint32_t j = 0; j < buffer_size; j++) {
-				buf[j] *= volume;
-
-				float l = ABS(buf[j].l);
-				if (l > peak.l) {
-					peak.l = l;
-				}
-				float r = ABS(buf[j].r);
-				if (r > peak.r) {
-					peak.r = r;
+			//swap buffers, so internal buffer always has the right data
+			for (int k = 0; k < p_bus->channels.size(); k++) {
+				if (!(p_bus->channels[k].active || p_bus->channels[k].effect_instances[j]->process_silence())) {
+					continue;
 				}
+				SWAP(p_bus->channels.write[k].buffer, p_bus->channels.write[k].effect_buffer);
 			}
 
-			bus->channels.write[k].peak_volume = AudioFrame(Math::linear2db(peak.l + AUDIO_PEAK_OFFSET), Math::linear2db(peak.r + AUDIO_PEAK_OFFSET));
+#ifdef DEBUG_ENABLED
+			p_bus->effects.write[j].prof_time += OS::get_singleton()->get_ticks_usec() - ticks;
+#endif
+		}
+	}
+
+	for (int k = 0; k < p_bus->channels.size(); k++) {
+		if (!p_bus->channels[k].active) {
+			p_bus->channels.write[k].peak_volume = AudioFrame(AUDIO_MIN_PEAK_DB, AUDIO_MIN_PEAK_DB);
+			continue;
+		}
 
-			if (!bus->channels[k].used) {
-				//see if any audio is contained, because channel was not used
+		AudioFrame *buf = p_bus->channels.write[k].buffer.ptrw();
 
-				if (MAX(peak.r, peak.l) > Math::db2linear(channel_disable_threshold_db)) {
-					bus->channels.write[k].last_mix_with_audio = mix_frames;
-				} else if (mix_frames - bus->channels[k].last_mix_with_audio > channel_disable_frames) {
-					bus->channels.write[k].active = false;
-					continue; //went inactive, don't mix.
-				}
+		float volume = Math::db2linear(p_bus->volume_db);
+
+		if (mix_solo_mode) {
+			if (!p_bus->soloed) {
+				volume = 0.0;
+			}
+		} else {
+			if (p_bus->mute) {
+				volume = 0.0;
 			}
+		}
 
-			if (send) {
-				//if not master bus, send
-				AudioFrame *target_buf = thread_get_channel_mix_buffer(send->index_cache, k);
+		//apply volume and compute peak
+		AudioFrame peak = AudioMixKernels::scale_peak(buf, buffer_size, volume);
 
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					target_buf[j] += buf[j];
-				}
+		p_bus->channels.write[k].peak_volume = AudioFrame(Math::linear2db(peak.l + AUDIO_PEAK_OFFSET), Math::linear2db(peak.r + AUDIO_PEAK_OFFSET));
+
+		if (!p_bus->channels[k].used) {
+			//see if any audio is contained, because channel was not used
+
+			if (MAX(peak.r, peak.l) > Math::db2linear(channel_disable_threshold_db)) {
+				p_bus->channels.write[k].last_mix_with_audio = mix_frames;
+			} else if (mix_frames - p_bus->channels[k].last_mix_with_audio > channel_disable_frames) {
+				p_bus->channels.write[k].active = false; //went inactive, won't be sent.
 			}
 		}
 	}
 
-	mix_frames += buffer_size;
-	to_mix = buffer_size;
+	p_bus->mix_usec = OS::get_singleton()->get_ticks_usec() - mix_ticks;
+}
+
+void AudioServer::_mix_bus_threaded(uint32_t p_index, Bus **p_schedule) {
+	_mix_bus(p_schedule[p_index]);
 }
 
 bool AudioServer::thread_has_channel_mix_buffer(int p_bus, int p_buffer) const {
@@ -546,6 +571,7 @@ void AudioServer::set_bus_count(int p_count) {
 		buses.write[i]->channels.resize(channel_count);
 		for (int j = 0; j < channel_count; j++) {
 			buses.write[i]->channels.write[j].buffer.resize(buffer_size);
+			buses.write[i]->channels.write[j].effect_buffer.resize(buffer_size);
 		}
 		buses[i]->name = attempt;
 		buses[i]->solo = false;
@@ -615,6 +641,7 @@ void AudioServer::add_bus(int p_at_pos) {
 	bus->channels.resize(channel_count);
 	for (int j = 0; j < channel_count; j++) {
 		bus->channels.write[j].buffer.resize(buffer_size);
+		bus->channels.write[j].effect_buffer.resize(buffer_size);
 	}
 	bus->name = attempt;
 	bus->solo = false;
@@ -925,16 +952,12 @@ float AudioServer::get_global_rate_scale() const {
 
 void AudioServer::init_channels_and_buffers() {
 	channel_count = get_channel_count();
-	temp_buffer.resize(channel_count);
-
-	for (int i = 0; i < temp_buffer.size(); i++) {
-		temp_buffer.write[i].resize(buffer_size);
-	}
 
 	for (int i = 0; i < buses.size(); i++) {
 		buses[i]->channels.resize(channel_count);
 		for (int j = 0; j < channel_count; j++) {
 			buses.write[i]->channels.write[j].buffer.resize(buffer_size);
+			buses.write[i]->channels.write[j].effect_buffer.resize(buffer_size);
 		}
 	}
 }
@@ -947,6 +970,25 @@ void AudioServer::init() {
 
 	init_channels_and_buffers();
 
+	if (GLOBAL_DEF_RST("audio/buses/use_threads", false)) {
+		mix_thread_pool.init();
+	}
+
+	voice_budget.max_real_voices = GLOBAL_DEF("audio/voices/max_real_voices", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/voices/max_real_voices", PropertyInfo(Variant::INT, "audio/voices/max_real_voices", PROPERTY_HINT_RANGE, "0,1024,1,or_greater"));
+	voice_budget.virtualize_db = GLOBAL_DEF("audio/voices/virtualize_below_db", -80.0);
+	voice_budget.hysteresis_db = GLOBAL_DEF("audio/voices/hysteresis_db", 3.0);
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/voices/hysteresis_db", PropertyInfo(Variant::FLOAT, "audio/voices/hysteresis_db", PROPERTY_HINT_RANGE, "0,24,0.1,or_greater"));
+	voice_budget.min_state_usec = float(GLOBAL_DEF("audio/voices/min_state_time", 0.25)) * 1000000;
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/voices/min_state_time", PropertyInfo(Variant::FLOAT, "audio/voices/min_state_time", PROPERTY_HINT_RANGE, "0,2,0.01,or_greater"));
+
+	AudioDecodedCache::set_budget(uint64_t(int(GLOBAL_DEF_RST("audio/decoding/cache_size_mb", 16))) * 1024 * 1024);
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/decoding/cache_size_mb", PropertyInfo(Variant::INT, "audio/decoding/cache_size_mb", PROPERTY_HINT_RANGE, "0,256,1,or_greater"));
+	AudioDecodedCache::set_max_stream_length(GLOBAL_DEF_RST("audio/decoding/cache_max_stream_length", 5.0));
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/decoding/cache_max_stream_length", PropertyInfo(Variant::FLOAT, "audio/decoding/cache_max_stream_length", PROPERTY_HINT_RANGE, "0,30,0.1,or_greater"));
+	AudioStreamPlaybackDecoded::set_prefetch_enabled(GLOBAL_DEF_RST("audio/decoding/prefetch_long_streams", false));
+	AudioStreamPlaybackDecoded::set_prefetch_min_length(GLOBAL_DEF_RST("audio/decoding/prefetch_min_length", 10.0));
+
 	mix_count = 0;
 	set_bus_count(1);
 	set_bus_name(0, "Master");
@@ -1030,11 +1072,75 @@ void AudioServer::update() {
 	prof_time = 0;
 #endif
 
+	_update_voices();
+
 	for (Set<CallbackItem>::Element *E = update_callbacks.front(); E; E = E->next()) {
 		E->get().callback(E->get().userdata);
 	}
 }
 
+void AudioServer::_update_voices() {
+	real_voice_count = rank_voices(voices, voice_budget, OS::get_singleton()->get_ticks_usec(), voice_ranking);
+	virtual_voice_count = voice_ranking.size() - real_voice_count;
+}
+
+int AudioServer::rank_voices(const LocalVector<Voice *> &p_voices, const VoiceBudget &p_budget, uint64_t p_ticks_usec, LocalVector<Voice *> &r_ranking) {
+	r_ranking.clear();
+	int held_real = 0;
+	for (uint32_t i = 0; i < p_voices.size(); i++) {
+		Voice *voice = p_voices[i];
+		if (!voice->playing) {
+			voice->virtualized.clear();
+			voice->ranked = false;
+			continue;
+		}
+
+		// Real voices rank as if they were louder, so a virtual voice must be clearly louder to take their place.
+		bool real = voice->ranked && !voice->virtualized.is_set();
+		voice->rank_db = voice->volume_db + (real ? p_budget.hysteresis_db : 0);
+		voice->held = voice->ranked && p_ticks_usec - voice->state_ticks_usec < p_budget.min_state_usec;
+		held_real += voice->held && real;
+		r_ranking.push_back(voice);
+	}
+
+	r_ranking.sort_custom<VoiceSort>();
+
+	// Held voices keep their state. Held real voices keep their place in the budget even when
+	// ranked lower, so the voices that are free to change only get what is left of it.
+	int real_count = 0;
+	for (uint32_t i = 0; i < r_ranking.size(); i++) {
+		Voice *voice = r_ranking[i];
+		bool was_virtual = voice->ranked && voice->virtualized.is_set();
+		bool is_virtual;
+		if (voice->held) {
+			is_virtual = was_virtual;
+			if (!was_virtual) {
+				held_real--;
+				// Only when the budget was lowered below the held voices.
+				is_virtual = p_budget.max_real_voices > 0 && real_count >= p_budget.max_real_voices;
+			}
+		} else {
+			bool over_budget = p_budget.max_real_voices > 0 && real_count + held_real >= p_budget.max_real_voices;
+			float virtualize_db = was_virtual ? p_budget.virtualize_db + p_budget.hysteresis_db : p_budget.virtualize_db;
+			is_virtual = over_budget || voice->volume_db < virtualize_db;
+		}
+
+		if (!voice->ranked || is_virtual != was_virtual) {
+			voice->ranked = true;
+			voice->state_ticks_usec = p_ticks_usec;
+		}
+
+		if (is_virtual) {
+			voice->virtualized.set();
+		} else {
+			voice->virtualized.clear();
+			real_count++;
+		}
+	}
+
+	return real_count;
+}
+
 void AudioServer::load_default_bus_layout() {
 	String layout_path = ProjectSettings::get_singleton()->get("audio/buses/default_bus_layout");
 
@@ -1051,6 +1157,10 @@ void AudioServer::finish() {
 		AudioDriverManager::get_driver(i)->finish();
 	}
 
+	mix_thread_pool.finish();
+	AudioStreamPlaybackDecoded::finish_prefetch();
+	AudioDecodedCache::clear();
+
 	for (int i = 0; i < buses.size(); i++) {
 		memdelete(buses[i]);
 	}
@@ -1134,6 +1244,42 @@ void AudioServer::remove_update_callback(AudioCallback p_callback, void *p_userd
 	unlock();
 }
 
+void AudioServer::add_voice(Voice *p_voice) {
+	ERR_FAIL_COND(voices.find(p_voice) >= 0);
+	voices.push_back(p_voice);
+}
+
+void AudioServer::remove_voice(Voice *p_voice) {
+	voices.erase(p_voice);
+	p_voice->virtualized.clear();
+	p_voice->ranked = false;
+}
+
+void AudioServer::set_max_real_voices(int p_count) {
+	ERR_FAIL_COND(p_count < 0);
+	voice_budget.max_real_voices = p_count;
+}
+
+int AudioServer::get_max_real_voices() const {
+	return voice_budget.max_real_voices;
+}
+
+void AudioServer::set_voice_virtualize_db(float p_db) {
+	voice_budget.virtualize_db = p_db;
+}
+
+float AudioServer::get_voice_virtualize_db() const {
+	return voice_budget.virtualize_db;
+}
+
+int AudioServer::get_real_voice_count() const {
+	return real_voice_count;
+}
+
+int AudioServer::get_virtual_voice_count() const {
+	return virtual_voice_count;
+}
+
 void AudioServer::set_bus_layout(const Ref<AudioBusLayout> &p_bus_layout) {
 	ERR_FAIL_COND(p_bus_layout.is_null() || p_bus_layout->buses.size() == 0);
 
@@ -1174,6 +1320,7 @@ void AudioServer::set_bus_layout(const Ref<AudioBusLayout> &p_bus_layout) {
 		buses[i]->channels.resize(channel_count);
 		for (int j = 0; j < channel_count; j++) {
 			buses.write[i]->channels.write[j].buffer.resize(buffer_size);
+			buses.write[i]->channels.write[j].effect_buffer.resize(buffer_size);
 		}
 		_update_bus_effects(i);
 	}
@@ -1290,6 +1437,13 @@ void AudioServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_time_since_last_mix"), &AudioServer::get_time_since_last_mix);
 	ClassDB::bind_method(D_METHOD("get_output_latency"), &AudioServer::get_output_latency);
 
+	ClassDB::bind_method(D_METHOD("set_max_real_voices", "count"), &AudioServer::set_max_real_voices);
+	ClassDB::bind_method(D_METHOD("get_max_real_voices"), &AudioServer::get_max_real_voices);
+	ClassDB::bind_method(D_METHOD("set_voice_virtualize_db", "db"), &AudioServer::set_voice_virtualize_db);
+	ClassDB::bind_method(D_METHOD("get_voice_virtualize_db"), &AudioServer::get_voice_virtualize_db);
+	ClassDB::bind_method(D_METHOD("get_real_voice_count"), &AudioServer::get_real_voice_count);
+	ClassDB::bind_method(D_METHOD("get_virtual_voice_count"), &AudioServer::get_virtual_voice_count);
+
 	ClassDB::bind_method(D_METHOD("capture_get_device_list"), &AudioServer::capture_get_device_list);
 	ClassDB::bind_method(D_METHOD("capture_get_device"), &AudioServer::capture_get_device);
 	ClassDB::bind_method(D_METHOD("capture_set_device", "name"), &AudioServer::capture_set_device);
@@ -34,6 +34,9 @@
 #include "core/math/audio_frame.h"
 #include "core/object/class_db.h"
 #include "core/os/os.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/thread_work_pool.h"
 #include "core/variant/variant.h"
 #include "servers/audio/audio_effect.h"
 
@@ -160,6 +163,34 @@ public:
 
 	typedef void (*AudioCallback)(void *p_userdata);
 
+	// A playback competing for the voice budget. Its owner keeps volume_db, priority and
+	// playing up to date on the main thread, voices are ranked in update(), and the owner
+	// checks virtualized on the audio thread to skip decoding and mixing.
+	struct Voice {
+		float volume_db = AUDIO_MIN_PEAK_DB;
+		int priority = 0;
+		bool playing = false;
+		SafeFlag virtualized;
+
+		// Kept by rank_voices().
+		bool ranked = false;
+		bool held = false;
+		float rank_db = 0;
+		uint64_t state_ticks_usec = 0;
+	};
+
+	struct VoiceBudget {
+		int max_real_voices = 0;
+		float virtualize_db = -80.0;
+		// Margin a voice must clear before it changes state, so voices near a limit don't flicker.
+		float hysteresis_db = 3.0;
+		// A voice keeps its state for at least this long after it changed.
+		uint64_t min_state_usec = 250000;
+	};
+
+	// Ranks the playing voices and updates which of them are virtual, returning the number of real voices.
+	static int rank_voices(const LocalVector<Voice *> &p_voices, const VoiceBudget &p_budget, uint64_t p_ticks_usec, LocalVector<Voice *> &r_ranking);
+
 private:
 	uint64_t mix_time;
 	int mix_size;
@@ -193,6 +224,7 @@ private:
 			bool active;
 			AudioFrame peak_volume;
 			Vector<AudioFrame> buffer;
+			Vector<AudioFrame> effect_buffer; // Effects write here, then it's swapped with buffer.
 			Vector<Ref<AudioEffectInstance>> effect_instances;
 			uint64_t last_mix_with_audio;
 			Channel() {
@@ -217,12 +249,32 @@ private:
 		float volume_db;
 		StringName send;
 		int index_cache;
+
+		// Set on each mix step.
+		Bus *mix_send = nullptr;
+		int mix_depth = 0;
+		uint64_t mix_usec = 0;
+	};
+
+	struct BusMixCostSort {
+		_FORCE_INLINE_ bool operator()(const Bus *p_a, const Bus *p_b) const {
+			return p_a->mix_usec > p_b->mix_usec;
+		}
+	};
+
+	enum {
+		// Buses that took less than this altogether last time are mixed on the audio thread.
+		MIX_THREADS_MIN_USEC = 200,
 	};
 
-	Vector<Vector<AudioFrame>> temp_buffer; //temp_buffer for each level
 	Vector<Bus *> buses;
 	Map<StringName, Bus *> bus_map;
 
+	ThreadWorkPool mix_thread_pool;
+	LocalVector<Bus *> mix_level;
+	LocalVector<Bus *> mix_schedule;
+	bool mix_solo_mode = false;
+
 	void _update_bus_effects(int p_bus);
 
 	static AudioServer *singleton;
@@ -230,6 +282,9 @@ private:
 	void init_channels_and_buffers();
 
 	void _mix_step();
+	Bus *_get_bus_send(Bus *p_bus);
+	void _mix_bus(Bus *p_bus);
+	void _mix_bus_threaded(uint32_t p_index, Bus **p_schedule);
 
 	struct CallbackItem {
 		AudioCallback callback;
@@ -243,6 +298,23 @@ private:
 	Set<CallbackItem> callbacks;
 	Set<CallbackItem> update_callbacks;
 
+	struct VoiceSort {
+		_FORCE_INLINE_ bool operator()(const Voice *p_a, const Voice *p_b) const {
+			if (p_a->priority != p_b->priority) {
+				return p_a->priority > p_b->priority;
+			}
+			return p_a->rank_db > p_b->rank_db;
+		}
+	};
+
+	LocalVector<Voice *> voices;
+	LocalVector<Voice *> voice_ranking;
+	VoiceBudget voice_budget;
+	int real_voice_count = 0;
+	int virtual_voice_count = 0;
+
+	void _update_voices();
+
 	friend class AudioDriver;
 	void _driver_process(int p_frames, int32_t *p_buffer);
 
@@ -346,6 +418,18 @@ public:
 	void add_update_callback(AudioCallback p_callback, void *p_userdata);
 	void remove_update_callback(AudioCallback p_callback, void *p_userdata);
 
+	void add_voice(Voice *p_voice);
+	void remove_voice(Voice *p_voice);
+
+	void set_max_real_voices(int p_count);
+	int get_max_real_voices() const;
+
+	void set_voice_virtualize_db(float p_db);
+	float get_voice_virtualize_db() const;
+
+	int get_real_voice_count() const;
+	int get_virtual_voice_count() const;
+
 	void set_bus_layout(const Ref<AudioBusLayout> &p_bus_layout);
 	Ref<AudioBusLayout> generate_bus_layout() const;
 
@@ -55,8 +55,8 @@ void PhysicsServer3DWrapMT::thread_loop() {
 	exit = false;
 	step_thread_up = true;
 	while (!exit) {
-		// flush commands one by one, until exit is requested
-		command_queue.wait_and_flush_one();
+		// flush commands as they come, until exit is requested
+		command_queue.wait_and_flush();
 	}
 
 	command_queue.flush_all(); // flush all
@@ -44,9 +44,11 @@ void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas
 	memset(z_last_list, 0, z_range * sizeof(RendererCanvasRender::Item *));
 
 	for (int i = 0; i < p_child_item_count; i++) {
+		_update_item_cache_root(p_child_items[i].item, p_transform);
 		_cull_canvas_item(p_child_items[i].item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr);
 	}
 	if (p_canvas_item) {
+		_update_item_cache_root(p_canvas_item, p_transform);
 		_cull_canvas_item(p_canvas_item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, nullptr, nullptr);
 	}
 
@@ -75,13 +77,25 @@ void RendererCanvasCull::_render_canvas_item_tree(RID p_to_render_target, Canvas
 	}
 }
 
-void _collect_ysort_children(RendererCanvasCull::Item *p_canvas_item, Transform2D p_transform, RendererCanvasCull::Item *p_material_owner, RendererCanvasCull::Item **r_items, int &r_index) {
+void RendererCanvasCull::_update_item_cache_root(Item *p_item, const Transform2D &p_transform) {
+	// Items directly under the canvas have nothing to propagate from, compare the canvas transform instead.
+	if (item_cache_force_update || p_item->cache_parent_xform != p_transform) {
+		p_item->cache_parent_xform = p_transform;
+		p_item->cache_dirty = true;
+	}
+}
+
+// Counts the Y-sorted children, updating their sorting data if p_update_items is set.
+// They are also stored in r_items when it's not null.
+void _collect_ysort_children(RendererCanvasCull::Item *p_canvas_item, Transform2D p_transform, RendererCanvasCull::Item *p_material_owner, RendererCanvasCull::Item **r_items, int &r_index, bool p_update_items) {
 	int child_item_count = p_canvas_item->child_items.size();
 	RendererCanvasCull::Item **child_items = p_canvas_item->child_items.ptrw();
 	for (int i = 0; i < child_item_count; i++) {
 		if (child_items[i]->visible) {
 			if (r_items) {
 				r_items[r_index] = child_items[i];
+			}
+			if (p_update_items) {
 				child_items[i]->ysort_xform = p_transform;
 				child_items[i]->ysort_pos = p_transform.xform(child_items[i]->xform.elements[2]);
 				child_items[i]->material_owner = child_items[i]->use_parent_material ? p_material_owner : nullptr;
@@ -91,12 +105,35 @@ void _collect_ysort_children(RendererCanvasCull::Item *p_canvas_item, Transform2
 			r_index++;
 
 			if (child_items[i]->sort_y) {
-				_collect_ysort_children(child_items[i], p_transform * child_items[i]->xform, child_items[i]->use_parent_material ? p_material_owner : child_items[i], r_items, r_index);
+				_collect_ysort_children(child_items[i], p_transform * child_items[i]->xform, child_items[i]->use_parent_material ? p_material_owner : child_items[i], r_items, r_index, p_update_items);
 			}
 		}
 	}
 }
 
+// Insertion sort for the previous frame's order, gives up when items moved too much.
+static bool _ysort_incremental(RendererCanvasCull::Item **p_items, int p_count, int p_max_shifts) {
+	RendererCanvasCull::ItemPtrSort compare;
+	int shifts = 0;
+
+	for (int i = 1; i < p_count; i++) {
+		RendererCanvasCull::Item *item = p_items[i];
+		int j = i;
+		while (j > 0 && compare(item, p_items[j - 1])) {
+			p_items[j] = p_items[j - 1];
+			j--;
+		}
+		p_items[j] = item;
+
+		shifts += i - j;
+		if (shifts > p_max_shifts) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void _mark_ysort_dirty(RendererCanvasCull::Item *ysort_owner, RID_PtrOwner<RendererCanvasCull::Item, true> &canvas_item_owner) {
 	do {
 		ysort_owner->ysort_children_count = -1;
@@ -104,6 +141,109 @@ void _mark_ysort_dirty(RendererCanvasCull::Item *ysort_owner, RID_PtrOwner<Rende
 	} while (ysort_owner && ysort_owner->sort_y);
 }
 
+bool RendererCanvasCull::_is_spatially_indexable(const Item *p_item) {
+	// Only leaves whose bounds are fully known to the canvas server can be skipped
+	// without being visited, everything else is culled the regular way.
+	if (!p_item->child_items.is_empty() || p_item->behind || p_item->sort_y || p_item->copy_back_buffer || p_item->update_when_visible || p_item->canvas_group || p_item->skeleton.is_valid()) {
+		return false;
+	}
+
+	for (const Item::Command *c = p_item->commands; c; c = c->next) {
+		// Mesh, multimesh and particle bounds can change in storage behind our back.
+		if (c->type == Item::Command::TYPE_MESH || c->type == Item::Command::TYPE_MULTIMESH || c->type == Item::Command::TYPE_PARTICLES) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+AABB RendererCanvasCull::_get_spatial_bounds(const Item *p_item) {
+	// Grow by one unit to account for the origin being floored when snapping transforms to pixel.
+	Rect2 rect = p_item->xform.xform(p_item->get_rect()).grow(1.0);
+	return AABB(Vector3(rect.position.x, rect.position.y, 0), Vector3(rect.size.x, rect.size.y, 0));
+}
+
+void RendererCanvasCull::_mark_spatial_index_dirty(Item *p_item) {
+	if (p_item->spatial_dirty || !canvas_item_owner.owns(p_item->parent)) {
+		return;
+	}
+
+	Item *parent = canvas_item_owner.getornull(p_item->parent);
+	if (!parent->spatial_index || parent->spatial_index->rebuild) {
+		return;
+	}
+
+	p_item->spatial_dirty = true;
+	parent->spatial_index->dirty.push_back(p_item);
+}
+
+void RendererCanvasCull::_update_spatial_index(Item *p_item) {
+	if (!p_item->spatial_index) {
+		p_item->spatial_index = memnew(Item::SpatialIndex);
+	}
+
+	Item::SpatialIndex *index = p_item->spatial_index;
+
+	if (!index->rebuild) {
+		for (uint32_t i = 0; i < index->dirty.size(); i++) {
+			Item *child = index->dirty[i];
+			child->spatial_dirty = false;
+
+			if (index->rebuild) {
+				continue;
+			}
+
+			if (_is_spatially_indexable(child) != child->spatial_id.is_valid()) {
+				// Moving a child in or out of the index changes the unindexed list, just rebuild.
+				index->rebuild = true;
+			} else if (child->spatial_id.is_valid()) {
+				index->bvh.update(child->spatial_id, _get_spatial_bounds(child));
+			}
+		}
+		index->dirty.clear();
+	}
+
+	if (index->rebuild) {
+		index->bvh.clear();
+		index->unindexed.clear();
+		index->dirty.clear();
+
+		int child_item_count = p_item->child_items.size();
+		Item **child_items = p_item->child_items.ptrw();
+
+		for (int i = 0; i < child_item_count; i++) {
+			Item *child = child_items[i];
+			child->spatial_order = i;
+			child->spatial_dirty = false;
+
+			if (_is_spatially_indexable(child)) {
+				child->spatial_id = index->bvh.insert(_get_spatial_bounds(child), child);
+			} else {
+				child->spatial_id = DynamicBVH::ID();
+				index->unindexed.push_back(child);
+			}
+		}
+
+		index->rebuild = false;
+	}
+}
+
+struct CanvasItemSpatialCull {
+	LocalVector<RendererCanvasCull::Item *> *items;
+
+	_FORCE_INLINE_ bool operator()(void *p_data) {
+		items->push_back((RendererCanvasCull::Item *)p_data);
+		return false;
+	}
+};
+
+struct CanvasItemSpatialOrderSort {
+	_FORCE_INLINE_ bool operator()(const RendererCanvasCull::Item *p_left, const RendererCanvasCull::Item *p_right) const {
+		return p_left->spatial_order < p_right->spatial_order;
+	}
+};
+
 void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, Item *p_canvas_clip, Item *p_material_owner) {
 	Item *ci = p_canvas_item;
 
@@ -114,14 +254,34 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	if (ci->children_order_dirty) {
 		ci->child_items.sort_custom<ItemIndexSort>();
 		ci->children_order_dirty = false;
+
+		if (ci->spatial_index) {
+			ci->spatial_index->rebuild = true;
+		}
 	}
 
-	Rect2 rect = ci->get_rect();
-	Transform2D xform = ci->xform;
-	if (snapping_2d_transforms_to_pixel) {
-		xform.elements[2] = xform.elements[2].floor();
+	if (ci->cache_dirty) {
+		Transform2D local_xform = ci->xform;
+		if (snapping_2d_transforms_to_pixel) {
+			local_xform.elements[2] = local_xform.elements[2].floor();
+		}
+		ci->cache_xform = p_transform * local_xform;
+		ci->cache_modulate = Color(ci->modulate.r * p_modulate.r, ci->modulate.g * p_modulate.g, ci->modulate.b * p_modulate.b, ci->modulate.a * p_modulate.a);
+		ci->cache_dirty = false;
+
+		// Children depend on both, so they need to update too. Done here rather
+		// than passed down, as children may be skipped by the spatial index.
+		int child_count = ci->child_items.size();
+		Item **children = ci->child_items.ptrw();
+		for (int i = 0; i < child_count; i++) {
+			children[i]->cache_dirty = true;
+		}
+
+		items_recomputed++;
 	}
-	xform = p_transform * xform;
+
+	Rect2 rect = ci->get_rect();
+	const Transform2D &xform = ci->cache_xform;
 
 	Rect2 global_rect = xform.xform(rect);
 	global_rect.position += p_clip_rect.position;
@@ -133,7 +293,7 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 		ci->material_owner = nullptr;
 	}
 
-	Color modulate(ci->modulate.r * p_modulate.r, ci->modulate.g * p_modulate.g, ci->modulate.b * p_modulate.b, ci->modulate.a * p_modulate.a);
+	const Color &modulate = ci->cache_modulate;
 
 	if (modulate.a < 0.007) {
 		return;
@@ -142,6 +302,29 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	int child_item_count = ci->child_items.size();
 	Item **child_items = ci->child_items.ptrw();
 
+	if (using_spatial_index && !ci->sort_y && child_item_count >= SPATIAL_INDEX_MIN_CHILDREN && xform.basis_determinant() != 0) {
+		// Only visit the children that may overlap the clip rect, keeping their draw order.
+		_update_spatial_index(ci);
+
+		Item::SpatialIndex *index = ci->spatial_index;
+		index->visible.clear();
+		for (uint32_t i = 0; i < index->unindexed.size(); i++) {
+			index->visible.push_back(index->unindexed[i]);
+		}
+
+		Rect2 local_clip = xform.affine_inverse().xform(Rect2(Point2(), p_clip_rect.size));
+		CanvasItemSpatialCull cull;
+		cull.items = &index->visible;
+		index->bvh.aabb_query(AABB(Vector3(local_clip.position.x, local_clip.position.y, 0), Vector3(local_clip.size.x, local_clip.size.y, 0)), cull);
+
+		child_item_count = index->visible.size();
+		child_items = index->visible.ptr();
+		if (child_item_count > 1) {
+			SortArray<Item *, CanvasItemSpatialOrderSort> sorter;
+			sorter.sort(child_items, child_item_count);
+		}
+	}
+
 	if (ci->clip) {
 		if (p_canvas_clip != nullptr) {
 			ci->final_clip_rect = p_canvas_clip->final_clip_rect.intersection(global_rect);
@@ -159,17 +342,33 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	if (ci->sort_y) {
 		if (ci->ysort_children_count == -1) {
 			ci->ysort_children_count = 0;
-			_collect_ysort_children(ci, Transform2D(), p_material_owner, nullptr, ci->ysort_children_count);
+			_collect_ysort_children(ci, Transform2D(), p_material_owner, nullptr, ci->ysort_children_count, false);
+			ci->ysort_order.clear();
 		}
 
 		child_item_count = ci->ysort_children_count;
-		child_items = (Item **)alloca(child_item_count * sizeof(Item *));
 
+		// The set of children only changes along with ysort_children_count, so the
+		// order from the previous frame is still valid input and usually almost sorted.
+		// Only their sorting data needs to be refreshed then.
 		int i = 0;
-		_collect_ysort_children(ci, Transform2D(), p_material_owner, child_items, i);
+		if ((int)ci->ysort_order.size() != child_item_count) {
+			ci->ysort_order.resize(child_item_count);
+			_collect_ysort_children(ci, Transform2D(), p_material_owner, ci->ysort_order.ptr(), i, true);
+
+			SortArray<Item *, ItemPtrSort> sorter;
+			sorter.sort(ci->ysort_order.ptr(), child_item_count);
+		} else {
+			_collect_ysort_children(ci, Transform2D(), p_material_owner, nullptr, i, true);
+
+			if (!_ysort_incremental(ci->ysort_order.ptr(), child_item_count, child_item_count * YSORT_MAX_SHIFTS_PER_ITEM)) {
+				// Too much moved around, finish with a regular sort.
+				SortArray<Item *, ItemPtrSort> sorter;
+				sorter.sort(ci->ysort_order.ptr(), child_item_count);
+			}
+		}
 
-		SortArray<Item *, ItemPtrSort> sorter;
-		sorter.sort(child_items, child_item_count);
+		child_items = ci->ysort_order.ptr();
 	}
 
 	if (ci->z_relative) {
@@ -190,6 +389,8 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 			continue;
 		}
 		if (ci->sort_y) {
+			// Y-sorted children are collected again every frame, their input is not tracked.
+			child_items[i]->cache_dirty = true;
 			_cull_canvas_item(child_items[i], xform * child_items[i]->ysort_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, (Item *)child_items[i]->material_owner);
 		} else {
 			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner);
@@ -297,6 +498,8 @@ void RendererCanvasCull::_cull_canvas_item(Item *p_canvas_item, const Transform2
 			continue;
 		}
 		if (ci->sort_y) {
+			// Y-sorted children are collected again every frame, their input is not tracked.
+			child_items[i]->cache_dirty = true;
 			_cull_canvas_item(child_items[i], xform * child_items[i]->ysort_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, (Item *)child_items[i]->material_owner);
 		} else {
 			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner);
@@ -308,7 +511,9 @@ void RendererCanvasCull::render_canvas(RID p_render_target, Canvas *p_canvas, co
 	RENDER_TIMESTAMP(">Render Canvas");
 
 	sdf_used = false;
+	item_cache_force_update = snapping_2d_transforms_to_pixel != p_snap_2d_transforms_to_pixel;
 	snapping_2d_transforms_to_pixel = p_snap_2d_transforms_to_pixel;
+	using_spatial_index = p_canvas->use_spatial_index;
 
 	if (p_canvas->children_order_dirty) {
 		p_canvas->child_items.sort();
@@ -358,6 +563,15 @@ bool RendererCanvasCull::was_sdf_used() {
 	return sdf_used;
 }
 
+void RendererCanvasCull::update_frame_stats() {
+	items_recomputed_in_frame = items_recomputed;
+	items_recomputed = 0;
+}
+
+uint64_t RendererCanvasCull::get_items_recomputed_in_frame() const {
+	return items_recomputed_in_frame;
+}
+
 RID RendererCanvasCull::canvas_allocate() {
 	return canvas_owner.allocate_rid();
 }
@@ -387,6 +601,12 @@ void RendererCanvasCull::canvas_set_disable_scale(bool p_disable) {
 	disable_scale = p_disable;
 }
 
+void RendererCanvasCull::canvas_set_use_spatial_index(RID p_canvas, bool p_enable) {
+	Canvas *canvas = canvas_owner.getornull(p_canvas);
+	ERR_FAIL_COND(!canvas);
+	canvas->use_spatial_index = p_enable;
+}
+
 void RendererCanvasCull::canvas_set_parent(RID p_canvas, RID p_parent, float p_scale) {
 	Canvas *canvas = canvas_owner.getornull(p_canvas);
 	ERR_FAIL_COND(!canvas);
@@ -418,6 +638,11 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 			if (item_owner->sort_y) {
 				_mark_ysort_dirty(item_owner, canvas_item_owner);
 			}
+
+			if (item_owner->spatial_index) {
+				item_owner->spatial_index->rebuild = true;
+			}
+			_mark_spatial_index_dirty(item_owner);
 		}
 
 		canvas_item->parent = RID();
@@ -439,12 +664,15 @@ void RendererCanvasCull::canvas_item_set_parent(RID p_item, RID p_parent) {
 				_mark_ysort_dirty(item_owner, canvas_item_owner);
 			}
 
+			_mark_spatial_index_dirty(item_owner);
+
 		} else {
 			ERR_FAIL_MSG("Invalid parent.");
 		}
 	}
 
 	canvas_item->parent = p_parent;
+	canvas_item->cache_dirty = true;
 }
 
 void RendererCanvasCull::canvas_item_set_visible(RID p_item, bool p_visible) {
@@ -466,8 +694,10 @@ void RendererCanvasCull::canvas_item_set_light_mask(RID p_item, int p_mask) {
 void RendererCanvasCull::canvas_item_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	canvas_item->xform = p_transform;
+	canvas_item->cache_dirty = true;
 }
 
 void RendererCanvasCull::canvas_item_set_clip(RID p_item, bool p_clip) {
@@ -487,6 +717,7 @@ void RendererCanvasCull::canvas_item_set_distance_field_mode(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_custom_rect(RID p_item, bool p_custom_rect, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	canvas_item->custom_rect = p_custom_rect;
 	canvas_item->rect = p_rect;
@@ -497,6 +728,7 @@ void RendererCanvasCull::canvas_item_set_modulate(RID p_item, const Color &p_col
 	ERR_FAIL_COND(!canvas_item);
 
 	canvas_item->modulate = p_color;
+	canvas_item->cache_dirty = true;
 }
 
 void RendererCanvasCull::canvas_item_set_self_modulate(RID p_item, const Color &p_color) {
@@ -509,6 +741,7 @@ void RendererCanvasCull::canvas_item_set_self_modulate(RID p_item, const Color &
 void RendererCanvasCull::canvas_item_set_draw_behind_parent(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	canvas_item->behind = p_enable;
 }
@@ -516,6 +749,7 @@ void RendererCanvasCull::canvas_item_set_draw_behind_parent(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_update) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	canvas_item->update_when_visible = p_update;
 }
@@ -523,6 +757,7 @@ void RendererCanvasCull::canvas_item_set_update_when_visible(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_add_line(RID p_item, const Point2 &p_from, const Point2 &p_to, const Color &p_color, float p_width) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandPrimitive *line = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!line);
@@ -547,6 +782,7 @@ void RendererCanvasCull::canvas_item_add_polyline(RID p_item, const Vector<Point
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Color color = Color(1, 1, 1, 1);
 
@@ -686,6 +922,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 	ERR_FAIL_COND(p_points.size() < 2);
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandPolygon *pline = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!pline);
@@ -702,6 +939,7 @@ void RendererCanvasCull::canvas_item_add_multiline(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -712,6 +950,7 @@ void RendererCanvasCull::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, c
 void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos, float p_radius, const Color &p_color) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandPolygon *circle = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!circle);
@@ -748,6 +987,7 @@ void RendererCanvasCull::canvas_item_add_circle(RID p_item, const Point2 &p_pos,
 void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p_rect, RID p_texture, bool p_tile, const Color &p_modulate, bool p_transpose) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -779,6 +1019,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect(RID p_item, const Rect2 &p
 void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const Rect2 &p_rect, RID p_texture, const Rect2 &p_src_rect, const Color &p_modulate, bool p_transpose, bool p_clip_uv) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
@@ -820,6 +1061,7 @@ void RendererCanvasCull::canvas_item_add_texture_rect_region(RID p_item, const R
 void RendererCanvasCull::canvas_item_add_nine_patch(RID p_item, const Rect2 &p_rect, const Rect2 &p_source, RID p_texture, const Vector2 &p_topleft, const Vector2 &p_bottomright, RS::NinePatchAxisMode p_x_axis_mode, RS::NinePatchAxisMode p_y_axis_mode, bool p_draw_center, const Color &p_modulate) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandNinePatch *style = canvas_item->alloc_command<Item::CommandNinePatch>();
 	ERR_FAIL_COND(!style);
@@ -844,6 +1086,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandPrimitive *prim = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!prim);
@@ -870,6 +1113,7 @@ void RendererCanvasCull::canvas_item_add_primitive(RID p_item, const Vector<Poin
 void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 #ifdef DEBUG_ENABLED
 	int pointcount = p_points.size();
 	ERR_FAIL_COND(pointcount < 3);
@@ -891,6 +1135,7 @@ void RendererCanvasCull::canvas_item_add_polygon(RID p_item, const Vector<Point2
 void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector<int> &p_indices, const Vector<Point2> &p_points, const Vector<Color> &p_colors, const Vector<Point2> &p_uvs, const Vector<int> &p_bones, const Vector<float> &p_weights, RID p_texture, int p_count) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	int vertex_count = p_points.size();
 	ERR_FAIL_COND(vertex_count == 0);
@@ -914,6 +1159,7 @@ void RendererCanvasCull::canvas_item_add_triangle_array(RID p_item, const Vector
 void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transform2D &p_transform) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandTransform *tr = canvas_item->alloc_command<Item::CommandTransform>();
 	ERR_FAIL_COND(!tr);
@@ -923,6 +1169,7 @@ void RendererCanvasCull::canvas_item_add_set_transform(RID p_item, const Transfo
 void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, const Transform2D &p_transform, const Color &p_modulate, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 	ERR_FAIL_COND(!p_mesh.is_valid());
 
 	Item::CommandMesh *m = canvas_item->alloc_command<Item::CommandMesh>();
@@ -942,6 +1189,7 @@ void RendererCanvasCull::canvas_item_add_mesh(RID p_item, const RID &p_mesh, con
 void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandParticles *part = canvas_item->alloc_command<Item::CommandParticles>();
 	ERR_FAIL_COND(!part);
@@ -956,6 +1204,7 @@ void RendererCanvasCull::canvas_item_add_particles(RID p_item, RID p_particles,
 void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p_texture) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandMultiMesh *mm = canvas_item->alloc_command<Item::CommandMultiMesh>();
 	ERR_FAIL_COND(!mm);
@@ -967,6 +1216,7 @@ void RendererCanvasCull::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p
 void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	Item::CommandClipIgnore *ci = canvas_item->alloc_command<Item::CommandClipIgnore>();
 	ERR_FAIL_COND(!ci);
@@ -976,6 +1226,7 @@ void RendererCanvasCull::canvas_item_add_clip_ignore(RID p_item, bool p_ignore)
 void RendererCanvasCull::canvas_item_set_sort_children_by_y(RID p_item, bool p_enable) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	canvas_item->sort_y = p_enable;
 
@@ -1001,6 +1252,7 @@ void RendererCanvasCull::canvas_item_set_z_as_relative_to_parent(RID p_item, boo
 void RendererCanvasCull::canvas_item_attach_skeleton(RID p_item, RID p_skeleton) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 	if (canvas_item->skeleton == p_skeleton) {
 		return;
 	}
@@ -1030,6 +1282,7 @@ void RendererCanvasCull::canvas_item_attach_skeleton(RID p_item, RID p_skeleton)
 void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_enable, const Rect2 &p_rect) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 	if (p_enable && (canvas_item->copy_back_buffer == nullptr)) {
 		canvas_item->copy_back_buffer = memnew(RendererCanvasRender::Item::CopyBackBuffer);
 	}
@@ -1047,6 +1300,7 @@ void RendererCanvasCull::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_e
 void RendererCanvasCull::canvas_item_clear(RID p_item) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	canvas_item->clear();
 }
@@ -1087,6 +1341,7 @@ void RendererCanvasCull::canvas_item_set_use_parent_material(RID p_item, bool p_
 void RendererCanvasCull::canvas_item_set_canvas_group_mode(RID p_item, RS::CanvasGroupMode p_mode, float p_clear_margin, bool p_fit_empty, float p_fit_margin, bool p_blur_mipmaps) {
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+	_mark_spatial_index_dirty(canvas_item);
 
 	if (p_mode == RS::CANVAS_GROUP_MODE_DISABLED) {
 		if (canvas_item->canvas_group != nullptr) {
@@ -1513,6 +1768,11 @@ bool RendererCanvasCull::free(RID p_rid) {
 				if (item_owner->sort_y) {
 					_mark_ysort_dirty(item_owner, canvas_item_owner);
 				}
+
+				if (item_owner->spatial_index) {
+					item_owner->spatial_index->rebuild = true;
+				}
+				_mark_spatial_index_dirty(item_owner);
 			}
 		}
 
@@ -1526,6 +1786,10 @@ bool RendererCanvasCull::free(RID p_rid) {
 		}
 		*/
 
+		if (canvas_item->spatial_index) {
+			memdelete(canvas_item->spatial_index);
+		}
+
 		canvas_item_owner.free(p_rid);
 
 		memdelete(canvas_item);
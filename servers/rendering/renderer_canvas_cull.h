@@ -31,6 +31,8 @@
 #ifndef RENDERING_SERVER_CANVAS_CULL_H
 #define RENDERING_SERVER_CANVAS_CULL_H
 
+#include "core/math/dynamic_bvh.h"
+#include "core/templates/local_vector.h"
 #include "renderer_compositor.h"
 #include "renderer_viewport.h"
 
@@ -52,9 +54,33 @@ public:
 		Transform2D ysort_xform;
 		Vector2 ysort_pos;
 		int ysort_index;
+		LocalVector<Item *> ysort_order; // Y-sorted children as of the last frame.
 
 		Vector<Item *> child_items;
 
+		// Bounds of the leaf children of this item, in its local space.
+		// Only built when the canvas enables the spatial index and the
+		// item has enough children (see SPATIAL_INDEX_MIN_CHILDREN).
+		struct SpatialIndex {
+			DynamicBVH bvh;
+			LocalVector<Item *> unindexed; // Children that are always culled the regular way.
+			LocalVector<Item *> dirty; // Indexed children whose bounds changed.
+			LocalVector<Item *> visible; // Scratch buffer filled while culling.
+			bool rebuild = true;
+		};
+
+		SpatialIndex *spatial_index = nullptr;
+		DynamicBVH::ID spatial_id;
+		uint32_t spatial_order = 0;
+		bool spatial_dirty = false;
+
+		// Final transform and modulate, only recomputed when this item or
+		// one of its parents changed.
+		bool cache_dirty = true;
+		Transform2D cache_parent_xform; // Only used by items directly under the canvas.
+		Transform2D cache_xform;
+		Color cache_modulate;
+
 		Item() {
 			children_order_dirty = true;
 			E = nullptr;
@@ -125,6 +151,7 @@ public:
 		Color modulate;
 		RID parent;
 		float parent_scale;
+		bool use_spatial_index = false;
 
 		int find_item(Item *p_item) {
 			for (int i = 0; i < child_items.size(); i++) {
@@ -155,11 +182,28 @@ public:
 	bool disable_scale;
 	bool sdf_used = false;
 	bool snapping_2d_transforms_to_pixel = false;
+	bool using_spatial_index = false;
+	bool item_cache_force_update = false;
+
+	uint64_t items_recomputed = 0;
+	uint64_t items_recomputed_in_frame = 0;
+
+	enum {
+		SPATIAL_INDEX_MIN_CHILDREN = 64,
+		YSORT_MAX_SHIFTS_PER_ITEM = 8
+	};
 
 private:
 	void _render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RendererCanvasRender::Light *p_lights, RendererCanvasRender::Light *p_directional_lights, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel);
 	void _cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, RendererCanvasRender::Item **z_list, RendererCanvasRender::Item **z_last_list, Item *p_canvas_clip, Item *p_material_owner);
 
+	void _update_item_cache_root(Item *p_item, const Transform2D &p_transform);
+
+	static bool _is_spatially_indexable(const Item *p_item);
+	static AABB _get_spatial_bounds(const Item *p_item);
+	void _mark_spatial_index_dirty(Item *p_item);
+	void _update_spatial_index(Item *p_item);
+
 	RendererCanvasRender::Item **z_list;
 	RendererCanvasRender::Item **z_last_list;
 
@@ -168,6 +212,9 @@ public:
 
 	bool was_sdf_used();
 
+	void update_frame_stats();
+	uint64_t get_items_recomputed_in_frame() const;
+
 	RID canvas_allocate();
 	void canvas_initialize(RID p_rid);
 
@@ -175,6 +222,7 @@ public:
 	void canvas_set_modulate(RID p_canvas, const Color &p_color);
 	void canvas_set_parent(RID p_canvas, RID p_parent, float p_scale);
 	void canvas_set_disable_scale(bool p_disable);
+	void canvas_set_use_spatial_index(RID p_canvas, bool p_enable);
 
 	RID canvas_item_allocate();
 	void canvas_item_initialize(RID p_rid);
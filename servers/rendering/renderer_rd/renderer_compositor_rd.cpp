@@ -31,6 +31,7 @@
 #include "renderer_compositor_rd.h"
 
 #include "core/config/project_settings.h"
+#include "servers/rendering/renderer_rd/shader_cache_rd.h"
 
 void RendererCompositorRD::prepare_for_blitting_render_targets() {
 	RD::get_singleton()->prepare_screen_for_drawing();
@@ -150,6 +151,8 @@ void RendererCompositorRD::finalize() {
 	blit.shader.version_free(blit.shader_version);
 	RD::get_singleton()->free(blit.index_buffer);
 	RD::get_singleton()->free(blit.sampler);
+
+	ShaderCacheRD::finalize();
 }
 
 RendererCompositorRD *RendererCompositorRD::singleton = nullptr;
@@ -158,6 +161,13 @@ RendererCompositorRD::RendererCompositorRD() {
 	singleton = this;
 	time = 0;
 
+	// Must be set up before any shader is compiled.
+	if (GLOBAL_GET("rendering/shader_compiler/shader_cache/enabled")) {
+		String cache_path = ProjectSettings::get_singleton()->globalize_path(GLOBAL_GET("rendering/shader_compiler/shader_cache/path"));
+		String driver_id = RD::get_singleton()->get_device_vendor_name() + "|" + RD::get_singleton()->get_device_name() + "|" + RD::get_singleton()->get_device_pipeline_cache_uuid();
+		ShaderCacheRD::initialize(cache_path, driver_id);
+	}
+
 	storage = memnew(RendererStorageRD);
 	canvas = memnew(RendererCanvasRenderRD(storage));
 
@@ -0,0 +1,132 @@
+/*************************************************************************/
+/*  shader_cache_rd.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "shader_cache_rd.h"
+
+#include "core/os/dir_access.h"
+#include "core/os/file_access.h"
+#include "core/os/thread.h"
+#include "core/version.h"
+
+static const char *SHADER_CACHE_MAGIC = "GDSC";
+
+String ShaderCacheRD::cache_dir;
+String ShaderCacheRD::driver_id;
+
+String ShaderCacheRD::get_key(RD::ShaderStage p_stage, const String &p_source_code, RD::ShaderLanguage p_language, const String &p_driver_id) {
+	String key = VERSION_FULL_BUILD;
+	key += "\n" + p_driver_id;
+	key += "\n" + itos(FORMAT_VERSION) + "," + itos(p_stage) + "," + itos(p_language) + "\n";
+	key += p_source_code;
+	return key.sha256_text();
+}
+
+Vector<uint8_t> ShaderCacheRD::load(const String &p_dir, const String &p_key) {
+	FileAccessRef f = FileAccess::open(p_dir.plus_file(p_key + ".spv"), FileAccess::READ);
+	if (!f) {
+		return Vector<uint8_t>();
+	}
+
+	uint8_t magic[4];
+	if (f->get_buffer(magic, 4) != 4 || memcmp(magic, SHADER_CACHE_MAGIC, 4) != 0 || f->get_32() != FORMAT_VERSION) {
+		return Vector<uint8_t>();
+	}
+
+	uint32_t size = f->get_32();
+	if (size == 0 || f->get_position() + size != f->get_len()) {
+		return Vector<uint8_t>(); // Truncated or corrupt, will be compiled and written again.
+	}
+
+	Vector<uint8_t> spirv;
+	spirv.resize(size);
+	if (f->get_buffer(spirv.ptrw(), size) != size) {
+		return Vector<uint8_t>();
+	}
+	return spirv;
+}
+
+Error ShaderCacheRD::save(const String &p_dir, const String &p_key, const Vector<uint8_t> &p_spirv) {
+	ERR_FAIL_COND_V(p_spirv.is_empty(), ERR_INVALID_PARAMETER);
+
+	// Write to a temporary file first, so a crash or another thread never leaves a partial entry behind.
+	const String path = p_dir.plus_file(p_key + ".spv");
+	const String temp_path = path + "." + itos(Thread::get_caller_id()) + ".tmp";
+	{
+		Error err;
+		FileAccessRef f = FileAccess::open(temp_path, FileAccess::WRITE, &err);
+		if (!f) {
+			return err;
+		}
+		f->store_buffer((const uint8_t *)SHADER_CACHE_MAGIC, 4);
+		f->store_32(FORMAT_VERSION);
+		f->store_32(p_spirv.size());
+		f->store_buffer(p_spirv.ptr(), p_spirv.size());
+	}
+
+	DirAccessRef da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	if (da->file_exists(path)) {
+		da->remove(path);
+	}
+	return da->rename(temp_path, path);
+}
+
+Vector<uint8_t> ShaderCacheRD::_cache_lookup(RD::ShaderStage p_stage, const String &p_source_code, RD::ShaderLanguage p_language) {
+	return load(cache_dir, get_key(p_stage, p_source_code, p_language, driver_id));
+}
+
+void ShaderCacheRD::_cache_store(RD::ShaderStage p_stage, const String &p_source_code, RD::ShaderLanguage p_language, const Vector<uint8_t> &p_spirv) {
+	Error err = save(cache_dir, get_key(p_stage, p_source_code, p_language, driver_id), p_spirv);
+	if (err != OK) {
+		WARN_PRINT_ONCE("Could not write to the shader cache at: " + cache_dir);
+	}
+}
+
+void ShaderCacheRD::initialize(const String &p_dir, const String &p_driver_id) {
+	DirAccessRef da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	if (!da->dir_exists(p_dir)) {
+		Error err = da->make_dir_recursive(p_dir);
+		ERR_FAIL_COND_MSG(err != OK, "Could not create the shader cache directory: " + p_dir);
+	}
+
+	cache_dir = p_dir;
+	driver_id = p_driver_id;
+	RD::shader_set_cache_function(_cache_lookup);
+	RD::shader_set_cache_store_function(_cache_store);
+}
+
+void ShaderCacheRD::finalize() {
+	if (cache_dir.is_empty()) {
+		return;
+	}
+	RD::shader_set_cache_function(nullptr);
+	RD::shader_set_cache_store_function(nullptr);
+	cache_dir = String();
+	driver_id = String();
+}
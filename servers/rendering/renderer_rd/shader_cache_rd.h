@@ -0,0 +1,61 @@
+/*************************************************************************/
+/*  shader_cache_rd.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SHADER_CACHE_RD_H
+#define SHADER_CACHE_RD_H
+
+#include "servers/rendering/rendering_device.h"
+
+// On-disk cache of compiled SPIR-V, plugged into RenderingDevice::shader_compile_from_source().
+// Entries are keyed by the hash of the full stage source (which includes all defines, so every
+// ShaderRD variant and every ShaderCompilerRD output gets its own entry), the engine version
+// and the driver, so upgrading either invalidates the cache.
+class ShaderCacheRD {
+	static String cache_dir;
+	static String driver_id;
+
+	static Vector<uint8_t> _cache_lookup(RD::ShaderStage p_stage, const String &p_source_code, RD::ShaderLanguage p_language);
+	static void _cache_store(RD::ShaderStage p_stage, const String &p_source_code, RD::ShaderLanguage p_language, const Vector<uint8_t> &p_spirv);
+
+public:
+	enum {
+		FORMAT_VERSION = 1,
+	};
+
+	static String get_key(RD::ShaderStage p_stage, const String &p_source_code, RD::ShaderLanguage p_language, const String &p_driver_id);
+	static Vector<uint8_t> load(const String &p_dir, const String &p_key);
+	static Error save(const String &p_dir, const String &p_key, const Vector<uint8_t> &p_spirv);
+
+	static void initialize(const String &p_dir, const String &p_driver_id);
+	static void finalize();
+	static bool is_enabled() { return !cache_dir.is_empty(); }
+};
+
+#endif // SHADER_CACHE_RD_H
@@ -207,6 +207,8 @@ public:
 	virtual void update() = 0;
 	virtual void render_probes() = 0;
 
+	virtual Array get_shadow_cull_times() const = 0;
+
 	virtual bool free(RID p_rid) = 0;
 
 	RendererScene();
@@ -31,12 +31,112 @@
 #include "renderer_scene_cull.h"
 
 #include "core/config/project_settings.h"
+#include "core/math/simd.h"
 #include "core/os/os.h"
+#include "renderer_scene_occlusion_cull_raster.h"
 #include "rendering_server_default.h"
 #include "rendering_server_globals.h"
 
 #include <new>
 
+/* INSTANCE BOUNDS */
+
+void RendererSceneCull::InstanceBounds::cull_frustum(const InstanceBounds *p_bounds, uint32_t p_count, const Frustum &p_frustum, uint8_t *r_inside) {
+	uint32_t i = 0;
+
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= p_count; i += 4) {
+		const real_t *b0 = p_bounds[i + 0].bounds;
+		const real_t *b1 = p_bounds[i + 1].bounds;
+		const real_t *b2 = p_bounds[i + 2].bounds;
+		const real_t *b3 = p_bounds[i + 3].bounds;
+
+		// Transpose four bounds so each register holds the same component of all of them.
+		__m128 lo0 = _mm_loadu_ps(b0), lo1 = _mm_loadu_ps(b1), lo2 = _mm_loadu_ps(b2), lo3 = _mm_loadu_ps(b3);
+		__m128 hi0 = _mm_loadu_ps(b0 + 2), hi1 = _mm_loadu_ps(b1 + 2), hi2 = _mm_loadu_ps(b2 + 2), hi3 = _mm_loadu_ps(b3 + 2);
+		_MM_TRANSPOSE4_PS(lo0, lo1, lo2, lo3);
+		_MM_TRANSPOSE4_PS(hi0, hi1, hi2, hi3);
+		// Same order as InstanceBounds::bounds, so plane signs can be used as indices.
+		const __m128 axis[6] = { lo0, lo1, lo2, lo3, hi2, hi3 };
+
+		__m128 outside = zero;
+		for (uint32_t j = 0; j < p_frustum.plane_count; j++) {
+			const Plane &plane = p_frustum.planes_ptr[j];
+			const uint32_t *signs = p_frustum.plane_signs_ptr[j].signs;
+
+			__m128 dist = _mm_mul_ps(axis[signs[0]], _mm_set1_ps(plane.normal.x));
+			dist = _mm_add_ps(dist, _mm_mul_ps(axis[signs[1]], _mm_set1_ps(plane.normal.y)));
+			dist = _mm_add_ps(dist, _mm_mul_ps(axis[signs[2]], _mm_set1_ps(plane.normal.z)));
+			dist = _mm_sub_ps(dist, _mm_set1_ps(plane.d));
+			outside = _mm_or_ps(outside, _mm_cmpge_ps(dist, zero));
+
+			if (_mm_movemask_ps(outside) == 0xF) {
+				break;
+			}
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		r_inside[i + 0] = !(mask & 1);
+		r_inside[i + 1] = !(mask & 2);
+		r_inside[i + 2] = !(mask & 4);
+		r_inside[i + 3] = !(mask & 8);
+	}
+#elif defined(SIMD_NEON) && !defined(REAL_T_IS_DOUBLE)
+	const float32x4_t zero = vdupq_n_f32(0);
+
+	for (; i + 4 <= p_count; i += 4) {
+		const real_t *b0 = p_bounds[i + 0].bounds;
+		const real_t *b1 = p_bounds[i + 1].bounds;
+		const real_t *b2 = p_bounds[i + 2].bounds;
+		const real_t *b3 = p_bounds[i + 3].bounds;
+
+		// Transpose four bounds so each register holds the same component of all of them.
+		float32x4x2_t lo01 = vtrnq_f32(vld1q_f32(b0), vld1q_f32(b1));
+		float32x4x2_t lo23 = vtrnq_f32(vld1q_f32(b2), vld1q_f32(b3));
+		float32x4x2_t hi01 = vtrnq_f32(vld1q_f32(b0 + 2), vld1q_f32(b1 + 2));
+		float32x4x2_t hi23 = vtrnq_f32(vld1q_f32(b2 + 2), vld1q_f32(b3 + 2));
+		// Same order as InstanceBounds::bounds, so plane signs can be used as indices.
+		const float32x4_t axis[6] = {
+			vcombine_f32(vget_low_f32(lo01.val[0]), vget_low_f32(lo23.val[0])),
+			vcombine_f32(vget_low_f32(lo01.val[1]), vget_low_f32(lo23.val[1])),
+			vcombine_f32(vget_high_f32(lo01.val[0]), vget_high_f32(lo23.val[0])),
+			vcombine_f32(vget_high_f32(lo01.val[1]), vget_high_f32(lo23.val[1])),
+			vcombine_f32(vget_high_f32(hi01.val[0]), vget_high_f32(hi23.val[0])),
+			vcombine_f32(vget_high_f32(hi01.val[1]), vget_high_f32(hi23.val[1])),
+		};
+
+		uint32x4_t outside = vdupq_n_u32(0);
+		for (uint32_t j = 0; j < p_frustum.plane_count; j++) {
+			const Plane &plane = p_frustum.planes_ptr[j];
+			const uint32_t *signs = p_frustum.plane_signs_ptr[j].signs;
+
+			float32x4_t dist = vmulq_n_f32(axis[signs[0]], plane.normal.x);
+			dist = vaddq_f32(dist, vmulq_n_f32(axis[signs[1]], plane.normal.y));
+			dist = vaddq_f32(dist, vmulq_n_f32(axis[signs[2]], plane.normal.z));
+			dist = vsubq_f32(dist, vdupq_n_f32(plane.d));
+			outside = vorrq_u32(outside, vcgeq_f32(dist, zero));
+
+			// Lanes are all ones or all zeros, so the AND of all four is only set when every bound is outside.
+			const uint32x2_t halves = vand_u32(vget_low_u32(outside), vget_high_u32(outside));
+			if (vget_lane_u32(halves, 0) & vget_lane_u32(halves, 1)) {
+				break;
+			}
+		}
+
+		r_inside[i + 0] = !vgetq_lane_u32(outside, 0);
+		r_inside[i + 1] = !vgetq_lane_u32(outside, 1);
+		r_inside[i + 2] = !vgetq_lane_u32(outside, 2);
+		r_inside[i + 3] = !vgetq_lane_u32(outside, 3);
+	}
+#endif
+
+	for (; i < p_count; i++) {
+		r_inside[i] = p_bounds[i].in_frustum(p_frustum);
+	}
+}
+
 /* CAMERA API */
 
 RID RendererSceneCull::camera_allocate() {
@@ -643,6 +743,14 @@ void RendererSceneCull::instance_set_scenario(RID p_instance, RID p_scenario) {
 	if (instance->scenario) {
 		instance->scenario->instances.remove(&instance->scenario_item);
 
+		if (!instance->lod_parent && !instance->lod_children.is_empty()) {
+			// Nothing updates the hierarchy outside a scenario, so don't leave it hidden.
+			instance->scenario->lod_proxy_roots.erase(instance);
+			if (instance->lod_children_hidden) {
+				_lod_proxy_set_children_hidden(instance, false);
+			}
+		}
+
 		if (instance->indexer_id.is_valid()) {
 			_unpair_instance(instance);
 		}
@@ -706,6 +814,10 @@ void RendererSceneCull::instance_set_scenario(RID p_instance, RID p_scenario) {
 
 		scenario->instances.add(&instance->scenario_item);
 
+		if (!instance->lod_parent && !instance->lod_children.is_empty()) {
+			scenario->lod_proxy_roots.insert(instance);
+		}
+
 		switch (instance->base_type) {
 			case RS::INSTANCE_LIGHT: {
 				InstanceLightData *light = static_cast<InstanceLightData *>(instance->base_data);
@@ -1104,9 +1216,150 @@ void RendererSceneCull::instance_geometry_set_material_override(RID p_instance,
 }
 
 void RendererSceneCull::instance_geometry_set_draw_range(RID p_instance, float p_min, float p_max, float p_min_margin, float p_max_margin) {
+	Instance *instance = instance_owner.getornull(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	instance->lod_begin = MAX(p_min, 0.0);
+	instance->lod_end = MAX(p_max, 0.0);
+	instance->lod_begin_hysteresis = MAX(p_min_margin, 0.0);
+	instance->lod_end_hysteresis = MAX(p_max_margin, 0.0);
+
+	_instance_update_visibility_range_flag(instance);
 }
 
 void RendererSceneCull::instance_geometry_set_as_instance_lod(RID p_instance, RID p_as_lod_of_instance) {
+	Instance *instance = instance_owner.getornull(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	Instance *proxy = nullptr;
+	if (p_as_lod_of_instance.is_valid()) {
+		proxy = instance_owner.getornull(p_as_lod_of_instance);
+		ERR_FAIL_COND(!proxy);
+		for (Instance *E = proxy; E; E = E->lod_parent) {
+			ERR_FAIL_COND_MSG(E == instance, "Setting this LOD would create a cycle in the proxy hierarchy.");
+		}
+	}
+
+	if (instance->lod_parent == proxy) {
+		return;
+	}
+
+	if (instance->lod_parent) {
+		Instance *old_proxy = instance->lod_parent;
+		old_proxy->lod_children.erase(instance);
+		if (old_proxy->lod_children.is_empty()) {
+			old_proxy->lod_children_hidden = false;
+			if (old_proxy->scenario) {
+				old_proxy->scenario->lod_proxy_roots.erase(old_proxy);
+			}
+		}
+	} else if (instance->scenario) {
+		instance->scenario->lod_proxy_roots.erase(instance);
+	}
+	instance->lod_parent = proxy;
+	if (proxy) {
+		proxy->lod_children.insert(instance);
+		if (!proxy->lod_parent && proxy->scenario) {
+			proxy->scenario->lod_proxy_roots.insert(proxy);
+		}
+	} else if (!instance->lod_children.is_empty() && instance->scenario) {
+		instance->scenario->lod_proxy_roots.insert(instance);
+	}
+
+	// Join the state of the new proxy right away, everything below a proxy that has taken over is hidden.
+	bool hidden = proxy && proxy->lod_children_hidden;
+	_instance_set_lod_hidden(instance, hidden);
+	if (hidden && !instance->lod_children_hidden && !instance->lod_children.is_empty()) {
+		_lod_proxy_set_children_hidden(instance, true);
+	}
+
+	_instance_update_visibility_range_flag(instance);
+}
+
+void RendererSceneCull::_scenario_swap_instances(Scenario *p_scenario, uint32_t p_index_a, uint32_t p_index_b) {
+	if (p_index_a == p_index_b) {
+		return;
+	}
+
+	InstanceData data = p_scenario->instance_data[p_index_a];
+	p_scenario->instance_data[p_index_a] = p_scenario->instance_data[p_index_b];
+	p_scenario->instance_data[p_index_b] = data;
+
+	InstanceBounds bounds = p_scenario->instance_aabbs[p_index_a];
+	p_scenario->instance_aabbs[p_index_a] = p_scenario->instance_aabbs[p_index_b];
+	p_scenario->instance_aabbs[p_index_b] = bounds;
+
+	p_scenario->instance_data[p_index_a].instance->array_index = p_index_a;
+	p_scenario->instance_data[p_index_b].instance->array_index = p_index_b;
+}
+
+void RendererSceneCull::_instance_set_lod_hidden(Instance *p_instance, bool p_hidden) {
+	if (p_instance->lod_hidden == p_hidden || !p_instance->scenario || p_instance->array_index < 0) {
+		return;
+	}
+
+	// Hidden instances are kept after all the others, swap with the last visible one or the first hidden one.
+	Scenario *scenario = p_instance->scenario;
+	uint32_t first_hidden = scenario->instance_data.size() - scenario->lod_hidden_count;
+	if (p_hidden) {
+		_scenario_swap_instances(scenario, p_instance->array_index, first_hidden - 1);
+		scenario->lod_hidden_count++;
+	} else {
+		_scenario_swap_instances(scenario, p_instance->array_index, first_hidden);
+		scenario->lod_hidden_count--;
+	}
+	p_instance->lod_hidden = p_hidden;
+}
+
+void RendererSceneCull::_lod_proxy_set_children_hidden(Instance *p_proxy, bool p_hidden) {
+	p_proxy->lod_children_hidden = p_hidden;
+
+	for (Set<Instance *>::Element *E = p_proxy->lod_children.front(); E; E = E->next()) {
+		_instance_set_lod_hidden(E->get(), p_hidden);
+		if (!E->get()->lod_children.is_empty()) {
+			_lod_proxy_set_children_hidden(E->get(), p_hidden);
+		}
+	}
+}
+
+void RendererSceneCull::_update_lod_proxy(Instance *p_proxy, const Vector3 &p_camera_position, bool p_hidden) {
+	if (!p_hidden && p_proxy->lod_begin > 0) {
+		real_t dist_sq = p_camera_position.distance_squared_to(p_proxy->transformed_aabb.position + p_proxy->transformed_aabb.size * 0.5);
+		// The margins overlap so both are drawn for a short distance instead of leaving a gap.
+		real_t switch_dist = p_proxy->lod_begin + p_proxy->lod_begin_hysteresis;
+		p_hidden = dist_sq >= switch_dist * switch_dist;
+	}
+
+	if (p_hidden) {
+		if (!p_proxy->lod_children_hidden) {
+			_lod_proxy_set_children_hidden(p_proxy, true);
+		}
+		return;
+	}
+
+	if (p_proxy->lod_children_hidden) {
+		// Reveal everything below, the proxies under this one decide again right after.
+		_lod_proxy_set_children_hidden(p_proxy, false);
+	}
+
+	for (Set<Instance *>::Element *E = p_proxy->lod_children.front(); E; E = E->next()) {
+		if (!E->get()->lod_children.is_empty()) {
+			_update_lod_proxy(E->get(), p_camera_position, false);
+		}
+	}
+}
+
+void RendererSceneCull::_instance_update_visibility_range_flag(Instance *p_instance) {
+	if (!p_instance->scenario || p_instance->array_index < 0) {
+		return;
+	}
+
+	InstanceData &idata = p_instance->scenario->instance_data[p_instance->array_index];
+	if (_instance_uses_visibility_range(p_instance)) {
+		idata.flags |= InstanceData::FLAG_VISIBILITY_RANGE;
+	} else {
+		idata.flags &= ~uint32_t(InstanceData::FLAG_VISIBILITY_RANGE);
+	}
 }
 
 void RendererSceneCull::instance_geometry_set_lightmap(RID p_instance, RID p_lightmap, const Rect2 &p_lightmap_uv_scale, int p_slice_index) {
@@ -1401,9 +1654,19 @@ void RendererSceneCull::_update_instance(Instance *p_instance) {
 		if (p_instance->ignore_occlusion_culling) {
 			idata.flags |= InstanceData::FLAG_IGNORE_OCCLUSION_CULLING;
 		}
+		if (_instance_uses_visibility_range(p_instance)) {
+			idata.flags |= InstanceData::FLAG_VISIBILITY_RANGE;
+		}
 
 		p_instance->scenario->instance_data.push_back(idata);
 		p_instance->scenario->instance_aabbs.push_back(InstanceBounds(p_instance->transformed_aabb));
+
+		// Keep the hidden LOD instances at the end.
+		p_instance->lod_hidden = false;
+		_scenario_swap_instances(p_instance->scenario, p_instance->array_index, p_instance->scenario->instance_data.size() - 1 - p_instance->scenario->lod_hidden_count);
+		if (p_instance->lod_parent && p_instance->lod_parent->lod_children_hidden) {
+			_instance_set_lod_hidden(p_instance, true);
+		}
 	} else {
 		if ((1 << p_instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) {
 			p_instance->scenario->indexers[Scenario::INDEXER_GEOMETRY].update(p_instance->indexer_id, bvh_aabb);
@@ -1483,6 +1746,11 @@ void RendererSceneCull::_unpair_instance(Instance *p_instance) {
 
 	p_instance->indexer_id = DynamicBVH::ID();
 
+	// Moved to the hidden tail first, so removing it keeps the visible instances together.
+	_instance_set_lod_hidden(p_instance, true);
+	p_instance->scenario->lod_hidden_count--;
+	p_instance->lod_hidden = false;
+
 	//replace this by last
 	int32_t swap_with_index = p_instance->scenario->instance_data.size() - 1;
 	if (swap_with_index != p_instance->array_index) {
@@ -1967,7 +2235,7 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 	Transform light_transform = p_instance->transform;
 	light_transform.orthonormalize(); //scale does not count on lights
 
-	bool animated_material_found = false;
+	// Only the shadow passes are set up here, culling them is done later for all lights at once, see _shadow_cull().
 
 	switch (RSG::storage->light_get_type(p_instance->base)) {
 		case RS::LIGHT_DIRECTIONAL: {
@@ -1995,48 +2263,10 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 					planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
 					planes.write[5] = light_transform.xform(Plane(Vector3(0, 0, -z), 0));
 
-					instance_shadow_cull_result.clear();
-
-					Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&planes[0], planes.size());
-
-					struct CullConvex {
-						PagedArray<Instance *> *result;
-						_FORCE_INLINE_ bool operator()(void *p_data) {
-							Instance *p_instance = (Instance *)p_data;
-							result->push_back(p_instance);
-							return false;
-						}
-					};
-
-					CullConvex cull_convex;
-					cull_convex.result = &instance_shadow_cull_result;
-
-					p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(planes.ptr(), planes.size(), points.ptr(), points.size(), cull_convex);
-
-					Plane near_plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
-
-					RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
-
-					for (int j = 0; j < (int)instance_shadow_cull_result.size(); j++) {
-						Instance *instance = instance_shadow_cull_result[j];
-						if (!instance->visible || !((1 << instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-							continue;
-						} else {
-							if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-								animated_material_found = true;
-							}
-
-							if (instance->mesh_instance.is_valid()) {
-								RSG::storage->mesh_instance_check_for_update(instance->mesh_instance);
-							}
-						}
-
-						shadow_data.instances.push_back(static_cast<InstanceGeometryData *>(instance->base_data)->geometry_instance);
-					}
-
-					RSG::storage->update_mesh_instances();
+					_shadow_cull_job_add(p_instance, p_scenario, planes, p_cam_transform.origin);
 
 					scene_render->light_instance_set_shadow_transform(light->instance, CameraMatrix(), light_transform, radius, 0, i, 0);
+					RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
 					shadow_data.light = light->instance;
 					shadow_data.pass = i;
 				}
@@ -2073,47 +2303,10 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 
 					Transform xform = light_transform * Transform().looking_at(view_normals[i], view_up[i]);
 
-					Vector<Plane> planes = cm.get_projection_planes(xform);
-
-					instance_shadow_cull_result.clear();
+					_shadow_cull_job_add(p_instance, p_scenario, cm.get_projection_planes(xform), p_cam_transform.origin);
 
-					Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&planes[0], planes.size());
-
-					struct CullConvex {
-						PagedArray<Instance *> *result;
-						_FORCE_INLINE_ bool operator()(void *p_data) {
-							Instance *p_instance = (Instance *)p_data;
-							result->push_back(p_instance);
-							return false;
-						}
-					};
-
-					CullConvex cull_convex;
-					cull_convex.result = &instance_shadow_cull_result;
-
-					p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(planes.ptr(), planes.size(), points.ptr(), points.size(), cull_convex);
-
-					RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
-
-					for (int j = 0; j < (int)instance_shadow_cull_result.size(); j++) {
-						Instance *instance = instance_shadow_cull_result[j];
-						if (!instance->visible || !((1 << instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-							continue;
-						} else {
-							if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-								animated_material_found = true;
-							}
-							if (instance->mesh_instance.is_valid()) {
-								RSG::storage->mesh_instance_check_for_update(instance->mesh_instance);
-							}
-						}
-
-						shadow_data.instances.push_back(static_cast<InstanceGeometryData *>(instance->base_data)->geometry_instance);
-					}
-
-					RSG::storage->update_mesh_instances();
 					scene_render->light_instance_set_shadow_transform(light->instance, cm, xform, radius, 0, i, 0);
-
+					RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
 					shadow_data.light = light->instance;
 					shadow_data.pass = i;
 				}
@@ -2136,54 +2329,147 @@ bool RendererSceneCull::_light_instance_update_shadow(Instance *p_instance, cons
 			CameraMatrix cm;
 			cm.set_perspective(angle * 2.0, 1.0, 0.01, radius);
 
-			Vector<Plane> planes = cm.get_projection_planes(light_transform);
+			_shadow_cull_job_add(p_instance, p_scenario, cm.get_projection_planes(light_transform), p_cam_transform.origin);
 
-			instance_shadow_cull_result.clear();
+			scene_render->light_instance_set_shadow_transform(light->instance, cm, light_transform, radius, 0, 0, 0);
+			RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
+			shadow_data.light = light->instance;
+			shadow_data.pass = 0;
 
-			Vector<Vector3> points = Geometry3D::compute_convex_mesh_points(&planes[0], planes.size());
+		} break;
+	}
 
-			struct CullConvex {
-				PagedArray<Instance *> *result;
-				_FORCE_INLINE_ bool operator()(void *p_data) {
-					Instance *p_instance = (Instance *)p_data;
-					result->push_back(p_instance);
-					return false;
-				}
-			};
+	return false;
+}
 
-			CullConvex cull_convex;
-			cull_convex.result = &instance_shadow_cull_result;
+void RendererSceneCull::_shadow_cull_job_add(Instance *p_light, Scenario *p_scenario, const Vector<Plane> &p_planes, const Vector3 &p_camera_position) {
+	if (shadow_cull_job_count == shadow_cull_jobs.size()) {
+		shadow_cull_jobs.push_back(ShadowCullJob());
+	}
 
-			p_scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(planes.ptr(), planes.size(), points.ptr(), points.size(), cull_convex);
+	// Jobs are reused between frames to keep the memory of their mesh instance lists.
+	ShadowCullJob &job = shadow_cull_jobs[shadow_cull_job_count++];
+	job.light = p_light;
+	job.scenario = p_scenario;
+	job.instances = &render_shadow_data[max_shadows_used].instances;
+	job.planes = p_planes;
+	job.points = Geometry3D::compute_convex_mesh_points(p_planes.ptr(), p_planes.size());
+	job.camera_position = p_camera_position;
+	job.mesh_instances.clear();
+	job.animated_material_found = false;
+	job.time_usec = 0;
+}
 
-			RendererSceneRender::RenderShadowData &shadow_data = render_shadow_data[max_shadows_used++];
+void RendererSceneCull::_shadow_cull(ShadowCullJob &p_job) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
 
-			for (int j = 0; j < (int)instance_shadow_cull_result.size(); j++) {
-				Instance *instance = instance_shadow_cull_result[j];
-				if (!instance->visible || !((1 << instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-					continue;
-				} else {
-					if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-						animated_material_found = true;
-					}
+	// Runs on worker threads, anything touching storage is deferred to _render_scene().
+	struct CullConvex {
+		ShadowCullJob *job;
+		PagedArray<RendererSceneRender::GeometryInstance *> *result;
+		_FORCE_INLINE_ bool operator()(void *p_data) {
+			Instance *p_instance = (Instance *)p_data;
+			if (!p_instance->visible || !((1 << p_instance->base_type) & RS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(p_instance->base_data)->can_cast_shadows) {
+				return false;
+			}
 
-					if (instance->mesh_instance.is_valid()) {
-						RSG::storage->mesh_instance_check_for_update(instance->mesh_instance);
-					}
-				}
-				shadow_data.instances.push_back(static_cast<InstanceGeometryData *>(instance->base_data)->geometry_instance);
+			// Instances out of their draw range, or replaced by a proxy, don't cast shadows either.
+			if (_instance_uses_visibility_range(p_instance) && !_visibility_range_check(p_instance, job->camera_position)) {
+				return false;
 			}
 
-			RSG::storage->update_mesh_instances();
+			InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(p_instance->base_data);
+			if (geom->material_is_animated) {
+				job->animated_material_found = true;
+			}
 
-			scene_render->light_instance_set_shadow_transform(light->instance, cm, light_transform, radius, 0, 0, 0);
-			shadow_data.light = light->instance;
-			shadow_data.pass = 0;
+			if (p_instance->mesh_instance.is_valid()) {
+				job->mesh_instances.push_back(p_instance->mesh_instance);
+			}
 
-		} break;
+			result->push_back(geom->geometry_instance);
+			return false;
+		}
+	};
+
+	CullConvex cull_convex;
+	cull_convex.job = &p_job;
+	cull_convex.result = p_job.instances;
+
+	p_job.scenario->indexers[Scenario::INDEXER_GEOMETRY].convex_query(p_job.planes.ptr(), p_job.planes.size(), p_job.points.ptr(), p_job.points.size(), cull_convex);
+
+	p_job.time_usec = OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+void RendererSceneCull::_shadow_cull_jobs(ShadowCullJob *p_jobs, uint32_t p_count, ThreadWorkPool *p_pool) {
+	if (p_pool && p_count > 1) {
+		struct Worker {
+			void cull(uint32_t p_index, ShadowCullJob *p_jobs) {
+				_shadow_cull(p_jobs[p_index]);
+			}
+		} worker;
+		p_pool->do_work(p_count, &worker, &Worker::cull, p_jobs);
+	} else {
+		for (uint32_t i = 0; i < p_count; i++) {
+			_shadow_cull(p_jobs[i]);
+		}
 	}
+}
+
+void RendererSceneCull::_shadow_cull_jobs_process() {
+	if (shadow_cull_job_count == 0) {
+		return;
+	}
+
+	RENDER_TIMESTAMP(">Culling Positional Shadows");
+
+	ThreadWorkPool *pool = &RendererThreadPool::singleton->thread_work_pool;
+	_shadow_cull_jobs(shadow_cull_jobs.ptr(), shadow_cull_job_count, pool->get_thread_count() > 1 ? pool : nullptr);
+
+	for (uint32_t i = 0; i < shadow_cull_job_count; i++) {
+		ShadowCullJob &job = shadow_cull_jobs[i];
+
+		for (uint32_t j = 0; j < job.mesh_instances.size(); j++) {
+			RSG::storage->mesh_instance_check_for_update(job.mesh_instances[j]);
+		}
 
-	return animated_material_found;
+		if (job.animated_material_found) {
+			static_cast<InstanceLightData *>(job.light->base_data)->shadow_dirty = true;
+		}
+
+		// Passes of the same light are added one after the other.
+		if (shadow_cull_times.size() && shadow_cull_times[shadow_cull_times.size() - 1].instance == job.light->self) {
+			ShadowCullTime &time = shadow_cull_times[shadow_cull_times.size() - 1];
+			time.passes++;
+			time.usec += job.time_usec;
+		} else {
+			ShadowCullTime time;
+			time.instance = job.light->self;
+			time.passes = 1;
+			time.usec = job.time_usec;
+			shadow_cull_times.push_back(time);
+		}
+	}
+
+	RSG::storage->update_mesh_instances();
+
+	shadow_cull_job_count = 0;
+
+	RENDER_TIMESTAMP("<Culling Positional Shadows");
+}
+
+Array RendererSceneCull::get_shadow_cull_times() const {
+	Array ret;
+	shadow_cull_times_lock.lock();
+	for (uint32_t i = 0; i < shadow_cull_times_in_frame.size(); i++) {
+		Dictionary d;
+		d["instance"] = shadow_cull_times_in_frame[i].instance;
+		d["passes"] = shadow_cull_times_in_frame[i].passes;
+		d["time_usec"] = shadow_cull_times_in_frame[i].usec;
+		ret.push_back(d);
+	}
+	shadow_cull_times_lock.unlock();
+	return ret;
 }
 
 void RendererSceneCull::render_camera(RID p_render_buffers, RID p_camera, RID p_scenario, RID p_viewport, Size2 p_viewport_size, float p_screen_lod_threshold, RID p_shadow_atlas) {
@@ -2324,7 +2610,7 @@ void RendererSceneCull::render_camera(RID p_render_buffers, Ref<XRInterface> &p_
 };
 
 void RendererSceneCull::_frustum_cull_threaded(uint32_t p_thread, CullData *cull_data) {
-	uint32_t cull_total = cull_data->scenario->instance_data.size();
+	uint32_t cull_total = cull_data->scenario->instance_data.size() - cull_data->scenario->lod_hidden_count;
 	uint32_t total_threads = RendererThreadPool::singleton->thread_work_pool.get_thread_count();
 	uint32_t cull_from = p_thread * cull_total / total_threads;
 	uint32_t cull_to = (p_thread + 1 == total_threads) ? cull_total : ((p_thread + 1) * cull_total / total_threads);
@@ -2344,10 +2630,36 @@ void RendererSceneCull::_frustum_cull(CullData &cull_data, FrustumCullResult &cu
 	Transform inv_cam_transform = cull_data.cam_transform.inverse();
 	float z_near = cull_data.camera_matrix->get_z_near();
 
+	// Frustum tests are done in blocks of bounds (which never cross a page) so they can be vectorized.
+	uint8_t in_frustum[FRUSTUM_CULL_BLOCK_SIZE];
+	uint8_t in_cascade[RendererSceneRender::MAX_DIRECTIONAL_LIGHTS][RendererSceneRender::MAX_DIRECTIONAL_LIGHT_CASCADES][FRUSTUM_CULL_BLOCK_SIZE];
+	uint32_t block_pos = 0;
+	uint32_t block_size = 0;
+	const uint64_t page_size_mask = instance_aabb_page_pool.get_page_size_mask();
+
 	for (uint64_t i = p_from; i < p_to; i++) {
 		bool mesh_visible = false;
 
-		if (cull_data.scenario->instance_aabbs[i].in_frustum(cull_data.cull->frustum) && (cull_data.occlusion_buffer == nullptr || cull_data.scenario->instance_data[i].flags & InstanceData::FLAG_IGNORE_OCCLUSION_CULLING ||
+		if (block_pos == block_size) {
+			block_size = MIN(MIN(p_to - i, (uint64_t)FRUSTUM_CULL_BLOCK_SIZE), page_size_mask + 1 - (i & page_size_mask));
+			block_pos = 0;
+
+			const InstanceBounds *bounds = &cull_data.scenario->instance_aabbs[i];
+			InstanceBounds::cull_frustum(bounds, block_size, cull_data.cull->frustum, in_frustum);
+			for (uint32_t j = 0; j < cull_data.cull->shadow_count; j++) {
+				for (uint32_t k = 0; k < cull_data.cull->shadows[j].cascade_count; k++) {
+					InstanceBounds::cull_frustum(bounds, block_size, cull_data.cull->shadows[j].cascades[k].frustum, in_cascade[j][k]);
+				}
+			}
+		}
+
+		const uint32_t block_index = block_pos++;
+
+		if (cull_data.scenario->instance_data[i].flags & InstanceData::FLAG_VISIBILITY_RANGE && !_visibility_range_check(cull_data.scenario->instance_data[i].instance, cull_data.cam_transform.origin)) {
+			continue;
+		}
+
+		if (in_frustum[block_index] && (cull_data.occlusion_buffer == nullptr || cull_data.scenario->instance_data[i].flags & InstanceData::FLAG_IGNORE_OCCLUSION_CULLING ||
 																								 !cull_data.occlusion_buffer->is_occluded(cull_data.scenario->instance_aabbs[i].bounds, cull_data.cam_transform.origin, inv_cam_transform, *cull_data.camera_matrix, z_near))) {
 			InstanceData &idata = cull_data.scenario->instance_data[i];
 			uint32_t base_type = idata.flags & InstanceData::FLAG_BASE_TYPE_MASK;
@@ -2503,7 +2815,7 @@ void RendererSceneCull::_frustum_cull(CullData &cull_data, FrustumCullResult &cu
 
 		for (uint32_t j = 0; j < cull_data.cull->shadow_count; j++) {
 			for (uint32_t k = 0; k < cull_data.cull->shadows[j].cascade_count; k++) {
-				if (cull_data.scenario->instance_aabbs[i].in_frustum(cull_data.cull->shadows[j].cascades[k].frustum)) {
+				if (in_cascade[j][k][block_index]) {
 					InstanceData &idata = cull_data.scenario->instance_data[i];
 					uint32_t base_type = idata.flags & InstanceData::FLAG_BASE_TYPE_MASK;
 
@@ -2637,9 +2949,14 @@ void RendererSceneCull::_render_scene(const Transform &p_cam_transform, const Ca
 
 	frustum_cull_result.clear();
 
+	for (Set<Instance *>::Element *E = scenario->lod_proxy_roots.front(); E; E = E->next()) {
+		_update_lod_proxy(E->get(), p_cam_transform.origin, false);
+	}
+
 	{
+		// Instances replaced by a proxy are past the end of the range.
 		uint64_t cull_from = 0;
-		uint64_t cull_to = scenario->instance_data.size();
+		uint64_t cull_to = scenario->instance_data.size() - scenario->lod_hidden_count;
 
 		CullData cull_data;
 
@@ -2808,6 +3125,8 @@ void RendererSceneCull::_render_scene(const Transform &p_cam_transform, const Ca
 				light->shadow_dirty = redraw;
 			}
 		}
+
+		_shadow_cull_jobs_process();
 	}
 
 	//render SDFGI
@@ -3521,6 +3840,11 @@ void RendererSceneCull::update_dirty_instances() {
 }
 
 void RendererSceneCull::update() {
+	shadow_cull_times_lock.lock();
+	shadow_cull_times_in_frame = shadow_cull_times;
+	shadow_cull_times_lock.unlock();
+	shadow_cull_times.clear();
+
 	//optimize bvhs
 	for (uint32_t i = 0; i < scenario_owner.get_rid_count(); i++) {
 		Scenario *s = scenario_owner.get_ptr_by_index(i);
@@ -3573,6 +3897,11 @@ bool RendererSceneCull::free(RID p_rid) {
 		instance_geometry_set_material_override(p_rid, RID());
 		instance_attach_skeleton(p_rid, RID());
 
+		instance_geometry_set_as_instance_lod(p_rid, RID());
+		while (instance->lod_children.front()) {
+			instance_geometry_set_as_instance_lod(instance->lod_children.front()->get()->self, RID());
+		}
+
 		if (instance->instance_allocated_shader_parameters) {
 			//free the used shader parameters
 			RSG::storage->global_variables_instance_free(instance->self);
@@ -3610,7 +3939,6 @@ RendererSceneCull::RendererSceneCull() {
 	singleton = this;
 
 	instance_cull_result.set_page_pool(&instance_cull_page_pool);
-	instance_shadow_cull_result.set_page_pool(&instance_cull_page_pool);
 
 	for (uint32_t i = 0; i < MAX_UPDATE_SHADOWS; i++) {
 		render_shadow_data[i].instances.set_page_pool(&geometry_instance_cull_page_pool);
@@ -3629,12 +3957,12 @@ RendererSceneCull::RendererSceneCull() {
 	thread_cull_threshold = GLOBAL_GET("rendering/limits/spatial_indexer/threaded_cull_minimum_instances");
 	thread_cull_threshold = MAX(thread_cull_threshold, (uint32_t)RendererThreadPool::singleton->thread_work_pool.get_thread_count()); //make sure there is at least one thread per CPU
 
-	dummy_occlusion_culling = memnew(RendererSceneOcclusionCull);
+	// Replaced by the raycast module when it is available.
+	default_occlusion_culling = memnew(RendererSceneOcclusionCullRaster);
 }
 
 RendererSceneCull::~RendererSceneCull() {
 	instance_cull_result.reset();
-	instance_shadow_cull_result.reset();
 
 	for (uint32_t i = 0; i < MAX_UPDATE_SHADOWS; i++) {
 		render_shadow_data[i].instances.reset();
@@ -3649,7 +3977,7 @@ RendererSceneCull::~RendererSceneCull() {
 	}
 	frustum_cull_result_threads.clear();
 
-	if (dummy_occlusion_culling) {
-		memdelete(dummy_occlusion_culling);
+	if (default_occlusion_culling) {
+		memdelete(default_occlusion_culling);
 	}
 }
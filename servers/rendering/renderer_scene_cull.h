@@ -57,7 +57,8 @@ public:
 		SDFGI_MAX_CASCADES = 8,
 		SDFGI_MAX_REGIONS_PER_CASCADE = 3,
 		MAX_INSTANCE_PAIRS = 32,
-		MAX_UPDATE_SHADOWS = 512
+		MAX_UPDATE_SHADOWS = 512,
+		FRUSTUM_CULL_BLOCK_SIZE = 64
 	};
 
 	uint64_t render_pass;
@@ -117,7 +118,7 @@ public:
 	virtual void occluder_initialize(RID p_occluder);
 	virtual void occluder_set_mesh(RID p_occluder, const PackedVector3Array &p_vertices, const PackedInt32Array &p_indices);
 
-	RendererSceneOcclusionCull *dummy_occlusion_culling;
+	RendererSceneOcclusionCull *default_occlusion_culling;
 
 	/* SCENARIO API */
 
@@ -240,6 +241,10 @@ public:
 
 			return true;
 		}
+
+		// Same as calling in_frustum() on each of the bounds, writing one byte per bounds
+		// to r_inside. Tests four bounds at once on CPUs with SSE2 or NEON.
+		static void cull_frustum(const InstanceBounds *p_bounds, uint32_t p_count, const Frustum &p_frustum, uint8_t *r_inside);
 	};
 
 	struct InstanceData {
@@ -259,6 +264,7 @@ public:
 			FLAG_USES_MESH_INSTANCE = (1 << 17),
 			FLAG_REFLECTION_PROBE_DIRTY = (1 << 18),
 			FLAG_IGNORE_OCCLUSION_CULLING = (1 << 19),
+			FLAG_VISIBILITY_RANGE = (1 << 20),
 		};
 
 		uint32_t flags = 0;
@@ -300,6 +306,11 @@ public:
 		PagedArray<InstanceBounds> instance_aabbs;
 		PagedArray<InstanceData> instance_data;
 
+		// Instances replaced by a LOD proxy are moved to the end of the arrays above and culling
+		// stops before them, so a hidden subtree costs nothing per frame, see _instance_set_lod_hidden().
+		uint32_t lod_hidden_count = 0;
+		Set<Instance *> lod_proxy_roots; // Proxies in this scenario that are not the LOD of another instance.
+
 		Scenario() {
 			indexers[INDEXER_GEOMETRY].set_index(INDEXER_GEOMETRY);
 			indexers[INDEXER_VOLUMES].set_index(INDEXER_VOLUMES);
@@ -416,7 +427,10 @@ public:
 		float lod_end;
 		float lod_begin_hysteresis;
 		float lod_end_hysteresis;
-		RID lod_instance;
+		Instance *lod_parent = nullptr; // Proxy that replaces this instance once it enters its own draw range.
+		Set<Instance *> lod_children;
+		bool lod_children_hidden = false; // Whether this proxy or one above it has taken over, updated before every cull.
+		bool lod_hidden = false; // Whether the instance data is in the hidden tail of the scenario arrays.
 
 		Vector<Color> lightmap_target_sh; //target is used for incrementally changing the SH over time, this avoids pops in some corner cases and when going interior <-> exterior
 
@@ -715,7 +729,6 @@ public:
 	PagedArrayPool<RID> rid_cull_page_pool;
 
 	PagedArray<Instance *> instance_cull_result;
-	PagedArray<Instance *> instance_shadow_cull_result;
 
 	struct FrustumCullResult {
 		PagedArray<RendererSceneRender::GeometryInstance *> geometry_instances;
@@ -880,6 +893,45 @@ public:
 	virtual void instance_geometry_set_lightmap(RID p_instance, RID p_lightmap, const Rect2 &p_lightmap_uv_scale, int p_slice_index);
 	virtual void instance_geometry_set_lod_bias(RID p_instance, float p_lod_bias);
 
+	void _instance_update_visibility_range_flag(Instance *p_instance);
+
+	static void _scenario_swap_instances(Scenario *p_scenario, uint32_t p_index_a, uint32_t p_index_b);
+	static void _instance_set_lod_hidden(Instance *p_instance, bool p_hidden);
+	static void _lod_proxy_set_children_hidden(Instance *p_proxy, bool p_hidden);
+
+	// Decides, from the top of a proxy hierarchy down, which proxies replace their children.
+	// Only proxies are visited and each is tested once. Once a proxy has taken over, nothing
+	// below it is visited again until it switches back, so a far away region costs a single
+	// distance test no matter how many instances it contains. A proxy without a begin distance
+	// never replaces its children.
+	static void _update_lod_proxy(Instance *p_proxy, const Vector3 &p_camera_position, bool p_hidden);
+
+	static _FORCE_INLINE_ bool _instance_uses_visibility_range(const Instance *p_instance) {
+		return p_instance->lod_begin > 0 || p_instance->lod_end > 0 || p_instance->lod_parent;
+	}
+
+	// Whether the instance should be drawn from p_camera_position, given its own draw range
+	// and the proxies above it, as last updated by _update_lod_proxy().
+	static _FORCE_INLINE_ bool _visibility_range_check(const Instance *p_instance, const Vector3 &p_camera_position) {
+		if (p_instance->lod_parent && p_instance->lod_parent->lod_children_hidden) {
+			return false;
+		}
+
+		if (p_instance->lod_begin > 0 || p_instance->lod_end > 0) {
+			real_t dist_sq = p_camera_position.distance_squared_to(p_instance->transformed_aabb.position + p_instance->transformed_aabb.size * 0.5);
+			real_t begin = p_instance->lod_begin - p_instance->lod_begin_hysteresis;
+			if (begin > 0 && dist_sq < begin * begin) {
+				return false;
+			}
+			real_t end = p_instance->lod_end + p_instance->lod_end_hysteresis;
+			if (p_instance->lod_end > 0 && dist_sq > end * end) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	void _update_instance_shader_parameters_from_material(Map<StringName, Instance::InstanceShaderParameter> &isparams, const Map<StringName, Instance::InstanceShaderParameter> &existing_isparams, RID p_material);
 
 	virtual void instance_geometry_set_shader_parameter(RID p_instance, const StringName &p_parameter, const Variant &p_value);
@@ -897,6 +949,38 @@ public:
 
 	_FORCE_INLINE_ bool _light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, bool p_cam_vaspect, RID p_shadow_atlas, Scenario *p_scenario, float p_scren_lod_threshold);
 
+	// One per positional shadow pass, culled in parallel once all lights were set up.
+	struct ShadowCullJob {
+		Instance *light = nullptr;
+		Scenario *scenario = nullptr;
+		PagedArray<RendererSceneRender::GeometryInstance *> *instances = nullptr;
+		Vector<Plane> planes;
+		Vector<Vector3> points;
+		Vector3 camera_position; // Draw ranges are measured from the camera, not the light.
+		LocalVector<RID> mesh_instances;
+		bool animated_material_found = false;
+		uint64_t time_usec = 0;
+	};
+
+	LocalVector<ShadowCullJob> shadow_cull_jobs;
+	uint32_t shadow_cull_job_count = 0;
+
+	struct ShadowCullTime {
+		RID instance;
+		uint32_t passes = 0;
+		uint64_t usec = 0;
+	};
+
+	LocalVector<ShadowCullTime> shadow_cull_times;
+	LocalVector<ShadowCullTime> shadow_cull_times_in_frame;
+	mutable SpinLock shadow_cull_times_lock; // Times of the previous frame can be read from other threads.
+
+	void _shadow_cull_job_add(Instance *p_light, Scenario *p_scenario, const Vector<Plane> &p_planes, const Vector3 &p_camera_position);
+	static void _shadow_cull(ShadowCullJob &p_job);
+	// Culls all jobs, on the worker threads of p_pool if given.
+	static void _shadow_cull_jobs(ShadowCullJob *p_jobs, uint32_t p_count, ThreadWorkPool *p_pool);
+	void _shadow_cull_jobs_process();
+
 	RID _render_get_environment(RID p_camera, RID p_scenario);
 
 	struct Cull {
@@ -1066,6 +1150,8 @@ public:
 
 	virtual void update();
 
+	virtual Array get_shadow_cull_times() const;
+
 	bool free(RID p_rid);
 
 	void set_scene_render(RendererSceneRender *p_scene_render);
@@ -0,0 +1,450 @@
+/*************************************************************************/
+/*  renderer_scene_occlusion_cull_raster.cpp                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "renderer_scene_occlusion_cull_raster.h"
+
+#include "core/math/simd.h"
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::clear() {
+	HZBuffer::clear();
+
+	triangles.clear();
+	tile_triangles.clear();
+	tile_count = Size2i();
+}
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::resize(const Size2i &p_size) {
+	if (p_size == Size2i()) {
+		clear();
+		return;
+	}
+
+	if (!sizes.is_empty() && p_size == sizes[0]) {
+		return; // Size didn't change
+	}
+
+	HZBuffer::resize(p_size);
+
+	tile_count = Size2i((p_size.x + TILE_SIZE - 1) / TILE_SIZE, (p_size.y + TILE_SIZE - 1) / TILE_SIZE);
+	tile_triangles.resize(tile_count.x * tile_count.y);
+}
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::setup_camera(const CameraMatrix &p_cam_projection, bool p_cam_orthogonal) {
+	projection = p_cam_projection;
+	orthogonal = p_cam_orthogonal;
+	z_near = p_cam_projection.get_z_near();
+	z_far = p_cam_projection.get_z_far();
+	debug_tex_range = z_far * 1.05f;
+
+	if (!orthogonal) {
+		// The view space direction of each pixel ray is (slope.x, slope.y, -1).
+		CameraMatrix inv_projection = p_cam_projection.inverse();
+		Vector3 from = inv_projection.xform(Vector3(-1, -1, -1));
+		Vector3 to = inv_projection.xform(Vector3(1, 1, -1));
+		ray_slope_from = Vector2(from.x, from.y) / -from.z;
+		ray_slope_to = Vector2(to.x, to.y) / -to.z;
+	}
+
+	triangles.clear();
+}
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::add_triangle(const Vector3 &p_a, const Vector3 &p_b, const Vector3 &p_c) {
+	// Clip against the near plane, the other planes are handled by clamping to the buffer.
+	const Vector3 points[3] = { p_a, p_b, p_c };
+	const float clip_z = -z_near;
+
+	Vector3 clipped[4];
+	int clipped_count = 0;
+
+	for (int i = 0; i < 3; i++) {
+		const Vector3 &from = points[i];
+		const Vector3 &to = points[(i + 1) % 3];
+		bool from_inside = from.z <= clip_z;
+		bool to_inside = to.z <= clip_z;
+
+		if (from_inside) {
+			clipped[clipped_count++] = from;
+		}
+		if (from_inside != to_inside) {
+			float t = (clip_z - from.z) / (to.z - from.z);
+			clipped[clipped_count++] = from.lerp(to, t);
+		}
+	}
+
+	for (int i = 2; i < clipped_count; i++) {
+		_setup_triangle(clipped[0], clipped[i - 1], clipped[i]);
+	}
+}
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::_setup_triangle(const Vector3 &p_a, const Vector3 &p_b, const Vector3 &p_c) {
+	const Size2i &size = sizes[0];
+	const Vector2 scale = Vector2(size.x - 1, size.y - 1) * 0.5;
+
+	Vector2 v[3];
+	float d[3];
+	const Vector3 points[3] = { p_a, p_b, p_c };
+	for (int i = 0; i < 3; i++) {
+		Vector3 ndc = projection.xform(points[i]);
+		v[i] = (Vector2(ndc.x, ndc.y) + Vector2(1, 1)) * scale;
+		d[i] = orthogonal ? -points[i].z : 1.0 / -points[i].z;
+	}
+
+	float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+	if (Math::abs(area) < CMP_EPSILON) {
+		return;
+	}
+	if (area < 0) {
+		SWAP(v[1], v[2]);
+		SWAP(d[1], d[2]);
+		area = -area;
+	}
+
+	Triangle tri;
+	tri.min_x = MAX(0, (int)Math::ceil(MIN(v[0].x, MIN(v[1].x, v[2].x))));
+	tri.min_y = MAX(0, (int)Math::ceil(MIN(v[0].y, MIN(v[1].y, v[2].y))));
+	tri.max_x = MIN(size.x - 1, (int)Math::floor(MAX(v[0].x, MAX(v[1].x, v[2].x))));
+	tri.max_y = MIN(size.y - 1, (int)Math::floor(MAX(v[0].y, MAX(v[1].y, v[2].y))));
+	if (tri.min_x > tri.max_x || tri.min_y > tri.max_y) {
+		return;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		const Vector2 &from = v[i];
+		const Vector2 &to = v[(i + 1) % 3];
+		tri.edge_a[i] = from.y - to.y;
+		tri.edge_b[i] = to.x - from.x;
+		tri.edge_c[i] = -(tri.edge_a[i] * from.x + tri.edge_b[i] * from.y);
+	}
+
+	tri.depth_a = ((d[1] - d[0]) * (v[2].y - v[0].y) - (d[2] - d[0]) * (v[1].y - v[0].y)) / area;
+	tri.depth_b = ((d[2] - d[0]) * (v[1].x - v[0].x) - (d[1] - d[0]) * (v[2].x - v[0].x)) / area;
+	tri.depth_c = d[0] - tri.depth_a * v[0].x - tri.depth_b * v[0].y;
+
+	triangles.push_back(tri);
+}
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::bin_triangles() {
+	for (uint32_t i = 0; i < tile_triangles.size(); i++) {
+		tile_triangles[i].clear();
+	}
+
+	for (uint32_t i = 0; i < triangles.size(); i++) {
+		const Triangle &tri = triangles[i];
+		for (int y = tri.min_y / TILE_SIZE; y <= tri.max_y / TILE_SIZE; y++) {
+			for (int x = tri.min_x / TILE_SIZE; x <= tri.max_x / TILE_SIZE; x++) {
+				tile_triangles[y * tile_count.x + x].push_back(i);
+			}
+		}
+	}
+}
+
+void RendererSceneOcclusionCullRaster::RasterHZBuffer::rasterize_tile(uint32_t p_tile, void *p_userdata) {
+	const Size2i &size = sizes[0];
+	const int tile_x = (p_tile % tile_count.x) * TILE_SIZE;
+	const int tile_y = (p_tile / tile_count.x) * TILE_SIZE;
+	const int tile_w = MIN(TILE_SIZE, size.x - tile_x);
+	const int tile_h = MIN(TILE_SIZE, size.y - tile_y);
+
+	// View depth of the closest occluder for each pixel of the tile.
+	float depth[TILE_SIZE * TILE_SIZE];
+	for (int i = 0; i < TILE_SIZE * TILE_SIZE; i++) {
+		depth[i] = FLT_MAX;
+	}
+
+	const LocalVector<uint32_t> &tile_list = tile_triangles[p_tile];
+	for (uint32_t i = 0; i < tile_list.size(); i++) {
+		const Triangle &tri = triangles[tile_list[i]];
+
+		const int from_x = MAX(tri.min_x, tile_x);
+		const int to_x = MIN(tri.max_x, tile_x + tile_w - 1);
+		const int from_y = MAX(tri.min_y, tile_y);
+		const int to_y = MIN(tri.max_y, tile_y + tile_h - 1);
+
+		for (int y = from_y; y <= to_y; y++) {
+			float *row = &depth[(y - tile_y) * TILE_SIZE];
+			const float fy = y;
+			const float row_e0 = tri.edge_b[0] * fy + tri.edge_c[0];
+			const float row_e1 = tri.edge_b[1] * fy + tri.edge_c[1];
+			const float row_e2 = tri.edge_b[2] * fy + tri.edge_c[2];
+			const float row_d = tri.depth_b * fy + tri.depth_c;
+
+			int x = from_x;
+#if defined(SIMD_SSE2) && !defined(REAL_T_IS_DOUBLE)
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 far_depth = _mm_set1_ps(FLT_MAX);
+			const __m128 one = _mm_set1_ps(1.0f);
+			for (; x + 4 <= to_x + 1; x += 4) {
+				const __m128 fx = _mm_add_ps(_mm_set1_ps(float(x)), _mm_set_ps(3, 2, 1, 0));
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(tri.edge_a[0])), _mm_set1_ps(row_e0)), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(tri.edge_a[1])), _mm_set1_ps(row_e1)), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(tri.edge_a[2])), _mm_set1_ps(row_e2)), zero));
+				if (_mm_movemask_ps(inside) == 0) {
+					continue;
+				}
+
+				__m128 d = _mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(tri.depth_a)), _mm_set1_ps(row_d));
+				if (!orthogonal) {
+					d = _mm_div_ps(one, d);
+				}
+				d = _mm_or_ps(_mm_and_ps(inside, d), _mm_andnot_ps(inside, far_depth));
+				_mm_storeu_ps(&row[x - tile_x], _mm_min_ps(_mm_loadu_ps(&row[x - tile_x]), d));
+			}
+#endif
+			for (; x <= to_x; x++) {
+				const float fx = x;
+				if (tri.edge_a[0] * fx + row_e0 < 0 || tri.edge_a[1] * fx + row_e1 < 0 || tri.edge_a[2] * fx + row_e2 < 0) {
+					continue;
+				}
+				float d = tri.depth_a * fx + row_d;
+				if (!orthogonal) {
+					d = 1.0f / d;
+				}
+				row[x - tile_x] = MIN(row[x - tile_x], d);
+			}
+		}
+	}
+
+	// Convert to the distance along each pixel ray from the near plane, like the raycast backend.
+	const float max_distance = z_far * 1.05f;
+	const Vector2 slope_step = size.x > 1 && size.y > 1 ? (ray_slope_to - ray_slope_from) / Vector2(size.x - 1, size.y - 1) : Vector2();
+	float *write = mips[0];
+	for (int y = 0; y < tile_h; y++) {
+		for (int x = 0; x < tile_w; x++) {
+			float d = depth[y * TILE_SIZE + x];
+			float distance = max_distance;
+			if (d != FLT_MAX) {
+				if (orthogonal) {
+					distance = d - z_near;
+				} else {
+					Vector2 slope = ray_slope_from + slope_step * Vector2(tile_x + x, tile_y + y);
+					distance = (d - z_near) * Math::sqrt(1.0f + slope.x * slope.x + slope.y * slope.y);
+				}
+				distance = MIN(distance, max_distance);
+			}
+			write[(tile_y + y) * size.x + tile_x + x] = distance;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////
+
+bool RendererSceneOcclusionCullRaster::is_occluder(RID p_rid) {
+	return occluder_owner.owns(p_rid);
+}
+
+RID RendererSceneOcclusionCullRaster::occluder_allocate() {
+	return occluder_owner.allocate_rid();
+}
+
+void RendererSceneOcclusionCullRaster::occluder_initialize(RID p_occluder) {
+	Occluder *occluder = memnew(Occluder);
+	occluder_owner.initialize_rid(p_occluder, occluder);
+}
+
+void RendererSceneOcclusionCullRaster::occluder_set_mesh(RID p_occluder, const PackedVector3Array &p_vertices, const PackedInt32Array &p_indices) {
+	Occluder *occluder = occluder_owner.getornull(p_occluder);
+	ERR_FAIL_COND(!occluder);
+
+	occluder->vertices = p_vertices;
+	occluder->indices = p_indices;
+}
+
+void RendererSceneOcclusionCullRaster::free_occluder(RID p_occluder) {
+	Occluder *occluder = occluder_owner.getornull(p_occluder);
+	ERR_FAIL_COND(!occluder);
+
+	for (Set<InstanceID>::Element *E = occluder->users.front(); E; E = E->next()) {
+		Scenario *scenario = scenarios.getptr(E->get().scenario);
+		if (scenario && scenario->instances.has(E->get().instance)) {
+			scenario->instances[E->get().instance].occluder = RID();
+		}
+	}
+
+	memdelete(occluder);
+	occluder_owner.free(p_occluder);
+}
+
+////////////////////////////////////////////////////////
+
+void RendererSceneOcclusionCullRaster::add_scenario(RID p_scenario) {
+	if (!scenarios.has(p_scenario)) {
+		scenarios[p_scenario] = Scenario();
+	}
+}
+
+void RendererSceneOcclusionCullRaster::remove_scenario(RID p_scenario) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	Scenario &scenario = scenarios[p_scenario];
+
+	const RID *instance_rid = nullptr;
+	while ((instance_rid = scenario.instances.next(instance_rid))) {
+		Occluder *occluder = occluder_owner.getornull(scenario.instances[*instance_rid].occluder);
+		if (occluder) {
+			occluder->users.erase(InstanceID(p_scenario, *instance_rid));
+		}
+	}
+
+	scenarios.erase(p_scenario);
+}
+
+void RendererSceneOcclusionCullRaster::scenario_set_instance(RID p_scenario, RID p_instance, RID p_occluder, const Transform &p_xform, bool p_enabled) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	Scenario &scenario = scenarios[p_scenario];
+
+	if (!scenario.instances.has(p_instance)) {
+		scenario.instances[p_instance] = OccluderInstance();
+	}
+
+	OccluderInstance &instance = scenario.instances[p_instance];
+
+	if (instance.occluder != p_occluder) {
+		Occluder *old_occluder = occluder_owner.getornull(instance.occluder);
+		if (old_occluder) {
+			old_occluder->users.erase(InstanceID(p_scenario, p_instance));
+		}
+
+		instance.occluder = p_occluder;
+
+		if (p_occluder.is_valid()) {
+			Occluder *occluder = occluder_owner.getornull(p_occluder);
+			ERR_FAIL_COND(!occluder);
+			occluder->users.insert(InstanceID(p_scenario, p_instance));
+		}
+	}
+
+	instance.xform = p_xform;
+	instance.enabled = p_enabled;
+}
+
+void RendererSceneOcclusionCullRaster::scenario_remove_instance(RID p_scenario, RID p_instance) {
+	ERR_FAIL_COND(!scenarios.has(p_scenario));
+	Scenario &scenario = scenarios[p_scenario];
+
+	if (scenario.instances.has(p_instance)) {
+		Occluder *occluder = occluder_owner.getornull(scenario.instances[p_instance].occluder);
+		if (occluder) {
+			occluder->users.erase(InstanceID(p_scenario, p_instance));
+		}
+		scenario.instances.erase(p_instance);
+	}
+}
+
+////////////////////////////////////////////////////////
+
+void RendererSceneOcclusionCullRaster::add_buffer(RID p_buffer) {
+	ERR_FAIL_COND(buffers.has(p_buffer));
+	buffers[p_buffer] = RasterHZBuffer();
+}
+
+void RendererSceneOcclusionCullRaster::remove_buffer(RID p_buffer) {
+	ERR_FAIL_COND(!buffers.has(p_buffer));
+	buffers.erase(p_buffer);
+}
+
+void RendererSceneOcclusionCullRaster::buffer_set_scenario(RID p_buffer, RID p_scenario) {
+	ERR_FAIL_COND(!buffers.has(p_buffer));
+	ERR_FAIL_COND(p_scenario.is_valid() && !scenarios.has(p_scenario));
+	buffers[p_buffer].scenario_rid = p_scenario;
+}
+
+void RendererSceneOcclusionCullRaster::buffer_set_size(RID p_buffer, const Vector2i &p_size) {
+	ERR_FAIL_COND(!buffers.has(p_buffer));
+	buffers[p_buffer].resize(p_size);
+}
+
+void RendererSceneOcclusionCullRaster::buffer_update(RID p_buffer, const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, ThreadWorkPool &p_thread_pool) {
+	if (!buffers.has(p_buffer)) {
+		return;
+	}
+
+	RasterHZBuffer &buffer = buffers[p_buffer];
+
+	if (buffer.is_empty() || !scenarios.has(buffer.scenario_rid)) {
+		return;
+	}
+
+	Scenario &scenario = scenarios[buffer.scenario_rid];
+	Transform inv_cam_transform = p_cam_transform.affine_inverse();
+
+	buffer.setup_camera(p_cam_projection, p_cam_orthogonal);
+
+	const RID *instance_rid = nullptr;
+	while ((instance_rid = scenario.instances.next(instance_rid))) {
+		const OccluderInstance &instance = scenario.instances[*instance_rid];
+		const Occluder *occluder = occluder_owner.getornull(instance.occluder);
+		if (!occluder || !instance.enabled) {
+			continue;
+		}
+
+		const Transform to_view = inv_cam_transform * instance.xform;
+		const int vertex_count = occluder->vertices.size();
+		const Vector3 *vertices = occluder->vertices.ptr();
+
+		view_vertices.resize(vertex_count);
+		for (int i = 0; i < vertex_count; i++) {
+			view_vertices[i] = to_view.xform(vertices[i]);
+		}
+
+		const int index_count = occluder->indices.size();
+		const int32_t *indices = occluder->indices.ptr();
+		for (int i = 0; i + 2 < index_count; i += 3) {
+			ERR_CONTINUE(indices[i] < 0 || indices[i] >= vertex_count || indices[i + 1] < 0 || indices[i + 1] >= vertex_count || indices[i + 2] < 0 || indices[i + 2] >= vertex_count);
+			buffer.add_triangle(view_vertices[indices[i]], view_vertices[indices[i + 1]], view_vertices[indices[i + 2]]);
+		}
+	}
+
+	buffer.bin_triangles();
+	p_thread_pool.do_work(buffer.tile_count.x * buffer.tile_count.y, &buffer, &RasterHZBuffer::rasterize_tile, (void *)nullptr);
+	buffer.update_mips();
+}
+
+RendererSceneOcclusionCullRaster::HZBuffer *RendererSceneOcclusionCullRaster::buffer_get_ptr(RID p_buffer) {
+	if (!buffers.has(p_buffer)) {
+		return nullptr;
+	}
+	return &buffers[p_buffer];
+}
+
+RID RendererSceneOcclusionCullRaster::buffer_get_debug_texture(RID p_buffer) {
+	ERR_FAIL_COND_V(!buffers.has(p_buffer), RID());
+	return buffers[p_buffer].get_debug_texture();
+}
+
+RendererSceneOcclusionCullRaster::RendererSceneOcclusionCullRaster() {
+}
+
+RendererSceneOcclusionCullRaster::~RendererSceneOcclusionCullRaster() {
+	List<RID> owned;
+	occluder_owner.get_owned_list(&owned);
+	for (List<RID>::Element *E = owned.front(); E; E = E->next()) {
+		memdelete(occluder_owner.getornull(E->get()));
+		occluder_owner.free(E->get());
+	}
+}
@@ -0,0 +1,154 @@
+/*************************************************************************/
+/*  renderer_scene_occlusion_cull_raster.h                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
+#define RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
+
+#include "core/templates/hash_map.h"
+#include "core/templates/rid_owner.h"
+#include "core/templates/set.h"
+#include "servers/rendering/renderer_scene_occlusion_cull.h"
+
+// Builds the occlusion buffer by rasterizing occluder meshes on the CPU.
+// Used when the raycast module (Embree) is not available or not wanted.
+// Produces the same depth metric as the raycast backend (distance along each
+// pixel ray from the near plane), so HZBuffer::is_occluded() works unchanged.
+class RendererSceneOcclusionCullRaster : public RendererSceneOcclusionCull {
+public:
+	enum {
+		TILE_SIZE = 32,
+	};
+
+	struct Triangle {
+		// Edge functions (a * x + b * y + c), positive inside.
+		float edge_a[3];
+		float edge_b[3];
+		float edge_c[3];
+		// Depth plane, 1/depth for perspective cameras and depth for orthogonal ones (linear in screen space).
+		float depth_a;
+		float depth_b;
+		float depth_c;
+		// Covered pixels, clamped to the buffer.
+		int min_x;
+		int min_y;
+		int max_x;
+		int max_y;
+	};
+
+	class RasterHZBuffer : public HZBuffer {
+	public:
+		RID scenario_rid;
+
+		CameraMatrix projection;
+		Size2i tile_count;
+		LocalVector<Triangle> triangles;
+		LocalVector<LocalVector<uint32_t>> tile_triangles;
+
+		// Pixel ray length per unit of view depth, varies linearly with the pixel position.
+		Vector2 ray_slope_from;
+		Vector2 ray_slope_to;
+		float z_near = 0.0;
+		float z_far = 0.0;
+		bool orthogonal = false;
+
+		virtual void clear() override;
+		virtual void resize(const Size2i &p_size) override;
+
+		void setup_camera(const CameraMatrix &p_cam_projection, bool p_cam_orthogonal);
+		void add_triangle(const Vector3 &p_a, const Vector3 &p_b, const Vector3 &p_c);
+		void _setup_triangle(const Vector3 &p_a, const Vector3 &p_b, const Vector3 &p_c);
+		void bin_triangles();
+		void rasterize_tile(uint32_t p_tile, void *p_userdata);
+	};
+
+private:
+	struct InstanceID {
+		RID scenario;
+		RID instance;
+
+		bool operator<(const InstanceID &rhs) const {
+			if (instance == rhs.instance) {
+				return rhs.scenario < scenario;
+			}
+			return instance < rhs.instance;
+		}
+
+		InstanceID() {}
+		InstanceID(RID s, RID i) :
+				scenario(s), instance(i) {}
+	};
+
+	struct Occluder {
+		PackedVector3Array vertices;
+		PackedInt32Array indices;
+		Set<InstanceID> users;
+	};
+
+	struct OccluderInstance {
+		RID occluder;
+		Transform xform;
+		bool enabled = true;
+	};
+
+	struct Scenario {
+		HashMap<RID, OccluderInstance> instances;
+	};
+
+	RID_PtrOwner<Occluder> occluder_owner;
+	HashMap<RID, Scenario> scenarios;
+	HashMap<RID, RasterHZBuffer> buffers;
+
+	LocalVector<Vector3> view_vertices;
+
+public:
+	virtual bool is_occluder(RID p_rid) override;
+	virtual RID occluder_allocate() override;
+	virtual void occluder_initialize(RID p_occluder) override;
+	virtual void occluder_set_mesh(RID p_occluder, const PackedVector3Array &p_vertices, const PackedInt32Array &p_indices) override;
+	virtual void free_occluder(RID p_occluder) override;
+
+	virtual void add_scenario(RID p_scenario) override;
+	virtual void remove_scenario(RID p_scenario) override;
+	virtual void scenario_set_instance(RID p_scenario, RID p_instance, RID p_occluder, const Transform &p_xform, bool p_enabled) override;
+	virtual void scenario_remove_instance(RID p_scenario, RID p_instance) override;
+
+	virtual void add_buffer(RID p_buffer) override;
+	virtual void remove_buffer(RID p_buffer) override;
+	virtual HZBuffer *buffer_get_ptr(RID p_buffer) override;
+	virtual void buffer_set_scenario(RID p_buffer, RID p_scenario) override;
+	virtual void buffer_set_size(RID p_buffer, const Vector2i &p_size) override;
+	virtual void buffer_update(RID p_buffer, const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, ThreadWorkPool &p_thread_pool) override;
+	virtual RID buffer_get_debug_texture(RID p_buffer) override;
+
+	RendererSceneOcclusionCullRaster();
+	~RendererSceneOcclusionCullRaster();
+};
+
+#endif // RENDERER_SCENE_OCCLUSION_CULL_RASTER_H
@@ -105,10 +105,12 @@ public:
 
 	typedef Vector<uint8_t> (*ShaderCompileFunction)(ShaderStage p_stage, const String &p_source_code, ShaderLanguage p_language, String *r_error, const Capabilities *p_capabilities);
 	typedef Vector<uint8_t> (*ShaderCacheFunction)(ShaderStage p_stage, const String &p_source_code, ShaderLanguage p_language);
+	typedef void (*ShaderCacheStoreFunction)(ShaderStage p_stage, const String &p_source_code, ShaderLanguage p_language, const Vector<uint8_t> &p_spirv);
 
 private:
 	static ShaderCompileFunction compile_function;
 	static ShaderCacheFunction cache_function;
+	static ShaderCacheStoreFunction cache_store_function;
 
 	static RenderingDevice *singleton;
 
@@ -638,6 +640,7 @@ public:
 
 	static void shader_set_compile_function(ShaderCompileFunction p_function);
 	static void shader_set_cache_function(ShaderCacheFunction p_function);
+	static void shader_set_cache_store_function(ShaderCacheStoreFunction p_function);
 
 	struct ShaderStageData {
 		ShaderStage shader_stage;
@@ -97,6 +97,12 @@ void RenderingServerDefault::_draw(bool p_swap_buffers, double frame_step) {
 
 	changes = 0;
 
+	CommandQueueMT::Stats stats = command_queue.get_stats();
+	command_queue_frame_stats.commands_flushed = stats.commands_flushed - command_queue_stats.commands_flushed;
+	command_queue_frame_stats.sync_wait_usec = stats.sync_wait_usec - command_queue_stats.sync_wait_usec;
+	command_queue_frame_stats.flush_wait_usec = stats.flush_wait_usec - command_queue_stats.flush_wait_usec;
+	command_queue_stats = stats;
+
 	RSG::rasterizer->begin_frame(frame_step);
 
 	TIMESTAMP_BEGIN()
@@ -112,6 +118,7 @@ void RenderingServerDefault::_draw(bool p_swap_buffers, double frame_step) {
 	RSG::scene->render_probes();
 
 	RSG::viewport->draw_viewports();
+	RSG::canvas->update_frame_stats();
 	RSG::canvas_render->update();
 
 	_draw_margins();
@@ -213,6 +220,10 @@ float RenderingServerDefault::get_frame_setup_time_cpu() const {
 	return frame_setup_time;
 }
 
+Array RenderingServerDefault::get_shadow_cull_times() const {
+	return RSG::scene->get_shadow_cull_times();
+}
+
 bool RenderingServerDefault::has_changed() const {
 	return changes > 0;
 }
@@ -258,6 +269,18 @@ void RenderingServerDefault::finish() {
 /* STATUS INFORMATION */
 
 uint64_t RenderingServerDefault::get_render_info(RenderInfo p_info) {
+	switch (p_info) {
+		case INFO_CANVAS_ITEMS_RECOMPUTED_IN_FRAME:
+			return RSG::canvas->get_items_recomputed_in_frame();
+		case INFO_COMMANDS_IN_FRAME:
+			return command_queue_frame_stats.commands_flushed;
+		case INFO_SYNC_WAIT_USEC_IN_FRAME:
+			return command_queue_frame_stats.sync_wait_usec;
+		case INFO_COMMAND_WAIT_USEC_IN_FRAME:
+			return command_queue_frame_stats.flush_wait_usec;
+		default:
+			break;
+	}
 	return RSG::storage->get_render_info(p_info);
 }
 
@@ -357,8 +380,8 @@ void RenderingServerDefault::_thread_loop() {
 
 	draw_thread_up.set();
 	while (!exit.is_set()) {
-		// flush commands one by one, until exit is requested
-		command_queue.wait_and_flush_one();
+		// flush commands as they come, until exit is requested
+		command_queue.wait_and_flush();
 	}
 
 	command_queue.flush_all(); // flush all
@@ -77,6 +77,9 @@ class RenderingServerDefault : public RenderingServer {
 
 	float frame_setup_time = 0;
 
+	CommandQueueMT::Stats command_queue_stats; // When the last frame started.
+	CommandQueueMT::Stats command_queue_frame_stats; // During the last frame.
+
 	//for printing
 	bool print_gpu_profile = false;
 	OrderedHashMap<String, float> print_gpu_profile_task_time;
@@ -763,6 +766,7 @@ public:
 	FUNC2(canvas_set_modulate, RID, const Color &)
 	FUNC3(canvas_set_parent, RID, RID, float)
 	FUNC1(canvas_set_disable_scale, bool)
+	FUNC2(canvas_set_use_spatial_index, RID, bool)
 
 	FUNCRIDSPLIT(canvas_texture)
 	FUNC3(canvas_texture_set_channel, RID, CanvasTextureChannel, RID)
@@ -928,6 +932,7 @@ public:
 	/* TESTING */
 
 	virtual float get_frame_setup_time_cpu() const override;
+	virtual Array get_shadow_cull_times() const override;
 
 	virtual void set_boot_image(const Ref<Image> &p_image, const Color &p_color, bool p_scale, bool p_use_filter = true) override;
 	virtual void set_default_clear_color(const Color &p_color) override;
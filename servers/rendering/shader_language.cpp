@@ -239,9 +239,6 @@ ShaderLanguage::Token ShaderLanguage::_make_token(TokenType p_type, const String
 	tk.type = p_type;
 	tk.text = p_text;
 	tk.line = tk_line;
-	if (tk.type == TK_ERROR) {
-		_set_error(p_text);
-	}
 	return tk;
 }
 
@@ -333,7 +330,22 @@ const ShaderLanguage::KeyWord ShaderLanguage::keyword_list[] = {
 	{ TK_ERROR, nullptr }
 };
 
-ShaderLanguage::Token ShaderLanguage::_get_token() {
+const HashMap<String, ShaderLanguage::TokenType> &ShaderLanguage::_get_keyword_map() {
+	struct KeywordMap {
+		HashMap<String, TokenType> map;
+
+		KeywordMap() {
+			for (int i = 0; keyword_list[i].text; i++) {
+				map[keyword_list[i].text] = keyword_list[i].token;
+			}
+		}
+	};
+
+	static const KeywordMap keywords;
+	return keywords.map;
+}
+
+ShaderLanguage::Token ShaderLanguage::_lex_token() {
 #define GETCHAR(m_idx) (((char_idx + m_idx) < code.length()) ? code[char_idx + m_idx] : char32_t(0))
 
 	while (true) {
@@ -544,7 +556,6 @@ ShaderLanguage::Token ShaderLanguage::_get_token() {
 					bool sign_found = false;
 					bool float_suffix_found = false;
 
-					String str;
 					int i = 0;
 
 					while (true) {
@@ -554,7 +565,7 @@ ShaderLanguage::Token ShaderLanguage::_get_token() {
 							}
 							period_found = true;
 						} else if (GETCHAR(i) == 'x') {
-							if (hexa_found || str.length() != 1 || str[0] != '0') {
+							if (hexa_found || i != 1 || GETCHAR(0) != '0') {
 								return _make_token(TK_ERROR, "Invalid numeric constant");
 							}
 							hexa_found = true;
@@ -582,10 +593,10 @@ ShaderLanguage::Token ShaderLanguage::_get_token() {
 							break;
 						}
 
-						str += char32_t(GETCHAR(i));
 						i++;
 					}
 
+					String str = code.substr(char_idx, i);
 					char32_t last_char = str[str.length() - 1];
 
 					if (hexa_found) {
@@ -660,25 +671,23 @@ ShaderLanguage::Token ShaderLanguage::_get_token() {
 
 				if (_is_text_char(GETCHAR(0))) {
 					// parse identifier
-					String str;
+					int start = char_idx;
 
 					while (_is_text_char(GETCHAR(0))) {
-						str += char32_t(GETCHAR(0));
 						char_idx++;
 					}
 
-					//see if keyword
-					//should be converted to a static map
-					int idx = 0;
+					String str = code.substr(start, char_idx - start);
 
-					while (keyword_list[idx].text) {
-						if (str == keyword_list[idx].text) {
-							return _make_token(keyword_list[idx].token);
-						}
-						idx++;
+					//see if keyword
+					const TokenType *keyword = _get_keyword_map().getptr(str);
+					if (keyword) {
+						return _make_token(*keyword);
 					}
 
-					str = str.replace("dus_", "_");
+					if (str.find("dus_") != -1) {
+						str = str.replace("dus_", "_");
+					}
 
 					return _make_token(TK_IDENTIFIER, str);
 				}
@@ -698,10 +707,41 @@ ShaderLanguage::Token ShaderLanguage::_get_token() {
 #undef GETCHAR
 }
 
+void ShaderLanguage::_tokenize() {
+	tokens.clear();
+	token_idx = 0;
+	char_idx = 0;
+	tk_line = 1;
+
+	while (true) {
+		Token tk = _lex_token();
+		tokens.push_back(tk);
+		if (tk.type == TK_EOF || tk.type == TK_ERROR) {
+			break;
+		}
+	}
+
+	tk_line = 1;
+}
+
+ShaderLanguage::Token ShaderLanguage::_get_token() {
+	const Token &tk = tokens[token_idx];
+	if (token_idx < (int)tokens.size() - 1) {
+		token_idx++; // Keep returning the last token once the end is reached.
+	}
+
+	tk_line = tk.line;
+	if (tk.type == TK_ERROR) {
+		_set_error(tk.text);
+	}
+	return tk;
+}
+
 String ShaderLanguage::token_debug(const String &p_code) {
 	clear();
 
 	code = p_code;
+	_tokenize();
 
 	String output;
 
@@ -914,11 +954,33 @@ void ShaderLanguage::clear() {
 	error_set = false;
 	error_str = "";
 	last_const = false;
+	tokens.clear();
+	token_idx = 0;
+
 	while (nodes) {
 		Node *n = nodes;
 		nodes = nodes->next;
-		memdelete(n);
+		n->~Node();
+	}
+	node_pages_used = 0;
+	node_page_offset = 0;
+}
+
+void *ShaderLanguage::_alloc_node_memory(size_t p_size) {
+	p_size = (p_size + 15) & ~size_t(15);
+	CRASH_COND(p_size > NODE_PAGE_SIZE);
+
+	if (node_pages_used == 0 || node_page_offset + p_size > NODE_PAGE_SIZE) {
+		if (node_pages_used == node_pages.size()) {
+			node_pages.push_back((uint8_t *)memalloc(NODE_PAGE_SIZE));
+		}
+		node_pages_used++;
+		node_page_offset = 0;
 	}
+
+	void *mem = node_pages[node_pages_used - 1] + node_page_offset;
+	node_page_offset += p_size;
+	return mem;
 }
 
 bool ShaderLanguage::_find_identifier(const BlockNode *p_block, bool p_allow_reassign, const FunctionInfo &p_function_info, const StringName &p_identifier, DataType *r_data_type, IdentifierType *r_type, bool *r_is_const, int *r_array_size, StringName *r_struct_name, ConstantNode::Value *r_constant_value) {
@@ -7002,7 +7064,7 @@ Error ShaderLanguage::_parse_shader(const Map<StringName, FunctionInfo> &p_funct
 									}
 								}
 
-								ConstantNode *expr = memnew(ConstantNode);
+								ConstantNode *expr = alloc_node<ConstantNode>();
 
 								expr->datatype = constant.type;
 
@@ -7451,6 +7513,7 @@ Error ShaderLanguage::compile(const String &p_code, const Map<StringName, Functi
 	varying_function_names = p_varying_function_names;
 
 	nodes = nullptr;
+	_tokenize();
 
 	shader = alloc_node<ShaderNode>();
 	Error err = _parse_shader(p_functions, p_render_modes, p_shader_types);
@@ -7469,6 +7532,7 @@ Error ShaderLanguage::complete(const String &p_code, const Map<StringName, Funct
 
 	nodes = nullptr;
 	global_var_get_type_func = p_global_variable_type_func;
+	_tokenize();
 
 	shader = alloc_node<ShaderNode>();
 	_parse_shader(p_functions, p_render_modes, p_shader_types);
@@ -7863,9 +7927,13 @@ ShaderLanguage::ShaderNode *ShaderLanguage::get_shader() {
 
 ShaderLanguage::ShaderLanguage() {
 	nodes = nullptr;
+	token_idx = 0;
 	completion_class = TAG_GLOBAL;
 }
 
 ShaderLanguage::~ShaderLanguage() {
 	clear();
+	for (uint32_t i = 0; i < node_pages.size(); i++) {
+		memfree(node_pages[i]);
+	}
 }
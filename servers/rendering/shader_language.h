@@ -34,7 +34,9 @@
 #include "core/object/script_language.h"
 #include "core/string/string_name.h"
 #include "core/string/ustring.h"
+#include "core/templates/hash_map.h"
 #include "core/templates/list.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/map.h"
 #include "core/typedefs.h"
 #include "core/variant/variant.h"
@@ -42,7 +44,7 @@
 class ShaderLanguage {
 public:
 	struct TkPos {
-		int char_idx;
+		int token_idx;
 		int tk_line;
 	};
 
@@ -371,9 +373,21 @@ public:
 		virtual ~Node() {}
 	};
 
+	// Nodes are allocated from pages that are kept between compilations, and are only
+	// destroyed (not freed) on clear().
+	enum {
+		NODE_PAGE_SIZE = 65536,
+	};
+
+	LocalVector<uint8_t *> node_pages;
+	uint32_t node_pages_used = 0;
+	uint32_t node_page_offset = 0;
+
+	void *_alloc_node_memory(size_t p_size);
+
 	template <class T>
 	T *alloc_node() {
-		T *node = memnew(T);
+		T *node = memnew_placement(_alloc_node_memory(sizeof(T)), T);
 		node->next = nodes;
 		nodes = node;
 		return node;
@@ -721,7 +735,7 @@ public:
 		TokenType type;
 		StringName text;
 		double constant;
-		uint16_t line;
+		int line;
 	};
 
 	static String get_operator_text(Operator p_op);
@@ -796,6 +810,7 @@ private:
 	};
 
 	static const KeyWord keyword_list[];
+	static const HashMap<String, TokenType> &_get_keyword_map();
 
 	GlobalVariableGetTypeFunc global_var_get_type_func;
 
@@ -807,6 +822,11 @@ private:
 	int char_idx;
 	int tk_line;
 
+	// The code is tokenized once before parsing, so backtracking only moves token_idx back.
+	// The stream always ends with a TK_EOF or TK_ERROR token.
+	LocalVector<Token> tokens;
+	int token_idx;
+
 	StringName current_function;
 	bool last_const = false;
 
@@ -814,13 +834,13 @@ private:
 
 	TkPos _get_tkpos() {
 		TkPos tkp;
-		tkp.char_idx = char_idx;
+		tkp.token_idx = token_idx;
 		tkp.tk_line = tk_line;
 		return tkp;
 	}
 
 	void _set_tkpos(TkPos p_pos) {
-		char_idx = p_pos.char_idx;
+		token_idx = p_pos.token_idx;
 		tk_line = p_pos.tk_line;
 	}
 
@@ -837,6 +857,8 @@ private:
 	static const char *token_names[TK_MAX];
 
 	Token _make_token(TokenType p_type, const StringName &p_text = StringName());
+	Token _lex_token();
+	void _tokenize();
 	Token _get_token();
 
 	ShaderNode *shader;
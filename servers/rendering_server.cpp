@@ -1736,6 +1736,7 @@ void RenderingServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("canvas_create"), &RenderingServer::canvas_create);
 	ClassDB::bind_method(D_METHOD("canvas_set_item_mirroring", "canvas", "item", "mirroring"), &RenderingServer::canvas_set_item_mirroring);
 	ClassDB::bind_method(D_METHOD("canvas_set_modulate", "canvas", "color"), &RenderingServer::canvas_set_modulate);
+	ClassDB::bind_method(D_METHOD("canvas_set_use_spatial_index", "canvas", "enable"), &RenderingServer::canvas_set_use_spatial_index);
 #ifndef _MSC_VER
 #warning TODO method bindings need to be fixed
 #endif
@@ -1845,6 +1846,7 @@ void RenderingServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_render_loop_enabled", "enabled"), &RenderingServer::set_render_loop_enabled);
 
 	ClassDB::bind_method(D_METHOD("get_frame_setup_time_cpu"), &RenderingServer::get_frame_setup_time_cpu);
+	ClassDB::bind_method(D_METHOD("get_shadow_cull_times"), &RenderingServer::get_shadow_cull_times);
 
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "render_loop_enabled"), "set_render_loop_enabled", "is_render_loop_enabled");
 
@@ -2213,6 +2215,10 @@ void RenderingServer::_bind_methods() {
 	BIND_ENUM_CONSTANT(INFO_VIDEO_MEM_USED);
 	BIND_ENUM_CONSTANT(INFO_TEXTURE_MEM_USED);
 	BIND_ENUM_CONSTANT(INFO_VERTEX_MEM_USED);
+	BIND_ENUM_CONSTANT(INFO_CANVAS_ITEMS_RECOMPUTED_IN_FRAME);
+	BIND_ENUM_CONSTANT(INFO_COMMANDS_IN_FRAME);
+	BIND_ENUM_CONSTANT(INFO_SYNC_WAIT_USEC_IN_FRAME);
+	BIND_ENUM_CONSTANT(INFO_COMMAND_WAIT_USEC_IN_FRAME);
 
 	BIND_ENUM_CONSTANT(FEATURE_SHADERS);
 	BIND_ENUM_CONSTANT(FEATURE_MULTITHREADED);
@@ -2306,6 +2312,9 @@ RenderingServer::RenderingServer() {
 					"rendering/vulkan/rendering/back_end",
 					PROPERTY_HINT_ENUM, "ForwardClustered,ForwardMobile"));
 
+	GLOBAL_DEF_RST("rendering/shader_compiler/shader_cache/enabled", true);
+	GLOBAL_DEF_RST("rendering/shader_compiler/shader_cache/path", "user://shader_cache");
+
 	GLOBAL_DEF("rendering/reflections/sky_reflections/roughness_layers", 8);
 	GLOBAL_DEF("rendering/reflections/sky_reflections/texture_array_reflections", true);
 	GLOBAL_DEF("rendering/reflections/sky_reflections/texture_array_reflections.mobile", false);
@@ -2363,6 +2372,7 @@ RenderingServer::RenderingServer() {
 
 	GLOBAL_DEF_RST("rendering/occlusion_culling/occlusion_rays_per_thread", 512);
 	GLOBAL_DEF_RST("rendering/occlusion_culling/bvh_build_quality", 2);
+	GLOBAL_DEF_RST("rendering/occlusion_culling/use_software_rasterizer", false);
 	ProjectSettings::get_singleton()->set_custom_property_info("rendering/occlusion_culling/bvh_build_quality", PropertyInfo(Variant::INT, "rendering/occlusion_culling/bvh_build_quality", PROPERTY_HINT_ENUM, "Low,Medium,High"));
 
 	GLOBAL_DEF("rendering/environment/glow/upscale_mode", 1);
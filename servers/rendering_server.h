@@ -1229,6 +1229,7 @@ public:
 	virtual void canvas_set_parent(RID p_canvas, RID p_parent, float p_scale) = 0;
 
 	virtual void canvas_set_disable_scale(bool p_disable) = 0;
+	virtual void canvas_set_use_spatial_index(RID p_canvas, bool p_enable) = 0;
 
 	virtual RID canvas_texture_create() = 0;
 
@@ -1456,6 +1457,10 @@ public:
 		INFO_VIDEO_MEM_USED,
 		INFO_TEXTURE_MEM_USED,
 		INFO_VERTEX_MEM_USED,
+		INFO_CANVAS_ITEMS_RECOMPUTED_IN_FRAME,
+		INFO_COMMANDS_IN_FRAME,
+		INFO_SYNC_WAIT_USEC_IN_FRAME,
+		INFO_COMMAND_WAIT_USEC_IN_FRAME,
 	};
 
 	virtual uint64_t get_render_info(RenderInfo p_info) = 0;
@@ -1473,6 +1478,7 @@ public:
 	virtual uint64_t get_frame_profile_frame() = 0;
 
 	virtual float get_frame_setup_time_cpu() const = 0;
+	virtual Array get_shadow_cull_times() const = 0;
 
 	virtual void gi_set_use_half_resolution(bool p_enable) = 0;
 
@@ -0,0 +1,267 @@
+/*************************************************************************/
+/*  test_animation.h                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_ANIMATION_H
+#define TEST_ANIMATION_H
+
+#include "core/os/os.h"
+#include "scene/resources/animation.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAnimation {
+
+static Ref<Animation> create_transform_animation(int p_tracks, int p_keys, float p_length) {
+	Ref<Animation> anim = memnew(Animation);
+	anim->set_length(p_length);
+	for (int i = 0; i < p_tracks; i++) {
+		int track = anim->add_track(Animation::TYPE_TRANSFORM);
+		anim->track_set_path(track, NodePath("Skeleton3D:bone_" + itos(i)));
+		for (int j = 0; j < p_keys; j++) {
+			float t = p_length * j / (p_keys - 1);
+			Vector3 loc = Vector3(Math::sin(t + i), Math::cos(t * 2.0) * 3.0, i * 0.5);
+			Quat rot = Quat(Vector3(0.3, 1, 0.2).normalized(), t + i * 0.1);
+			// Bones are rarely scaled, keep that channel constant.
+			anim->transform_track_insert_key(track, t, loc, rot, Vector3(1, 1, 1));
+		}
+	}
+	return anim;
+}
+
+TEST_CASE("[Animation] Transform track compression round trip") {
+	Ref<Animation> anim = create_transform_animation(4, 31, 2.0);
+	Ref<Animation> reference = create_transform_animation(4, 31, 2.0);
+
+	uint64_t uncompressed_size = anim->get_transform_key_memory_usage();
+	CHECK(!anim->is_compressed());
+	anim->compress();
+	CHECK(anim->is_compressed());
+	CHECK_MESSAGE(
+			anim->get_transform_key_memory_usage() * 2 < uncompressed_size,
+			"Compressed keys should take less than half the memory.");
+
+	for (int i = 0; i < anim->get_track_count(); i++) {
+		REQUIRE(anim->track_get_key_count(i) == reference->track_get_key_count(i));
+		for (int j = 0; j < anim->track_get_key_count(i); j++) {
+			CHECK(anim->track_get_key_time(i, j) == reference->track_get_key_time(i, j));
+			CHECK(anim->track_get_key_transition(i, j) == 1.0);
+		}
+
+		for (float t = 0.0; t <= 2.0; t += 0.05) {
+			Vector3 loc, ref_loc, scale, ref_scale;
+			Quat rot, ref_rot;
+			REQUIRE(anim->transform_track_interpolate(i, t, &loc, &rot, &scale) == OK);
+			reference->transform_track_interpolate(i, t, &ref_loc, &ref_rot, &ref_scale);
+			CHECK(loc.distance_to(ref_loc) < 0.001);
+			CHECK(Math::abs(rot.dot(ref_rot)) > 0.99999);
+			CHECK(scale.is_equal_approx(ref_scale));
+		}
+	}
+
+	anim->decompress();
+	CHECK(!anim->is_compressed());
+	CHECK(anim->get_transform_key_memory_usage() == uncompressed_size);
+	Vector3 loc;
+	Quat rot;
+	Vector3 scale;
+	anim->transform_track_get_key(1, 5, &loc, &rot, &scale);
+	Vector3 ref_loc;
+	reference->transform_track_get_key(1, 5, &ref_loc, &rot, &scale);
+	CHECK(loc.distance_to(ref_loc) < 0.001);
+}
+
+TEST_CASE("[Animation] Exact key lookup after compression") {
+	Ref<Animation> anim = create_transform_animation(1, 31, 2.0);
+	// A late key makes the other ones much closer together than the track length divided by 65535.
+	anim->transform_track_insert_key(0, 1.01, Vector3(1, 2, 3));
+	anim->transform_track_insert_key(0, 1.012, Vector3(3, 2, 1));
+	anim->transform_track_insert_key(0, 600.0, Vector3());
+	Ref<Animation> reference = anim->duplicate();
+	anim->compress();
+	REQUIRE(anim->is_compressed());
+	REQUIRE(anim->track_get_key_count(0) == reference->track_get_key_count(0));
+
+	for (int i = 0; i < reference->track_get_key_count(0); i++) {
+		float time = reference->track_get_key_time(0, i);
+		CHECK_MESSAGE(anim->track_find_key(0, time, true) == i, "Every key should still be found at its exact time.");
+	}
+
+	Vector3 loc;
+	Quat rot;
+	Vector3 scale;
+	REQUIRE(anim->transform_track_interpolate(0, 1.011, &loc, &rot, &scale) == OK);
+	CHECK_MESSAGE(loc.distance_to(Vector3(2, 2, 2)) < 0.01, "Sampling between close keys should interpolate them, not divide by zero.");
+}
+
+TEST_CASE("[Animation] Compressed transform tracks") {
+	Ref<Animation> anim = create_transform_animation(2, 10, 1.0);
+	anim->track_set_key_transition(1, 3, 0.5);
+	anim->compress();
+
+	SUBCASE("Tracks using transitions are left uncompressed") {
+		CHECK(anim->track_get_key_transition(1, 3) == 0.5);
+		anim->track_set_key_transition(1, 3, 1.0);
+		CHECK(anim->track_get_key_transition(1, 3) == 1.0);
+	}
+
+	SUBCASE("Compressed tracks are read only") {
+		ERR_PRINT_OFF;
+		CHECK(anim->transform_track_insert_key(0, 0.5, Vector3()) == -1);
+		anim->track_remove_key(0, 0);
+		ERR_PRINT_ON;
+		CHECK(anim->track_get_key_count(0) == 10);
+
+		anim->decompress();
+		anim->track_remove_key(0, 0);
+		CHECK(anim->track_get_key_count(0) == 9);
+	}
+
+	SUBCASE("Compressed keys survive duplication") {
+		Ref<Animation> copy = anim->duplicate();
+		CHECK(copy->is_compressed());
+		Vector3 loc, copy_loc, scale;
+		Quat rot;
+		anim->transform_track_interpolate(0, 0.25, &loc, &rot, &scale);
+		copy->transform_track_interpolate(0, 0.25, &copy_loc, &rot, &scale);
+		CHECK(loc.is_equal_approx(copy_loc));
+	}
+}
+
+TEST_CASE("[Animation] Sampling with key cursors") {
+	Ref<Animation> anim = create_transform_animation(1, 50, 5.0);
+	anim->set_loop(true);
+	int value_track = anim->add_track(Animation::TYPE_VALUE);
+	for (int i = 0; i < 20; i++) {
+		anim->track_insert_key(value_track, i * 0.25, i * 2.0);
+	}
+
+	int transform_cursor = -1;
+	int value_cursor = -1;
+	auto check_sample = [&](float p_time) {
+		Vector3 loc, cursor_loc;
+		Quat rot, cursor_rot;
+		Vector3 scale, cursor_scale;
+		anim->transform_track_interpolate(0, p_time, &loc, &rot, &scale);
+		anim->transform_track_interpolate(0, p_time, &cursor_loc, &cursor_rot, &cursor_scale, &transform_cursor);
+		CHECK(loc.is_equal_approx(cursor_loc));
+		CHECK(rot.is_equal_approx(cursor_rot));
+		CHECK(anim->value_track_interpolate(value_track, p_time) == anim->value_track_interpolate(value_track, p_time, &value_cursor));
+	};
+
+	SUBCASE("Forward and backward playback") {
+		for (float t = 0.0; t <= 5.0; t += 1.0 / 60.0) {
+			check_sample(t);
+		}
+		for (float t = 5.0; t >= 0.0; t -= 1.0 / 30.0) {
+			check_sample(t);
+		}
+	}
+
+	SUBCASE("Seeking and wrapping around") {
+		const float times[] = { 4.9, 0.05, 2.5, 2.6, 0.0, 5.0, 1.337, 4.99, 0.01 };
+		for (float t : times) {
+			check_sample(t);
+		}
+	}
+
+	SUBCASE("Cursors stay valid after editing keys") {
+		check_sample(4.5);
+		for (int i = anim->track_get_key_count(0) - 1; i >= 10; i--) {
+			anim->track_remove_key(0, i);
+		}
+		for (int i = anim->track_get_key_count(value_track) - 1; i >= 5; i--) {
+			anim->track_remove_key(value_track, i);
+		}
+		check_sample(4.5);
+		check_sample(0.5);
+		transform_cursor = 1000;
+		check_sample(0.5);
+	}
+}
+
+TEST_CASE("[Animation][Benchmark] Sampling with key cursors" * doctest::skip()) {
+	const int tracks = 256;
+	const int keys = 600;
+	Ref<Animation> anim = create_transform_animation(tracks, keys, 20.0);
+	LocalVector<int> cursors;
+	cursors.resize(tracks);
+	for (int i = 0; i < tracks; i++) {
+		cursors[i] = -1;
+	}
+
+	for (int use_cursors = 0; use_cursors < 2; use_cursors++) {
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (float t = 0.0; t <= 20.0; t += 1.0 / 60.0) {
+			for (int i = 0; i < tracks; i++) {
+				Vector3 loc;
+				Quat rot;
+				Vector3 scale;
+				anim->transform_track_interpolate(i, t, &loc, &rot, &scale, use_cursors ? &cursors[i] : nullptr);
+			}
+		}
+		MESSAGE(vformat("Sampled %d tracks for 1200 frames %s cursors in %d usec.", tracks, use_cursors ? "with" : "without", OS::get_singleton()->get_ticks_usec() - begin));
+	}
+}
+
+TEST_CASE("[Animation][Benchmark] Transform track compression" * doctest::skip()) {
+	const int tracks = 64;
+	const int keys = 300;
+	Ref<Animation> anim = create_transform_animation(tracks, keys, 10.0);
+	Ref<Animation> reference = create_transform_animation(tracks, keys, 10.0);
+	uint64_t uncompressed_size = anim->get_transform_key_memory_usage();
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	anim->compress();
+	uint64_t compress_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	float max_loc_error = 0.0;
+	float max_rot_error = 0.0;
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < tracks; i++) {
+		for (float t = 0.0; t <= 10.0; t += 1.0 / 60.0) {
+			Vector3 loc, ref_loc, scale;
+			Quat rot, ref_rot;
+			anim->transform_track_interpolate(i, t, &loc, &rot, &scale);
+			reference->transform_track_interpolate(i, t, &ref_loc, &ref_rot, &scale);
+			max_loc_error = MAX(max_loc_error, loc.distance_to(ref_loc));
+			max_rot_error = MAX(max_rot_error, 2.0f * Math::acos(MIN(1.0f, Math::abs(rot.dot(ref_rot)))));
+		}
+	}
+	uint64_t sample_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	MESSAGE(vformat("Transform keys: %d bytes uncompressed, %d bytes compressed.", uncompressed_size, anim->get_transform_key_memory_usage()));
+	MESSAGE(vformat("Compression took %d usec, sampling %d usec.", compress_usec, sample_usec));
+	MESSAGE(vformat("Max location error: %f, max rotation error: %f rad.", max_loc_error, max_rot_error));
+}
+
+} // namespace TestAnimation
+
+#endif // TEST_ANIMATION_H
@@ -0,0 +1,87 @@
+/*************************************************************************/
+/*  test_animation_fixtures.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_ANIMATION_FIXTURES_H
+#define TEST_ANIMATION_FIXTURES_H
+
+#include "scene/3d/skeleton_3d.h"
+#include "scene/animation/animation_blend_space_1d.h"
+#include "scene/animation/animation_blend_tree.h"
+#include "scene/animation/animation_tree.h"
+
+namespace TestAnimationFixtures {
+
+// A skeleton with bones named "bone_<i>", animated by a player holding the
+// animations "a" and "b". With a tree, both are blended by a BlendSpace1D
+// with "a" at 0 and "b" at 1.
+struct AnimatedSkeleton {
+	Node3D *root = nullptr;
+	Skeleton3D *skeleton = nullptr;
+	AnimationPlayer *player = nullptr;
+	AnimationTree *tree = nullptr;
+};
+
+static AnimatedSkeleton create_animated_skeleton(int p_bones, const Ref<Animation> &p_a, const Ref<Animation> &p_b, bool p_use_tree) {
+	AnimatedSkeleton s;
+	s.root = memnew(Node3D);
+	s.skeleton = memnew(Skeleton3D);
+	s.skeleton->set_name("Skeleton");
+	for (int i = 0; i < p_bones; i++) {
+		s.skeleton->add_bone("bone_" + itos(i));
+	}
+	s.root->add_child(s.skeleton);
+
+	s.player = memnew(AnimationPlayer);
+	s.player->set_name("AnimationPlayer");
+	s.player->add_animation("a", p_a);
+	s.player->add_animation("b", p_b);
+	s.root->add_child(s.player);
+
+	if (p_use_tree) {
+		Ref<AnimationNodeBlendSpace1D> blend_space = memnew(AnimationNodeBlendSpace1D);
+		Ref<AnimationNodeAnimation> a = memnew(AnimationNodeAnimation);
+		a->set_animation("a");
+		Ref<AnimationNodeAnimation> b = memnew(AnimationNodeAnimation);
+		b->set_animation("b");
+		blend_space->add_blend_point(a, 0.0);
+		blend_space->add_blend_point(b, 1.0);
+
+		s.tree = memnew(AnimationTree);
+		s.root->add_child(s.tree);
+		s.tree->set_tree_root(blend_space);
+		s.tree->set_animation_player(NodePath("../AnimationPlayer"));
+		s.tree->set_active(true);
+	}
+	return s;
+}
+
+} // namespace TestAnimationFixtures
+
+#endif // TEST_ANIMATION_FIXTURES_H
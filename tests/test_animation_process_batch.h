@@ -0,0 +1,242 @@
+/*************************************************************************/
+/*  test_animation_process_batch.h                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_ANIMATION_PROCESS_BATCH_H
+#define TEST_ANIMATION_PROCESS_BATCH_H
+
+#include "core/os/os.h"
+#include "scene/animation/animation_process_batch.h"
+#include "tests/test_animation_fixtures.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAnimationProcessBatch {
+
+using namespace TestAnimationFixtures;
+
+static Ref<Animation> create_skeleton_animation(int p_bones, float p_speed) {
+	Ref<Animation> anim = memnew(Animation);
+	anim->set_length(2.0);
+	anim->set_loop(true);
+	for (int i = 0; i < p_bones; i++) {
+		int track = anim->add_track(Animation::TYPE_TRANSFORM);
+		anim->track_set_path(track, NodePath("Skeleton:bone_" + itos(i)));
+		for (int j = 0; j <= 60; j++) {
+			float t = j / 30.0;
+			Quat rot = Quat(Vector3(0, 1, 0), Math::sin(t * p_speed + i) * 0.5);
+			anim->transform_track_insert_key(track, t, Vector3(0, Math::cos(t * p_speed) * 0.1, i * 0.2), rot, Vector3(1, 1, 1));
+		}
+	}
+
+	// Discrete values call into the node, so they are left for the main thread.
+	int visibility = anim->add_track(Animation::TYPE_VALUE);
+	anim->track_set_path(visibility, NodePath("Skeleton:visible"));
+	anim->value_track_set_update_mode(visibility, Animation::UPDATE_DISCRETE);
+	anim->track_insert_key(visibility, 0.0, true);
+	anim->track_insert_key(visibility, 0.5, false);
+	return anim;
+}
+
+static AnimatedSkeleton create_character(int p_bones, const Ref<Animation> &p_walk, const Ref<Animation> &p_run, bool p_use_tree) {
+	AnimatedSkeleton c = create_animated_skeleton(p_bones, p_walk, p_run, p_use_tree);
+	if (p_use_tree) {
+		c.tree->set("parameters/blend_position", 0.3);
+	} else {
+		c.player->play("a");
+		c.player->play("b", 0.5);
+	}
+	return c;
+}
+
+static bool is_same_pose(const AnimatedSkeleton &p_a, const AnimatedSkeleton &p_b) {
+	for (int i = 0; i < p_a.skeleton->get_bone_count(); i++) {
+		if (!p_a.skeleton->get_bone_pose(i).is_equal_approx(p_b.skeleton->get_bone_pose(i))) {
+			return false;
+		}
+	}
+	return p_a.skeleton->is_visible() == p_b.skeleton->is_visible();
+}
+
+TEST_CASE("[AnimationProcessBatch] Matches serial processing") {
+	const int characters = 8;
+	const int bones = 10;
+	Ref<Animation> walk = create_skeleton_animation(bones, 2.0);
+	Ref<Animation> run = create_skeleton_animation(bones, 5.0);
+
+	for (int use_tree = 0; use_tree < 2; use_tree++) {
+		Vector<AnimatedSkeleton> serial;
+		Vector<AnimatedSkeleton> threaded;
+		for (int i = 0; i < characters; i++) {
+			serial.push_back(create_character(bones, walk, run, use_tree));
+			threaded.push_back(create_character(bones, walk, run, use_tree));
+		}
+
+		AnimationProcessBatch batch;
+		for (int frame = 0; frame < 45; frame++) {
+			for (int i = 0; i < characters; i++) {
+				if (use_tree) {
+					serial[i].tree->advance(1.0 / 60.0);
+					batch.add_tree(threaded[i].tree);
+				} else {
+					serial[i].player->advance(1.0 / 60.0);
+					batch.add_player(threaded[i].player);
+				}
+			}
+			batch.process(1.0 / 60.0);
+		}
+
+		for (int i = 0; i < characters; i++) {
+			CHECK_MESSAGE(
+					is_same_pose(serial[i], threaded[i]),
+					"Nodes evaluated on worker threads should end up in the same pose as serially processed ones.");
+			CHECK(!threaded[i].skeleton->is_visible());
+			memdelete(serial[i].root);
+			memdelete(threaded[i].root);
+		}
+	}
+}
+
+TEST_CASE("[AnimationProcessBatch] Trees sharing animation nodes below different roots") {
+	const int characters = 6;
+	const int bones = 10;
+	Ref<Animation> walk = create_skeleton_animation(bones, 2.0);
+	Ref<Animation> run = create_skeleton_animation(bones, 5.0);
+
+	// Each tree has its own root, but all of them use the same walk node.
+	Ref<AnimationNodeAnimation> shared_walk = memnew(AnimationNodeAnimation);
+	shared_walk->set_animation("a");
+
+	Vector<AnimatedSkeleton> serial;
+	Vector<AnimatedSkeleton> threaded;
+	for (int i = 0; i < characters * 2; i++) {
+		AnimatedSkeleton c = create_character(bones, walk, run, true);
+		Ref<AnimationNodeBlendSpace1D> blend_space = memnew(AnimationNodeBlendSpace1D);
+		Ref<AnimationNodeAnimation> own_run = memnew(AnimationNodeAnimation);
+		own_run->set_animation("b");
+		blend_space->add_blend_point(shared_walk, 0.0);
+		blend_space->add_blend_point(own_run, 1.0);
+		c.tree->set_tree_root(blend_space);
+		c.tree->set("parameters/blend_position", 0.1 * (i % characters));
+		if (i < characters) {
+			serial.push_back(c);
+		} else {
+			threaded.push_back(c);
+		}
+	}
+
+	AnimationProcessBatch batch;
+	for (int frame = 0; frame < 30; frame++) {
+		for (int i = 0; i < characters; i++) {
+			serial[i].tree->advance(1.0 / 60.0);
+			batch.add_tree(threaded[i].tree);
+		}
+		batch.process(1.0 / 60.0);
+	}
+
+	for (int i = 0; i < characters; i++) {
+		CHECK_MESSAGE(
+				is_same_pose(serial[i], threaded[i]),
+				"Trees sharing a node should be evaluated one after the other, as when processed serially.");
+		memdelete(serial[i].root);
+		memdelete(threaded[i].root);
+	}
+}
+
+TEST_CASE("[AnimationProcessBatch] Blended tracks") {
+	Ref<Animation> anim = memnew(Animation);
+	int transform = anim->add_track(Animation::TYPE_TRANSFORM);
+	int method = anim->add_track(Animation::TYPE_METHOD);
+	int continuous = anim->add_track(Animation::TYPE_VALUE);
+	int discrete = anim->add_track(Animation::TYPE_VALUE);
+	anim->value_track_set_update_mode(discrete, Animation::UPDATE_DISCRETE);
+	int capture = anim->add_track(Animation::TYPE_VALUE);
+	anim->value_track_set_update_mode(capture, Animation::UPDATE_CAPTURE);
+
+	for (int reads = 0; reads < 2; reads++) {
+		CHECK(AnimationProcessBatch::is_blended_track(anim.ptr(), transform, 0.1, reads));
+		CHECK(!AnimationProcessBatch::is_blended_track(anim.ptr(), method, 0.1, reads));
+		CHECK(!AnimationProcessBatch::is_blended_track(anim.ptr(), method, 0.0, reads));
+		CHECK(AnimationProcessBatch::is_blended_track(anim.ptr(), continuous, 0.1, reads));
+		CHECK_MESSAGE(!AnimationProcessBatch::is_blended_track(anim.ptr(), discrete, 0.1, reads), "Discrete values are set on the node while playing.");
+		CHECK_MESSAGE(AnimationProcessBatch::is_blended_track(anim.ptr(), discrete, 0.0, reads), "Discrete values are blended when seeking.");
+	}
+
+	CHECK_MESSAGE(!AnimationProcessBatch::is_blended_track(anim.ptr(), capture, 0.1, true), "Capture tracks that read the property should stay on the main thread.");
+	CHECK(AnimationProcessBatch::is_blended_track(anim.ptr(), capture, 0.1, false));
+}
+
+TEST_CASE("[AnimationProcessBatch][Benchmark] Many characters" * doctest::skip()) {
+	const int characters = 300;
+	const int bones = 60;
+	const int frames = 120;
+	Ref<Animation> walk = create_skeleton_animation(bones, 2.0);
+	Ref<Animation> run = create_skeleton_animation(bones, 5.0);
+
+	Vector<AnimatedSkeleton> crowd;
+	for (int i = 0; i < characters; i++) {
+		crowd.push_back(create_character(bones, walk, run, true));
+	}
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < characters; i++) {
+			crowd[i].tree->advance(1.0 / 60.0);
+		}
+	}
+	uint64_t serial_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	// Trees sharing a root are evaluated on the same thread, give each character its own.
+	for (int i = 0; i < characters; i++) {
+		crowd.write[i].tree->set_tree_root(crowd[i].tree->get_tree_root()->duplicate(true));
+		crowd.write[i].tree->set("parameters/blend_position", 0.3);
+	}
+
+	AnimationProcessBatch batch;
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < characters; i++) {
+			batch.add_tree(crowd[i].tree);
+		}
+		batch.process(1.0 / 60.0);
+	}
+	uint64_t threaded_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	MESSAGE(vformat("%d characters with %d bones over %d frames.", characters, bones, frames));
+	MESSAGE(vformat("Serial: %d usec, batched on %d threads: %d usec.", serial_usec, OS::get_singleton()->get_processor_count(), threaded_usec));
+
+	for (int i = 0; i < characters; i++) {
+		memdelete(crowd[i].root);
+	}
+}
+
+} // namespace TestAnimationProcessBatch
+
+#endif // TEST_ANIMATION_PROCESS_BATCH_H
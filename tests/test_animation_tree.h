@@ -0,0 +1,122 @@
+/*************************************************************************/
+/*  test_animation_tree.h                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_ANIMATION_TREE_H
+#define TEST_ANIMATION_TREE_H
+
+#include "core/os/os.h"
+#include "tests/test_animation_fixtures.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAnimationTree {
+
+using namespace TestAnimationFixtures;
+
+// A pose that holds still, so blends can be checked against known values.
+static Ref<Animation> create_static_pose(int p_bones, const Vector3 &p_loc, float p_angle, const Vector3 &p_scale) {
+	Ref<Animation> anim = memnew(Animation);
+	anim->set_length(1.0);
+	for (int i = 0; i < p_bones; i++) {
+		int track = anim->add_track(Animation::TYPE_TRANSFORM);
+		anim->track_set_path(track, NodePath("Skeleton:bone_" + itos(i)));
+		anim->transform_track_insert_key(track, 0.0, p_loc * (i + 1), Quat(Vector3(0, 1, 0), p_angle), p_scale);
+	}
+	return anim;
+}
+
+TEST_CASE("[AnimationTree] Blending transform tracks") {
+	// Not a multiple of four, so both the vectorized and the scalar blends run.
+	const int bones = 7;
+	Ref<Animation> a = create_static_pose(bones, Vector3(1, 0, 0), 0.0, Vector3(1, 1, 1));
+	Ref<Animation> b = create_static_pose(bones, Vector3(0, 2, 0), Math_PI / 2.0, Vector3(3, 3, 3));
+	AnimatedSkeleton setup = create_animated_skeleton(bones, a, b, true);
+
+	setup.tree->set("parameters/blend_position", 0.0);
+	setup.tree->advance(0.1);
+	for (int i = 0; i < bones; i++) {
+		Transform pose = setup.skeleton->get_bone_pose(i);
+		CHECK_MESSAGE(
+				pose.origin.is_equal_approx(Vector3(i + 1, 0, 0)),
+				"A single animation should be applied as is.");
+		CHECK(pose.basis.get_rotation_quat().is_equal_approx(Quat()));
+	}
+
+	setup.tree->set("parameters/blend_position", 0.25);
+	setup.tree->advance(0.1);
+	for (int i = 0; i < bones; i++) {
+		Transform pose = setup.skeleton->get_bone_pose(i);
+		CHECK_MESSAGE(
+				pose.origin.is_equal_approx(Vector3(0.75, 0.5, 0) * (i + 1)),
+				"Locations should be lerped by blend amount.");
+		CHECK_MESSAGE(
+				pose.basis.get_scale().is_equal_approx(Vector3(1.5, 1.5, 1.5)),
+				"Scales should be lerped by blend amount.");
+
+		// Normalized lerp doesn't rotate at constant speed, but must stay between both rotations and be closer to the heavier one.
+		Vector3 axis;
+		real_t angle;
+		pose.basis.orthonormalized().get_axis_angle(axis, angle);
+		CHECK(angle > Math_PI / 8.0 - 0.1);
+		CHECK(angle < Math_PI / 8.0 + 0.1);
+	}
+
+	setup.tree->set("parameters/blend_position", 1.0);
+	setup.tree->advance(0.1);
+	for (int i = 0; i < bones; i++) {
+		CHECK(setup.skeleton->get_bone_pose(i).basis.get_rotation_quat().is_equal_approx(Quat(Vector3(0, 1, 0), Math_PI / 2.0)));
+	}
+
+	memdelete(setup.root);
+}
+
+TEST_CASE("[AnimationTree][Benchmark] Blending a large skeleton" * doctest::skip()) {
+	const int bones = 256;
+	const int frames = 10000;
+	Ref<Animation> a = create_static_pose(bones, Vector3(1, 0, 0), 0.0, Vector3(1, 1, 1));
+	Ref<Animation> b = create_static_pose(bones, Vector3(0, 2, 0), Math_PI / 2.0, Vector3(3, 3, 3));
+	AnimatedSkeleton setup = create_animated_skeleton(bones, a, b, true);
+	setup.tree->set("parameters/blend_position", 0.5);
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < frames; i++) {
+		setup.tree->advance(1.0 / 60.0);
+	}
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+	MESSAGE(vformat("Blended %d bones over %d frames in %d usec.", bones, frames, elapsed));
+
+	memdelete(setup.root);
+}
+
+} // namespace TestAnimationTree
+
+#endif // TEST_ANIMATION_TREE_H
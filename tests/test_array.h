@@ -181,6 +181,39 @@ TEST_CASE("[Array] max() and min()") {
 	CHECK(max == 5);
 	CHECK(min == 2);
 }
+
+TEST_CASE("[Array] Move constructor and assignment") {
+	Array arr;
+	arr.push_back(1);
+	const void *id = arr.id();
+
+	Array moved = std::move(arr);
+	CHECK(moved.id() == id);
+	CHECK(moved.size() == 1);
+
+	Array assigned;
+	assigned.push_back(2);
+	assigned = std::move(moved);
+	CHECK(assigned.id() == id);
+	CHECK(int(assigned[0]) == 1);
+	CHECK_MESSAGE(moved.is_empty(), "The moved-from array should be left empty.");
+
+	// Moved-from arrays stay usable.
+	moved.push_back(3);
+	CHECK(moved.size() == 1);
+	CHECK(moved.id() != id);
+	CHECK(arr.is_empty());
+	arr = moved;
+	CHECK(int(arr[0]) == 3);
+
+	// Copies of a moved-from array still share its data.
+	Array source;
+	Array target = std::move(source);
+	Array copy = source;
+	copy.push_back(4);
+	CHECK_MESSAGE(source.size() == 1, "Copies of a moved-from array should share its data.");
+	CHECK(target.is_empty());
+}
 } // namespace TestArray
 
 #endif // TEST_ARRAY_H
@@ -0,0 +1,265 @@
+/*************************************************************************/
+/*  test_audio_mix_kernels.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_MIX_KERNELS_H
+#define TEST_AUDIO_MIX_KERNELS_H
+
+#include "core/os/os.h"
+#include "servers/audio/audio_mix_kernels.h"
+#include "servers/audio/audio_rb_resampler.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAudioMixKernels {
+
+// Odd, so the scalar tail after the vector loops is exercised too.
+const int FRAMES = 259;
+
+static void fill(Vector<AudioFrame> &r_frames, int p_frames, float p_seed) {
+	r_frames.resize(p_frames);
+	for (int i = 0; i < p_frames; i++) {
+		r_frames.write[i] = AudioFrame(Math::sin(p_seed + i * 0.37) * 1.5, Math::cos(p_seed + i * 0.21) * 1.5);
+	}
+}
+
+static bool is_frame_equal_approx(const AudioFrame &p_a, const AudioFrame &p_b) {
+	return Math::is_equal_approx(p_a.l, p_b.l) && Math::is_equal_approx(p_a.r, p_b.r);
+}
+
+TEST_CASE("[AudioMixKernels] Accumulation and gain ramps") {
+	Vector<AudioFrame> src;
+	Vector<AudioFrame> dst;
+	fill(src, FRAMES, 0.0);
+	fill(dst, FRAMES, 1.0);
+	const AudioFrame from = AudioFrame(0.25, 1.0);
+	const AudioFrame inc = AudioFrame(0.01, -0.002);
+
+	Vector<AudioFrame> added = dst;
+	AudioMixKernels::add(added.ptrw(), src.ptr(), FRAMES);
+	Vector<AudioFrame> mixed = dst;
+	AudioMixKernels::mix_ramp(mixed.ptrw(), src.ptr(), FRAMES, from, inc);
+	Vector<AudioFrame> scaled = src;
+	AudioMixKernels::scale_ramp(scaled.ptrw(), scaled.ptr(), FRAMES, from, inc);
+
+	bool added_ok = true;
+	bool mixed_ok = true;
+	bool scaled_ok = true;
+	for (int i = 0; i < FRAMES; i++) {
+		AudioFrame gain = from + inc * float(i);
+		added_ok = added_ok && is_frame_equal_approx(added[i], dst[i] + src[i]);
+		mixed_ok = mixed_ok && is_frame_equal_approx(mixed[i], dst[i] + src[i] * gain);
+		scaled_ok = scaled_ok && is_frame_equal_approx(scaled[i], src[i] * gain);
+	}
+	CHECK_MESSAGE(added_ok, "Adding buffers should match the scalar sum.");
+	CHECK_MESSAGE(mixed_ok, "Mixing with a gain ramp should match the scalar result.");
+	CHECK_MESSAGE(scaled_ok, "Scaling in place with a gain ramp should match the scalar result.");
+}
+
+TEST_CASE("[AudioMixKernels] Volume and peak") {
+	Vector<AudioFrame> buffer;
+	fill(buffer, FRAMES, 2.0);
+	buffer.write[FRAMES - 1] = AudioFrame(-3.0, 0.5);
+	Vector<AudioFrame> expected = buffer;
+
+	AudioFrame expected_peak = AudioFrame(0, 0);
+	for (int i = 0; i < FRAMES; i++) {
+		expected.write[i] *= 0.5;
+		expected_peak.l = MAX(expected_peak.l, ABS(expected[i].l));
+		expected_peak.r = MAX(expected_peak.r, ABS(expected[i].r));
+	}
+
+	AudioFrame peak = AudioMixKernels::scale_peak(buffer.ptrw(), FRAMES, 0.5);
+
+	bool scaled_ok = true;
+	for (int i = 0; i < FRAMES; i++) {
+		scaled_ok = scaled_ok && buffer[i].l == expected[i].l && buffer[i].r == expected[i].r;
+	}
+	CHECK_MESSAGE(scaled_ok, "Scaling should match the scalar result.");
+	CHECK_MESSAGE(peak.l == doctest::Approx(1.5), "The left peak should come from the last frame, which is only handled by the scalar tail.");
+	CHECK_MESSAGE(peak.r == doctest::Approx(expected_peak.r), "The right peak should match the scalar result.");
+}
+
+TEST_CASE("[AudioMixKernels] Sample conversion") {
+	Vector<AudioFrame> src;
+	fill(src, FRAMES, 3.0);
+
+	// Interleave into the second of three stereo channels, as the audio server does for surround output.
+	const int stride = 6;
+	Vector<int32_t> converted;
+	converted.resize(FRAMES * stride);
+	for (int i = 0; i < converted.size(); i++) {
+		converted.write[i] = 7;
+	}
+	AudioMixKernels::to_int32(converted.ptrw() + 2, stride, src.ptr(), FRAMES);
+
+	bool converted_ok = true;
+	bool untouched_ok = true;
+	for (int i = 0; i < FRAMES; i++) {
+		for (int c = 0; c < 2; c++) {
+			float v = CLAMP(src[i][c], -1.0, 1.0);
+			int32_t vi = v * ((1 << 20) - 1);
+			int32_t expected = (vi < 0 ? -1 : 1) * (ABS(vi) << 11);
+			converted_ok = converted_ok && converted[i * stride + 2 + c] == expected;
+		}
+		untouched_ok = untouched_ok && converted[i * stride + 0] == 7 && converted[i * stride + 5] == 7;
+	}
+	CHECK_MESSAGE(converted_ok, "Conversion to 32-bit samples should match the scalar result.");
+	CHECK_MESSAGE(untouched_ok, "Conversion should not write outside of its channel.");
+
+	Vector<int16_t> narrowed;
+	narrowed.resize(converted.size());
+	AudioMixKernels::int32_to_int16(narrowed.ptrw(), converted.ptr(), converted.size() - 1);
+	narrowed.write[converted.size() - 1] = 0;
+
+	bool narrowed_ok = true;
+	for (int i = 0; i < converted.size() - 1; i++) {
+		narrowed_ok = narrowed_ok && narrowed[i] == int16_t(converted[i] >> 16);
+	}
+	CHECK_MESSAGE(narrowed_ok, "Conversion to 16-bit samples should keep the most significant bits.");
+}
+
+TEST_CASE("[AudioRBResampler] Linear interpolation") {
+	const int channel_counts[3] = { 1, 2, 6 };
+	for (int c = 0; c < 3; c++) {
+		const int channels = channel_counts[c];
+		AudioRBResampler resampler;
+		resampler.setup(channels, 22050, 44100, 100, 0);
+
+		// A ramp is reproduced exactly by linear interpolation.
+		float *write = resampler.get_write_buffer();
+		for (int i = 0; i < 512; i++) {
+			write[i * channels + 0] = i;
+			if (channels > 1) {
+				write[i * channels + 1] = -i;
+			}
+		}
+		resampler.write(512);
+
+		Vector<AudioFrame> out;
+		out.resize(FRAMES);
+		CHECK(resampler.mix(out.ptrw(), FRAMES));
+
+		bool resampled_ok = true;
+		for (int i = 0; i < FRAMES; i++) {
+			float expected = (i + 1) * 0.5;
+			resampled_ok = resampled_ok && out[i].l == expected && out[i].r == (channels > 1 ? -expected : expected);
+		}
+		CHECK_MESSAGE(resampled_ok, vformat("Upsampling %d channels should interpolate between source frames.", channels));
+	}
+}
+
+TEST_CASE("[AudioMixKernels][Benchmark] Mixing kernels" * doctest::skip()) {
+	const int frames = 1024;
+	const int iterations = 20000;
+	const double total = double(frames) * iterations;
+
+	Vector<AudioFrame> src;
+	Vector<AudioFrame> dst;
+	fill(src, frames, 0.0);
+	fill(dst, frames, 1.0);
+	Vector<int32_t> samples;
+	samples.resize(frames * 2);
+	Vector<int16_t> samples_16;
+	samples_16.resize(frames * 2);
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		AudioMixKernels::add(dst.ptrw(), src.ptr(), frames);
+	}
+	MESSAGE(vformat("add: %.3f ns/frame", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / total));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		AudioMixKernels::mix_ramp(dst.ptrw(), src.ptr(), frames, AudioFrame(0.5, 0.5), AudioFrame(0.0001, -0.0001));
+	}
+	MESSAGE(vformat("mix_ramp: %.3f ns/frame", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / total));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		AudioMixKernels::scale_ramp(dst.ptrw(), src.ptr(), frames, AudioFrame(0.5, 0.5), AudioFrame(0.0001, -0.0001));
+	}
+	MESSAGE(vformat("scale_ramp: %.3f ns/frame", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / total));
+
+	AudioFrame peak;
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		peak = AudioMixKernels::scale_peak(dst.ptrw(), frames, 1.0);
+	}
+	MESSAGE(vformat("scale_peak: %.3f ns/frame (peak %f)", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / total, MAX(peak.l, peak.r)));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		AudioMixKernels::to_int32(samples.ptrw(), 2, src.ptr(), frames);
+	}
+	MESSAGE(vformat("to_int32: %.3f ns/frame", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / total));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		AudioMixKernels::int32_to_int16(samples_16.ptrw(), samples.ptr(), frames * 2);
+	}
+	MESSAGE(vformat("int32_to_int16: %.3f ns/frame", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / total));
+}
+
+TEST_CASE("[AudioRBResampler][Benchmark] Resampling" * doctest::skip()) {
+	const int frames = 1024;
+	const int iterations = 5000;
+
+	Vector<AudioFrame> out;
+	out.resize(frames);
+
+	const int channel_counts[2] = { 1, 2 };
+	for (int c = 0; c < 2; c++) {
+		AudioRBResampler resampler;
+		resampler.setup(channel_counts[c], 44100, 48000, 100, 0);
+
+		uint64_t elapsed = 0;
+		uint64_t mixed = 0;
+		for (int i = 0; i < iterations; i++) {
+			// Keep the ring buffer fed, only mixing is timed.
+			int space = resampler.get_writer_space();
+			float *write = resampler.get_write_buffer();
+			for (int j = 0; j < space * channel_counts[c]; j++) {
+				write[j] = Math::sin(j * 0.01);
+			}
+			resampler.write(space);
+
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			resampler.mix(out.ptrw(), frames);
+			elapsed += OS::get_singleton()->get_ticks_usec() - begin;
+			mixed += frames;
+		}
+		MESSAGE(vformat("%d channel(s): %.3f ns/frame", channel_counts[c], elapsed * 1000.0 / mixed));
+	}
+}
+
+} // namespace TestAudioMixKernels
+
+#endif // TEST_AUDIO_MIX_KERNELS_H
@@ -0,0 +1,276 @@
+/*************************************************************************/
+/*  test_audio_server.h                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_SERVER_H
+#define TEST_AUDIO_SERVER_H
+
+#include "core/config/project_settings.h"
+#include "core/os/os.h"
+#include "servers/audio/audio_driver_dummy.h"
+#include "servers/audio/effects/audio_effect_chorus.h"
+#include "servers/audio/effects/audio_effect_compressor.h"
+#include "servers/audio/effects/audio_effect_reverb.h"
+#include "servers/audio_server.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAudioServer {
+
+// Applies a gain after waiting for a while, so buses take long enough to be split across threads.
+class TestSlowEffectInstance : public AudioEffectInstance {
+public:
+	float gain = 1.0;
+	int usec = 0;
+
+	virtual void process(const AudioFrame *p_src_frames, AudioFrame *p_dst_frames, int p_frame_count) override {
+		OS::get_singleton()->delay_usec(usec);
+		for (int i = 0; i < p_frame_count; i++) {
+			p_dst_frames[i] = p_src_frames[i] * gain;
+		}
+	}
+};
+
+class TestSlowEffect : public AudioEffect {
+public:
+	float gain = 1.0;
+	int usec = 0;
+
+	virtual Ref<AudioEffectInstance> instance() override {
+		Ref<TestSlowEffectInstance> ins;
+		ins.instance();
+		ins->gain = gain;
+		ins->usec = usec;
+		return ins;
+	}
+};
+
+// Plays a different tone into every bus but master.
+struct TestSignal {
+	int bus_count = 0;
+	uint64_t frame = 0;
+
+	static void mix(void *p_userdata) {
+		TestSignal *signal = (TestSignal *)p_userdata;
+		int buffer_size = AudioServer::get_singleton()->thread_get_mix_buffer_size();
+
+		for (int i = 1; i < signal->bus_count; i++) {
+			AudioFrame *buffer = AudioServer::get_singleton()->thread_get_channel_mix_buffer(i, 0);
+			float frequency = 110.0 * i / AudioServer::get_singleton()->get_mix_rate();
+			for (int j = 0; j < buffer_size; j++) {
+				float phase = Math_TAU * frequency * (signal->frame + j);
+				buffer[j] += AudioFrame(Math::sin(phase), Math::cos(phase)) * 0.2;
+			}
+		}
+		signal->frame += buffer_size;
+	}
+};
+
+// Mixes p_frames of a tree of buses, each sending to the bus (i - 1) / 3, through the dummy driver.
+static void mix_bus_tree(bool p_use_threads, int p_bus_count, int p_effect_usec, int p_frames, LocalVector<int32_t> &r_output) {
+	ProjectSettings::get_singleton()->set_setting("audio/buses/use_threads", p_use_threads);
+
+	AudioDriverDummy *driver = AudioDriverDummy::get_dummy_singleton();
+	driver->set_use_threads(false);
+	AudioDriverManager::initialize(AudioDriverManager::get_driver_count() - 1);
+
+	AudioServer *audio_server = memnew(AudioServer);
+	audio_server->init();
+
+	audio_server->set_bus_count(p_bus_count);
+	for (int i = 1; i < p_bus_count; i++) {
+		audio_server->set_bus_name(i, "Bus " + itos(i));
+		audio_server->set_bus_send(i, audio_server->get_bus_name((i - 1) / 3));
+		audio_server->set_bus_volume_db(i, -0.5 * i);
+
+		Ref<TestSlowEffect> slow = memnew(TestSlowEffect);
+		slow->gain = 0.5 + 0.05 * i;
+		slow->usec = p_effect_usec;
+		audio_server->add_bus_effect(i, slow);
+
+		if (i % 2) {
+			Ref<AudioEffectReverb> reverb = memnew(AudioEffectReverb);
+			audio_server->add_bus_effect(i, reverb);
+		} else {
+			Ref<AudioEffectChorus> chorus = memnew(AudioEffectChorus);
+			audio_server->add_bus_effect(i, chorus);
+		}
+		Ref<AudioEffectCompressor> compressor = memnew(AudioEffectCompressor);
+		audio_server->add_bus_effect(i, compressor);
+	}
+
+	TestSignal signal;
+	signal.bus_count = p_bus_count;
+	audio_server->add_callback(&TestSignal::mix, &signal);
+
+	r_output.resize(p_frames * driver->get_channels());
+	driver->mix_audio(p_frames, r_output.ptr());
+
+	audio_server->remove_callback(&TestSignal::mix, &signal);
+	audio_server->finish();
+	memdelete(audio_server);
+
+	ProjectSettings::get_singleton()->set_setting("audio/buses/use_threads", false);
+}
+
+TEST_CASE("[AudioServer] Mixing buses on threads matches mixing them on the audio thread") {
+	// Three levels of buses, which cost enough per step to be mixed on threads.
+	const int bus_count = 14;
+	const int frames = 44100;
+
+	LocalVector<int32_t> serial;
+	LocalVector<int32_t> threaded;
+	mix_bus_tree(false, bus_count, 100, frames, serial);
+	mix_bus_tree(true, bus_count, 100, frames, threaded);
+
+	REQUIRE(serial.size() == threaded.size());
+
+	int mismatches = 0;
+	int32_t peak = 0;
+	for (uint32_t i = 0; i < serial.size(); i++) {
+		mismatches += serial[i] != threaded[i];
+		peak = MAX(peak, ABS(serial[i]));
+	}
+
+	CHECK_MESSAGE(mismatches == 0, "Buses mixed on worker threads should give exactly the same output.");
+	CHECK_MESSAGE(peak > (1 << 24), "The output should not be silent, or the comparison proves nothing.");
+}
+
+TEST_CASE("[AudioServer] Voices are ranked by priority, then volume") {
+	AudioServer::Voice a, b, c, d;
+	a.volume_db = -10;
+	b.volume_db = -30;
+	b.priority = 1;
+	c.volume_db = -5;
+	d.volume_db = -50;
+
+	LocalVector<AudioServer::Voice *> voices;
+	voices.push_back(&a);
+	voices.push_back(&b);
+	voices.push_back(&c);
+	voices.push_back(&d);
+	for (uint32_t i = 0; i < voices.size(); i++) {
+		voices[i]->playing = true;
+	}
+
+	AudioServer::VoiceBudget budget;
+	budget.max_real_voices = 2;
+	budget.virtualize_db = -40;
+	budget.hysteresis_db = 3;
+	budget.min_state_usec = 1000;
+
+	LocalVector<AudioServer::Voice *> ranking;
+	CHECK(AudioServer::rank_voices(voices, budget, 0, ranking) == 2);
+	REQUIRE(ranking.size() == 4);
+	CHECK_MESSAGE(ranking[0] == &b, "Higher priority voices should rank first, however quiet.");
+	CHECK(ranking[1] == &c);
+	CHECK(ranking[2] == &a);
+	CHECK(ranking[3] == &d);
+	CHECK_MESSAGE(!b.virtualized.is_set(), "Voices within the budget should be real.");
+	CHECK(!c.virtualized.is_set());
+	CHECK_MESSAGE(a.virtualized.is_set(), "Voices past the budget should be virtual.");
+	CHECK_MESSAGE(d.virtualized.is_set(), "Voices below the volume limit should be virtual.");
+
+	a.volume_db = -4;
+	CHECK(AudioServer::rank_voices(voices, budget, 2000, ranking) == 2);
+	CHECK_MESSAGE(!c.virtualized.is_set(), "A virtual voice within the hysteresis margin should not replace a real voice.");
+	CHECK(a.virtualized.is_set());
+
+	a.volume_db = -1;
+	CHECK(AudioServer::rank_voices(voices, budget, 4000, ranking) == 2);
+	CHECK_MESSAGE(!a.virtualized.is_set(), "A virtual voice past the hysteresis margin should replace a real voice.");
+	CHECK(c.virtualized.is_set());
+
+	c.volume_db = 5;
+	CHECK(AudioServer::rank_voices(voices, budget, 4500, ranking) == 2);
+	CHECK_MESSAGE(c.virtualized.is_set(), "Voices should keep their state for the hold time after changing.");
+	CHECK(!a.virtualized.is_set());
+
+	CHECK(AudioServer::rank_voices(voices, budget, 5000, ranking) == 2);
+	CHECK_MESSAGE(!c.virtualized.is_set(), "Voices should change state again once the hold time has passed.");
+	CHECK(a.virtualized.is_set());
+
+	c.playing = false;
+	CHECK(AudioServer::rank_voices(voices, budget, 10000, ranking) == 2);
+	CHECK_MESSAGE(ranking.size() == 3, "Voices that aren't playing should not be ranked.");
+	CHECK(!c.virtualized.is_set());
+	CHECK(!a.virtualized.is_set());
+}
+
+TEST_CASE("[AudioServer] Virtual voices need the hysteresis margin to become real") {
+	AudioServer::Voice voice;
+	voice.playing = true;
+	voice.volume_db = -50;
+
+	LocalVector<AudioServer::Voice *> voices;
+	voices.push_back(&voice);
+
+	AudioServer::VoiceBudget budget;
+	budget.virtualize_db = -40;
+	budget.hysteresis_db = 3;
+	budget.min_state_usec = 0;
+
+	LocalVector<AudioServer::Voice *> ranking;
+	CHECK(AudioServer::rank_voices(voices, budget, 0, ranking) == 0);
+	CHECK(voice.virtualized.is_set());
+
+	voice.volume_db = -39;
+	CHECK_MESSAGE(AudioServer::rank_voices(voices, budget, 1, ranking) == 0, "A voice just above the limit should stay virtual.");
+	CHECK(voice.virtualized.is_set());
+
+	voice.volume_db = -36;
+	CHECK_MESSAGE(AudioServer::rank_voices(voices, budget, 2, ranking) == 1, "A voice past the hysteresis margin should become real.");
+	CHECK(!voice.virtualized.is_set());
+
+	voice.volume_db = -39;
+	CHECK_MESSAGE(AudioServer::rank_voices(voices, budget, 3, ranking) == 1, "A real voice should stay real until it falls below the limit.");
+
+	voice.volume_db = -41;
+	CHECK(AudioServer::rank_voices(voices, budget, 4, ranking) == 0);
+	CHECK(voice.virtualized.is_set());
+}
+
+TEST_CASE("[AudioServer][Benchmark] Mixing 64 buses with effects" * doctest::skip()) {
+	const int bus_count = 64;
+	const int frames = 44100 * 10;
+
+	for (int use_threads = 0; use_threads < 2; use_threads++) {
+		LocalVector<int32_t> output;
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		mix_bus_tree(use_threads, bus_count, 0, frames, output);
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		MESSAGE(vformat("%s: %d buses, 10 seconds of audio mixed in %d usec.", use_threads ? "Threaded" : "Serial", bus_count, elapsed));
+	}
+}
+
+} // namespace TestAudioServer
+
+#endif // TEST_AUDIO_SERVER_H
@@ -0,0 +1,356 @@
+/*************************************************************************/
+/*  test_audio_stream_decoded.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_STREAM_DECODED_H
+#define TEST_AUDIO_STREAM_DECODED_H
+
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "servers/audio/audio_stream_decoded.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAudioStreamDecoded {
+
+// Decodes frames whose value is their index in the stream, so any mix can be checked
+// against the expected position. p_work simulates the cost of a real decoder.
+class TestPlayback : public AudioStreamPlaybackDecoded {
+	uint32_t position = 0;
+
+protected:
+	virtual int _decode(AudioFrame *p_buffer, int p_frames) override {
+		if (Thread::get_caller_id() != mix_thread) {
+			// Lets tests act while the prefetch thread holds the decoder.
+			while (hold_prefetch.is_set()) {
+				prefetch_held.set();
+				OS::get_singleton()->delay_usec(100);
+			}
+		}
+
+		int todo = MIN(p_frames, int(length_frames - position));
+		for (int i = 0; i < todo; i++) {
+			for (int j = 0; j < work; j++) {
+				noise = Math::sin(noise + j);
+			}
+			p_buffer[i] = AudioFrame(position + i, -float(position + i));
+		}
+		position += todo;
+		decoded_frames += todo;
+		return todo;
+	}
+
+	virtual void _decoder_seek(uint32_t p_frame) override {
+		position = MIN(p_frame, length_frames);
+	}
+
+	virtual float _get_length() const override { return length_frames / sample_rate; }
+	virtual float _get_sample_rate() const override { return sample_rate; }
+	virtual bool _has_loop() const override { return loop; }
+	virtual float _get_loop_offset() const override { return loop_offset; }
+
+public:
+	uint32_t length_frames = 1000;
+	float sample_rate = 1000;
+	bool loop = false;
+	float loop_offset = 0;
+	int work = 0;
+	float noise = 0;
+	int decoded_frames = 0;
+	Thread::ID mix_thread = Thread::get_caller_id();
+	SafeFlag hold_prefetch;
+	SafeFlag prefetch_held;
+
+	void setup(uint64_t p_stream) {
+		_setup_source(ObjectID(p_stream));
+	}
+
+	void mix_frames(AudioFrame *p_buffer, int p_frames) {
+		_mix_internal(p_buffer, p_frames);
+	}
+
+	uint32_t get_frame_position() const {
+		return uint32_t(Math::round(get_playback_position() * sample_rate));
+	}
+
+	~TestPlayback() {
+		_stop_prefetch();
+	}
+};
+
+// start() and skip() mix this many frames ahead into the resampler's buffer.
+static const uint32_t RESAMPLER_AHEAD = 256;
+
+// Mixes p_frames in blocks and checks they follow the stream from p_from, looping back to p_loop_from.
+// With p_allow_gaps, blocks may end in silence, as when the prefetch thread holds the decoder.
+static bool mixes_in_order(TestPlayback *p_playback, int p_frames, uint32_t p_from, uint32_t p_loop_from, bool p_allow_gaps = false) {
+	AudioFrame buffer[256];
+	uint32_t expected = p_from;
+	int mixed = 0;
+	while (mixed < p_frames) {
+		int todo = MIN(256, p_frames - mixed);
+		uint32_t position = p_playback->get_frame_position();
+		p_playback->mix_frames(buffer, todo);
+
+		int count = todo;
+		if (p_allow_gaps) {
+			count = (p_playback->get_frame_position() + p_playback->length_frames - position) % p_playback->length_frames;
+		}
+		for (int i = 0; i < count; i++) {
+			if (buffer[i].l != float(expected) || buffer[i].r != -float(expected)) {
+				return false;
+			}
+			expected++;
+			if (expected == p_playback->length_frames) {
+				expected = p_loop_from;
+			}
+		}
+		for (int i = count; i < todo; i++) {
+			if (buffer[i].l != 0 || buffer[i].r != 0) {
+				return false;
+			}
+		}
+		mixed += count;
+	}
+	return true;
+}
+
+TEST_CASE("[AudioStreamDecoded] Short streams are decoded once and shared") {
+	AudioDecodedCache::clear();
+	AudioDecodedCache::set_budget(1024 * 1024);
+	AudioDecodedCache::set_max_stream_length(5.0);
+
+	Ref<TestPlayback> first = memnew(TestPlayback);
+	first->setup(1);
+	CHECK(first->is_cached());
+	CHECK(first->decoded_frames == 1000);
+	CHECK(AudioDecodedCache::get_used_bytes() == 1000 * sizeof(AudioFrame));
+
+	Ref<TestPlayback> second = memnew(TestPlayback);
+	second->setup(1);
+	CHECK(second->is_cached());
+	CHECK_MESSAGE(second->decoded_frames == 0, "The second playback should reuse the cached frames.");
+
+	second->start(0.25);
+	CHECK(second->get_frame_position() == 250 + RESAMPLER_AHEAD);
+	CHECK(mixes_in_order(second.ptr(), 750 - RESAMPLER_AHEAD, 250 + RESAMPLER_AHEAD, 0));
+	CHECK(second->is_playing());
+
+	AudioFrame tail[16];
+	second->mix_frames(tail, 16);
+	CHECK_MESSAGE(!second->is_playing(), "Playback should stop at the end of a non-looping stream.");
+	CHECK(tail[15].l == 0);
+
+	Ref<TestPlayback> looping = memnew(TestPlayback);
+	looping->loop = true;
+	looping->loop_offset = 0.2;
+	looping->setup(1);
+	looping->start();
+	CHECK(mixes_in_order(looping.ptr(), 2500 - RESAMPLER_AHEAD, RESAMPLER_AHEAD, 200));
+	CHECK(looping->get_loop_count() == 2);
+	CHECK(Math::is_equal_approx(looping->get_playback_position(), 0.9f));
+
+	AudioDecodedCache::clear();
+	CHECK(AudioDecodedCache::get_used_bytes() == 0);
+}
+
+TEST_CASE("[AudioStreamDecoded] Cache eviction") {
+	const uint64_t entry_bytes = 1000 * sizeof(AudioFrame);
+	AudioDecodedCache::clear();
+	AudioDecodedCache::set_budget(entry_bytes * 3);
+	AudioDecodedCache::set_max_stream_length(5.0);
+
+	Vector<AudioFrame> frames;
+	frames.resize(1000);
+	for (uint64_t i = 1; i <= 3; i++) {
+		AudioDecodedCache::put(ObjectID(i), frames);
+	}
+	CHECK(AudioDecodedCache::get_used_bytes() == entry_bytes * 3);
+
+	Vector<AudioFrame> found;
+	CHECK(AudioDecodedCache::get(ObjectID(uint64_t(1)), found));
+	CHECK(found.size() == 1000);
+
+	// Over budget, the least recently used stream goes first.
+	AudioDecodedCache::put(ObjectID(uint64_t(4)), frames);
+	CHECK(AudioDecodedCache::get_used_bytes() == entry_bytes * 3);
+	CHECK(AudioDecodedCache::get(ObjectID(uint64_t(1)), found));
+	CHECK(!AudioDecodedCache::get(ObjectID(uint64_t(2)), found));
+
+	AudioDecodedCache::erase(ObjectID(uint64_t(3)));
+	CHECK(AudioDecodedCache::get_used_bytes() == entry_bytes * 2);
+
+	AudioDecodedCache::set_budget(entry_bytes);
+	CHECK(AudioDecodedCache::get_used_bytes() == entry_bytes);
+
+	// Streams larger than the whole budget are played without caching.
+	Ref<TestPlayback> large = memnew(TestPlayback);
+	large->length_frames = 2000;
+	large->setup(5);
+	CHECK(!large->is_cached());
+	CHECK(!AudioDecodedCache::get(ObjectID(uint64_t(5)), found));
+	large->start();
+	CHECK(mixes_in_order(large.ptr(), 2000 - RESAMPLER_AHEAD, RESAMPLER_AHEAD, 0));
+
+	AudioDecodedCache::clear();
+	AudioDecodedCache::set_budget(16 * 1024 * 1024);
+}
+
+TEST_CASE("[AudioStreamDecoded] Decoding while playing") {
+	AudioDecodedCache::set_max_stream_length(0);
+
+	Ref<TestPlayback> playback = memnew(TestPlayback);
+	playback->loop = true;
+	playback->loop_offset = 0.5;
+	playback->setup(1);
+	CHECK(!playback->is_cached());
+	CHECK(!playback->is_prefetching());
+
+	playback->start(0.1);
+	CHECK(mixes_in_order(playback.ptr(), 3000 - RESAMPLER_AHEAD, 100 + RESAMPLER_AHEAD, 500));
+	CHECK(playback->get_loop_count() == 5);
+
+	// Skips from 600 to 850, then mixes ahead past the end, looping back to 500.
+	playback->skip(0.25);
+	CHECK(playback->get_frame_position() == 850 + RESAMPLER_AHEAD - 500);
+	CHECK(mixes_in_order(playback.ptr(), 1000, 850 + RESAMPLER_AHEAD - 500, 500));
+
+	AudioDecodedCache::set_max_stream_length(5.0);
+}
+
+TEST_CASE("[AudioStreamDecoded] Prefetching long streams") {
+	AudioDecodedCache::set_max_stream_length(0);
+	AudioStreamPlaybackDecoded::set_prefetch_enabled(true);
+	AudioStreamPlaybackDecoded::set_prefetch_min_length(0);
+
+	Ref<TestPlayback> playback = memnew(TestPlayback);
+	playback->length_frames = 100000;
+	playback->loop = true;
+	playback->setup(1);
+	CHECK(playback->is_prefetching());
+
+	// Frames come in order whether the prefetch thread keeps up or not. When it's busy
+	// decoding, the mix gets silence instead of waiting for it.
+	// Whether start() could mix ahead depends on the prefetch thread too.
+	playback->start();
+	CHECK(mixes_in_order(playback.ptr(), 20000, playback->get_frame_position(), 0, true));
+	OS::get_singleton()->delay_usec(10000);
+	CHECK(mixes_in_order(playback.ptr(), 20000, playback->get_frame_position(), 0, true));
+
+	playback->seek(90.0);
+	CHECK(mixes_in_order(playback.ptr(), 20000, 90000, 0, true));
+	CHECK(playback->is_playing());
+	CHECK(playback->get_loop_count() == 1);
+	CHECK(Math::is_equal_approx(playback->get_playback_position(), 10.0f));
+
+	playback.unref();
+	AudioStreamPlaybackDecoded::finish_prefetch();
+	AudioStreamPlaybackDecoded::set_prefetch_enabled(false);
+	AudioStreamPlaybackDecoded::set_prefetch_min_length(10.0);
+	AudioDecodedCache::set_max_stream_length(5.0);
+}
+
+TEST_CASE("[AudioStreamDecoded] Seeking while the prefetch thread decodes") {
+	AudioDecodedCache::set_max_stream_length(0);
+	AudioStreamPlaybackDecoded::set_prefetch_enabled(true);
+	AudioStreamPlaybackDecoded::set_prefetch_min_length(0);
+
+	Ref<TestPlayback> playback = memnew(TestPlayback);
+	playback->length_frames = 100000;
+	playback->setup(1);
+	CHECK(playback->is_prefetching());
+
+	playback->hold_prefetch.set();
+	playback->start();
+	for (int i = 0; i < 1000 && !playback->prefetch_held.is_set(); i++) {
+		OS::get_singleton()->delay_usec(1000);
+	}
+	REQUIRE(playback->prefetch_held.is_set());
+
+	// Neither of these may wait for the decoder.
+	playback->seek(50.0);
+	CHECK(playback->get_frame_position() == 50000);
+	playback->start(20.0);
+	CHECK(playback->get_frame_position() == 20000);
+
+	AudioFrame buffer[256];
+	playback->mix_frames(buffer, 256);
+	CHECK_MESSAGE(buffer[0].l == 0, "The mix should play silence until the seek is applied.");
+	CHECK(playback->get_frame_position() == 20000);
+	CHECK(playback->is_playing());
+
+	playback->hold_prefetch.clear();
+	CHECK_MESSAGE(mixes_in_order(playback.ptr(), 20000, 20000, 0, true), "Frames prefetched for the old position should be dropped.");
+
+	playback.unref();
+	AudioStreamPlaybackDecoded::finish_prefetch();
+	AudioStreamPlaybackDecoded::set_prefetch_enabled(false);
+	AudioStreamPlaybackDecoded::set_prefetch_min_length(10.0);
+	AudioDecodedCache::set_max_stream_length(5.0);
+}
+
+TEST_CASE("[AudioStreamDecoded][Benchmark] Many concurrent playbacks of a short stream" * doctest::skip()) {
+	const int playback_count = 50;
+	const int block = 512;
+	const int blocks = 200;
+
+	for (int cached = 0; cached < 2; cached++) {
+		AudioDecodedCache::clear();
+		AudioDecodedCache::set_max_stream_length(cached ? 5.0 : 0.0);
+
+		AudioFrame buffer[block];
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		Vector<Ref<TestPlayback>> playbacks;
+		for (int i = 0; i < playback_count; i++) {
+			Ref<TestPlayback> playback = memnew(TestPlayback);
+			playback->length_frames = 44100;
+			playback->sample_rate = 44100;
+			playback->loop = true;
+			playback->work = 8;
+			playback->setup(1);
+			playback->start(i * 0.01);
+			playbacks.push_back(playback);
+		}
+		for (int i = 0; i < blocks; i++) {
+			for (int j = 0; j < playback_count; j++) {
+				playbacks.write[j]->mix_frames(buffer, block);
+			}
+		}
+		double elapsed_msec = (OS::get_singleton()->get_ticks_usec() - begin) / 1000.0;
+		MESSAGE(vformat("%s: %d playbacks, %d frames each, %.2f msec", cached ? "Cached" : "Decoding", playback_count, block * blocks, elapsed_msec));
+	}
+
+	AudioDecodedCache::clear();
+	AudioDecodedCache::set_max_stream_length(5.0);
+}
+
+} // namespace TestAudioStreamDecoded
+
+#endif // TEST_AUDIO_STREAM_DECODED_H
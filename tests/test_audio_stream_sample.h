@@ -0,0 +1,121 @@
+/*************************************************************************/
+/*  test_audio_stream_sample.h                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_AUDIO_STREAM_SAMPLE_H
+#define TEST_AUDIO_STREAM_SAMPLE_H
+
+#include "scene/resources/audio_stream_sample.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestAudioStreamSample {
+
+// One second of silence at 1000 Hz, looping between 0.2 and 0.6 seconds.
+static Ref<AudioStreamPlayback> create_playback(AudioStreamSample::LoopMode p_loop_mode) {
+	Vector<uint8_t> data;
+	data.resize(1000 * 2);
+	data.fill(0);
+
+	Ref<AudioStreamSample> sample = memnew(AudioStreamSample);
+	sample->set_format(AudioStreamSample::FORMAT_16_BITS);
+	sample->set_mix_rate(1000);
+	sample->set_data(data);
+	sample->set_loop_mode(p_loop_mode);
+	sample->set_loop_begin(200);
+	sample->set_loop_end(600);
+
+	Ref<AudioStreamPlayback> playback = sample->instance_playback();
+	playback->start(0);
+	return playback;
+}
+
+TEST_CASE("[AudioStreamSample] Skipping without a loop") {
+	Ref<AudioStreamPlayback> playback = create_playback(AudioStreamSample::LOOP_DISABLED);
+
+	playback->skip(0.5);
+	CHECK(playback->is_playing());
+	CHECK(Math::is_equal_approx(playback->get_playback_position(), 0.5f));
+
+	playback->skip(0.6);
+	CHECK_MESSAGE(!playback->is_playing(), "Skipping past the end should stop the playback.");
+
+	playback->skip(0.1);
+	CHECK_MESSAGE(!playback->is_playing(), "Skipping a stopped playback should do nothing.");
+}
+
+TEST_CASE("[AudioStreamSample] Skipping with a forward loop") {
+	Ref<AudioStreamPlayback> playback = create_playback(AudioStreamSample::LOOP_FORWARD);
+
+	playback->skip(0.1);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.1f), "The part before the loop should play once.");
+
+	playback->skip(0.6);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.3f), "Skipping past the loop end should wrap to the loop begin.");
+
+	playback->skip(1000.05);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.35f, 0.002f), "Long skips should wrap as many times as needed.");
+	CHECK(playback->is_playing());
+}
+
+TEST_CASE("[AudioStreamSample] Skipping with a backward loop") {
+	Ref<AudioStreamPlayback> playback = create_playback(AudioStreamSample::LOOP_BACKWARD);
+
+	playback->skip(0.1);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.3f), "Playing backward from the start should wrap to the loop end.");
+
+	playback->skip(0.25);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.45f), "Skipping past the loop begin should wrap to the loop end.");
+
+	playback->skip(1000.05);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.4f, 0.002f), "Long skips should wrap as many times as needed.");
+	CHECK(playback->is_playing());
+}
+
+TEST_CASE("[AudioStreamSample] Skipping with a ping-pong loop") {
+	Ref<AudioStreamPlayback> playback = create_playback(AudioStreamSample::LOOP_PING_PONG);
+
+	playback->skip(0.7);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.5f), "Skipping past the loop end should bounce back.");
+
+	playback->skip(0.4);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.3f), "Skipping past the loop begin should bounce forward.");
+
+	playback->skip(0.1);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.4f), "The playback should keep the direction of the last bounce.");
+
+	playback->skip(1000.4);
+	CHECK_MESSAGE(Math::is_equal_approx(playback->get_playback_position(), 0.4f, 0.002f), "Long skips should bounce as many times as needed.");
+	CHECK(playback->is_playing());
+}
+
+} // namespace TestAudioStreamSample
+
+#endif // TEST_AUDIO_STREAM_SAMPLE_H
@@ -114,6 +114,7 @@ public:
 		TEST_MSGSYNC_FUNC2_TRANSFORM_FLOAT,
 		TEST_MSGRET_FUNC1_TRANSFORM,
 		TEST_MSGRET_FUNC2_TRANSFORM_FLOAT,
+		TEST_MSG_FUNC1_PAYLOAD,
 		TEST_MSG_MAX
 	};
 
@@ -127,6 +128,10 @@ public:
 
 	int func1_count = 0;
 
+	struct Payload {
+		uint8_t data[2048] = {};
+	};
+
 	void func1(Transform t) {
 		func1_count++;
 	}
@@ -136,6 +141,9 @@ public:
 	void func3(Transform t1, Transform t2, Transform t3, Transform t4, Transform t5, Transform t6) {
 		func1_count++;
 	}
+	void func1_payload(Payload p) {
+		func1_count++;
+	}
 	Transform func1r(Transform t) {
 		func1_count++;
 		return t;
@@ -178,6 +186,7 @@ public:
 			Transform tr;
 			Transform otr;
 			float f = 1;
+			Payload payload;
 			during_writing = true;
 			for (int i = 0; i < message_types_to_write.size(); i++) {
 				TestMsgType msg_type = message_types_to_write[i];
@@ -203,6 +212,9 @@ public:
 					case TEST_MSGRET_FUNC2_TRANSFORM_FLOAT:
 						command_queue.push_and_ret(this, &SharedThreadState::func2r, tr, f, &otr);
 						break;
+					case TEST_MSG_FUNC1_PAYLOAD:
+						command_queue.push(this, &SharedThreadState::func1_payload, payload);
+						break;
 					default:
 						break;
 				}
@@ -276,7 +288,7 @@ TEST_CASE("[CommandQueue] Test Queue Basics") {
 			ProjectSettings::get_singleton()->property_get_revert(COMMAND_QUEUE_SETTING));
 }
 
-TEST_CASE("[CommandQueue] Test Waiting at Queue Full") {
+TEST_CASE("[CommandQueue] Test Growing at Queue Full") {
 	const char *COMMAND_QUEUE_SETTING = "memory/limits/command_queue/multithreading_queue_size_kb";
 	ProjectSettings::get_singleton()->set_setting(COMMAND_QUEUE_SETTING, 1);
 	SharedThreadState sts;
@@ -287,30 +299,27 @@ TEST_CASE("[CommandQueue] Test Waiting at Queue Full") {
 		sts.add_msg_to_write(SharedThreadState::TEST_MSG_FUNC1_TRANSFORM);
 	}
 	sts.writer_threadwork.main_start_work();
-	// If we call main_wait_for_done, we will deadlock. So instead...
+	sts.writer_threadwork.main_wait_for_done();
+	CHECK_MESSAGE(sts.func1_count == 0,
+			"Control: no messages read before reader has run.");
+	CHECK_MESSAGE(sts.during_writing == false,
+			"Writer thread should not be blocked when a page is full.");
+	CHECK_MESSAGE(sts.command_queue.get_stats().page_count > 1,
+			"Queue should have grown to more than one page.");
+
 	sts.message_count_to_read = 1;
 	sts.reader_threadwork.main_start_work();
 	sts.reader_threadwork.main_wait_for_done();
 	CHECK_MESSAGE(sts.func1_count == 1,
 			"Reader should have read one message");
-	CHECK_MESSAGE(sts.during_writing,
-			"Writer thread should still be blocked on writing.");
-	sts.message_count_to_read = msgs_to_add - 3;
-	sts.reader_threadwork.main_start_work();
-	sts.reader_threadwork.main_wait_for_done();
-	CHECK_MESSAGE(sts.func1_count >= msgs_to_add - 3,
-			"Reader should have read most messages");
-	sts.writer_threadwork.main_wait_for_done();
-	CHECK_MESSAGE(sts.during_writing == false,
-			"Writer thread should no longer be blocked on writing.");
-	sts.message_count_to_read = 2;
-	sts.reader_threadwork.main_start_work();
-	sts.reader_threadwork.main_wait_for_done();
+
 	sts.message_count_to_read = -1;
 	sts.reader_threadwork.main_start_work();
 	sts.reader_threadwork.main_wait_for_done();
 	CHECK_MESSAGE(sts.func1_count == msgs_to_add,
 			"Reader should have read all messages");
+	CHECK_MESSAGE(sts.command_queue.get_stats().commands_flushed == (uint64_t)msgs_to_add,
+			"All messages should be counted as flushed.");
 
 	sts.destroy_threads();
 
@@ -320,6 +329,33 @@ TEST_CASE("[CommandQueue] Test Waiting at Queue Full") {
 			ProjectSettings::get_singleton()->property_get_revert(COMMAND_QUEUE_SETTING));
 }
 
+TEST_CASE("[CommandQueue] Test Commands Bigger Than a Page") {
+	const char *COMMAND_QUEUE_SETTING = "memory/limits/command_queue/multithreading_queue_size_kb";
+	ProjectSettings::get_singleton()->set_setting(COMMAND_QUEUE_SETTING, 1);
+	SharedThreadState sts;
+	sts.init_threads();
+
+	// Payload commands don't fit in a 1kB page, so this alternates between regular pages and
+	// oversized ones.
+	for (int i = 0; i < 10; i++) {
+		sts.add_msg_to_write(SharedThreadState::TEST_MSG_FUNC3_TRANSFORMx6);
+		sts.add_msg_to_write(SharedThreadState::TEST_MSG_FUNC1_PAYLOAD);
+		sts.add_msg_to_write(SharedThreadState::TEST_MSG_FUNC1_TRANSFORM);
+	}
+	sts.writer_threadwork.main_start_work();
+	sts.writer_threadwork.main_wait_for_done();
+
+	sts.message_count_to_read = -1;
+	sts.reader_threadwork.main_start_work();
+	sts.reader_threadwork.main_wait_for_done();
+	CHECK_MESSAGE(sts.func1_count == 30,
+			"Reader should have read all messages");
+
+	sts.destroy_threads();
+	ProjectSettings::get_singleton()->set_setting(COMMAND_QUEUE_SETTING,
+			ProjectSettings::get_singleton()->property_get_revert(COMMAND_QUEUE_SETTING));
+}
+
 TEST_CASE("[CommandQueue] Test Queue Wrapping to same spot.") {
 	const char *COMMAND_QUEUE_SETTING = "memory/limits/command_queue/multithreading_queue_size_kb";
 	ProjectSettings::get_singleton()->set_setting(COMMAND_QUEUE_SETTING, 1);
@@ -470,6 +506,78 @@ TEST_CASE("[Stress][CommandQueue] Stress test command queue") {
 	ProjectSettings::get_singleton()->set_setting(COMMAND_QUEUE_SETTING,
 			ProjectSettings::get_singleton()->property_get_revert(COMMAND_QUEUE_SETTING));
 }
+
+// Stands in for a server running on its own thread, receiving the kind of calls a scene
+// makes to the RenderingServer every frame.
+class BenchmarkServer {
+public:
+	CommandQueueMT command_queue = CommandQueueMT(true);
+	Thread thread;
+	bool exit = false;
+	uint64_t work = 0;
+
+	void instance_set_transform(RID p_instance, const Transform &p_transform) {
+		work += p_instance.get_id();
+	}
+	void canvas_item_add_rect(RID p_item, const Rect2 &p_rect, const Color &p_color) {
+		work += p_item.get_id();
+	}
+	void material_set_param(RID p_material, const StringName &p_param, const Variant &p_value) {
+		work += p_material.get_id();
+	}
+	int viewport_get_render_info(RID p_viewport, int p_info) {
+		return p_info;
+	}
+	void draw() {
+		work++;
+	}
+	void finish() {
+		exit = true;
+	}
+
+	static void thread_func(void *p_userdata) {
+		BenchmarkServer *server = static_cast<BenchmarkServer *>(p_userdata);
+		while (!server->exit) {
+			server->command_queue.wait_and_flush();
+		}
+		server->command_queue.flush_all();
+	}
+};
+
+TEST_CASE("[CommandQueue][Benchmark] Per-frame rendering traffic" * doctest::skip()) {
+	const int frames = 1000;
+	const int instances = 2000;
+	const int rects = 500;
+	const int materials = 50;
+
+	BenchmarkServer server;
+	server.thread.start(&BenchmarkServer::thread_func, &server);
+
+	StringName param = "albedo";
+	int info = 0;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < frames; i++) {
+		for (int j = 0; j < instances; j++) {
+			server.command_queue.push(&server, &BenchmarkServer::instance_set_transform, RID::from_uint64(j), Transform(Basis(), Vector3(i, j, 0)));
+		}
+		for (int j = 0; j < rects; j++) {
+			server.command_queue.push(&server, &BenchmarkServer::canvas_item_add_rect, RID::from_uint64(j), Rect2(j, i, 16, 16), Color(1, 1, 1));
+		}
+		for (int j = 0; j < materials; j++) {
+			server.command_queue.push(&server, &BenchmarkServer::material_set_param, RID::from_uint64(j), param, Variant(float(i)));
+		}
+		server.command_queue.push_and_ret(&server, &BenchmarkServer::viewport_get_render_info, RID(), i, &info);
+		server.command_queue.push(&server, &BenchmarkServer::draw);
+	}
+	server.command_queue.push_and_sync(&server, &BenchmarkServer::finish);
+	uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+	server.thread.wait_to_finish();
+
+	CommandQueueMT::Stats stats = server.command_queue.get_stats();
+	CHECK(stats.commands_flushed == uint64_t(frames) * (instances + rects + materials + 2) + 1);
+	MESSAGE(vformat("%d frames in %.2f ms (%.2f us per frame), %d commands.", frames, usec / 1000.0, double(usec) / frames, stats.commands_flushed));
+	MESSAGE(vformat("Writer blocked for %.2f ms, reader idle for %.2f ms, %d pages.", stats.sync_wait_usec / 1000.0, stats.flush_wait_usec / 1000.0, stats.page_count));
+}
 } // namespace TestCommandQueue
 
 #endif // !defined(NO_THREADS)
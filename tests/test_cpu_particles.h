@@ -0,0 +1,268 @@
+/*************************************************************************/
+/*  test_cpu_particles.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_CPU_PARTICLES_H
+#define TEST_CPU_PARTICLES_H
+
+#include "core/os/os.h"
+#include "core/templates/thread_work_pool.h"
+#include "scene/2d/cpu_particles_2d.h"
+#include "scene/3d/cpu_particles_3d.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestCPUParticles {
+
+// Uses every stage of the update: curves, the color ramp, hue variation, damping and random spreads.
+static void setup_simulation_3d(CPUParticles3D::Simulation &r_simulation, int p_amount) {
+	r_simulation.emitting = true;
+	r_simulation.set_amount(p_amount);
+	r_simulation.lifetime = 1.5;
+	r_simulation.randomness_ratio = 0.5;
+	r_simulation.lifetime_randomness = 0.3;
+	r_simulation.spread = 120.0;
+	r_simulation.emission_shape = CPUParticles3D::EMISSION_SHAPE_SPHERE;
+	r_simulation.particle_flags[CPUParticles3D::PARTICLE_FLAG_ALIGN_Y_TO_VELOCITY] = true;
+
+	r_simulation.parameters[CPUParticles3D::PARAM_INITIAL_LINEAR_VELOCITY] = 4.0;
+	r_simulation.parameters[CPUParticles3D::PARAM_RADIAL_ACCEL] = 1.0;
+	r_simulation.parameters[CPUParticles3D::PARAM_DAMPING] = 0.5;
+	r_simulation.parameters[CPUParticles3D::PARAM_SCALE] = 1.0;
+	r_simulation.parameters[CPUParticles3D::PARAM_HUE_VARIATION] = 0.3;
+	for (int i = 0; i < CPUParticles3D::PARAM_MAX; i++) {
+		r_simulation.randomness[i] = 0.5;
+	}
+
+	Ref<Curve> scale = memnew(Curve);
+	scale->add_point(Vector2(0, 1));
+	scale->add_point(Vector2(1, 0.2));
+	r_simulation.curve_parameters[CPUParticles3D::PARAM_SCALE] = scale;
+
+	Ref<Gradient> ramp = memnew(Gradient);
+	ramp->add_point(0.5, Color(1, 0.5, 0, 1));
+	r_simulation.color_ramp = ramp;
+}
+
+static void setup_simulation_2d(CPUParticles2D::Simulation &r_simulation, int p_amount) {
+	r_simulation.emitting = true;
+	r_simulation.set_amount(p_amount);
+	r_simulation.lifetime = 1.5;
+	r_simulation.randomness_ratio = 0.5;
+	r_simulation.lifetime_randomness = 0.3;
+	r_simulation.spread = 120.0;
+	r_simulation.emission_shape = CPUParticles2D::EMISSION_SHAPE_SPHERE;
+
+	r_simulation.parameters[CPUParticles2D::PARAM_INITIAL_LINEAR_VELOCITY] = 200.0;
+	r_simulation.parameters[CPUParticles2D::PARAM_ORBIT_VELOCITY] = 0.2;
+	r_simulation.parameters[CPUParticles2D::PARAM_DAMPING] = 10.0;
+	r_simulation.parameters[CPUParticles2D::PARAM_SCALE] = 1.0;
+	r_simulation.parameters[CPUParticles2D::PARAM_HUE_VARIATION] = 0.3;
+	for (int i = 0; i < CPUParticles2D::PARAM_MAX; i++) {
+		r_simulation.randomness[i] = 0.5;
+	}
+
+	Ref<Curve> scale = memnew(Curve);
+	scale->add_point(Vector2(0, 1));
+	scale->add_point(Vector2(1, 0.2));
+	r_simulation.curve_parameters[CPUParticles2D::PARAM_SCALE] = scale;
+
+	Ref<Gradient> ramp = memnew(Gradient);
+	ramp->add_point(0.5, Color(1, 0.5, 0, 1));
+	r_simulation.color_ramp = ramp;
+}
+
+TEST_CASE("[CPUParticles3D] Chunked simulation matches serial simulation") {
+	// Several chunks, and a partial one at the end to cover the scalar tail of each stage.
+	const int amount = CPUParticles3D::PROCESS_CHUNK_SIZE * 4 + 3;
+	const Transform emission_xform(Basis(Vector3(0, 1, 0), 0.5), Vector3(1, 2, 3));
+
+	CPUParticles3D::Simulation serial;
+	CPUParticles3D::Simulation chunked;
+	setup_simulation_3d(serial, amount);
+	setup_simulation_3d(chunked, amount);
+	serial.local_coords = false;
+	chunked.local_coords = false;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init(4);
+
+	Math::seed(42);
+	for (int i = 0; i < 90; i++) {
+		serial.process(1.0 / 60.0, emission_xform);
+	}
+	Math::seed(42);
+	for (int i = 0; i < 90; i++) {
+		chunked.process(1.0 / 60.0, emission_xform, &thread_pool);
+	}
+
+	thread_pool.finish();
+
+	int active = 0;
+	int mismatches = 0;
+	for (int i = 0; i < amount; i++) {
+		const CPUParticles3D::Particle &a = serial.particles[i];
+		const CPUParticles3D::Particle &b = chunked.particles[i];
+		active += a.active;
+		if (a.active != b.active || a.time != b.time || a.custom[0] != b.custom[0] || a.custom[2] != b.custom[2] ||
+				serial.get_transform(i) != chunked.get_transform(i) ||
+				serial.get_velocity(i) != chunked.get_velocity(i) ||
+				serial.get_color(i) != chunked.get_color(i)) {
+			mismatches++;
+		}
+	}
+
+	CHECK_MESSAGE(mismatches == 0, "Particles simulated in chunks on worker threads should match the serial simulation exactly.");
+	CHECK_MESSAGE(active > amount / 2, "Most particles should be alive, or the comparison proves nothing.");
+}
+
+TEST_CASE("[CPUParticles2D] Chunked simulation matches serial simulation") {
+	const int amount = CPUParticles2D::PROCESS_CHUNK_SIZE * 4 + 3;
+	const Transform2D emission_xform(0.5, Vector2(10, 20));
+
+	CPUParticles2D::Simulation serial;
+	CPUParticles2D::Simulation chunked;
+	setup_simulation_2d(serial, amount);
+	setup_simulation_2d(chunked, amount);
+	serial.local_coords = false;
+	chunked.local_coords = false;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init(4);
+
+	Math::seed(42);
+	for (int i = 0; i < 90; i++) {
+		serial.process(1.0 / 60.0, emission_xform);
+	}
+	Math::seed(42);
+	for (int i = 0; i < 90; i++) {
+		chunked.process(1.0 / 60.0, emission_xform, &thread_pool);
+	}
+
+	thread_pool.finish();
+
+	int active = 0;
+	int mismatches = 0;
+	for (int i = 0; i < amount; i++) {
+		const CPUParticles2D::Particle &a = serial.particles[i];
+		const CPUParticles2D::Particle &b = chunked.particles[i];
+		active += a.active;
+		if (a.active != b.active || a.time != b.time || a.rotation != b.rotation || a.custom[2] != b.custom[2] ||
+				serial.get_transform(i) != chunked.get_transform(i) ||
+				serial.get_velocity(i) != chunked.get_velocity(i) ||
+				serial.get_color(i) != chunked.get_color(i)) {
+			mismatches++;
+		}
+	}
+
+	CHECK_MESSAGE(mismatches == 0, "Particles simulated in chunks on worker threads should match the serial simulation exactly.");
+	CHECK_MESSAGE(active > amount / 2, "Most particles should be alive, or the comparison proves nothing.");
+}
+
+TEST_CASE("[CPUParticles3D] Color stage applies the hue rotation") {
+	const int amount = 7;
+	CPUParticles3D::Simulation simulation;
+	setup_simulation_3d(simulation, amount);
+
+	Math::seed(7);
+	for (int i = 0; i < 30; i++) {
+		simulation.process(1.0 / 60.0, Transform());
+	}
+
+	// Same as the per particle Basis the hue rotation was computed with before the stage was split out.
+	const Basis mat1(0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114);
+	const Basis mat2(0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886);
+	const Basis mat3(0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203);
+
+	for (int i = 0; i < amount; i++) {
+		Basis hue_rot_mat;
+		for (int j = 0; j < 3; j++) {
+			hue_rot_mat[j] = mat1[j] + mat2[j] * simulation.hue_rotations[0][i] + mat3[j] * simulation.hue_rotations[1][i];
+		}
+		Color ramp(simulation.ramp_colors[0][i], simulation.ramp_colors[1][i], simulation.ramp_colors[2][i], simulation.ramp_colors[3][i]);
+		Color base(simulation.base_colors[0][i], simulation.base_colors[1][i], simulation.base_colors[2][i], simulation.base_colors[3][i]);
+		Vector3 rgb = hue_rot_mat.xform_inv(Vector3(ramp.r, ramp.g, ramp.b));
+		Color expected = Color(rgb.x, rgb.y, rgb.z, ramp.a) * base;
+
+		CHECK_MESSAGE(simulation.get_color(i).is_equal_approx(expected), "Colors should be the ramp color, rotated in hue and tinted by the emission color.");
+	}
+}
+
+TEST_CASE("[CPUParticles3D][Benchmark] Simulating 100K particles" * doctest::skip()) {
+	const int amount = 100000;
+	const int frames = 120;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	for (int threaded = 0; threaded < 2; threaded++) {
+		CPUParticles3D::Simulation simulation;
+		setup_simulation_3d(simulation, amount);
+
+		Math::seed(42);
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < frames; i++) {
+			simulation.process(1.0 / 60.0, Transform(), threaded ? &thread_pool : nullptr);
+		}
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		MESSAGE(vformat("%s: %d particles, %d frames: %d usec (%d particles/ms).", threaded ? "Chunked" : "Serial", amount, frames, elapsed, uint64_t(amount) * frames * 1000 / MAX(elapsed, uint64_t(1))));
+	}
+
+	thread_pool.finish();
+}
+
+TEST_CASE("[CPUParticles2D][Benchmark] Simulating 100K particles" * doctest::skip()) {
+	const int amount = 100000;
+	const int frames = 120;
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	for (int threaded = 0; threaded < 2; threaded++) {
+		CPUParticles2D::Simulation simulation;
+		setup_simulation_2d(simulation, amount);
+
+		Math::seed(42);
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < frames; i++) {
+			simulation.process(1.0 / 60.0, Transform2D(), threaded ? &thread_pool : nullptr);
+		}
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		MESSAGE(vformat("%s: %d particles, %d frames: %d usec (%d particles/ms).", threaded ? "Chunked" : "Serial", amount, frames, elapsed, uint64_t(amount) * frames * 1000 / MAX(elapsed, uint64_t(1))));
+	}
+
+	thread_pool.finish();
+}
+
+} // namespace TestCPUParticles
+
+#endif // TEST_CPU_PARTICLES_H
@@ -155,5 +155,45 @@ TEST_CASE("[Dictionary] keys() and values()") {
 	CHECK(int(keys[0]) == 1);
 	CHECK(int(values[0]) == 3);
 }
+
+TEST_CASE("[Dictionary] Move constructor and assignment") {
+	Dictionary map;
+	map[1] = 2;
+	const void *id = map.id();
+
+	Dictionary moved = std::move(map);
+	CHECK(moved.id() == id);
+	CHECK(int(moved[1]) == 2);
+	CHECK_MESSAGE(map.is_empty(), "The moved-from dictionary should be left empty.");
+	map[3] = 4;
+	CHECK(map.size() == 1);
+
+	Dictionary assigned;
+	assigned["old"] = true;
+	assigned = std::move(moved);
+	CHECK(assigned.id() == id);
+	CHECK(!assigned.has("old"));
+	CHECK(moved.is_empty());
+
+	// Implicit moves of structs holding dictionaries leave them usable too.
+	struct Holder {
+		Dictionary dict;
+	};
+	Holder a;
+	a.dict[1] = 1;
+	Holder b = std::move(a);
+	CHECK(b.dict.size() == 1);
+	CHECK(a.dict.is_empty());
+	a.dict[2] = 2;
+	CHECK(a.dict.size() == 1);
+
+	// Copies of a moved-from dictionary still share its data.
+	Dictionary source;
+	Dictionary target = std::move(source);
+	Dictionary copy = source;
+	copy[5] = 6;
+	CHECK_MESSAGE(source.size() == 1, "Copies of a moved-from dictionary should share its data.");
+	CHECK(target.is_empty());
+}
 } // namespace TestDictionary
 #endif // TEST_DICTIONARY_H
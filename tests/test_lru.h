@@ -95,6 +95,47 @@ TEST_CASE("[LRU] Resize and clear") {
 	CHECK(!lru.has(3));
 	CHECK(!lru.has(4));
 }
+
+static int evicted_sum = 0;
+
+static void _sum_evicted(int &p_key, int &p_data) {
+	evicted_sum += p_data;
+}
+
+TEST_CASE("[LRU] Erase and eviction callback") {
+	LRUCache<int, int, _sum_evicted> lru;
+	evicted_sum = 0;
+
+	lru.set_capacity(3);
+	lru.insert(1, 1);
+	lru.insert(2, 2);
+	lru.insert(3, 4);
+	CHECK(lru.get_size() == 3);
+
+	lru.insert(4, 8); // Evicts <1>.
+	CHECK(evicted_sum == 1);
+	CHECK(!lru.has(1));
+
+	lru.insert(2, 16); // Replaces <2>.
+	CHECK(evicted_sum == 3);
+	CHECK(lru.get(2) == 16);
+	CHECK(lru.get_size() == 3);
+
+	CHECK(lru.erase(3));
+	CHECK(!lru.erase(3));
+	CHECK(evicted_sum == 7);
+	CHECK(!lru.has(3));
+	CHECK(lru.get_size() == 2);
+
+	lru.set_capacity(1); // Evicts <4>, as <2> was used last.
+	CHECK(evicted_sum == 15);
+	CHECK(lru.has(2));
+	CHECK(!lru.has(4));
+
+	lru.clear();
+	CHECK(evicted_sum == 15);
+	CHECK(lru.get_size() == 0);
+}
 } // namespace TestLRU
 
 #endif // TEST_LRU_H
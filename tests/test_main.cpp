@@ -33,13 +33,21 @@
 #include "core/templates/list.h"
 
 #include "test_aabb.h"
+#include "test_animation.h"
+#include "test_animation_process_batch.h"
+#include "test_animation_tree.h"
 #include "test_array.h"
 #include "test_astar.h"
+#include "test_audio_mix_kernels.h"
+#include "test_audio_server.h"
+#include "test_audio_stream_decoded.h"
+#include "test_audio_stream_sample.h"
 #include "test_basis.h"
 #include "test_class_db.h"
 #include "test_color.h"
 #include "test_command_queue.h"
 #include "test_config_file.h"
+#include "test_cpu_particles.h"
 #include "test_crypto.h"
 #include "test_curve.h"
 #include "test_dictionary.h"
@@ -70,8 +78,13 @@
 #include "test_random_number_generator.h"
 #include "test_rect2.h"
 #include "test_render.h"
+#include "test_renderer_canvas_cull.h"
+#include "test_renderer_scene_cull.h"
+#include "test_renderer_scene_occlusion_cull.h"
 #include "test_resource.h"
+#include "test_shader_cache_rd.h"
 #include "test_shader_lang.h"
+#include "test_skeleton_3d.h"
 #include "test_string.h"
 #include "test_text_server.h"
 #include "test_translation.h"
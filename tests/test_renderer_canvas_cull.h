@@ -0,0 +1,303 @@
+/*************************************************************************/
+/*  test_renderer_canvas_cull.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_CANVAS_CULL_H
+#define TEST_RENDERER_CANVAS_CULL_H
+
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "drivers/dummy/rasterizer_dummy.h"
+#include "servers/rendering/renderer_canvas_cull.h"
+#include "servers/rendering/rendering_server_globals.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestRendererCanvasCull {
+
+// Records the items the canvas cull hands over to the renderer, in draw order.
+class RasterizerCanvasRecord : public RasterizerCanvasDummy {
+public:
+	Vector<Item *> items;
+
+	void canvas_render_items(RID p_to_render_target, Item *p_item_list, const Color &p_modulate, Light *p_light_list, Light *p_directional_list, const Transform2D &p_canvas_transform, RS::CanvasItemTextureFilter p_default_filter, RS::CanvasItemTextureRepeat p_default_repeat, bool p_snap_2d_vertices_to_pixel, bool &r_sdf_used) override {
+		items.clear();
+		for (Item *item = p_item_list; item; item = item->next) {
+			items.push_back(item);
+		}
+		r_sdf_used = false;
+	}
+};
+
+class CanvasCullFixture {
+	RendererStorage *prev_storage = nullptr;
+	RendererCanvasRender *prev_canvas_render = nullptr;
+
+public:
+	RasterizerStorageDummy storage;
+	RasterizerCanvasRecord canvas_render;
+	RendererCanvasCull canvas_cull;
+
+	RID canvas;
+	RID root;
+	Vector<RID> items;
+
+	// Lays out a grid of 32x32 rects, one canvas item each, under a single parent.
+	void create_grid(int p_width, int p_height) {
+		canvas = canvas_cull.canvas_allocate();
+		canvas_cull.canvas_initialize(canvas);
+
+		root = canvas_cull.canvas_item_allocate();
+		canvas_cull.canvas_item_initialize(root);
+		canvas_cull.canvas_item_set_parent(root, canvas);
+
+		for (int y = 0; y < p_height; y++) {
+			for (int x = 0; x < p_width; x++) {
+				RID item = canvas_cull.canvas_item_allocate();
+				canvas_cull.canvas_item_initialize(item);
+				canvas_cull.canvas_item_set_parent(item, root);
+				canvas_cull.canvas_item_set_draw_index(item, items.size());
+				canvas_cull.canvas_item_set_transform(item, Transform2D(0, Vector2(x * 32, y * 32)));
+				canvas_cull.canvas_item_add_rect(item, Rect2(0, 0, 32, 32), Color(1, 1, 1));
+				items.push_back(item);
+			}
+		}
+	}
+
+	void render(bool p_use_spatial_index, const Transform2D &p_transform, const Rect2 &p_clip_rect) {
+		canvas_cull.canvas_set_use_spatial_index(canvas, p_use_spatial_index);
+		RendererCanvasCull::Canvas *c = canvas_cull.canvas_owner.getornull(canvas);
+		canvas_cull.render_canvas(RID(), c, p_transform, nullptr, nullptr, p_clip_rect, RS::CANVAS_ITEM_TEXTURE_FILTER_DEFAULT, RS::CANVAS_ITEM_TEXTURE_REPEAT_DEFAULT, false, false);
+	}
+
+	CanvasCullFixture() {
+		prev_storage = RSG::storage;
+		prev_canvas_render = RSG::canvas_render;
+		RSG::storage = &storage;
+		RSG::canvas_render = &canvas_render;
+	}
+
+	~CanvasCullFixture() {
+		for (int i = 0; i < items.size(); i++) {
+			canvas_cull.free(items[i]);
+		}
+		if (root.is_valid()) {
+			canvas_cull.free(root);
+		}
+		if (canvas.is_valid()) {
+			canvas_cull.free(canvas);
+		}
+		RSG::storage = prev_storage;
+		RSG::canvas_render = prev_canvas_render;
+	}
+};
+
+TEST_CASE("[RendererCanvasCull] Spatial index culls the same items in the same order") {
+	CanvasCullFixture fixture;
+	fixture.create_grid(40, 40);
+
+	const Transform2D view = Transform2D(0, Vector2(-200, -150));
+	const Rect2 clip = Rect2(0, 0, 320, 240);
+
+	fixture.render(false, view, clip);
+	Vector<RendererCanvasRender::Item *> expected = fixture.canvas_render.items;
+	CHECK_MESSAGE(expected.size() > 0, "Some items should be visible.");
+	CHECK_MESSAGE(expected.size() < fixture.items.size(), "Items outside of the clip rect should be culled.");
+
+	fixture.render(true, view, clip);
+	CHECK_MESSAGE(fixture.canvas_render.items == expected, "The spatial index should not change the culled items or their order.");
+
+	// Move an item from far away into view, the index must pick up the new transform.
+	fixture.canvas_cull.canvas_item_set_transform(fixture.items[fixture.items.size() - 1], Transform2D(0, Vector2(250, 200)));
+	fixture.render(false, view, clip);
+	expected = fixture.canvas_render.items;
+	fixture.render(true, view, clip);
+	CHECK_MESSAGE(fixture.canvas_render.items == expected, "The spatial index should follow transform changes.");
+
+	// Redraw an item with a bigger rect so it reaches into view.
+	fixture.canvas_cull.canvas_item_clear(fixture.items[0]);
+	fixture.canvas_cull.canvas_item_add_rect(fixture.items[0], Rect2(0, 0, 256, 256), Color(1, 1, 1));
+	fixture.render(false, view, clip);
+	expected = fixture.canvas_render.items;
+	fixture.render(true, view, clip);
+	CHECK_MESSAGE(fixture.canvas_render.items == expected, "The spatial index should follow rect changes.");
+
+	// Give a leaf a child, so it has to be culled the regular way.
+	RID child = fixture.canvas_cull.canvas_item_allocate();
+	fixture.canvas_cull.canvas_item_initialize(child);
+	fixture.canvas_cull.canvas_item_set_parent(child, fixture.items[1]);
+	fixture.canvas_cull.canvas_item_set_transform(child, Transform2D(0, Vector2(220, 160)));
+	fixture.canvas_cull.canvas_item_add_rect(child, Rect2(0, 0, 32, 32), Color(1, 1, 1));
+	fixture.render(false, view, clip);
+	expected = fixture.canvas_render.items;
+	fixture.render(true, view, clip);
+	CHECK_MESSAGE(fixture.canvas_render.items == expected, "The spatial index should handle items gaining children.");
+	fixture.canvas_cull.free(child);
+}
+
+TEST_CASE("[RendererCanvasCull] Cached transforms are only recomputed when dirty") {
+	CanvasCullFixture fixture;
+	fixture.create_grid(10, 10);
+
+	const Rect2 clip = Rect2(0, 0, 320, 320);
+
+	fixture.render(false, Transform2D(), clip);
+	fixture.canvas_cull.update_frame_stats();
+	CHECK_MESSAGE(fixture.canvas_cull.get_items_recomputed_in_frame() == 101, "All items should be computed on the first frame.");
+	Vector<RendererCanvasRender::Item *> expected = fixture.canvas_render.items;
+
+	fixture.render(false, Transform2D(), clip);
+	fixture.canvas_cull.update_frame_stats();
+	CHECK_MESSAGE(fixture.canvas_cull.get_items_recomputed_in_frame() == 0, "Nothing should be recomputed when nothing moved.");
+	CHECK_MESSAGE(fixture.canvas_render.items == expected, "Cached transforms should give the same result.");
+
+	fixture.canvas_cull.canvas_item_set_transform(fixture.items[5], Transform2D(0, Vector2(1000, 1000)));
+	fixture.render(false, Transform2D(), clip);
+	fixture.canvas_cull.update_frame_stats();
+	CHECK_MESSAGE(fixture.canvas_cull.get_items_recomputed_in_frame() == 1, "Only the moved item should be recomputed.");
+	CHECK_MESSAGE(fixture.canvas_render.items.size() == expected.size() - 1, "The moved item should now be culled.");
+
+	fixture.canvas_cull.canvas_item_set_modulate(fixture.root, Color(1, 1, 1, 0.5));
+	fixture.render(false, Transform2D(), clip);
+	fixture.canvas_cull.update_frame_stats();
+	CHECK_MESSAGE(fixture.canvas_cull.get_items_recomputed_in_frame() == 101, "Changing the parent should recompute its children.");
+	CHECK(fixture.canvas_render.items[0]->final_modulate.a == doctest::Approx(0.5));
+
+	fixture.render(false, Transform2D(0, Vector2(-10, 0)), clip);
+	fixture.canvas_cull.update_frame_stats();
+	CHECK_MESSAGE(fixture.canvas_cull.get_items_recomputed_in_frame() == 101, "Moving the canvas should recompute everything.");
+	CHECK(fixture.canvas_render.items[0]->final_transform.get_origin().is_equal_approx(Vector2(-10, 0)));
+}
+
+static bool is_drawn_in_y_order(const Vector<RendererCanvasRender::Item *> &p_items) {
+	for (int i = 1; i < p_items.size(); i++) {
+		if (p_items[i]->final_transform.get_origin().y < p_items[i - 1]->final_transform.get_origin().y) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("[RendererCanvasCull] Y-sort keeps items sorted as they move") {
+	CanvasCullFixture fixture;
+	fixture.create_grid(20, 20);
+	fixture.canvas_cull.canvas_item_set_sort_children_by_y(fixture.root, true);
+
+	RandomNumberGenerator rng;
+	rng.set_seed(1234);
+
+	const Rect2 clip = Rect2(0, 0, 2000, 2000);
+
+	fixture.render(false, Transform2D(), clip);
+	CHECK(fixture.canvas_render.items.size() == 400);
+	CHECK_MESSAGE(is_drawn_in_y_order(fixture.canvas_render.items), "Items should be drawn sorted by Y.");
+
+	// Small moves, handled by the incremental sort.
+	for (int i = 0; i < fixture.items.size(); i++) {
+		fixture.canvas_cull.canvas_item_set_transform(fixture.items[i], Transform2D(0, Vector2((i % 20) * 32, (i / 20) * 32 + rng.randf_range(-40, 40))));
+	}
+	fixture.render(false, Transform2D(), clip);
+	CHECK_MESSAGE(is_drawn_in_y_order(fixture.canvas_render.items), "Items should be drawn sorted by Y after small moves.");
+
+	// Shuffle everything, falls back to a full sort.
+	for (int i = 0; i < fixture.items.size(); i++) {
+		fixture.canvas_cull.canvas_item_set_transform(fixture.items[i], Transform2D(0, Vector2(0, rng.randf_range(0, 1000))));
+	}
+	fixture.render(false, Transform2D(), clip);
+	CHECK_MESSAGE(is_drawn_in_y_order(fixture.canvas_render.items), "Items should be drawn sorted by Y after large moves.");
+
+	// Changing visibility changes the set of sorted children.
+	fixture.canvas_cull.canvas_item_set_visible(fixture.items[0], false);
+	fixture.render(false, Transform2D(), clip);
+	CHECK(fixture.canvas_render.items.size() == 399);
+	CHECK_MESSAGE(is_drawn_in_y_order(fixture.canvas_render.items), "Items should be drawn sorted by Y after hiding one.");
+}
+
+TEST_CASE("[RendererCanvasCull][Benchmark] Y-sort mostly coherent scene" * doctest::skip()) {
+	CanvasCullFixture fixture;
+	fixture.create_grid(100, 100);
+	fixture.canvas_cull.canvas_item_set_sort_children_by_y(fixture.root, true);
+
+	RandomNumberGenerator rng;
+	const Rect2 clip = Rect2(0, 0, 3200, 3200);
+	const int frames = 60;
+
+	Vector<Vector2> positions;
+	for (int i = 0; i < fixture.items.size(); i++) {
+		positions.push_back(Vector2(rng.randf_range(0, 3200), rng.randf_range(0, 3200)));
+	}
+
+	for (int pass = 0; pass < 2; pass++) {
+		bool incremental = pass == 1;
+		fixture.render(false, Transform2D(), clip);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < frames; i++) {
+			// Every item moves a little each frame, like characters walking around.
+			for (int j = 0; j < fixture.items.size(); j++) {
+				positions.write[j] += Vector2(rng.randf_range(-2, 2), rng.randf_range(-2, 2));
+				fixture.canvas_cull.canvas_item_set_transform(fixture.items[j], Transform2D(0, positions[j]));
+			}
+			if (!incremental) {
+				// Marks the Y-sort dirty, so the children are sorted from scratch like before.
+				fixture.canvas_cull.canvas_item_set_sort_children_by_y(fixture.root, true);
+			}
+			fixture.render(false, Transform2D(), clip);
+		}
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		MESSAGE(vformat("%d items, %s: %.3f msec per frame.", fixture.items.size(), incremental ? "incremental sort" : "full sort", elapsed / 1000.0 / frames));
+	}
+}
+
+TEST_CASE("[RendererCanvasCull][Benchmark] Cull large static canvas" * doctest::skip()) {
+	CanvasCullFixture fixture;
+	fixture.create_grid(500, 400);
+
+	const Rect2 clip = Rect2(0, 0, 1920, 1080);
+	const int frames = 60;
+
+	for (int pass = 0; pass < 2; pass++) {
+		bool use_spatial_index = pass == 1;
+		// Warm up, this also builds the index.
+		fixture.render(use_spatial_index, Transform2D(), clip);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < frames; i++) {
+			fixture.render(use_spatial_index, Transform2D(0, Vector2(-i * 16, -i * 8)), clip);
+		}
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		MESSAGE(vformat("%d items, %s: %d visible, %.3f msec per frame.", fixture.items.size(), use_spatial_index ? "spatial index" : "tree walk", fixture.canvas_render.items.size(), elapsed / 1000.0 / frames));
+	}
+}
+
+} // namespace TestRendererCanvasCull
+
+#endif // TEST_RENDERER_CANVAS_CULL_H
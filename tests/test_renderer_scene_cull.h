@@ -0,0 +1,412 @@
+/*************************************************************************/
+/*  test_renderer_scene_cull.h                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_SCENE_CULL_H
+#define TEST_RENDERER_SCENE_CULL_H
+
+#include "core/math/camera_matrix.h"
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "core/templates/thread_work_pool.h"
+#include "servers/rendering/renderer_scene_cull.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestRendererSceneCull {
+
+static Vector<RendererSceneCull::InstanceBounds> make_random_bounds(uint32_t p_count, uint64_t p_seed) {
+	Ref<RandomNumberGenerator> rng;
+	rng.instance();
+	rng->set_seed(p_seed);
+
+	Vector<RendererSceneCull::InstanceBounds> bounds;
+	bounds.resize(p_count);
+	RendererSceneCull::InstanceBounds *ptr = bounds.ptrw();
+	for (uint32_t i = 0; i < p_count; i++) {
+		Vector3 position(rng->randf_range(-200, 200), rng->randf_range(-200, 200), rng->randf_range(-200, 200));
+		Vector3 size(rng->randf_range(0.1, 10), rng->randf_range(0.1, 10), rng->randf_range(0.1, 10));
+		ptr[i] = RendererSceneCull::InstanceBounds(AABB(position, size));
+	}
+	return bounds;
+}
+
+static RendererSceneCull::Frustum make_frustum(const Transform &p_transform) {
+	CameraMatrix projection;
+	projection.set_perspective(70, 16.0 / 9.0, 0.05, 100);
+	return RendererSceneCull::Frustum(projection.get_projection_planes(p_transform));
+}
+
+TEST_CASE("[RendererSceneCull] Batched frustum culling matches per-instance culling") {
+	// Odd count so the scalar tail is exercised too.
+	const uint32_t count = 4099;
+	Vector<RendererSceneCull::InstanceBounds> bounds = make_random_bounds(count, 1234);
+
+	Transform transforms[] = {
+		Transform(),
+		Transform(Basis(Vector3(0, 1, 0), Math_PI * 0.3), Vector3(10, -5, 30)),
+		Transform(Basis(Vector3(1, 1, 0).normalized(), Math_PI * 0.8), Vector3(-50, 20, 0)),
+	};
+
+	Vector<uint8_t> inside;
+	inside.resize(count);
+
+	for (const Transform &transform : transforms) {
+		RendererSceneCull::Frustum frustum = make_frustum(transform);
+		RendererSceneCull::InstanceBounds::cull_frustum(bounds.ptr(), count, frustum, inside.ptrw());
+
+		uint32_t mismatches = 0;
+		uint32_t visible = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			bool expected = bounds[i].in_frustum(frustum);
+			if (bool(inside[i]) != expected) {
+				mismatches++;
+			}
+			visible += expected ? 1 : 0;
+		}
+
+		CHECK_MESSAGE(mismatches == 0, "Batched culling should give the same result as InstanceBounds::in_frustum().");
+		CHECK_MESSAGE(visible > 0, "Some instances should be visible, or the test proves nothing.");
+		CHECK_MESSAGE(visible < count, "Some instances should be culled, or the test proves nothing.");
+	}
+}
+
+// Proxies are updated from the root before every cull, do the same here.
+static bool is_drawn(RendererSceneCull::Instance *p_root, const RendererSceneCull::Instance *p_instance, const Vector3 &p_camera_position) {
+	RendererSceneCull::_update_lod_proxy(p_root, p_camera_position, false);
+	return RendererSceneCull::_visibility_range_check(p_instance, p_camera_position);
+}
+
+TEST_CASE("[RendererSceneCull] Draw ranges and LOD proxies") {
+	RendererSceneCull::Instance detail_a;
+	detail_a.transformed_aabb = AABB(Vector3(-1, -1, -1), Vector3(2, 2, 2));
+	RendererSceneCull::Instance detail_b;
+	detail_b.transformed_aabb = AABB(Vector3(1, -1, -1), Vector3(2, 2, 2));
+	RendererSceneCull::Instance proxy;
+	proxy.transformed_aabb = detail_a.transformed_aabb.merge(detail_b.transformed_aabb);
+	proxy.lod_begin = 100;
+	proxy.lod_begin_hysteresis = 10;
+	detail_a.lod_parent = &proxy;
+	detail_b.lod_parent = &proxy;
+	proxy.lod_children.insert(&detail_a);
+	proxy.lod_children.insert(&detail_b);
+	const Vector3 center = proxy.transformed_aabb.position + proxy.transformed_aabb.size * 0.5;
+
+	CHECK_MESSAGE(is_drawn(&proxy, &detail_a, center + Vector3(0, 0, 50)), "Detail should be drawn close to the proxy.");
+	CHECK_MESSAGE(!is_drawn(&proxy, &proxy, center + Vector3(0, 0, 50)), "Proxy should be hidden close to it.");
+
+	CHECK_MESSAGE(is_drawn(&proxy, &detail_b, center + Vector3(0, 0, 105)), "Detail should still be drawn inside the margin.");
+	CHECK_MESSAGE(is_drawn(&proxy, &proxy, center + Vector3(0, 0, 105)), "Proxy should already be drawn inside the margin.");
+
+	CHECK_MESSAGE(!is_drawn(&proxy, &detail_a, center + Vector3(0, 0, 200)), "Detail should be replaced far from the proxy.");
+	CHECK_MESSAGE(!is_drawn(&proxy, &detail_b, center + Vector3(0, 0, 200)), "Detail should be replaced far from the proxy.");
+	CHECK_MESSAGE(is_drawn(&proxy, &proxy, center + Vector3(0, 0, 200)), "Proxy should be drawn far from it.");
+
+	// A second level of proxies replaces the whole group even farther away.
+	RendererSceneCull::Instance region;
+	region.transformed_aabb = proxy.transformed_aabb;
+	region.lod_begin = 1000;
+	proxy.lod_end = 1000;
+	proxy.lod_parent = &region;
+	region.lod_children.insert(&proxy);
+
+	CHECK(!is_drawn(&region, &proxy, center + Vector3(0, 0, 2000)));
+	CHECK(!is_drawn(&region, &detail_a, center + Vector3(0, 0, 2000)));
+	CHECK(is_drawn(&region, &region, center + Vector3(0, 0, 2000)));
+	CHECK(!is_drawn(&region, &region, center + Vector3(0, 0, 200)));
+
+	// The details are rejected at the region without testing the proxy below it.
+	proxy.lod_begin = 5000;
+	CHECK_MESSAGE(!is_drawn(&region, &detail_a, center + Vector3(0, 0, 2000)), "Details should be hidden once a proxy above their own has taken over.");
+}
+
+TEST_CASE("[RendererSceneCull] LOD proxies without a begin distance never replace their children") {
+	RendererSceneCull::Instance detail;
+	detail.transformed_aabb = AABB(Vector3(-1, -1, -1), Vector3(2, 2, 2));
+	RendererSceneCull::Instance proxy;
+	proxy.transformed_aabb = detail.transformed_aabb;
+	proxy.lod_end = 50;
+	detail.lod_parent = &proxy;
+	proxy.lod_children.insert(&detail);
+
+	CHECK(is_drawn(&proxy, &detail, Vector3(0, 0, 10)));
+	CHECK(is_drawn(&proxy, &detail, Vector3(0, 0, 10000)));
+	CHECK(is_drawn(&proxy, &proxy, Vector3(0, 0, 10)));
+	CHECK(!is_drawn(&proxy, &proxy, Vector3(0, 0, 10000)));
+}
+
+static void add_to_scenario(RendererSceneCull::Scenario *p_scenario, RendererSceneCull::Instance *p_instance) {
+	p_instance->scenario = p_scenario;
+	p_instance->array_index = p_scenario->instance_data.size();
+	RendererSceneCull::InstanceData idata;
+	idata.instance = p_instance;
+	p_scenario->instance_data.push_back(idata);
+	p_scenario->instance_aabbs.push_back(RendererSceneCull::InstanceBounds(p_instance->transformed_aabb));
+}
+
+// Whether only the details of p_proxy are past the culled range, and the arrays still agree with the instances.
+static bool is_partitioned(RendererSceneCull::Scenario *p_scenario, const RendererSceneCull::Instance *p_proxy, bool p_details_hidden) {
+	uint32_t culled_count = p_scenario->instance_data.size() - p_scenario->lod_hidden_count;
+	for (uint32_t i = 0; i < p_scenario->instance_data.size(); i++) {
+		const RendererSceneCull::Instance *instance = p_scenario->instance_data[i].instance;
+		if (instance->array_index != int32_t(i) || p_scenario->instance_aabbs[i].bounds[0] != instance->transformed_aabb.position.x) {
+			return false;
+		}
+		bool hidden = p_details_hidden && instance->lod_parent == p_proxy;
+		if (hidden != (i >= culled_count)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("[RendererSceneCull] Instances replaced by a LOD proxy are left out of the culled range") {
+	PagedArrayPool<RendererSceneCull::InstanceBounds> bounds_pool;
+	PagedArrayPool<RendererSceneCull::InstanceData> data_pool;
+	RendererSceneCull::Scenario scenario;
+	scenario.instance_aabbs.set_page_pool(&bounds_pool);
+	scenario.instance_data.set_page_pool(&data_pool);
+
+	const uint32_t detail_count = 8;
+	RendererSceneCull::Instance proxy;
+	proxy.transformed_aabb = AABB(Vector3(-10, -1, -10), Vector3(20, 2, 20));
+	proxy.lod_begin = 100;
+	add_to_scenario(&scenario, &proxy);
+
+	// Details are interleaved with unrelated instances, as they would be in a real scene.
+	RendererSceneCull::Instance details[detail_count];
+	RendererSceneCull::Instance others[detail_count];
+	for (uint32_t i = 0; i < detail_count; i++) {
+		details[i].transformed_aabb = AABB(Vector3(i * 2.0 - 8, -1, -1), Vector3(2, 2, 2));
+		details[i].lod_parent = &proxy;
+		proxy.lod_children.insert(&details[i]);
+		add_to_scenario(&scenario, &details[i]);
+		others[i].transformed_aabb = AABB(Vector3(i * 2.0 - 8, 5, -1), Vector3(2, 2, 2));
+		add_to_scenario(&scenario, &others[i]);
+	}
+
+	RendererSceneCull::_update_lod_proxy(&proxy, Vector3(0, 0, 500), false);
+	CHECK(scenario.lod_hidden_count == detail_count);
+	CHECK_MESSAGE(is_partitioned(&scenario, &proxy, true), "Replaced details should be moved after every other instance.");
+
+	// Nothing below a proxy that already took over is touched again.
+	RendererSceneCull::_update_lod_proxy(&proxy, Vector3(0, 0, 600), false);
+	CHECK(scenario.lod_hidden_count == detail_count);
+	CHECK(is_partitioned(&scenario, &proxy, true));
+
+	RendererSceneCull::_update_lod_proxy(&proxy, Vector3(0, 0, 20), false);
+	CHECK(scenario.lod_hidden_count == 0);
+	CHECK_MESSAGE(is_partitioned(&scenario, &proxy, false), "Details should be culled again close to the proxy.");
+
+	scenario.instance_data.reset();
+	scenario.instance_aabbs.reset();
+}
+
+TEST_CASE("[RendererSceneCull] Shadow culling applies draw ranges") {
+	RendererSceneCull::Scenario scenario;
+	RendererSceneCull::Instance instances[4];
+	const Vector3 positions[4] = { Vector3(0, 0, 10), Vector3(0, 0, 80), Vector3(10, 0, 10), Vector3(10, 0, 10) };
+	for (uint32_t i = 0; i < 4; i++) {
+		instances[i].base_type = RS::INSTANCE_MESH;
+		RendererSceneCull::InstanceGeometryData *geom = memnew(RendererSceneCull::InstanceGeometryData);
+		// Never dereferenced, only used to tell the culled instances apart.
+		geom->geometry_instance = (RendererSceneRender::GeometryInstance *)(uintptr_t)(i + 1);
+		geom->can_cast_shadows = true;
+		geom->material_is_animated = false;
+		instances[i].base_data = geom;
+		instances[i].transformed_aabb = AABB(positions[i], Vector3(2, 2, 2));
+		scenario.indexers[RendererSceneCull::Scenario::INDEXER_GEOMETRY].insert(instances[i].transformed_aabb, &instances[i]);
+	}
+	// Too far from the camera for its own draw range.
+	instances[1].lod_end = 50;
+	// A detail and the proxy that replaced it.
+	instances[2].lod_parent = &instances[3];
+	instances[3].lod_children.insert(&instances[2]);
+	instances[3].lod_children_hidden = true;
+
+	PagedArrayPool<RendererSceneRender::GeometryInstance *> page_pool;
+	PagedArray<RendererSceneRender::GeometryInstance *> result;
+	result.set_page_pool(&page_pool);
+
+	RendererSceneCull::ShadowCullJob job;
+	job.scenario = &scenario;
+	job.instances = &result;
+	job.planes = Geometry3D::build_box_planes(Vector3(200, 200, 200));
+	job.points = Geometry3D::compute_convex_mesh_points(job.planes.ptr(), job.planes.size());
+	job.camera_position = Vector3();
+	RendererSceneCull::_shadow_cull_jobs(&job, 1, nullptr);
+
+	Set<uintptr_t> culled;
+	for (uint64_t i = 0; i < result.size(); i++) {
+		culled.insert((uintptr_t)result[i]);
+	}
+	CHECK(culled.has(1));
+	CHECK_MESSAGE(!culled.has(2), "An instance out of its draw range from the camera should not cast shadows.");
+	CHECK_MESSAGE(!culled.has(3), "A detail replaced by its proxy should not cast shadows.");
+	CHECK(culled.has(4));
+
+	result.reset();
+}
+
+TEST_CASE("[RendererSceneCull] Threaded shadow culling matches serial culling") {
+	const uint32_t instance_count = 2000;
+	Ref<RandomNumberGenerator> rng;
+	rng.instance();
+	rng->set_seed(4321);
+
+	RendererSceneCull::Scenario scenario;
+	LocalVector<RendererSceneCull::Instance *> instances;
+	for (uint32_t i = 0; i < instance_count; i++) {
+		RendererSceneCull::Instance *instance = memnew(RendererSceneCull::Instance);
+		instance->base_type = RS::INSTANCE_MESH;
+		RendererSceneCull::InstanceGeometryData *geom = memnew(RendererSceneCull::InstanceGeometryData);
+		// Never dereferenced, only used to tell the culled instances apart.
+		geom->geometry_instance = (RendererSceneRender::GeometryInstance *)(uintptr_t)(i + 1);
+		geom->can_cast_shadows = i % 7 != 0;
+		geom->material_is_animated = false;
+		instance->base_data = geom;
+		Vector3 position(rng->randf_range(-200, 200), rng->randf_range(-200, 200), rng->randf_range(-200, 200));
+		instance->transformed_aabb = AABB(position, Vector3(2, 2, 2));
+		scenario.indexers[RendererSceneCull::Scenario::INDEXER_GEOMETRY].insert(instance->transformed_aabb, instance);
+		instances.push_back(instance);
+	}
+
+	// One spot light and the six sides of an omni light cube map.
+	CameraMatrix spot;
+	spot.set_perspective(90, 1, 0.01, 150);
+	CameraMatrix cube;
+	cube.set_perspective(90, 1, 0.01, 120);
+	const Vector3 view_normals[6] = { Vector3(+1, 0, 0), Vector3(-1, 0, 0), Vector3(0, -1, 0), Vector3(0, +1, 0), Vector3(0, 0, +1), Vector3(0, 0, -1) };
+	const Vector3 view_up[6] = { Vector3(0, -1, 0), Vector3(0, -1, 0), Vector3(0, 0, -1), Vector3(0, 0, +1), Vector3(0, -1, 0), Vector3(0, -1, 0) };
+
+	const uint32_t job_count = 7;
+	RendererSceneCull::ShadowCullJob jobs[job_count];
+	for (uint32_t i = 0; i < job_count; i++) {
+		Vector<Plane> planes;
+		if (i == 0) {
+			planes = spot.get_projection_planes(Transform(Basis(Vector3(0, 1, 0), Math_PI * 0.2), Vector3(20, 0, 20)));
+		} else {
+			planes = cube.get_projection_planes(Transform(Basis(), Vector3(-30, 10, 0)) * Transform().looking_at(view_normals[i - 1], view_up[i - 1]));
+		}
+		jobs[i].scenario = &scenario;
+		jobs[i].planes = planes;
+		jobs[i].points = Geometry3D::compute_convex_mesh_points(planes.ptr(), planes.size());
+	}
+
+	PagedArrayPool<RendererSceneRender::GeometryInstance *> page_pool;
+	PagedArray<RendererSceneRender::GeometryInstance *> serial[job_count];
+	PagedArray<RendererSceneRender::GeometryInstance *> threaded[job_count];
+	for (uint32_t i = 0; i < job_count; i++) {
+		serial[i].set_page_pool(&page_pool);
+		threaded[i].set_page_pool(&page_pool);
+		jobs[i].instances = &serial[i];
+	}
+
+	RendererSceneCull::_shadow_cull_jobs(jobs, job_count, nullptr);
+
+	ThreadWorkPool thread_pool;
+	thread_pool.init(4);
+	for (uint32_t i = 0; i < job_count; i++) {
+		jobs[i].instances = &threaded[i];
+	}
+	RendererSceneCull::_shadow_cull_jobs(jobs, job_count, &thread_pool);
+	thread_pool.finish();
+
+	uint64_t culled = 0;
+	uint32_t mismatches = 0;
+	uint32_t non_casters = 0;
+	for (uint32_t i = 0; i < job_count; i++) {
+		if (serial[i].size() != threaded[i].size()) {
+			mismatches++;
+			continue;
+		}
+		for (uint64_t j = 0; j < serial[i].size(); j++) {
+			if (serial[i][j] != threaded[i][j]) {
+				mismatches++;
+			}
+			if (((uintptr_t)serial[i][j] - 1) % 7 == 0) {
+				non_casters++;
+			}
+		}
+		culled += serial[i].size();
+	}
+
+	CHECK_MESSAGE(mismatches == 0, "Threaded shadow culling should give every light pass the same instance list as serial culling.");
+	CHECK_MESSAGE(non_casters == 0, "Instances that don't cast shadows should never be culled into a shadow pass.");
+	CHECK_MESSAGE(culled > 0, "Some instances should be inside the shadow passes, or the test proves nothing.");
+
+	for (uint32_t i = 0; i < job_count; i++) {
+		serial[i].reset();
+		threaded[i].reset();
+	}
+	for (uint32_t i = 0; i < instances.size(); i++) {
+		memdelete(instances[i]);
+	}
+}
+
+TEST_CASE("[RendererSceneCull][Benchmark] Frustum culling 1M instances" * doctest::skip()) {
+	const uint32_t count = 1000000;
+	const int iterations = 20;
+	Vector<RendererSceneCull::InstanceBounds> bounds = make_random_bounds(count, 42);
+	RendererSceneCull::Frustum frustum = make_frustum(Transform(Basis(Vector3(0, 1, 0), Math_PI * 0.25), Vector3()));
+
+	Vector<uint8_t> inside;
+	inside.resize(count);
+	uint8_t *inside_ptr = inside.ptrw();
+	const RendererSceneCull::InstanceBounds *bounds_ptr = bounds.ptr();
+
+	uint32_t visible_scalar = 0;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int k = 0; k < iterations; k++) {
+		for (uint32_t i = 0; i < count; i++) {
+			inside_ptr[i] = bounds_ptr[i].in_frustum(frustum);
+		}
+	}
+	uint64_t scalar_usec = OS::get_singleton()->get_ticks_usec() - begin;
+	for (uint32_t i = 0; i < count; i++) {
+		visible_scalar += inside_ptr[i];
+	}
+
+	uint32_t visible_batched = 0;
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int k = 0; k < iterations; k++) {
+		RendererSceneCull::InstanceBounds::cull_frustum(bounds_ptr, count, frustum, inside_ptr);
+	}
+	uint64_t batched_usec = OS::get_singleton()->get_ticks_usec() - begin;
+	for (uint32_t i = 0; i < count; i++) {
+		visible_batched += inside_ptr[i];
+	}
+
+	CHECK(visible_scalar == visible_batched);
+	MESSAGE(vformat("Per-instance: %d usec per pass, batched: %d usec per pass, %d visible.", scalar_usec / iterations, batched_usec / iterations, visible_batched));
+}
+
+} // namespace TestRendererSceneCull
+
+#endif // TEST_RENDERER_SCENE_CULL_H
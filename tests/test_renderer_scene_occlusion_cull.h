@@ -0,0 +1,214 @@
+/*************************************************************************/
+/*  test_renderer_scene_occlusion_cull.h                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_RENDERER_SCENE_OCCLUSION_CULL_H
+#define TEST_RENDERER_SCENE_OCCLUSION_CULL_H
+
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "core/templates/thread_work_pool.h"
+#include "servers/rendering/renderer_scene_occlusion_cull_raster.h"
+
+#ifdef MODULE_RAYCAST_ENABLED
+#include "modules/raycast/raycast_occlusion_cull.h"
+#endif
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestRendererSceneOcclusionCull {
+
+static void make_box(const AABB &p_aabb, PackedVector3Array &r_vertices, PackedInt32Array &r_indices) {
+	static const int faces[6][4] = {
+		{ 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }
+	};
+
+	r_vertices.clear();
+	r_indices.clear();
+	for (int i = 0; i < 8; i++) {
+		r_vertices.push_back(p_aabb.get_endpoint(i));
+	}
+	for (int i = 0; i < 6; i++) {
+		r_indices.push_back(faces[i][0]);
+		r_indices.push_back(faces[i][1]);
+		r_indices.push_back(faces[i][2]);
+		r_indices.push_back(faces[i][0]);
+		r_indices.push_back(faces[i][2]);
+		r_indices.push_back(faces[i][3]);
+	}
+}
+
+static bool is_occluded(const RendererSceneOcclusionCull::HZBuffer *p_buffer, const AABB &p_aabb, const Transform &p_cam_transform, const CameraMatrix &p_projection) {
+	const float bounds[6] = {
+		(float)p_aabb.position.x, (float)p_aabb.position.y, (float)p_aabb.position.z,
+		(float)(p_aabb.position.x + p_aabb.size.x), (float)(p_aabb.position.y + p_aabb.size.y), (float)(p_aabb.position.z + p_aabb.size.z)
+	};
+	return p_buffer->is_occluded(bounds, p_cam_transform.origin, p_cam_transform.affine_inverse(), p_projection, p_projection.get_z_near());
+}
+
+TEST_CASE("[RendererSceneOcclusionCull] Software rasterizer occludes what is behind occluders") {
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	RendererSceneOcclusionCullRaster *occlusion_cull = memnew(RendererSceneOcclusionCullRaster);
+	const RID scenario = RID::from_uint64(1);
+	const RID buffer = RID::from_uint64(2);
+	const RID instance = RID::from_uint64(3);
+
+	// A wall 10 units in front of the camera.
+	PackedVector3Array vertices;
+	PackedInt32Array indices;
+	make_box(AABB(Vector3(-5, -5, -10.5), Vector3(10, 10, 1)), vertices, indices);
+
+	RID occluder = occlusion_cull->occluder_allocate();
+	occlusion_cull->occluder_initialize(occluder);
+	occlusion_cull->occluder_set_mesh(occluder, vertices, indices);
+	occlusion_cull->add_scenario(scenario);
+	occlusion_cull->scenario_set_instance(scenario, instance, occluder, Transform(), true);
+	occlusion_cull->add_buffer(buffer);
+	occlusion_cull->buffer_set_scenario(buffer, scenario);
+	occlusion_cull->buffer_set_size(buffer, Size2i(128, 72));
+
+	CameraMatrix projection;
+	projection.set_perspective(70, 16.0 / 9.0, 0.05, 100);
+
+	Transform cameras[] = {
+		Transform(),
+		Transform(Basis(Vector3(0, 1, 0), Math_PI * 0.05), Vector3(1, 0.5, 0)),
+	};
+
+	for (const Transform &camera : cameras) {
+		occlusion_cull->buffer_update(buffer, camera, projection, false, thread_pool);
+		const RendererSceneOcclusionCull::HZBuffer *hz_buffer = occlusion_cull->buffer_get_ptr(buffer);
+
+		CHECK_MESSAGE(is_occluded(hz_buffer, AABB(Vector3(-0.5, -0.5, -20.5), Vector3(1, 1, 1)), camera, projection), "A box right behind the wall should be occluded.");
+		CHECK_MESSAGE(!is_occluded(hz_buffer, AABB(Vector3(-0.5, -0.5, -5.5), Vector3(1, 1, 1)), camera, projection), "A box in front of the wall should not be occluded.");
+		CHECK_MESSAGE(!is_occluded(hz_buffer, AABB(Vector3(15, -0.5, -30.5), Vector3(1, 1, 1)), camera, projection), "A box next to the wall should not be occluded.");
+		CHECK_MESSAGE(!is_occluded(hz_buffer, AABB(Vector3(-2, -2, -22), Vector3(4, 24, 4)), camera, projection), "A box sticking out from behind the wall should not be occluded.");
+	}
+
+	occlusion_cull->remove_buffer(buffer);
+	occlusion_cull->scenario_remove_instance(scenario, instance);
+	occlusion_cull->remove_scenario(scenario);
+	occlusion_cull->free_occluder(occluder);
+	memdelete(occlusion_cull);
+
+	thread_pool.finish();
+}
+
+static void benchmark_occlusion_cull(const String &p_name, RendererSceneOcclusionCull *p_occlusion_cull, ThreadWorkPool &p_thread_pool, const Vector<AABB> &p_occluders, const Vector<AABB> &p_bounds) {
+	const RID scenario = RID::from_uint64(1);
+	const RID buffer = RID::from_uint64(2);
+	const int iterations = 20;
+
+	p_occlusion_cull->add_scenario(scenario);
+	LocalVector<RID> occluders;
+	for (int i = 0; i < p_occluders.size(); i++) {
+		PackedVector3Array vertices;
+		PackedInt32Array indices;
+		make_box(p_occluders[i], vertices, indices);
+
+		RID occluder = p_occlusion_cull->occluder_allocate();
+		p_occlusion_cull->occluder_initialize(occluder);
+		p_occlusion_cull->occluder_set_mesh(occluder, vertices, indices);
+		p_occlusion_cull->scenario_set_instance(scenario, RID::from_uint64(100 + i), occluder, Transform(), true);
+		occluders.push_back(occluder);
+	}
+	p_occlusion_cull->add_buffer(buffer);
+	p_occlusion_cull->buffer_set_scenario(buffer, scenario);
+	p_occlusion_cull->buffer_set_size(buffer, Size2i(512, 288));
+
+	CameraMatrix projection;
+	projection.set_perspective(70, 16.0 / 9.0, 0.05, 500);
+	Transform camera;
+
+	// The raycast backend builds its acceleration structure on a thread, give it time to finish.
+	p_occlusion_cull->buffer_update(buffer, camera, projection, false, p_thread_pool);
+	OS::get_singleton()->delay_usec(500000);
+	p_occlusion_cull->buffer_update(buffer, camera, projection, false, p_thread_pool);
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		p_occlusion_cull->buffer_update(buffer, camera, projection, false, p_thread_pool);
+	}
+	uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	const RendererSceneOcclusionCull::HZBuffer *hz_buffer = p_occlusion_cull->buffer_get_ptr(buffer);
+	int culled = 0;
+	for (int i = 0; i < p_bounds.size(); i++) {
+		culled += is_occluded(hz_buffer, p_bounds[i], camera, projection) ? 1 : 0;
+	}
+
+	MESSAGE(vformat("%s: %d usec per occlusion buffer, %d of %d instances culled.", p_name, usec / iterations, culled, p_bounds.size()));
+
+	p_occlusion_cull->remove_buffer(buffer);
+	for (uint32_t i = 0; i < occluders.size(); i++) {
+		p_occlusion_cull->scenario_remove_instance(scenario, RID::from_uint64(100 + i));
+		p_occlusion_cull->free_occluder(occluders[i]);
+	}
+	p_occlusion_cull->remove_scenario(scenario);
+}
+
+TEST_CASE("[RendererSceneOcclusionCull][Benchmark] Occlusion buffer build" * doctest::skip()) {
+	ThreadWorkPool thread_pool;
+	thread_pool.init();
+
+	Ref<RandomNumberGenerator> rng;
+	rng.instance();
+	rng->set_seed(7);
+
+	// Walls and boxes spread in front of the camera, and instances scattered among them.
+	Vector<AABB> occluders;
+	for (int i = 0; i < 500; i++) {
+		Vector3 position(rng->randf_range(-150, 150), rng->randf_range(-20, 0), rng->randf_range(-400, -10));
+		Vector3 size(rng->randf_range(1, 30), rng->randf_range(1, 20), rng->randf_range(1, 30));
+		occluders.push_back(AABB(position, size));
+	}
+	Vector<AABB> bounds;
+	for (int i = 0; i < 100000; i++) {
+		Vector3 position(rng->randf_range(-200, 200), rng->randf_range(-20, 10), rng->randf_range(-450, -5));
+		bounds.push_back(AABB(position, Vector3(1, 1, 1)));
+	}
+
+	RendererSceneOcclusionCullRaster *raster = memnew(RendererSceneOcclusionCullRaster);
+	benchmark_occlusion_cull("Software rasterizer", raster, thread_pool, occluders, bounds);
+	memdelete(raster);
+
+#ifdef MODULE_RAYCAST_ENABLED
+	RaycastOcclusionCull *raycast = memnew(RaycastOcclusionCull);
+	benchmark_occlusion_cull("Embree raycast", raycast, thread_pool, occluders, bounds);
+	memdelete(raycast);
+#endif
+
+	thread_pool.finish();
+}
+
+} // namespace TestRendererSceneOcclusionCull
+
+#endif // TEST_RENDERER_SCENE_OCCLUSION_CULL_H
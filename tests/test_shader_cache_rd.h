@@ -0,0 +1,92 @@
+/*************************************************************************/
+/*  test_shader_cache_rd.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SHADER_CACHE_RD_H
+#define TEST_SHADER_CACHE_RD_H
+
+#include "core/os/dir_access.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "servers/rendering/renderer_rd/shader_cache_rd.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestShaderCacheRD {
+
+static const char *test_source = "#version 450\nlayout(location = 0) out vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+TEST_CASE("[ShaderCacheRD] Cache keys") {
+	const String key = ShaderCacheRD::get_key(RD::SHADER_STAGE_FRAGMENT, test_source, RD::SHADER_LANGUAGE_GLSL, "Vendor|Device|UUID");
+
+	CHECK_MESSAGE(key.length() == 64, "Keys should be SHA-256 hashes in hexadecimal.");
+	CHECK_MESSAGE(key == ShaderCacheRD::get_key(RD::SHADER_STAGE_FRAGMENT, test_source, RD::SHADER_LANGUAGE_GLSL, "Vendor|Device|UUID"), "Keys should be stable.");
+	CHECK_MESSAGE(key != ShaderCacheRD::get_key(RD::SHADER_STAGE_VERTEX, test_source, RD::SHADER_LANGUAGE_GLSL, "Vendor|Device|UUID"), "The stage should be part of the key.");
+	CHECK_MESSAGE(key != ShaderCacheRD::get_key(RD::SHADER_STAGE_FRAGMENT, String("#define USE_LAYER\n") + test_source, RD::SHADER_LANGUAGE_GLSL, "Vendor|Device|UUID"), "Defines should be part of the key.");
+	CHECK_MESSAGE(key != ShaderCacheRD::get_key(RD::SHADER_STAGE_FRAGMENT, test_source, RD::SHADER_LANGUAGE_GLSL, "Vendor|Device|UUID2"), "The driver should be part of the key.");
+}
+
+TEST_CASE("[ShaderCacheRD] Saving and loading entries") {
+	const String dir = OS::get_singleton()->get_cache_path().plus_file("shader_cache_test");
+	DirAccessRef da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	da->make_dir_recursive(dir);
+
+	const String key = ShaderCacheRD::get_key(RD::SHADER_STAGE_FRAGMENT, test_source, RD::SHADER_LANGUAGE_GLSL, "Driver");
+	CHECK_MESSAGE(ShaderCacheRD::load(dir, key).is_empty(), "Missing entries should not load.");
+
+	Vector<uint8_t> spirv;
+	for (int i = 0; i < 1000; i++) {
+		spirv.push_back(i * 7);
+	}
+	CHECK(ShaderCacheRD::save(dir, key, spirv) == OK);
+	CHECK_MESSAGE(ShaderCacheRD::load(dir, key) == spirv, "Saved entries should load back unchanged.");
+
+	Vector<uint8_t> other = spirv;
+	other.resize(10);
+	CHECK(ShaderCacheRD::save(dir, key, other) == OK);
+	CHECK_MESSAGE(ShaderCacheRD::load(dir, key) == other, "Saving should replace the entry.");
+
+	// Cut the file short, as if writing it had been interrupted.
+	const String path = dir.plus_file(key + ".spv");
+	Vector<uint8_t> contents = FileAccess::get_file_as_array(path);
+	{
+		FileAccessRef f = FileAccess::open(path, FileAccess::WRITE);
+		f->store_buffer(contents.ptr(), contents.size() - 3);
+	}
+	ERR_PRINT_OFF;
+	CHECK_MESSAGE(ShaderCacheRD::load(dir, key).is_empty(), "Truncated entries should be ignored.");
+	ERR_PRINT_ON;
+
+	da->remove(path);
+	da->remove(dir);
+}
+
+} // namespace TestShaderCacheRD
+
+#endif // TEST_SHADER_CACHE_RD_H
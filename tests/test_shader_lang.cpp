@@ -39,6 +39,8 @@
 #include "scene/gui/text_edit.h"
 #include "servers/rendering/shader_language.h"
 
+#include "tests/test_macros.h"
+
 typedef ShaderLanguage SL;
 
 namespace TestShaderLang {
@@ -357,4 +359,87 @@ MainLoop *test() {
 
 	return nullptr;
 }
+
+static String _make_large_shader(int p_seed, int p_functions) {
+	String code = "shader_type spatial;\n\n";
+	code += "uniform vec4 tint : hint_color = vec4(1.0);\n";
+	code += "uniform float scale = 1.0;\n\n";
+	code += "struct Layer {\n\tvec3 color;\n\tfloat weight;\n};\n\n";
+
+	for (int i = 0; i < p_functions; i++) {
+		code += vformat("vec3 layer_%d(vec3 p_color, float p_t) {\n", i);
+		code += "\tLayer layer;\n";
+		code += vformat("\tlayer.color = p_color * vec3(%d.0, 0.5, 0.25) + vec3(sin(p_t), cos(p_t), 0.0);\n", p_seed + i);
+		code += "\tlayer.weight = clamp(p_t * scale, 0.0, 1.0);\n";
+		code += "\tfor (int j = 0; j < 4; j++) {\n";
+		code += "\t\tlayer.color = mix(layer.color, layer.color.zyx * 0.5, float(j) / 4.0);\n";
+		code += "\t\tif (layer.color.x > 0.5 && j != 2) {\n\t\t\tlayer.weight *= 0.9;\n\t\t}\n";
+		code += "\t}\n";
+		code += "\treturn layer.color * layer.weight;\n";
+		code += "}\n\n";
+	}
+
+	code += "void fragment() {\n\tvec3 color = tint.rgb;\n";
+	for (int i = 0; i < p_functions; i++) {
+		code += vformat("\tcolor = layer_%d(color, %d.5);\n", i, i);
+	}
+	code += "\tALBEDO = color;\n}\n";
+
+	return code;
+}
+
+static Error _compile(SL &p_sl, const String &p_code) {
+	Map<StringName, SL::FunctionInfo> functions;
+	functions["fragment"].built_ins["ALBEDO"] = SL::TYPE_VEC3;
+
+	Set<String> types;
+	types.insert("spatial");
+
+	return p_sl.compile(p_code, functions, Vector<StringName>(), SL::VaryingFunctionNames(), types, nullptr);
+}
+
+TEST_CASE("[ShaderLanguage] Compiling and reusing the parser") {
+	SL sl;
+	for (int i = 0; i < 3; i++) {
+		Error err = _compile(sl, _make_large_shader(i, 50));
+		CHECK_MESSAGE(err == OK, vformat("Line %d: %s", sl.get_error_line(), sl.get_error_text()));
+		CHECK(sl.get_shader()->functions.size() == 51);
+	}
+}
+
+TEST_CASE("[ShaderLanguage] Error lines") {
+	SL sl;
+
+	CHECK(_compile(sl, "shader_type spatial;\n\nvoid fragment() {\n\tALBEDO = vec3(1.0) +;\n}\n") != OK);
+	CHECK(sl.get_error_line() == 4);
+
+	// Tokenizer errors are reported when the parser reaches them.
+	CHECK(_compile(sl, "shader_type spatial;\n\nvoid fragment() {\n\n\tfloat x = 1.2.3;\n}\n") != OK);
+	CHECK(sl.get_error_line() == 5);
+	CHECK(sl.get_error_text() == "Invalid numeric constant");
+
+	CHECK(_compile(sl, _make_large_shader(0, 4)) == OK);
+}
+
+TEST_CASE("[ShaderLanguage][Benchmark] Parsing large shaders" * doctest::skip()) {
+	const int shader_count = 100;
+	const int function_count = 200;
+
+	Vector<String> corpus;
+	int lines = 0;
+	for (int i = 0; i < shader_count; i++) {
+		corpus.push_back(_make_large_shader(i, function_count));
+		lines += corpus[i].get_slice_count("\n");
+	}
+
+	SL sl;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < shader_count; i++) {
+		CHECK(_compile(sl, corpus[i]) == OK);
+	}
+	uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	MESSAGE(vformat("Parsed %d shaders (%d lines) in %.2f ms (%.2f us per line).", shader_count, lines, usec / 1000.0, double(usec) / lines));
+}
+
 } // namespace TestShaderLang
@@ -0,0 +1,196 @@
+/*************************************************************************/
+/*  test_skeleton_3d.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2021 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2021 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_SKELETON_3D_H
+#define TEST_SKELETON_3D_H
+
+#include "core/os/os.h"
+#include "scene/3d/skeleton_3d.h"
+#include "tests/test_macros.h"
+
+#include "thirdparty/doctest/doctest.h"
+
+namespace TestSkeleton3D {
+
+// Every bone is a child of the previous one, offset along X from its parent.
+static Skeleton3D *create_chain(int p_bones) {
+	Skeleton3D *skeleton = memnew(Skeleton3D);
+	for (int i = 0; i < p_bones; i++) {
+		skeleton->add_bone("bone_" + itos(i));
+		skeleton->set_bone_parent(i, i - 1);
+		skeleton->set_bone_rest(i, Transform(Basis(), Vector3(1, 0, 0)));
+	}
+	return skeleton;
+}
+
+static Transform get_expected_global_pose(Skeleton3D *p_skeleton, int p_bone) {
+	Transform global;
+	for (int i = 0; i <= p_bone; i++) {
+		global = global * p_skeleton->get_bone_rest(i) * p_skeleton->get_bone_pose(i);
+	}
+	return global;
+}
+
+TEST_CASE("[Skeleton3D] Global poses of changed bones") {
+	const int bones = 5;
+	Skeleton3D *skeleton = create_chain(bones);
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+
+	CHECK_MESSAGE(
+			skeleton->get_bone_global_pose(bones - 1).origin.is_equal_approx(Vector3(bones, 0, 0)),
+			"Rests should add up along the chain.");
+
+	Transform turn(Basis(Vector3(0, 1, 0), Math_PI / 2.0), Vector3(0, 0.5, 0));
+	skeleton->set_bone_pose(2, turn);
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+
+	for (int i = 0; i < bones; i++) {
+		CHECK_MESSAGE(
+				skeleton->get_bone_global_pose(i).is_equal_approx(get_expected_global_pose(skeleton, i)),
+				"Bones below a changed bone should be recomputed, others kept.");
+	}
+
+	Vector<float> buffer = skeleton->get_bone_pose_buffer();
+	CHECK(buffer.size() == bones * 12);
+	CHECK(buffer[2 * 12 + 7] == doctest::Approx(0.5));
+
+	// Move the root through the buffer, so every bone follows.
+	buffer.write[3] = 2.0;
+	skeleton->set_bone_pose_buffer(buffer);
+	CHECK(skeleton->get_bone_pose(0).origin.is_equal_approx(Vector3(2, 0, 0)));
+	CHECK(skeleton->get_bone_pose(2).is_equal_approx(turn));
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+
+	for (int i = 0; i < bones; i++) {
+		CHECK(skeleton->get_bone_global_pose(i).is_equal_approx(get_expected_global_pose(skeleton, i)));
+	}
+
+	ERR_PRINT_OFF;
+	skeleton->set_bone_pose_buffer(Vector<float>());
+	ERR_PRINT_ON;
+	CHECK_MESSAGE(
+			skeleton->get_bone_pose(0).origin.is_equal_approx(Vector3(2, 0, 0)),
+			"A buffer of the wrong size should be rejected.");
+
+	memdelete(skeleton);
+}
+
+TEST_CASE("[Skeleton3D] Global pose overrides") {
+	const int bones = 3;
+	Skeleton3D *skeleton = create_chain(bones);
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+
+	Transform expected = skeleton->get_bone_global_pose(1);
+	Transform override(Basis(), Vector3(0, 10, 0));
+	skeleton->set_bone_global_pose_override(1, override, 1.0);
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+
+	CHECK(skeleton->get_bone_global_pose(1).is_equal_approx(override));
+	CHECK(skeleton->get_bone_global_pose_no_override(1).is_equal_approx(expected));
+	CHECK_MESSAGE(
+			skeleton->get_bone_global_pose(2).is_equal_approx(override * skeleton->get_bone_rest(2)),
+			"Children should follow the overridden pose.");
+
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+	CHECK_MESSAGE(
+			skeleton->get_bone_global_pose(1).is_equal_approx(expected),
+			"Overrides that aren't persistent should only last one update.");
+	CHECK(skeleton->get_bone_global_pose(2).is_equal_approx(get_expected_global_pose(skeleton, 2)));
+
+	memdelete(skeleton);
+}
+
+TEST_CASE("[Skeleton3D] Disabling a bone rest") {
+	const int bones = 3;
+	Skeleton3D *skeleton = create_chain(bones);
+	skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+	CHECK(skeleton->get_bone_global_pose(2).origin.is_equal_approx(Vector3(3, 0, 0)));
+
+	// No explicit update here, the skeleton should queue one by itself.
+	skeleton->set_bone_disable_rest(1, true);
+	CHECK_MESSAGE(
+			skeleton->get_bone_global_pose(1).origin.is_equal_approx(Vector3(1, 0, 0)),
+			"The bone should no longer be offset by its rest.");
+	CHECK_MESSAGE(
+			skeleton->get_bone_global_pose(2).origin.is_equal_approx(Vector3(2, 0, 0)),
+			"Children should follow the bone without its rest.");
+
+	memdelete(skeleton);
+}
+
+TEST_CASE("[Skeleton3D][Benchmark] Updating many skeletons" * doctest::skip()) {
+	const int skeletons = 100;
+	const int bones = 100;
+	const int frames = 120;
+
+	Vector<Skeleton3D *> crowd;
+	for (int i = 0; i < skeletons; i++) {
+		Skeleton3D *skeleton = memnew(Skeleton3D);
+		for (int j = 0; j < bones; j++) {
+			skeleton->add_bone("bone_" + itos(j));
+			skeleton->set_bone_parent(j, j > 0 ? (j - 1) / 2 : -1);
+			skeleton->set_bone_rest(j, Transform(Basis(), Vector3(0, 0.1, 0)));
+		}
+		skeleton->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+		crowd.push_back(skeleton);
+	}
+
+	for (int changed = bones; changed > 0; changed /= 10) {
+		// The leaves are at the end of the bone list, so the last bones have the smallest chains.
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int frame = 0; frame < frames; frame++) {
+			for (int i = 0; i < skeletons; i++) {
+				Vector<float> buffer = crowd[i]->get_bone_pose_buffer();
+				float *w = buffer.ptrw();
+				for (int j = bones - changed; j < bones; j++) {
+					Basis basis(Vector3(0, 0, 1), Math::sin(frame * 0.1 + j) * 0.3);
+					for (int k = 0; k < 3; k++) {
+						w[j * 12 + k * 4 + 0] = basis.elements[k][0];
+						w[j * 12 + k * 4 + 1] = basis.elements[k][1];
+						w[j * 12 + k * 4 + 2] = basis.elements[k][2];
+					}
+				}
+				crowd[i]->set_bone_pose_buffer(buffer);
+				crowd[i]->notification(Skeleton3D::NOTIFICATION_UPDATE_SKELETON);
+			}
+		}
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+		MESSAGE(vformat("%d skeletons of %d bones with %d posed bones, %d frames: %d usec.", skeletons, bones, changed, frames, elapsed));
+	}
+
+	for (int i = 0; i < skeletons; i++) {
+		memdelete(crowd[i]);
+	}
+}
+
+} // namespace TestSkeleton3D
+
+#endif // TEST_SKELETON_3D_H
@@ -1346,6 +1346,21 @@ TEST_CASE("[String] validate_node_name") {
 	String name_with_invalid_chars = "Name with invalid characters :.@removed!";
 	CHECK(name_with_invalid_chars.validate_node_name() == "Name with invalid characters removed!");
 }
+
+TEST_CASE("[String] Move constructor and assignment") {
+	String s = "Sample text";
+	const char32_t *data = s.ptr();
+
+	String moved = std::move(s);
+	CHECK(moved.ptr() == data);
+	CHECK(moved == "Sample text");
+	CHECK(s.is_empty());
+
+	String assigned = "Other";
+	assigned = std::move(moved);
+	CHECK(assigned.ptr() == data);
+	CHECK(moved.is_empty());
+}
 } // namespace TestString
 
 #endif // TEST_STRING_H
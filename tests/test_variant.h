@@ -31,6 +31,8 @@
 #ifndef TEST_VARIANT_H
 #define TEST_VARIANT_H
 
+#include "core/os/os.h"
+#include "core/os/thread.h"
 #include "core/variant/variant.h"
 #include "core/variant/variant_parser.h"
 
@@ -699,6 +701,302 @@ TEST_CASE("[Variant] Assignment To Color from Bool,Int,Float,String,Vec2,Vec2i,V
 	vec3i_v = col_v;
 	CHECK(vec3i_v.get_type() == Variant::COLOR);
 }
+
+TEST_CASE("[Variant] Copy and assignment of heap-stored math types") {
+	const Transform xform = Transform(Basis(Vector3(0, 1, 0), 0.5), Vector3(1, 2, 3));
+	const Transform2D xform2d = Transform2D(0.5, Vector2(4, 5));
+	const Basis basis = Basis(Vector3(1, 0, 0), 0.25);
+	const AABB aabb = AABB(Vector3(-1, -2, -3), Vector3(4, 5, 6));
+
+	Variant xform_v = xform;
+	Variant xform2d_v = xform2d;
+	Variant basis_v = basis;
+	Variant aabb_v = aabb;
+
+	Variant copy = xform_v;
+	CHECK(copy == xform_v);
+	copy = xform2d_v;
+	CHECK(Transform2D(copy) == xform2d);
+	copy = basis_v;
+	CHECK(Basis(copy) == basis);
+	copy = aabb_v;
+	CHECK(::AABB(copy) == aabb);
+	copy = xform_v;
+	CHECK(Transform(copy) == xform);
+
+	// Assigning over the same type reuses the storage; the source must remain untouched.
+	Variant other = Transform();
+	other = xform_v;
+	CHECK(Transform(other) == xform);
+	other = Transform();
+	CHECK(Transform(xform_v) == xform);
+	CHECK(Transform(other) == Transform());
+}
+
+TEST_CASE("[Variant] Packed array bulk operations") {
+	PackedFloat32Array floats;
+	floats.push_back(1);
+	floats.push_back(-2);
+	floats.push_back(3);
+	Variant floats_v = floats;
+
+	floats_v.call("multiply_scalar", 2);
+	floats_v.call("add_scalar", 1);
+	PackedFloat32Array result = floats_v;
+	CHECK(result[0] == doctest::Approx(3));
+	CHECK(result[1] == doctest::Approx(-3));
+	CHECK(result[2] == doctest::Approx(7));
+	CHECK(float(floats_v.call("sum")) == doctest::Approx(7));
+	CHECK(float(floats_v.call("min")) == doctest::Approx(-3));
+	CHECK(float(floats_v.call("max")) == doctest::Approx(7));
+	CHECK_MESSAGE(floats[0] == doctest::Approx(1), "The original array should not be modified.");
+
+	PackedVector3Array points;
+	points.push_back(Vector3(1, 0, 0));
+	points.push_back(Vector3(0, 2, 0));
+	Variant points_v = points;
+
+	points_v.call("transform", Transform(Basis(), Vector3(1, 1, 1)));
+	PackedVector3Array moved = points_v;
+	CHECK(moved[0].is_equal_approx(Vector3(2, 1, 1)));
+	CHECK(moved[1].is_equal_approx(Vector3(1, 3, 1)));
+
+	points_v.call("lerp_array", points, 0.5);
+	moved = points_v;
+	CHECK(moved[0].is_equal_approx(Vector3(1.5, 0.5, 0.5)));
+	CHECK(moved[1].is_equal_approx(Vector3(0.5, 2.5, 0.5)));
+	CHECK(Vector3(points_v.call("max")).is_equal_approx(Vector3(1.5, 2.5, 0.5)));
+
+	PackedVector2Array uvs;
+	uvs.push_back(Vector2(1, 2));
+	Variant uvs_v = uvs;
+	uvs_v.call("multiply_array", uvs);
+	uvs_v.call("add_array", uvs);
+	CHECK(Vector2(uvs_v.call("sum")).is_equal_approx(Vector2(2, 6)));
+}
+
+TEST_CASE("[Variant] Packed array bulk operations match per-element math") {
+	// Long enough for the vector paths, with a scalar tail after them.
+	const int count = 23;
+	PackedVector3Array points;
+	PackedVector3Array targets;
+	PackedVector2Array uvs;
+	PackedFloat32Array floats;
+	for (int i = 0; i < count; i++) {
+		points.push_back(Vector3(i, -i * 0.5, (i % 5) - 2));
+		targets.push_back(Vector3(i % 3, i * 0.25, -i));
+		uvs.push_back(Vector2(i * 0.1, (i % 7) - 3));
+		floats.push_back((i % 9) - 4.5);
+	}
+
+	Variant points_v = points;
+	points_v.call("lerp_array", targets, 0.25);
+	points_v.call("multiply_scalar", 2);
+	PackedVector3Array lerped = points_v;
+	Vector3 expected_min = points[0].lerp(targets[0], 0.25) * 2;
+	Vector3 expected_max = expected_min;
+	Vector3 expected_sum;
+	int mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		Vector3 expected = points[i].lerp(targets[i], 0.25) * 2;
+		mismatches += !lerped[i].is_equal_approx(expected);
+		expected_min = Vector3(MIN(expected_min.x, expected.x), MIN(expected_min.y, expected.y), MIN(expected_min.z, expected.z));
+		expected_max = Vector3(MAX(expected_max.x, expected.x), MAX(expected_max.y, expected.y), MAX(expected_max.z, expected.z));
+		expected_sum += expected;
+	}
+	CHECK(mismatches == 0);
+	CHECK(Vector3(points_v.call("min")).is_equal_approx(expected_min));
+	CHECK(Vector3(points_v.call("max")).is_equal_approx(expected_max));
+	CHECK(Vector3(points_v.call("sum")).is_equal_approx(expected_sum));
+
+	const Transform2D xform = Transform2D(0.5, Vector2(1, -2));
+	Variant uvs_v = uvs;
+	uvs_v.call("transform", xform);
+	uvs_v.call("add_array", uvs);
+	PackedVector2Array moved = uvs_v;
+	mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		mismatches += !moved[i].is_equal_approx(xform.xform(uvs[i]) + uvs[i]);
+	}
+	CHECK(mismatches == 0);
+
+	Variant floats_v = floats;
+	floats_v.call("multiply_array", floats);
+	floats_v.call("add_scalar", -1);
+	PackedFloat32Array squared = floats_v;
+	float expected_float_sum = 0;
+	mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		mismatches += !Math::is_equal_approx(squared[i], floats[i] * floats[i] - 1);
+		expected_float_sum += floats[i] * floats[i] - 1;
+	}
+	CHECK(mismatches == 0);
+	CHECK(float(floats_v.call("sum")) == doctest::Approx(expected_float_sum));
+	CHECK(float(floats_v.call("min")) == doctest::Approx(-0.75));
+	CHECK(float(floats_v.call("max")) == doctest::Approx(19.25));
+}
+
+TEST_CASE("[Variant][Benchmark] Packed array bulk operations versus per-element access" * doctest::skip()) {
+	const int count = 100000;
+	PackedVector3Array points;
+	points.resize(count);
+	const Transform xform = Transform(Basis(Vector3(0, 1, 0), 0.5), Vector3(1, 2, 3));
+
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+	Variant points_v = points;
+	for (int i = 0; i < count; i++) {
+		Variant point = points_v.get(i);
+		points_v.set(i, xform.xform(Vector3(point)));
+	}
+	MESSAGE("Per-element transform of ", count, " points: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	start = OS::get_singleton()->get_ticks_usec();
+	points_v.call("transform", xform);
+	MESSAGE("Bulk transform of ", count, " points: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+}
+
+TEST_CASE("[Variant] Move constructor and assignment") {
+	String s = "Sample text";
+	Variant v = s;
+
+	Variant moved = std::move(v);
+	CHECK(v.get_type() == Variant::NIL);
+	CHECK(moved == s);
+
+	Array arr;
+	arr.push_back(moved);
+	Variant arr_v = arr;
+	Variant &element = arr[0];
+	arr = Array();
+	// The destination holds the only reference to the array owning the element,
+	// so moving must detach the element before releasing the array.
+	arr_v = std::move(element);
+	CHECK(arr_v == s);
+
+	Variant xform_v = Transform(Basis(), Vector3(1, 2, 3));
+	moved = std::move(xform_v);
+	CHECK(xform_v.get_type() == Variant::NIL);
+	CHECK(Transform(moved).origin == Vector3(1, 2, 3));
+}
+
+TEST_CASE("[Variant][Benchmark] Copy versus move of refcounted types" * doctest::skip()) {
+	const int iterations = 1000000;
+	const String s = "Sample text";
+
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Variant src = s;
+		Variant dst = src; // One reference taken and released.
+	}
+	MESSAGE("Copy String variant: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Variant src = s;
+		Variant dst = std::move(src); // No reference count traffic.
+	}
+	MESSAGE("Move String variant: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	Array arr;
+	arr.resize(16);
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Variant dst = Variant(arr).duplicate(false);
+	}
+	MESSAGE("Return Array by value: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+}
+
+// Every thread starts from the same array and dictionary, so copies contend on their reference counts.
+struct RefCountContention {
+	Array array;
+	Dictionary dictionary;
+	int iterations = 0;
+	bool move = false;
+};
+
+static void ref_count_contention_thread(void *p_userdata) {
+	const RefCountContention *rc = (const RefCountContention *)p_userdata;
+	Array array = rc->array;
+	Dictionary dictionary = rc->dictionary;
+	for (int i = 0; i < rc->iterations; i++) {
+		if (rc->move) {
+			// No atomic operations and no allocations.
+			Array array_tmp = std::move(array);
+			array = std::move(array_tmp);
+			Dictionary dictionary_tmp = std::move(dictionary);
+			dictionary = std::move(dictionary_tmp);
+		} else {
+			// Two atomic operations per copy.
+			Array array_tmp = array;
+			Dictionary dictionary_tmp = dictionary;
+		}
+	}
+}
+
+TEST_CASE("[Variant][Benchmark] Reference count contention when copying and moving containers" * doctest::skip()) {
+	RefCountContention rc;
+	rc.array.resize(16);
+	rc.dictionary[1] = 2;
+	rc.iterations = 1000000;
+	const int thread_count = MAX(2, OS::get_singleton()->get_processor_count());
+
+	for (int pass = 0; pass < 2; pass++) {
+		rc.move = pass == 1;
+		Thread *threads = memnew_arr(Thread, thread_count);
+		uint64_t start = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < thread_count; i++) {
+			threads[i].start(ref_count_contention_thread, &rc);
+		}
+		for (int i = 0; i < thread_count; i++) {
+			threads[i].wait_to_finish();
+		}
+		MESSAGE((rc.move ? "Move" : "Copy"), " Array and Dictionary on ", thread_count, " threads: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+		memdelete_arr(threads);
+	}
+}
+
+TEST_CASE("[Variant][Benchmark] Copy, assign and operator throughput for math types" * doctest::skip()) {
+	const int iterations = 1000000;
+	const Transform xform = Transform(Basis(Vector3(0, 1, 0), 0.5), Vector3(1, 2, 3));
+	const Variant xform_v = xform;
+	const Variant vec_v = Vector3(1, 2, 3);
+
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Variant copy = xform_v;
+	}
+	MESSAGE("Copy construct Transform: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	Variant dst;
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		dst = Variant();
+		dst = xform_v;
+	}
+	MESSAGE("Assign Transform over Nil: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		dst = xform_v;
+	}
+	MESSAGE("Assign Transform over Transform: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	Variant ret;
+	bool valid;
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Variant::evaluate(Variant::OP_MULTIPLY, xform_v, xform_v, ret, valid);
+	}
+	MESSAGE("Transform * Transform: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	start = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Variant::evaluate(Variant::OP_MULTIPLY, xform_v, vec_v, ret, valid);
+	}
+	MESSAGE("Transform * Vector3: ", OS::get_singleton()->get_ticks_usec() - start, " usec");
+
+	CHECK(valid);
+}
 } // namespace TestVariant
 
 #endif // TEST_VARIANT_H
@@ -491,6 +491,29 @@ TEST_CASE("[Vector] Operators") {
 	CHECK(vector != vector_other);
 }
 
+TEST_CASE("[Vector] Move constructor and assignment") {
+	Vector<int> vector;
+	vector.push_back(1);
+	vector.push_back(2);
+	const int *data = vector.ptr();
+
+	Vector<int> moved = std::move(vector);
+	CHECK_MESSAGE(moved.ptr() == data, "Moving should steal the buffer instead of sharing it.");
+	CHECK(moved.size() == 2);
+	CHECK(vector.is_empty());
+
+	Vector<int> assigned;
+	assigned.push_back(3);
+	assigned = std::move(moved);
+	CHECK(assigned.ptr() == data);
+	CHECK(assigned[1] == 2);
+	CHECK(moved.is_empty());
+
+	// The buffer was never shared, so writing to it must not copy it.
+	assigned.write[0] = 4;
+	CHECK(assigned.ptr() == data);
+}
+
 } // namespace TestVector
 
 #endif // TEST_VECTOR_H